@@ -3,10 +3,19 @@
 
 #include "Defines.hpp"
 
+#include "IRenderer.hpp"
+
 LPCSTR CLASS_NAME = "DX12HelloCube";
 LPCSTR WINDOW_NAME = "DX12 - Hello Cube";
 
 CONST LONG WINDOW_WIDTH = 512;
 CONST LONG WINDOW_HEIGHT = 512;
 
+CONST IRenderer::RendererType RENDERER_TYPE = IRenderer::RendererType::D3D12;
+
+LPCSTR TRACE_FILE_NAME = "DX12_HelloCube.trace";
+CONST SIZE_T TRACE_RING_SIZE = 4 * 1024 * 1024;
+
+LPCSTR PROFILE_FILE_NAME = "DX12_HelloCube.profile.json";
+
 #endif // CONFIG_HPP
\ No newline at end of file
@@ -3,7 +3,9 @@
 #include "Config.hpp"
 
 #include "Console.hpp"
+#include "Jobs.hpp"
 #include "Memory.hpp"
+#include "Profiler.hpp"
 #include "IWindow.hpp"
 #include "IRenderer.hpp"
 
@@ -59,6 +61,32 @@ BOOL DX12_HelloCube::Initialize(VOID)
 		}
 	}
 
+	if (Status == TRUE)
+	{
+		if (Profiler::Initialize() != TRUE)
+		{
+			Status = FALSE;
+		}
+		else
+		{
+			Profiler::SetThreadName("Main");
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		// Tracing is diagnostic only, keep running without it
+		Console::OpenTrace(TRACE_FILE_NAME, TRACE_RING_SIZE);
+	}
+
+	if (Status == TRUE)
+	{
+		if (Jobs::Initialize(0) != TRUE)
+		{
+			Status = FALSE;
+		}
+	}
+
 	if (Status == TRUE)
 	{
 		m_pIWindow = IWindow::Create(CLASS_NAME, WINDOW_NAME, WINDOW_WIDTH, WINDOW_HEIGHT);
@@ -70,7 +98,7 @@ BOOL DX12_HelloCube::Initialize(VOID)
 
 	if (Status == TRUE)
 	{
-		m_pIRenderer = IRenderer::Create(m_pIWindow->GetHandle(), WINDOW_WIDTH, WINDOW_HEIGHT);
+		m_pIRenderer = IRenderer::Create(RENDERER_TYPE, m_pIWindow->GetHandle(), WINDOW_WIDTH, WINDOW_HEIGHT);
 		if (m_pIRenderer == NULL)
 		{
 			Status = FALSE;
@@ -94,6 +122,16 @@ VOID DX12_HelloCube::Uninitialize(VOID)
 		m_pIWindow = NULL;
 	}
 
+	Jobs::Uninitialize();
+
+	// Every other thread has stopped, so the zone buffers are stable
+	Profiler::ExportChromeTrace(PROFILE_FILE_NAME);
+	Profiler::Uninitialize();
+
+#if _DEBUG
+	Memory::ReportStatistics();
+#endif
+
 	Console::Uninitialize();
 
 	Memory::Uninitialize();
@@ -107,6 +145,9 @@ BOOL DX12_HelloCube::MainLoop(VOID)
 
 	while ((Status == TRUE) && m_pIWindow->Open())
 	{
+		// Window work may only happen on this thread, jobs hand it over here
+		Jobs::PumpMainThread();
+
 		if (m_pIWindow->GetEvent(Event) == TRUE)
 		{
 			if (Event.ID == IWindow::EventID::QUIT)
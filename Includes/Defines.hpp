@@ -1,6 +1,10 @@
 #ifndef DEFINES_HPP
 #define DEFINES_HPP
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+
 #define CONST	const
 #define VOID	void
 
@@ -11,15 +15,6 @@
 #define TRUE	1
 #define FALSE   0
 
-typedef signed char			int8_t;
-typedef short				int16_t;
-typedef int					int32_t;
-typedef long long			int64_t;
-typedef unsigned char		uint8_t;
-typedef unsigned short		uint16_t;
-typedef unsigned int		uint32_t;
-typedef unsigned long long	uint64_t;
-
 typedef int					BOOL;
 typedef char				CHAR;
 typedef short				SHORT;
@@ -27,9 +22,9 @@ typedef int					INT;
 typedef unsigned int        UINT;
 typedef long				LONG;
 typedef unsigned long		ULONG;
-typedef unsigned __int64	SIZE_T;
+typedef size_t				SIZE_T;
 
-typedef unsigned __int64    UINT64;
+typedef unsigned long long	UINT64;
 
 typedef unsigned long		DWORD;
 
@@ -40,11 +35,11 @@ typedef const char*			LPCCH;
 typedef const char*			LPCSTR;
 typedef const wchar_t*		LPCWSTR;
 
-typedef unsigned __int64    WPARAM;
-typedef __int64				LPARAM;
+typedef unsigned long long	WPARAM;
+typedef long long			LPARAM;
 
 typedef long				HRESULT;
-typedef __int64             LRESULT;
+typedef long long			LRESULT;
 
 typedef unsigned short      ATOM;
 typedef void*				HANDLE;
@@ -53,6 +48,4 @@ typedef struct HINSTANCE__* HMODULE;
 typedef struct HINSTANCE__* HINSTANCE;
 typedef void*				PVOID;
 
-typedef char*				va_list;
-
 #endif // DEFINES_HPP
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <string.h>
+
+#include "Defines.hpp"
+
+// 64 bit FNV-1a. Every function continues the hash it is given, so a key is built by feeding its parts in turn,
+// starting from OffsetBasis.
+namespace Hash
+{
+	constexpr UINT64 OffsetBasis = 0xCBF29CE484222325ull;
+	constexpr UINT64 Prime = 0x100000001B3ull;
+
+	inline UINT64 Fnv1a(CONST VOID* pData, SIZE_T nBytes, UINT64 Hash = OffsetBasis)
+	{
+		CONST uint8_t* pBytes = reinterpret_cast<CONST uint8_t*>(pData);
+
+		for (SIZE_T i = 0; i < nBytes; i++)
+		{
+			Hash = (Hash ^ pBytes[i]) * Prime;
+		}
+
+		return Hash;
+	}
+
+	// Byte by byte from the lowest, so the result does not depend on the host's endianness
+	inline UINT64 Fnv1aValue(UINT64 Value, UINT64 Hash = OffsetBasis)
+	{
+		for (UINT i = 0; i < sizeof(UINT64); i++)
+		{
+			Hash = (Hash ^ static_cast<uint8_t>(Value >> (i * 8))) * Prime;
+		}
+
+		return Hash;
+	}
+
+	// The terminator is hashed as well, so ("ab", "c") and ("a", "bc") differ. NULL counts as "".
+	inline UINT64 Fnv1aString(LPCSTR pString, UINT64 Hash = OffsetBasis)
+	{
+		pString = (pString != NULL) ? pString : "";
+		return Fnv1a(pString, strlen(pString) + 1, Hash);
+	}
+}
+
+#endif // HASH_HPP
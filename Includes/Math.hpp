@@ -0,0 +1,549 @@
+#ifndef MATH_HPP
+#define MATH_HPP
+
+#include <math.h>
+
+#include "Defines.hpp"
+
+// The instruction set is picked at compile time from the compiler's target flags, MATH_SCALAR forces the portable code
+#if !defined(MATH_SCALAR)
+	#if defined(__AVX__)
+		#include <immintrin.h>
+		#define MATH_AVX 1
+		#define MATH_SSE 1
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+		#include <emmintrin.h>
+		#define MATH_SSE 1
+	#elif defined(__ARM_NEON) || defined(_M_ARM64)
+		#include <arm_neon.h>
+		#define MATH_NEON 1
+	#endif
+#endif
+
+#ifndef MATH_AVX
+	#define MATH_AVX 0
+#endif
+
+#ifndef MATH_SSE
+	#define MATH_SSE 0
+#endif
+
+#ifndef MATH_NEON
+	#define MATH_NEON 0
+#endif
+
+// MSVC has no FMA macro, but every target it builds for with /arch:AVX2 has FMA3
+#if MATH_AVX && (defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__)))
+	#define MATH_FMA 1
+#else
+	#define MATH_FMA 0
+#endif
+
+struct Vec3
+{
+	FLOAT x, y, z;
+};
+
+struct alignas(16) Vec4
+{
+	FLOAT x, y, z, w;
+};
+
+// Unit quaternions stand for rotations, w is the scalar part
+struct alignas(16) Quat
+{
+	FLOAT x, y, z, w;
+};
+
+// Row major with points as row vectors (p' = p * M), so A * B applies A first and the translation sits in the last row.
+// This is the DirectXMath convention and matches a row_major float4x4 used as mul(p, M) in HLSL.
+struct alignas(16) Mat4
+{
+	FLOAT m[4][4];
+};
+
+namespace Math
+{
+	constexpr FLOAT Pi = 3.14159265358979f;
+
+	inline LPCSTR GetInstructionSet(VOID)
+	{
+#if MATH_AVX && MATH_FMA
+		return "AVX+FMA";
+#elif MATH_AVX
+		return "AVX";
+#elif MATH_SSE
+		return "SSE2";
+#elif MATH_NEON
+		return "NEON";
+#else
+		return "Scalar";
+#endif
+	}
+
+	inline Vec3 Add(CONST Vec3& rA, CONST Vec3& rB)
+	{
+		return Vec3{ rA.x + rB.x, rA.y + rB.y, rA.z + rB.z };
+	}
+
+	inline Vec3 Subtract(CONST Vec3& rA, CONST Vec3& rB)
+	{
+		return Vec3{ rA.x - rB.x, rA.y - rB.y, rA.z - rB.z };
+	}
+
+	inline Vec3 Scale(CONST Vec3& rV, FLOAT Factor)
+	{
+		return Vec3{ rV.x * Factor, rV.y * Factor, rV.z * Factor };
+	}
+
+	inline FLOAT Dot(CONST Vec3& rA, CONST Vec3& rB)
+	{
+		return rA.x * rB.x + rA.y * rB.y + rA.z * rB.z;
+	}
+
+	inline Vec3 Cross(CONST Vec3& rA, CONST Vec3& rB)
+	{
+		return Vec3{ rA.y * rB.z - rA.z * rB.y, rA.z * rB.x - rA.x * rB.z, rA.x * rB.y - rA.y * rB.x };
+	}
+
+	inline FLOAT Length(CONST Vec3& rV)
+	{
+		return sqrtf(Dot(rV, rV));
+	}
+
+	// A zero vector has no direction and is returned unchanged
+	inline Vec3 Normalize(CONST Vec3& rV)
+	{
+		FLOAT Len = Length(rV);
+		return (Len > 0.0f) ? Scale(rV, 1.0f / Len) : rV;
+	}
+
+	inline Mat4 Identity(VOID)
+	{
+		return Mat4{ { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } };
+	}
+
+	inline Mat4 Translation(FLOAT x, FLOAT y, FLOAT z)
+	{
+		return Mat4{ { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { x, y, z, 1.0f } } };
+	}
+
+	inline Mat4 Scaling(FLOAT x, FLOAT y, FLOAT z)
+	{
+		return Mat4{ { { x, 0.0f, 0.0f, 0.0f }, { 0.0f, y, 0.0f, 0.0f }, { 0.0f, 0.0f, z, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } };
+	}
+
+	inline Mat4 Transpose(CONST Mat4& rM)
+	{
+		Mat4 Result;
+
+		for (UINT r = 0; r < 4; r++)
+		{
+			for (UINT c = 0; c < 4; c++)
+			{
+				Result.m[r][c] = rM.m[c][r];
+			}
+		}
+
+		return Result;
+	}
+
+	// Reference kernels, always compiled so the SIMD paths can be checked and benchmarked against them
+	namespace Scalar
+	{
+		inline Mat4 Multiply(CONST Mat4& rA, CONST Mat4& rB)
+		{
+			Mat4 Result;
+
+			for (UINT r = 0; r < 4; r++)
+			{
+				for (UINT c = 0; c < 4; c++)
+				{
+					Result.m[r][c] = rA.m[r][0] * rB.m[0][c] + rA.m[r][1] * rB.m[1][c] + rA.m[r][2] * rB.m[2][c] + rA.m[r][3] * rB.m[3][c];
+				}
+			}
+
+			return Result;
+		}
+
+		inline VOID TransformPoints(CONST Mat4& rM, CONST FLOAT* pPositions, SIZE_T Stride, Vec4* pOutput, SIZE_T Count)
+		{
+			CONST uint8_t* pInput = reinterpret_cast<CONST uint8_t*>(pPositions);
+
+			for (SIZE_T i = 0; i < Count; i++)
+			{
+				CONST FLOAT* p = reinterpret_cast<CONST FLOAT*>(pInput + i * Stride);
+
+				pOutput[i].x = p[0] * rM.m[0][0] + p[1] * rM.m[1][0] + p[2] * rM.m[2][0] + rM.m[3][0];
+				pOutput[i].y = p[0] * rM.m[0][1] + p[1] * rM.m[1][1] + p[2] * rM.m[2][1] + rM.m[3][1];
+				pOutput[i].z = p[0] * rM.m[0][2] + p[1] * rM.m[1][2] + p[2] * rM.m[2][2] + rM.m[3][2];
+				pOutput[i].w = p[0] * rM.m[0][3] + p[1] * rM.m[1][3] + p[2] * rM.m[2][3] + rM.m[3][3];
+			}
+		}
+	}
+
+	namespace Internal
+	{
+#if MATH_SSE
+		inline __m128 MulAdd(__m128 a, __m128 b, __m128 c)
+		{
+	#if MATH_FMA
+			return _mm_fmadd_ps(a, b, c);
+	#else
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
+	#endif
+		}
+#endif
+
+#if MATH_AVX
+		inline __m256 MulAdd(__m256 a, __m256 b, __m256 c)
+		{
+	#if MATH_FMA
+			return _mm256_fmadd_ps(a, b, c);
+	#else
+			return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+	#endif
+		}
+#endif
+
+#if MATH_NEON
+		inline float32x4_t MulAdd(float32x4_t a, float32x4_t b, FLOAT c)
+		{
+	#if defined(__aarch64__) || defined(_M_ARM64)
+			return vfmaq_n_f32(a, b, c);
+	#else
+			return vmlaq_n_f32(a, b, c);
+	#endif
+		}
+#endif
+	}
+
+	inline Mat4 Multiply(CONST Mat4& rA, CONST Mat4& rB)
+	{
+#if MATH_AVX
+		Mat4 Result;
+
+		CONST __m256 B0 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rB.m[0]));
+		CONST __m256 B1 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rB.m[1]));
+		CONST __m256 B2 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rB.m[2]));
+		CONST __m256 B3 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rB.m[3]));
+
+		// Two rows of A per register, the in-lane shuffles splat each row's own coefficients
+		for (UINT r = 0; r < 4; r += 2)
+		{
+			CONST __m256 A = _mm256_loadu_ps(rA.m[r]);
+
+			__m256 Row = _mm256_mul_ps(_mm256_shuffle_ps(A, A, _MM_SHUFFLE(0, 0, 0, 0)), B0);
+			Row = Internal::MulAdd(_mm256_shuffle_ps(A, A, _MM_SHUFFLE(1, 1, 1, 1)), B1, Row);
+			Row = Internal::MulAdd(_mm256_shuffle_ps(A, A, _MM_SHUFFLE(2, 2, 2, 2)), B2, Row);
+			Row = Internal::MulAdd(_mm256_shuffle_ps(A, A, _MM_SHUFFLE(3, 3, 3, 3)), B3, Row);
+
+			_mm256_storeu_ps(Result.m[r], Row);
+		}
+
+		return Result;
+#elif MATH_SSE
+		Mat4 Result;
+
+		CONST __m128 B0 = _mm_load_ps(rB.m[0]);
+		CONST __m128 B1 = _mm_load_ps(rB.m[1]);
+		CONST __m128 B2 = _mm_load_ps(rB.m[2]);
+		CONST __m128 B3 = _mm_load_ps(rB.m[3]);
+
+		for (UINT r = 0; r < 4; r++)
+		{
+			CONST __m128 A = _mm_load_ps(rA.m[r]);
+
+			__m128 Row = _mm_mul_ps(_mm_shuffle_ps(A, A, _MM_SHUFFLE(0, 0, 0, 0)), B0);
+			Row = Internal::MulAdd(_mm_shuffle_ps(A, A, _MM_SHUFFLE(1, 1, 1, 1)), B1, Row);
+			Row = Internal::MulAdd(_mm_shuffle_ps(A, A, _MM_SHUFFLE(2, 2, 2, 2)), B2, Row);
+			Row = Internal::MulAdd(_mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 3, 3, 3)), B3, Row);
+
+			_mm_store_ps(Result.m[r], Row);
+		}
+
+		return Result;
+#elif MATH_NEON
+		Mat4 Result;
+
+		CONST float32x4_t B0 = vld1q_f32(rB.m[0]);
+		CONST float32x4_t B1 = vld1q_f32(rB.m[1]);
+		CONST float32x4_t B2 = vld1q_f32(rB.m[2]);
+		CONST float32x4_t B3 = vld1q_f32(rB.m[3]);
+
+		for (UINT r = 0; r < 4; r++)
+		{
+			float32x4_t Row = vmulq_n_f32(B0, rA.m[r][0]);
+			Row = Internal::MulAdd(Row, B1, rA.m[r][1]);
+			Row = Internal::MulAdd(Row, B2, rA.m[r][2]);
+			Row = Internal::MulAdd(Row, B3, rA.m[r][3]);
+
+			vst1q_f32(Result.m[r], Row);
+		}
+
+		return Result;
+#else
+		return Scalar::Multiply(rA, rB);
+#endif
+	}
+
+	// Transforms Count points with w = 1 into homogeneous coordinates. Each point's x, y and z are consecutive floats and
+	// points are Stride bytes apart, so positions can be read straight out of an interleaved vertex buffer.
+	inline VOID TransformPoints(CONST Mat4& rM, CONST FLOAT* pPositions, SIZE_T Stride, Vec4* pOutput, SIZE_T Count)
+	{
+#if MATH_SSE || MATH_NEON
+		CONST uint8_t* pInput = reinterpret_cast<CONST uint8_t*>(pPositions);
+		SIZE_T i = 0;
+#endif
+
+#if MATH_AVX
+		CONST __m256 M0 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rM.m[0]));
+		CONST __m256 M1 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rM.m[1]));
+		CONST __m256 M2 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rM.m[2]));
+		CONST __m256 M3 = _mm256_broadcast_ps(reinterpret_cast<CONST __m128*>(rM.m[3]));
+
+		// Two points per iteration, one in each 128 bit lane
+		for (; (i + 2) <= Count; i += 2)
+		{
+			CONST FLOAT* p0 = reinterpret_cast<CONST FLOAT*>(pInput + i * Stride);
+			CONST FLOAT* p1 = reinterpret_cast<CONST FLOAT*>(pInput + (i + 1) * Stride);
+
+			__m256 Point = Internal::MulAdd(_mm256_setr_ps(p0[0], p0[0], p0[0], p0[0], p1[0], p1[0], p1[0], p1[0]), M0, M3);
+			Point = Internal::MulAdd(_mm256_setr_ps(p0[1], p0[1], p0[1], p0[1], p1[1], p1[1], p1[1], p1[1]), M1, Point);
+			Point = Internal::MulAdd(_mm256_setr_ps(p0[2], p0[2], p0[2], p0[2], p1[2], p1[2], p1[2], p1[2]), M2, Point);
+
+			_mm256_storeu_ps(&pOutput[i].x, Point);
+		}
+#endif
+
+#if MATH_SSE
+		CONST __m128 R0 = _mm_load_ps(rM.m[0]);
+		CONST __m128 R1 = _mm_load_ps(rM.m[1]);
+		CONST __m128 R2 = _mm_load_ps(rM.m[2]);
+		CONST __m128 R3 = _mm_load_ps(rM.m[3]);
+
+		for (; i < Count; i++)
+		{
+			CONST FLOAT* p = reinterpret_cast<CONST FLOAT*>(pInput + i * Stride);
+
+			__m128 Point = Internal::MulAdd(_mm_set1_ps(p[0]), R0, R3);
+			Point = Internal::MulAdd(_mm_set1_ps(p[1]), R1, Point);
+			Point = Internal::MulAdd(_mm_set1_ps(p[2]), R2, Point);
+
+			_mm_store_ps(&pOutput[i].x, Point);
+		}
+#elif MATH_NEON
+		CONST float32x4_t R0 = vld1q_f32(rM.m[0]);
+		CONST float32x4_t R1 = vld1q_f32(rM.m[1]);
+		CONST float32x4_t R2 = vld1q_f32(rM.m[2]);
+		CONST float32x4_t R3 = vld1q_f32(rM.m[3]);
+
+		for (; i < Count; i++)
+		{
+			CONST FLOAT* p = reinterpret_cast<CONST FLOAT*>(pInput + i * Stride);
+
+			float32x4_t Point = Internal::MulAdd(R3, R0, p[0]);
+			Point = Internal::MulAdd(Point, R1, p[1]);
+			Point = Internal::MulAdd(Point, R2, p[2]);
+
+			vst1q_f32(&pOutput[i].x, Point);
+		}
+#else
+		Scalar::TransformPoints(rM, pPositions, Stride, pOutput, Count);
+#endif
+	}
+
+	inline Vec4 TransformPoint(CONST Mat4& rM, CONST Vec3& rPoint)
+	{
+		Vec4 Result;
+		TransformPoints(rM, &rPoint.x, sizeof(Vec3), &Result, 1);
+		return Result;
+	}
+
+	// General inverse from the 2x2 sub-determinants of the upper and lower row pairs. Returns FALSE and leaves rInverse
+	// untouched when the matrix is singular.
+	inline BOOL Inverse(CONST Mat4& rM, Mat4& rInverse)
+	{
+		CONST FLOAT (*m)[4] = rM.m;
+
+		CONST FLOAT s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+		CONST FLOAT s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+		CONST FLOAT s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+		CONST FLOAT s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+		CONST FLOAT s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+		CONST FLOAT s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+		CONST FLOAT c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+		CONST FLOAT c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+		CONST FLOAT c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+		CONST FLOAT c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+		CONST FLOAT c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+		CONST FLOAT c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+		CONST FLOAT Determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+		if (!(fabsf(Determinant) > 0.0f) || !isfinite(Determinant))
+		{
+			return FALSE;
+		}
+
+		CONST FLOAT d = 1.0f / Determinant;
+
+		rInverse.m[0][0] = ( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * d;
+		rInverse.m[0][1] = (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * d;
+		rInverse.m[0][2] = ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * d;
+		rInverse.m[0][3] = (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * d;
+
+		rInverse.m[1][0] = (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * d;
+		rInverse.m[1][1] = ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * d;
+		rInverse.m[1][2] = (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * d;
+		rInverse.m[1][3] = ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * d;
+
+		rInverse.m[2][0] = ( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * d;
+		rInverse.m[2][1] = (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * d;
+		rInverse.m[2][2] = ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * d;
+		rInverse.m[2][3] = (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * d;
+
+		rInverse.m[3][0] = (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * d;
+		rInverse.m[3][1] = ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * d;
+		rInverse.m[3][2] = (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * d;
+		rInverse.m[3][3] = ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * d;
+
+		return TRUE;
+	}
+
+	// Left handed view matrix, the camera looks down +z
+	inline Mat4 LookAtLH(CONST Vec3& rEye, CONST Vec3& rTarget, CONST Vec3& rUp)
+	{
+		CONST Vec3 z = Normalize(Subtract(rTarget, rEye));
+		CONST Vec3 x = Normalize(Cross(rUp, z));
+		CONST Vec3 y = Cross(z, x);
+
+		return Mat4{ {
+			{ x.x, y.x, z.x, 0.0f },
+			{ x.y, y.y, z.y, 0.0f },
+			{ x.z, y.z, z.z, 0.0f },
+			{ -Dot(x, rEye), -Dot(y, rEye), -Dot(z, rEye), 1.0f }
+		} };
+	}
+
+	// Right handed view matrix, the camera looks down -z. That is the left handed view looking away from the target.
+	inline Mat4 LookAtRH(CONST Vec3& rEye, CONST Vec3& rTarget, CONST Vec3& rUp)
+	{
+		return LookAtLH(rEye, Subtract(Scale(rEye, 2.0f), rTarget), rUp);
+	}
+
+	// Left handed projection onto D3D clip space, depth runs from 0 at the near plane to 1 at the far plane
+	inline Mat4 PerspectiveFovLH(FLOAT FovY, FLOAT AspectRatio, FLOAT NearZ, FLOAT FarZ)
+	{
+		CONST FLOAT h = 1.0f / tanf(FovY * 0.5f);
+		CONST FLOAT w = h / AspectRatio;
+		CONST FLOAT Range = FarZ / (FarZ - NearZ);
+
+		return Mat4{ {
+			{ w, 0.0f, 0.0f, 0.0f },
+			{ 0.0f, h, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, Range, 1.0f },
+			{ 0.0f, 0.0f, -Range * NearZ, 0.0f }
+		} };
+	}
+
+	// Right handed counterpart of PerspectiveFovLH, points in front of the camera have negative view space z
+	inline Mat4 PerspectiveFovRH(FLOAT FovY, FLOAT AspectRatio, FLOAT NearZ, FLOAT FarZ)
+	{
+		CONST FLOAT h = 1.0f / tanf(FovY * 0.5f);
+		CONST FLOAT w = h / AspectRatio;
+		CONST FLOAT Range = FarZ / (NearZ - FarZ);
+
+		return Mat4{ {
+			{ w, 0.0f, 0.0f, 0.0f },
+			{ 0.0f, h, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, Range, -1.0f },
+			{ 0.0f, 0.0f, Range * NearZ, 0.0f }
+		} };
+	}
+
+	// The planes of the view volume of a projection onto D3D clip space, in the space the matrix transforms from. Each is
+	// (normal, distance) with a unit normal pointing inwards, in the order left, right, bottom, top, near, far.
+	inline VOID FrustumPlanes(CONST Mat4& rM, Vec4 pPlanes[6])
+	{
+		// With row vectors clip x, y, z and w are the dot products of the point with the columns of the matrix
+		CONST FLOAT Signs[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+		CONST UINT Columns[6] = { 0, 0, 1, 1, 2, 2 };
+
+		for (UINT p = 0; p < 6; p++)
+		{
+			// -w <= x <= w and -w <= y <= w, but 0 <= z <= w
+			CONST FLOAT w = (p != 4) ? 1.0f : 0.0f;
+			CONST UINT c = Columns[p];
+			CONST FLOAT s = Signs[p];
+
+			CONST Vec3 Normal = { w * rM.m[0][3] + s * rM.m[0][c], w * rM.m[1][3] + s * rM.m[1][c], w * rM.m[2][3] + s * rM.m[2][c] };
+			CONST FLOAT Distance = w * rM.m[3][3] + s * rM.m[3][c];
+			CONST FLOAT Len = Length(Normal);
+			CONST FLOAT InvLen = (Len > 0.0f) ? (1.0f / Len) : 0.0f;
+
+			pPlanes[p] = Vec4{ Normal.x * InvLen, Normal.y * InvLen, Normal.z * InvLen, Distance * InvLen };
+		}
+	}
+
+	// rAxis must have unit length
+	inline Quat AxisAngle(CONST Vec3& rAxis, FLOAT Angle)
+	{
+		CONST FLOAT s = sinf(Angle * 0.5f);
+		return Quat{ rAxis.x * s, rAxis.y * s, rAxis.z * s, cosf(Angle * 0.5f) };
+	}
+
+	// Like the matrix product, the result rotates by A first and B second
+	inline Quat Multiply(CONST Quat& rA, CONST Quat& rB)
+	{
+		return Quat{
+			rB.w * rA.x + rB.x * rA.w + rB.y * rA.z - rB.z * rA.y,
+			rB.w * rA.y - rB.x * rA.z + rB.y * rA.w + rB.z * rA.x,
+			rB.w * rA.z + rB.x * rA.y - rB.y * rA.x + rB.z * rA.w,
+			rB.w * rA.w - rB.x * rA.x - rB.y * rA.y - rB.z * rA.z
+		};
+	}
+
+	inline Quat Normalize(CONST Quat& rQ)
+	{
+		CONST FLOAT Len = sqrtf(rQ.x * rQ.x + rQ.y * rQ.y + rQ.z * rQ.z + rQ.w * rQ.w);
+		CONST FLOAT s = (Len > 0.0f) ? (1.0f / Len) : 0.0f;
+		return (Len > 0.0f) ? Quat{ rQ.x * s, rQ.y * s, rQ.z * s, rQ.w * s } : Quat{ 0.0f, 0.0f, 0.0f, 1.0f };
+	}
+
+	inline Mat4 Rotation(CONST Quat& rQ)
+	{
+		CONST FLOAT xx = rQ.x * rQ.x, yy = rQ.y * rQ.y, zz = rQ.z * rQ.z;
+		CONST FLOAT xy = rQ.x * rQ.y, xz = rQ.x * rQ.z, yz = rQ.y * rQ.z;
+		CONST FLOAT wx = rQ.w * rQ.x, wy = rQ.w * rQ.y, wz = rQ.w * rQ.z;
+
+		return Mat4{ {
+			{ 1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f },
+			{ 2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f },
+			{ 2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f },
+			{ 0.0f, 0.0f, 0.0f, 1.0f }
+		} };
+	}
+
+	// Scales, then rotates, then translates, the usual order for an object's local transform
+	inline Mat4 Compose(CONST Vec3& rScale, CONST Quat& rRotation, CONST Vec3& rTranslation)
+	{
+		Mat4 Result = Rotation(rRotation);
+
+		for (UINT c = 0; c < 3; c++)
+		{
+			Result.m[0][c] *= rScale.x;
+			Result.m[1][c] *= rScale.y;
+			Result.m[2][c] *= rScale.z;
+		}
+
+		Result.m[3][0] = rTranslation.x;
+		Result.m[3][1] = rTranslation.y;
+		Result.m[3][2] = rTranslation.z;
+
+		return Result;
+	}
+}
+
+#endif // MATH_HPP
@@ -1,15 +1,106 @@
 #ifndef CONSOLE_HPP
 #define CONSOLE_HPP
 
+#include <cstring>
+#include <type_traits>
+
 #include "Defines.hpp"
 
+// Messages below this level are compiled out of CONSOLE_LOG call sites
+#ifndef CONSOLE_MIN_LEVEL
+	#if _DEBUG
+		#define CONSOLE_MIN_LEVEL 0
+	#else
+		#define CONSOLE_MIN_LEVEL 1
+	#endif
+#endif
+
+#define CONSOLE_LOG(Level, ...) (((Level) >= CONSOLE_MIN_LEVEL) ? Console::WriteLevel((Level), __VA_ARGS__) : TRUE)
+
+// Records an event in the binary trace. The format is registered once per call site, only its ID, a timestamp and the
+// raw arguments are stored and Tools/TraceDecoder formats them offline. Arguments must be numbers or pointers.
+#define CONSOLE_TRACE(Level, Format, ...) \
+	do \
+	{ \
+		if ((Level) >= CONSOLE_MIN_LEVEL) \
+		{ \
+			static CONST UINT TraceFormat = Console::RegisterTrace((Level), (Format)); \
+			Console::Trace(TraceFormat, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
 class Console
 {
+public:
+	enum Level : uint8_t
+	{
+		LEVEL_DEBUG = 0,
+		LEVEL_INFO = 1,
+		LEVEL_WARNING = 2,
+		LEVEL_ERROR = 3
+	};
+
 public:
 	static BOOL Initialize(VOID);
 	static VOID Uninitialize(VOID);
 
+	// Formats on the calling thread and returns, a background thread writes the message to the sinks
 	static BOOL Write(LPCCH Msg, ...);
+	static BOOL WriteLevel(Level eLevel, LPCCH Msg, ...);
+
+	// Blocks until every message written so far has reached the sinks
+	static VOID Flush(VOID);
+
+	// Messages below eMinLevel are left out of standard output, LEVEL_INFO by default
+	static VOID SetMinLevel(Level eMinLevel);
+
+	static BOOL OpenLogFile(LPCSTR pPath, Level eMinLevel);
+
+	// Copies the most recent output of messages at eMinLevel or above, oldest first, and returns the number of
+	// characters copied
+	static SIZE_T GetRecentOutput(PCHAR pBuffer, SIZE_T BufferSize, Level eMinLevel);
+
+	// Maps a trace file with a ring of about RingSize bytes, the oldest events are overwritten when it wraps.
+	// Events traced while no file is open are discarded.
+	static BOOL OpenTrace(LPCSTR pPath, SIZE_T RingSize);
+	static VOID CloseTrace(VOID);
+
+	static UINT RegisterTrace(Level eLevel, LPCCH Format);
+	static VOID WriteTrace(UINT Format, UINT nArguments, CONST UINT64* pArguments);
+
+	template <typename... Arguments>
+	static VOID Trace(UINT Format, Arguments... Args)
+	{
+		CONST UINT64 Words[] = { TraceArgument(Args)..., 0 };
+		WriteTrace(Format, sizeof...(Args), Words);
+	}
+
+private:
+	template <typename Type>
+	static UINT64 TraceArgument(Type Value)
+	{
+		static_assert(std::is_integral<Type>::value || std::is_enum<Type>::value, "Trace arguments must be numbers or pointers");
+		return static_cast<UINT64>(static_cast<int64_t>(Value));
+	}
+
+	template <typename Type>
+	static UINT64 TraceArgument(Type* pValue)
+	{
+		static_assert(!std::is_same<typename std::remove_cv<Type>::type, CHAR>::value, "Strings cannot be traced, put the text in the format");
+		return static_cast<UINT64>(reinterpret_cast<uintptr_t>(pValue));
+	}
+
+	static UINT64 TraceArgument(double Value)
+	{
+		UINT64 Bits = 0;
+		memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	static UINT64 TraceArgument(FLOAT Value)
+	{
+		return TraceArgument(static_cast<double>(Value));
+	}
 };
 
-#endif // CONSOLE_HPP
\ No newline at end of file
+#endif // CONSOLE_HPP
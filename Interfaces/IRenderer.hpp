@@ -6,11 +6,34 @@
 class IRenderer
 {
 public:
-	static IRenderer* Create(HWND hWND, ULONG Width, ULONG Height);
+	enum RendererType : uint8_t
+	{
+		D3D12 = 0,
+		SOFTWARE = 1
+	};
+
+	// GPU time of one pass over the most recent frames, in milliseconds
+	struct PassTiming
+	{
+		LPCSTR pName;
+		FLOAT  MinMs;
+		FLOAT  AvgMs;
+		FLOAT  MaxMs;
+		UINT   Samples;
+	};
+
+public:
+	static IRenderer* Create(RendererType Type, HWND hWND, ULONG Width, ULONG Height);
 	static VOID		  Destroy(IRenderer* pRenderer);
 
 public:
-	virtual BOOL	  Render(VOID) = 0;
+	virtual ~IRenderer() { }
+
+	virtual RendererType GetType(VOID) = 0;
+	virtual BOOL		 Render(VOID) = 0;
+
+	virtual UINT		 GetPassCount(VOID) = 0;
+	virtual BOOL		 GetPassTiming(UINT Pass, PassTiming& rTiming) = 0;
 };
 
-#endif // IRENDERER_HPP
\ No newline at end of file
+#endif // IRENDERER_HPP
@@ -0,0 +1,69 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <atomic>
+
+#include "Defines.hpp"
+
+class Jobs
+{
+public:
+	typedef VOID (*JobFunction)(PVOID pData);
+
+	// Handles the items First to First + Count - 1, which make up chunk Chunk
+	typedef VOID (*RangeFunction)(PVOID pData, UINT Chunk, UINT First, UINT Count);
+
+	enum Affinity : uint8_t
+	{
+		ANY_THREAD = 0,
+		MAIN_THREAD = 1
+	};
+
+	enum : UINT { InvalidThreadIndex = 0xFFFFFFFF };
+
+	// Counts the unfinished jobs that were started with it. Jobs queued with RunAfter are released when it
+	// reaches zero. A counter may be reused once Wait on it has returned.
+	class Counter
+	{
+	private:
+		friend class CJobSystem;
+
+		std::atomic<UINT>  m_Pending;
+		std::atomic<PVOID> m_pWaiting;
+		std::atomic<UINT>  m_nReleasing;
+
+	public:
+		Counter();
+
+		UINT GetPending(VOID);
+	};
+
+public:
+	// nWorkers = 0 starts one worker per remaining hardware thread, the calling thread becomes the main thread
+	static BOOL Initialize(UINT nWorkers);
+	static VOID Uninitialize(VOID);
+
+	static BOOL Run(JobFunction pFunction, PVOID pData, Counter* pCounter);
+	static BOOL RunOnMainThread(JobFunction pFunction, PVOID pData, Counter* pCounter);
+	static BOOL RunAfter(Counter* pDependency, Affinity eAffinity, JobFunction pFunction, PVOID pData, Counter* pCounter);
+
+	// Executes other jobs while waiting, on the main thread that includes main thread jobs
+	static VOID Wait(Counter* pCounter);
+
+	// Splits nItems into nChunks contiguous chunks and calls pFunction once per chunk. The calling thread claims chunks
+	// along with the workers and returns once every chunk is done. Chunks are empty when there are fewer items.
+	static VOID ParallelFor(UINT nItems, UINT nChunks, RangeFunction pFunction, PVOID pData);
+
+	// The items of chunk Chunk when ParallelFor splits nItems into nChunks, sizes differ by at most one item
+	static VOID GetChunk(UINT nItems, UINT nChunks, UINT Chunk, UINT& rFirst, UINT& rCount);
+
+	// Executes the jobs queued for the main thread, called once per main loop iteration
+	static VOID PumpMainThread(VOID);
+
+	static UINT GetWorkerCount(VOID);
+
+	// 0 on the main thread, 1 to GetWorkerCount() on workers and InvalidThreadIndex on any other thread
+	static UINT GetThreadIndex(VOID);
+};
+
+#endif // JOBS_HPP
@@ -5,12 +5,39 @@
 
 class Memory
 {
+public:
+	struct Statistics
+	{
+		SIZE_T BlockSize;
+		UINT64 Hits;
+		UINT64 Misses;
+	};
+
+	struct FrameStatistics
+	{
+		SIZE_T Capacity;
+		SIZE_T LastFrameUsed;
+		SIZE_T HighWaterMark;
+	};
+
 public:
 	static BOOL  Initialize(VOID);
 	static VOID  Uninitialize(VOID);
 
 	static PVOID Allocate(SIZE_T nBytes, BOOL bClear);
 	static BOOL  Free(PVOID pMemory);
+
+	static BOOL  CreateFrameArenas(UINT nArenas, SIZE_T nBytesPerArena);
+	static VOID  DestroyFrameArenas(VOID);
+
+	static VOID  BeginFrame(UINT FrameIndex);
+	static PVOID AllocateFrame(SIZE_T nBytes, SIZE_T Alignment);
+	static VOID  EndFrame(VOID);
+
+	static UINT  GetSizeClassCount(VOID);
+	static BOOL  GetStatistics(UINT SizeClass, Statistics& rStatistics);
+	static BOOL  GetFrameStatistics(FrameStatistics& rStatistics);
+	static VOID  ReportStatistics(VOID);
 };
 
-#endif // MEMORY_HPP
\ No newline at end of file
+#endif // MEMORY_HPP
@@ -0,0 +1,79 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "Defines.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86)
+	#include <intrin.h>
+	#define PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define PROFILER_RDTSC 1
+#else
+	#include <chrono>
+	#define PROFILER_RDTSC 0
+#endif
+
+// With PROFILER_ENABLED set to 0 the zone macros expand to nothing
+#ifndef PROFILER_ENABLED
+	#define PROFILER_ENABLED 1
+#endif
+
+#define PROFILER_CONCAT_INNER(A, B) A##B
+#define PROFILER_CONCAT(A, B) PROFILER_CONCAT_INNER(A, B)
+
+#if PROFILER_ENABLED
+	#define PROFILE_ZONE(Name) Profiler::Zone PROFILER_CONCAT(ProfileZone, __LINE__)(Name)
+	#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#else
+	#define PROFILE_ZONE(Name)
+	#define PROFILE_FUNCTION()
+#endif
+
+class Profiler
+{
+public:
+	// Times the scope it lives in, zones opened inside it show up nested below it. Name must outlive the profiler.
+	class Zone
+	{
+	private:
+		LPCSTR m_pName;
+		UINT64 m_Start;
+
+	public:
+		Zone(LPCSTR pName)
+		{
+			m_pName = pName;
+			m_Start = Profiler::GetTimestamp();
+		}
+
+		~Zone()
+		{
+			Profiler::RecordZone(m_pName, m_Start, Profiler::GetTimestamp());
+		}
+	};
+
+public:
+	static BOOL Initialize(VOID);
+	static VOID Uninitialize(VOID);
+
+	// Shown as the thread's name in the exported trace, the text is copied
+	static VOID SetThreadName(LPCSTR pName);
+
+	static inline UINT64 GetTimestamp(VOID)
+	{
+#if PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return static_cast<UINT64>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	static VOID RecordZone(LPCSTR pName, UINT64 Start, UINT64 End);
+
+	// Writes every zone still held in the per-thread buffers as Chrome trace_event JSON. Threads that are still
+	// recording keep running, zones they overwrite while the export reads them are left out.
+	static BOOL ExportChromeTrace(LPCSTR pPath);
+};
+
+#endif // PROFILER_HPP
@@ -1,10 +1,23 @@
 
+#ifndef LIT
+#define LIT 0
+#endif
+
 struct PS_Input
 {
     float4 vertex : SV_POSITION;
     float3 color  : COLOR;
+#if LIT
+    float3 normal : NORMAL;
+#endif
 };
 
+#if LIT
+// A fixed directional light in world space, pointing towards the light
+static const float3 LightDirection = normalize(float3(0.3, 0.8, -0.5));
+static const float Ambient = 0.25;
+#endif
+
 struct PS_Output
 {
     float4 color : SV_TARGET;
@@ -15,6 +28,9 @@ PS_Output main(PS_Input input)
     PS_Output Output;
 
     Output.color.rgb = input.color;
+#if LIT
+    Output.color.rgb *= Ambient + (1 - Ambient) * saturate(dot(normalize(input.normal), LightDirection));
+#endif
     Output.color.a = 1;
     return Output;
 }
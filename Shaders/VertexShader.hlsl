@@ -1,22 +1,110 @@
+#ifndef INSTANCED
+#define INSTANCED 0
+#endif
 
+#ifndef QUANTIZED_VERTICES
+#define QUANTIZED_VERTICES 0
+#endif
+
+#ifndef LIT
+#define LIT 0
+#endif
+
+#if LIT && !QUANTIZED_VERTICES
+#error Lighting needs the normals of quantized vertices
+#endif
+
+// Root constants, every draw sets its own. Without instancing they hold the draw's whole transform.
+cbuffer RootConstants : register(b0)
+{
+    row_major float4x4 ViewProjection;
+};
+
+// Read from the frame's constant buffer. CRenderer packs it through a CConstantLayout built in the same order, so the
+// two have to change together. The bounds are only read for quantized vertices.
+cbuffer DrawConstants : register(b1)
+{
+    float3 BoundsMin;
+    float3 BoundsExtent;
+};
+
+#if QUANTIZED_VERTICES
+struct VS_Input
+{
+    float4 vertex : POSITION;
+    float2 normal : NORMAL;
+    float4 color  : COLOR;
+};
+#else
 struct VS_Input
 {
     float3 vertex : POSITION;
     float3 color  : COLOR;
 };
+#endif
+
+// Matches InstanceData in CInstanceBuilder.hpp, read from input slot 1. world0 to world2 are the columns of the world
+// matrix and tint.a is how far the colour is pulled towards tint.rgb.
+struct VS_Instance
+{
+    float4 world0 : WORLD0;
+    float4 world1 : WORLD1;
+    float4 world2 : WORLD2;
+    float4 tint   : TINT;
+};
 
 struct VS_Output
 {
     float4 vertex : SV_POSITION;
     float3 color  : COLOR;
+#if LIT
+    float3 normal : NORMAL;
+#endif
 };
 
+#if LIT
+// Inverse of CVertexQuantizer::EncodeOctahedral
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded.xy, 1 - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-normal.z);
+    normal.xy += (normal.xy >= 0) ? -t : t;
+    return normalize(normal);
+}
+#endif
+
+#if INSTANCED
+VS_Output main(VS_Input input, VS_Instance instance)
+#else
 VS_Output main(VS_Input input)
+#endif
 {
     VS_Output output;
-    output.vertex.xyz = input.vertex;
-    output.vertex.w = 1;
+#if QUANTIZED_VERTICES
+    float3 position = BoundsMin + input.vertex.xyz * BoundsExtent;
+    output.color = input.color.rgb;
+#else
+    float3 position = input.vertex;
     output.color = input.color;
+#endif
+#if LIT
+    float3 normal = DecodeOctahedral(input.normal);
+#endif
+#if INSTANCED
+    float4 local = float4(position, 1);
+    float3 world = float3(dot(instance.world0, local), dot(instance.world1, local), dot(instance.world2, local));
+
+    output.color = lerp(output.color, instance.tint.rgb, instance.tint.a);
+#if LIT
+    normal = float3(dot(instance.world0.xyz, normal), dot(instance.world1.xyz, normal), dot(instance.world2.xyz, normal));
+#endif
+#else
+    float3 world = position;
+#endif
+#if LIT
+    output.normal = normal;
+#endif
+    output.vertex = mul(float4(world, 1), ViewProjection);
 
     return output;
 }
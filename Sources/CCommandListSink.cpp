@@ -0,0 +1,162 @@
+#include "CCommandListSink.hpp"
+
+#include "Console.hpp"
+
+CCommandListSink::CCommandListSink()
+{
+	for (UINT i = 0; i < CFrameScheduler::MaxFramesInFlight; i++)
+	{
+		m_pICommandAllocators[i] = NULL;
+	}
+
+	m_pICommandList = NULL;
+	m_nFrames = 0;
+	m_Slot = 0;
+	m_pState = NULL;
+	m_pIPipelineState = NULL;
+}
+
+CCommandListSink::~CCommandListSink()
+{
+	Uninitialize();
+}
+
+BOOL CCommandListSink::Initialize(ID3D12Device* pIDevice, UINT nFramesInFlight)
+{
+	BOOL Status = ((nFramesInFlight != 0) && (nFramesInFlight <= CFrameScheduler::MaxFramesInFlight)) ? TRUE : FALSE;
+
+	m_nFrames = nFramesInFlight;
+
+	for (UINT i = 0; (Status == TRUE) && (i < nFramesInFlight); i++)
+	{
+		if (pIDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator), reinterpret_cast<VOID**>(&m_pICommandAllocators[i])) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create recording command allocator %u\n", i);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		if (pIDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_pICommandAllocators[0], NULL, __uuidof(ID3D12GraphicsCommandList), reinterpret_cast<VOID**>(&m_pICommandList)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create recording command list\n");
+		}
+	}
+
+	// Lists are created open, Begin expects it closed
+	if ((Status == TRUE) && (m_pICommandList->Close() != S_OK))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not close recording command list\n");
+	}
+
+	return Status;
+}
+
+VOID CCommandListSink::Uninitialize(VOID)
+{
+	if (m_pICommandList != NULL)
+	{
+		m_pICommandList->Release();
+		m_pICommandList = NULL;
+	}
+
+	for (UINT i = 0; i < CFrameScheduler::MaxFramesInFlight; i++)
+	{
+		if (m_pICommandAllocators[i] != NULL)
+		{
+			m_pICommandAllocators[i]->Release();
+			m_pICommandAllocators[i] = NULL;
+		}
+	}
+
+	m_nFrames = 0;
+	m_pState = NULL;
+}
+
+VOID CCommandListSink::SetFrame(UINT Slot, CONST PassState* pState)
+{
+	m_Slot = Slot % ((m_nFrames != 0) ? m_nFrames : 1);
+	m_pState = pState;
+}
+
+ID3D12CommandList* CCommandListSink::GetCommandList(VOID)
+{
+	return m_pICommandList;
+}
+
+BOOL CCommandListSink::Begin(VOID)
+{
+	BOOL Status = ((m_pICommandList != NULL) && (m_pState != NULL)) ? TRUE : FALSE;
+
+	// The caller has already waited for the frame that last used this slot
+	if ((Status == TRUE) && (m_pICommandAllocators[m_Slot]->Reset() != S_OK))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to reset recording command allocator\n");
+	}
+
+	// Every draw names its pipeline, the first one sets it
+	if ((Status == TRUE) && (m_pICommandList->Reset(m_pICommandAllocators[m_Slot], NULL) != S_OK))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to reset recording command list\n");
+	}
+
+	m_pIPipelineState = NULL;
+
+	if (Status == TRUE)
+	{
+		// Slot 0 holds the mesh's vertices, slot 1 the instances
+		CONST D3D12_VERTEX_BUFFER_VIEW VertexBufferViews[] = { m_pState->VertexBufferView, m_pState->InstanceBufferView };
+
+		m_pICommandList->SetGraphicsRootSignature(m_pState->pIRootSignature);
+		m_pICommandList->RSSetViewports(1, &m_pState->Viewport);
+		m_pICommandList->RSSetScissorRects(1, &m_pState->ScissorRect);
+		m_pICommandList->OMSetRenderTargets(1, &m_pState->RenderTarget, FALSE, &m_pState->DepthStencil);
+		m_pICommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		m_pICommandList->IASetVertexBuffers(0, _countof(VertexBufferViews), VertexBufferViews);
+		m_pICommandList->IASetIndexBuffer(&m_pState->IndexBufferView);
+	}
+
+	return Status;
+}
+
+VOID CCommandListSink::Draw(CONST DrawCommand& rDraw)
+{
+	CONSOLE_TRACE(Console::LEVEL_INFO, "Draw %u indices from %u, %u instances", rDraw.IndexCount, rDraw.StartIndex, rDraw.InstanceCount);
+
+	if ((rDraw.pPipeline != NULL) && (rDraw.pPipeline != m_pIPipelineState))
+	{
+		m_pIPipelineState = reinterpret_cast<ID3D12PipelineState*>(rDraw.pPipeline);
+		m_pICommandList->SetPipelineState(m_pIPipelineState);
+	}
+
+	// Root parameter 0 holds the root constants and 1 the constant buffer view, as laid out by CRenderer
+	if (rDraw.pConstants != NULL)
+	{
+		m_pICommandList->SetGraphicsRoot32BitConstants(0, rDraw.nConstants, rDraw.pConstants, 0);
+	}
+
+	if (rDraw.ConstantBufferAddress != 0)
+	{
+		m_pICommandList->SetGraphicsRootConstantBufferView(1, rDraw.ConstantBufferAddress);
+	}
+
+	m_pICommandList->DrawIndexedInstanced(rDraw.IndexCount, rDraw.InstanceCount, rDraw.StartIndex, rDraw.BaseVertex, rDraw.StartInstance);
+}
+
+BOOL CCommandListSink::End(VOID)
+{
+	BOOL Status = TRUE;
+
+	if (m_pICommandList->Close() != S_OK)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not finalize recording command list\n");
+	}
+
+	return Status;
+}
@@ -0,0 +1,50 @@
+#ifndef CCOMMANDLISTSINK_HPP
+#define CCOMMANDLISTSINK_HPP
+
+#include <d3d12.h>
+
+#include "CFrameScheduler.hpp"
+#include "ICommandSink.hpp"
+
+// Records draws into a D3D12 command list with one allocator per frame in flight. A draw's pipeline is an
+// ID3D12PipelineState.
+class CCommandListSink : public ICommandSink
+{
+public:
+	// Everything a list needs before it can draw, shared by all sinks for a frame
+	struct PassState
+	{
+		ID3D12RootSignature*		pIRootSignature;
+		D3D12_VIEWPORT				Viewport;
+		D3D12_RECT					ScissorRect;
+		D3D12_CPU_DESCRIPTOR_HANDLE RenderTarget;
+		D3D12_CPU_DESCRIPTOR_HANDLE DepthStencil;
+		D3D12_VERTEX_BUFFER_VIEW	VertexBufferView;
+		D3D12_VERTEX_BUFFER_VIEW	InstanceBufferView;
+		D3D12_INDEX_BUFFER_VIEW		IndexBufferView;
+	};
+
+protected:
+	ID3D12CommandAllocator*	   m_pICommandAllocators[CFrameScheduler::MaxFramesInFlight];
+	ID3D12GraphicsCommandList* m_pICommandList;
+	UINT					   m_nFrames;
+	UINT					   m_Slot;
+	CONST PassState*		   m_pState;
+	ID3D12PipelineState*	   m_pIPipelineState;
+
+public:
+	CCommandListSink();
+	~CCommandListSink();
+
+	BOOL Initialize(ID3D12Device* pIDevice, UINT nFramesInFlight);
+	VOID Uninitialize(VOID);
+
+	VOID SetFrame(UINT Slot, CONST PassState* pState);
+	ID3D12CommandList* GetCommandList(VOID);
+
+	virtual BOOL Begin(VOID);
+	virtual VOID Draw(CONST DrawCommand& rDraw);
+	virtual BOOL End(VOID);
+};
+
+#endif // CCOMMANDLISTSINK_HPP
@@ -0,0 +1,75 @@
+#include "CCommandRecorder.hpp"
+
+#include "Console.hpp"
+#include "Jobs.hpp"
+#include "Profiler.hpp"
+
+CCommandRecorder::CCommandRecorder()
+{
+	m_pDraws = NULL;
+	m_ppSinks = NULL;
+	m_bFailed = FALSE;
+}
+
+CCommandRecorder::~CCommandRecorder()
+{
+}
+
+VOID CCommandRecorder::RecordChunk(PVOID pData, UINT Chunk, UINT First, UINT Count)
+{
+	PROFILE_FUNCTION();
+
+	CCommandRecorder* pRecorder = reinterpret_cast<CCommandRecorder*>(pData);
+	ICommandSink* pSink = pRecorder->m_ppSinks[Chunk];
+
+	if (pSink->Begin() == TRUE)
+	{
+		for (UINT i = 0; i < Count; i++)
+		{
+			pSink->Draw(pRecorder->m_pDraws[First + i]);
+		}
+
+		if (pSink->End() != TRUE)
+		{
+			pRecorder->m_bFailed = TRUE;
+		}
+	}
+	else
+	{
+		pRecorder->m_bFailed = TRUE;
+	}
+}
+
+BOOL CCommandRecorder::Record(CONST DrawCommand* pDraws, UINT nDraws, ICommandSink** ppSinks, UINT nSinks, UINT& rSinksUsed)
+{
+	BOOL Status = ((ppSinks != NULL) && (nSinks != 0) && (nSinks <= MaxSinks) && ((pDraws != NULL) || (nDraws == 0))) ? TRUE : FALSE;
+
+	rSinksUsed = 0;
+
+	if (Status == TRUE)
+	{
+		// Small batches are not worth waking other threads for
+		UINT nChunks = (nDraws + MinDrawsPerChunk - 1) / MinDrawsPerChunk;
+		nChunks = (nChunks < nSinks) ? nChunks : nSinks;
+		nChunks = (nChunks < 1) ? 1 : nChunks;
+
+		m_pDraws = pDraws;
+		m_ppSinks = ppSinks;
+		m_bFailed = FALSE;
+
+		// Chunk i goes to sink i
+		Jobs::ParallelFor(nDraws, nChunks, RecordChunk, this);
+
+		if (m_bFailed == TRUE)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to record %u draws into %u command sinks\n", nDraws, nChunks);
+		}
+		else
+		{
+			rSinksUsed = nChunks;
+		}
+	}
+
+	return Status;
+}
@@ -0,0 +1,32 @@
+#ifndef CCOMMANDRECORDER_HPP
+#define CCOMMANDRECORDER_HPP
+
+#include <atomic>
+
+#include "Defines.hpp"
+
+#include "ICommandSink.hpp"
+
+// Records a list of draws into several sinks in parallel on the job system. The draws are split into contiguous
+// chunks and chunk i always goes to sink i, so executing the sinks in order reproduces the original draw order.
+class CCommandRecorder
+{
+public:
+	enum { MaxSinks = 32, MinDrawsPerChunk = 16 };
+
+protected:
+	CONST DrawCommand* m_pDraws;
+	ICommandSink**	   m_ppSinks;
+	std::atomic<BOOL>  m_bFailed;
+
+	static VOID RecordChunk(PVOID pData, UINT Chunk, UINT First, UINT Count);
+
+public:
+	CCommandRecorder();
+	~CCommandRecorder();
+
+	// Returns the number of sinks that were used, they have to be submitted in order. The calling thread records too.
+	BOOL Record(CONST DrawCommand* pDraws, UINT nDraws, ICommandSink** ppSinks, UINT nSinks, UINT& rSinksUsed);
+};
+
+#endif // CCOMMANDRECORDER_HPP
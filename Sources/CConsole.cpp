@@ -1,12 +1,8 @@
 #include "Console.hpp"
 #include "CConsole.hpp"
 
-#include <cstdarg>
-
-#include <windows.h>
-#include <strsafe.h>
-
-#include "Memory.hpp"
+#include <chrono>
+#include <cstdio>
 
 CConsole g_Console;
 
@@ -27,37 +23,94 @@ BOOL Console::Write(LPCCH Msg, ...)
 	va_list Args;
 	va_start(Args, Msg);
 
-	Status = g_Console.Write(Msg, Args);
+	Status = g_Console.Write(LEVEL_INFO, Msg, Args);
 
 	va_end(Args);
 
 	return Status;
 }
 
+BOOL Console::WriteLevel(Level eLevel, LPCCH Msg, ...)
+{
+	BOOL Status = TRUE;
+
+	va_list Args;
+	va_start(Args, Msg);
+
+	Status = g_Console.Write(eLevel, Msg, Args);
+
+	va_end(Args);
+
+	return Status;
+}
+
+VOID Console::Flush(VOID)
+{
+	g_Console.Flush();
+}
+
+VOID Console::SetMinLevel(Level eMinLevel)
+{
+	g_Console.SetMinLevel(eMinLevel);
+}
+
+BOOL Console::OpenLogFile(LPCSTR pPath, Level eMinLevel)
+{
+	return g_Console.OpenLogFile(pPath, eMinLevel);
+}
+
+SIZE_T Console::GetRecentOutput(PCHAR pBuffer, SIZE_T BufferSize, Level eMinLevel)
+{
+	return g_Console.GetRecentOutput(pBuffer, BufferSize, eMinLevel);
+}
+
+BOOL Console::OpenTrace(LPCSTR pPath, SIZE_T RingSize)
+{
+	return g_Console.OpenTrace(pPath, RingSize);
+}
+
+VOID Console::CloseTrace(VOID)
+{
+	g_Console.CloseTrace();
+}
+
+UINT Console::RegisterTrace(Level eLevel, LPCCH Format)
+{
+	return g_Console.RegisterTrace(eLevel, Format);
+}
+
+VOID Console::WriteTrace(UINT Format, UINT nArguments, CONST UINT64* pArguments)
+{
+	g_Console.WriteTrace(Format, nArguments, pArguments);
+}
+
 CConsole::CConsole()
 {
-	m_hStdOut = NULL;;
-	m_pBuffer = NULL;
+	m_bRunning = FALSE;
+	m_bWriterWaiting = FALSE;
+	m_nWriting = 0;
 }
 
 CConsole::~CConsole()
 {
+	Uninitialize();
 }
 
 BOOL CConsole::Initialize(VOID)
 {
-	BOOL  Status = TRUE;
+	BOOL Status = TRUE;
 
-	m_hStdOut = GetStdHandle(STD_OUTPUT_HANDLE);
+	Status = m_StdOutSink.Initialize();
 
-	if ((m_hStdOut == NULL) || (m_hStdOut == INVALID_HANDLE_VALUE))
+	if (Status == TRUE)
 	{
-		Status = FALSE;
+		Status = m_Queue.Initialize();
 	}
 
 	if (Status == TRUE)
 	{
-		m_pBuffer = reinterpret_cast<PCHAR>(Memory::Allocate(MaxLength, TRUE));
+		m_bRunning = TRUE;
+		m_Writer = std::thread(&CConsole::WriterMain, this);
 	}
 
 	return Status;
@@ -65,40 +118,213 @@ BOOL CConsole::Initialize(VOID)
 
 VOID CConsole::Uninitialize(VOID)
 {
-	m_hStdOut = NULL;
+	if (m_Writer.joinable() == true)
+	{
+		// Producers that saw m_bRunning before it was cleared still publish, wait for them so the writer drains their
+		// records and none can reach the queue after it is freed
+		m_bRunning = FALSE;
+
+		while (m_nWriting != 0)
+		{
+			std::this_thread::yield();
+		}
+
+		// The writer drains everything that is left before it exits
+		WakeWriter();
+
+		m_Writer.join();
+	}
+
+	m_Trace.Close();
+	m_FileSink.Close();
+	m_Queue.Uninitialize();
+}
+
+VOID CConsole::WriteSinks(uint8_t Level, LPCSTR pText, SIZE_T Length)
+{
+	m_StdOutSink.Write(Level, pText, Length);
+	m_FileSink.Write(Level, pText, Length);
+	m_RingSink.Write(Level, pText, Length);
+}
+
+VOID CConsole::WakeWriter(VOID)
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_WakeLock);
+	}
 
-	if (m_pBuffer != NULL)
+	m_WakeUp.notify_one();
+}
+
+VOID CConsole::WriterMain(VOID)
+{
+	while (TRUE)
 	{
-		Memory::Free(m_pBuffer);
-		m_pBuffer = NULL;
+		{
+			std::lock_guard<std::mutex> Lock(m_SinkLock);
+
+			for (CLogQueue::Record* pRecord = m_Queue.Peek(); pRecord != NULL; pRecord = m_Queue.Peek())
+			{
+				WriteSinks(pRecord->Level, pRecord->Text, pRecord->Length);
+				m_Queue.Pop();
+			}
+
+			UINT64 nDropped = m_Queue.TakeDropped();
+
+			if (nDropped != 0)
+			{
+				CHAR Text[64] = { };
+				INT Length = snprintf(Text, sizeof(Text), "Warning: %llu log messages were dropped\n", nDropped);
+
+				WriteSinks(Console::LEVEL_WARNING, Text, static_cast<SIZE_T>(Length));
+			}
+
+			m_StdOutSink.Flush();
+			m_FileSink.Flush();
+		}
+
+		m_Drained.notify_all();
+
+		std::unique_lock<std::mutex> Lock(m_WakeLock);
+
+		if ((m_bRunning == FALSE) && (m_Queue.IsEmpty() == TRUE))
+		{
+			break;
+		}
+
+		// Producers only signal while the writer is waiting, the timeout covers a signal that raced with this check
+		m_bWriterWaiting = TRUE;
+
+		if (m_Queue.IsEmpty() == TRUE)
+		{
+			m_WakeUp.wait_for(Lock, std::chrono::milliseconds(IdleWaitMs));
+		}
+
+		m_bWriterWaiting = FALSE;
 	}
 }
 
-BOOL CConsole::Write(LPCCH Msg, va_list Args)
+BOOL CConsole::Write(uint8_t Level, LPCCH Msg, va_list Args)
 {
 	BOOL Status = TRUE;
-	SIZE_T CharsFree = 0;
-	SIZE_T CharsUsed = 0;
-	DWORD  CharsWritten = 0;
 
-	if (StringCchVPrintfEx(m_pBuffer, MaxLength, NULL, &CharsFree, 0, Msg, Args) == S_OK)
+	// Counted before the check, so Uninitialize either sees this producer or this producer sees m_bRunning cleared
+	m_nWriting++;
+
+	if (m_bRunning == TRUE)
 	{
-		CharsUsed = MaxLength - CharsFree;
+		CLogQueue::Record* pRecord = m_Queue.Acquire();
+
+		if (pRecord != NULL)
+		{
+			INT Length = vsnprintf(pRecord->Text, MaxLength, Msg, Args);
+
+			// Messages longer than a record are truncated
+			pRecord->Length = (Length < 0) ? 0 : ((Length >= MaxLength) ? (MaxLength - 1) : static_cast<UINT>(Length));
+			pRecord->Level = Level;
+
+			m_Queue.Publish(pRecord);
+
+			if (m_bWriterWaiting == TRUE)
+			{
+				WakeWriter();
+			}
+		}
+		else
+		{
+			Status = FALSE;
+		}
+
+		m_nWriting--;
 	}
 	else
 	{
-		Status = FALSE;
+		m_nWriting--;
+
+		// Before Initialize and after Uninitialize there is no writer thread, write on the caller's thread
+		CHAR Text[MaxLength] = { };
+		INT Length = vsnprintf(Text, MaxLength, Msg, Args);
+
+		Length = (Length < 0) ? 0 : ((Length >= MaxLength) ? (MaxLength - 1) : Length);
+
+		std::lock_guard<std::mutex> Lock(m_SinkLock);
+
+		if (m_StdOutSink.Initialize() == TRUE)
+		{
+			m_StdOutSink.Write(Level, Text, static_cast<SIZE_T>(Length));
+			m_StdOutSink.Flush();
+		}
+
+		m_RingSink.Write(Level, Text, static_cast<SIZE_T>(Length));
 	}
 
-	if (Status == TRUE)
+	return Status;
+}
+
+VOID CConsole::Flush(VOID)
+{
+	UINT64 Target = m_Queue.GetEnqueued();
+
+	while ((m_bRunning == TRUE) && (m_Queue.GetDequeued() < Target))
 	{
-		Status = WriteConsole(m_hStdOut, m_pBuffer, CharsUsed, &CharsWritten, NULL);
+		WakeWriter();
+
+		std::unique_lock<std::mutex> Lock(m_SinkLock);
+		m_Drained.wait_for(Lock, std::chrono::milliseconds(IdleWaitMs));
 	}
+}
+
+VOID CConsole::SetMinLevel(uint8_t MinLevel)
+{
+	// Messages already queued are filtered at the new level
+	std::lock_guard<std::mutex> Lock(m_SinkLock);
+	m_StdOutSink.SetMinLevel(MinLevel);
+}
+
+BOOL CConsole::OpenLogFile(LPCSTR pPath, uint8_t MinLevel)
+{
+	BOOL Status = TRUE;
+
+	// Everything written before the file was opened only goes to the other sinks
+	Flush();
 
-	if (Status == TRUE)
 	{
-		Status = (CharsWritten == CharsUsed) ? TRUE : FALSE;
+		std::lock_guard<std::mutex> Lock(m_SinkLock);
+		Status = m_FileSink.Open(pPath, MinLevel);
+	}
+
+	if (Status != TRUE)
+	{
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open log file %s\n", pPath);
 	}
 
 	return Status;
 }
+
+SIZE_T CConsole::GetRecentOutput(PCHAR pBuffer, SIZE_T BufferSize, uint8_t MinLevel)
+{
+	// Only output that has been drained is visible, flush first so recent writes are included
+	Flush();
+
+	return m_RingSink.Copy(pBuffer, BufferSize, MinLevel);
+}
+
+BOOL CConsole::OpenTrace(LPCSTR pPath, SIZE_T RingSize)
+{
+	return m_Trace.Open(pPath, RingSize);
+}
+
+VOID CConsole::CloseTrace(VOID)
+{
+	m_Trace.Close();
+}
+
+UINT CConsole::RegisterTrace(uint8_t Level, LPCCH Format)
+{
+	return m_Trace.RegisterFormat(Level, Format);
+}
+
+VOID CConsole::WriteTrace(UINT Format, UINT nArguments, CONST UINT64* pArguments)
+{
+	m_Trace.Write(Format, nArguments, pArguments);
+}
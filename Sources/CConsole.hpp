@@ -1,15 +1,47 @@
 #ifndef CCONSOLE_HPP
 #define CCONSOLE_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <mutex>
+#include <thread>
+
 #include "Defines.hpp"
 
+#include "CLogQueue.hpp"
+#include "CLogSinks.hpp"
+#include "CTraceLog.hpp"
+
 class CConsole
 {
 private:
-	enum { MaxLength = 1024 };
+	enum { MaxLength = CLogQueue::MaxLength, IdleWaitMs = 10 };
+
+	CLogQueue				m_Queue;
+
+	CStdOutLogSink			m_StdOutSink;
+	CFileLogSink			m_FileSink;
+	CRingLogSink			m_RingSink;
+
+	// Held by the writer while it drains, and by anyone changing the sinks or writing synchronously
+	std::mutex				m_SinkLock;
 
-	HANDLE m_hStdOut;
-	PCHAR  m_pBuffer;
+	std::thread				m_Writer;
+	std::mutex				m_WakeLock;
+	std::condition_variable m_WakeUp;
+	std::condition_variable m_Drained;
+	std::atomic<BOOL>		m_bRunning;
+	std::atomic<BOOL>		m_bWriterWaiting;
+
+	// Producers between their m_bRunning check and Publish, Uninitialize waits for them before the queue goes away
+	std::atomic<UINT>		m_nWriting;
+
+	CTraceLog				m_Trace;
+
+	VOID WriteSinks(uint8_t Level, LPCSTR pText, SIZE_T Length);
+	VOID WriterMain(VOID);
+	VOID WakeWriter(VOID);
 
 public:
 	CConsole();
@@ -18,7 +50,17 @@ public:
 	BOOL Initialize(VOID);
 	VOID Uninitialize(VOID);
 
-	BOOL Write(LPCCH Msg, va_list Args);
+	BOOL Write(uint8_t Level, LPCCH Msg, va_list Args);
+	VOID Flush(VOID);
+
+	VOID   SetMinLevel(uint8_t MinLevel);
+	BOOL   OpenLogFile(LPCSTR pPath, uint8_t MinLevel);
+	SIZE_T GetRecentOutput(PCHAR pBuffer, SIZE_T BufferSize, uint8_t MinLevel);
+
+	BOOL OpenTrace(LPCSTR pPath, SIZE_T RingSize);
+	VOID CloseTrace(VOID);
+	UINT RegisterTrace(uint8_t Level, LPCCH Format);
+	VOID WriteTrace(UINT Format, UINT nArguments, CONST UINT64* pArguments);
 };
 
-#endif // CCONSOLE_HPP
\ No newline at end of file
+#endif // CCONSOLE_HPP
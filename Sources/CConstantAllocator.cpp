@@ -0,0 +1,86 @@
+#include "CConstantAllocator.hpp"
+
+CConstantAllocator::CConstantAllocator()
+{
+	m_nFrames = 0;
+	m_FrameCapacity = 0;
+	m_Slot = 0;
+	m_Offset = 0;
+}
+
+CConstantAllocator::~CConstantAllocator()
+{
+}
+
+BOOL CConstantAllocator::Initialize(UINT nFramesInFlight, SIZE_T FrameCapacity)
+{
+	BOOL Status = ((nFramesInFlight != 0) && (nFramesInFlight <= MaxFramesInFlight) && (FrameCapacity >= Alignment)) ? TRUE : FALSE;
+
+	Uninitialize();
+
+	if (Status == TRUE)
+	{
+		m_nFrames = nFramesInFlight;
+		m_FrameCapacity = FrameCapacity & ~static_cast<SIZE_T>(Alignment - 1);
+	}
+
+	return Status;
+}
+
+VOID CConstantAllocator::Uninitialize(VOID)
+{
+	m_nFrames = 0;
+	m_FrameCapacity = 0;
+	m_Slot = 0;
+	m_Offset = 0;
+}
+
+VOID CConstantAllocator::BeginFrame(UINT Slot)
+{
+	m_Slot = Slot % ((m_nFrames != 0) ? m_nFrames : 1);
+	m_Offset.store(0, std::memory_order_relaxed);
+}
+
+BOOL CConstantAllocator::Allocate(SIZE_T nBytes, SIZE_T& rOffset)
+{
+	BOOL Status = ((nBytes != 0) && (nBytes <= m_FrameCapacity)) ? TRUE : FALSE;
+	SIZE_T Size = (nBytes + Alignment - 1) & ~static_cast<SIZE_T>(Alignment - 1);
+	SIZE_T Offset = 0;
+
+	// The region start and every size are multiples of the alignment, so a plain add keeps every offset aligned and
+	// lets recording threads allocate concurrently
+	if (Status == TRUE)
+	{
+		Offset = m_Offset.fetch_add(Size, std::memory_order_relaxed);
+
+		if (Offset + Size > m_FrameCapacity)
+		{
+			Status = FALSE;
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		rOffset = m_Slot * m_FrameCapacity + Offset;
+	}
+
+	return Status;
+}
+
+SIZE_T CConstantAllocator::GetCapacity(VOID)
+{
+	return m_nFrames * m_FrameCapacity;
+}
+
+SIZE_T CConstantAllocator::GetFrameCapacity(VOID)
+{
+	return m_FrameCapacity;
+}
+
+SIZE_T CConstantAllocator::GetUsed(VOID)
+{
+	SIZE_T Used = m_Offset.load(std::memory_order_relaxed);
+
+	// Failed allocations still advance the offset
+	return (Used < m_FrameCapacity) ? Used : m_FrameCapacity;
+}
@@ -0,0 +1,40 @@
+#ifndef CCONSTANTALLOCATOR_HPP
+#define CCONSTANTALLOCATOR_HPP
+
+#include <atomic>
+
+#include "Defines.hpp"
+
+// Offset bookkeeping for a persistently mapped upload buffer of constants or instances, it never touches the GPU itself.
+// The buffer is split into one region per frame in flight. BeginFrame rewinds the region of the frame being recorded,
+// which the caller has already waited for, and Allocate bumps through it at constant buffer placement alignment.
+class CConstantAllocator
+{
+public:
+	enum { Alignment = 256, MaxFramesInFlight = 8 };
+
+protected:
+	UINT				m_nFrames;
+	SIZE_T				m_FrameCapacity;
+	UINT				m_Slot;
+	std::atomic<SIZE_T> m_Offset;
+
+public:
+	CConstantAllocator();
+	~CConstantAllocator();
+
+	// FrameCapacity is rounded down to a multiple of Alignment
+	BOOL Initialize(UINT nFramesInFlight, SIZE_T FrameCapacity);
+	VOID Uninitialize(VOID);
+
+	VOID BeginFrame(UINT Slot);
+
+	// rOffset is relative to the start of the whole buffer, fails when the frame's region is full
+	BOOL Allocate(SIZE_T nBytes, SIZE_T& rOffset);
+
+	SIZE_T GetCapacity(VOID);
+	SIZE_T GetFrameCapacity(VOID);
+	SIZE_T GetUsed(VOID);
+};
+
+#endif // CCONSTANTALLOCATOR_HPP
@@ -0,0 +1,123 @@
+#include "CConstantLayout.hpp"
+
+#include <cstring>
+
+CConstantLayout::CConstantLayout()
+{
+	Clear();
+}
+
+CConstantLayout::~CConstantLayout()
+{
+}
+
+VOID CConstantLayout::Clear(VOID)
+{
+	m_Members.clear();
+	m_End = 0;
+}
+
+VOID CConstantLayout::GetDimensions(ConstantType Type, UINT& rRows, UINT& rColumns)
+{
+	static CONST UINT Dimensions[NumConstantTypes][2] =
+	{
+		{ 1, 1 }, // CONSTANT_FLOAT
+		{ 1, 2 }, // CONSTANT_FLOAT2
+		{ 1, 3 }, // CONSTANT_FLOAT3
+		{ 1, 4 }, // CONSTANT_FLOAT4
+		{ 1, 1 }, // CONSTANT_INT
+		{ 1, 4 }, // CONSTANT_INT4
+		{ 1, 1 }, // CONSTANT_UINT
+		{ 1, 4 }, // CONSTANT_UINT4
+		{ 3, 3 }, // CONSTANT_FLOAT3X3
+		{ 4, 3 }, // CONSTANT_FLOAT4X3
+		{ 4, 4 }  // CONSTANT_FLOAT4X4
+	};
+
+	rRows = (Type < NumConstantTypes) ? Dimensions[Type][0] : 0;
+	rColumns = (Type < NumConstantTypes) ? Dimensions[Type][1] : 0;
+}
+
+UINT CConstantLayout::Add(ConstantType Type, UINT nElements)
+{
+	UINT Rows = 0;
+	UINT Columns = 0;
+
+	GetDimensions(Type, Rows, Columns);
+	nElements = (nElements != 0) ? nElements : 1;
+
+	// Every row but the last fills a whole register, and so does every element of an array but the last
+	CONST UINT ElementSize = (Rows - 1) * RegisterSize + Columns * ComponentSize;
+	CONST UINT ElementStride = (ElementSize + RegisterSize - 1) & ~(RegisterSize - 1);
+
+	Member NewMember = { };
+	NewMember.Type = Type;
+	NewMember.nElements = nElements;
+	NewMember.Size = (nElements - 1) * ElementStride + ElementSize;
+	NewMember.Offset = m_End;
+
+	CONST BOOL bStartsRegister = ((Rows > 1) || (nElements > 1)) ? TRUE : FALSE;
+	CONST BOOL bStraddles = (((m_End % RegisterSize) + NewMember.Size) > RegisterSize) ? TRUE : FALSE;
+
+	if ((bStartsRegister == TRUE) || (bStraddles == TRUE))
+	{
+		NewMember.Offset = (m_End + RegisterSize - 1) & ~(RegisterSize - 1);
+	}
+
+	m_End = NewMember.Offset + NewMember.Size;
+	m_Members.push_back(NewMember);
+
+	return static_cast<UINT>(m_Members.size() - 1);
+}
+
+UINT CConstantLayout::GetMemberCount(VOID)
+{
+	return static_cast<UINT>(m_Members.size());
+}
+
+BOOL CConstantLayout::GetMember(UINT Index, Member& rMember)
+{
+	BOOL Status = (Index < m_Members.size()) ? TRUE : FALSE;
+
+	if (Status == TRUE)
+	{
+		rMember = m_Members[Index];
+	}
+
+	return Status;
+}
+
+UINT CConstantLayout::GetOffset(UINT Index)
+{
+	return (Index < m_Members.size()) ? m_Members[Index].Offset : 0;
+}
+
+UINT CConstantLayout::GetSize(VOID)
+{
+	return (m_End + RegisterSize - 1) & ~(RegisterSize - 1);
+}
+
+VOID CConstantLayout::Write(uint8_t* pBuffer, UINT Index, CONST VOID* pData)
+{
+	if (Index < m_Members.size())
+	{
+		CONST Member& rMember = m_Members[Index];
+		CONST uint8_t* pSource = reinterpret_cast<CONST uint8_t*>(pData);
+
+		UINT Rows = 0;
+		UINT Columns = 0;
+		GetDimensions(rMember.Type, Rows, Columns);
+
+		uint8_t* pRow = pBuffer + rMember.Offset;
+		CONST SIZE_T RowBytes = Columns * ComponentSize;
+
+		// Rows of consecutive elements are laid out one register apart, just like the rows within an element
+		for (UINT i = 0; i < rMember.nElements * Rows; i++)
+		{
+			memcpy(pRow, pSource, RowBytes);
+
+			pRow += RegisterSize;
+			pSource += RowBytes;
+		}
+	}
+}
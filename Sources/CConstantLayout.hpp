@@ -0,0 +1,71 @@
+#ifndef CCONSTANTLAYOUT_HPP
+#define CCONSTANTLAYOUT_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+// Places the members of an HLSL cbuffer the way the shader compiler does, so the CPU can fill one from tightly packed
+// values. Members are added in declaration order. Constants are stored in 16 byte registers: a vector never straddles
+// two registers, while every array element and every matrix row starts a new one. A member that follows an array or a
+// matrix may still use the rest of its last register. Matrices are expected to be declared row_major.
+class CConstantLayout
+{
+public:
+	enum ConstantType : UINT
+	{
+		CONSTANT_FLOAT = 0,
+		CONSTANT_FLOAT2 = 1,
+		CONSTANT_FLOAT3 = 2,
+		CONSTANT_FLOAT4 = 3,
+		CONSTANT_INT = 4,
+		CONSTANT_INT4 = 5,
+		CONSTANT_UINT = 6,
+		CONSTANT_UINT4 = 7,
+		CONSTANT_FLOAT3X3 = 8,
+		CONSTANT_FLOAT4X3 = 9,
+		CONSTANT_FLOAT4X4 = 10,
+		NumConstantTypes = 11
+	};
+
+	enum { RegisterSize = 16, ComponentSize = 4 };
+
+	struct Member
+	{
+		ConstantType Type;
+		UINT		 nElements;
+		UINT		 Offset;
+		UINT		 Size;
+	};
+
+protected:
+	std::vector<Member> m_Members;
+	UINT				m_End;
+
+public:
+	CConstantLayout();
+	~CConstantLayout();
+
+	VOID Clear(VOID);
+
+	// nElements is the array length, 1 for a member that is not an array. Returns the member's index.
+	UINT Add(ConstantType Type, UINT nElements = 1);
+
+	UINT GetMemberCount(VOID);
+	BOOL GetMember(UINT Index, Member& rMember);
+
+	// Byte offset of the member from the start of the cbuffer
+	UINT GetOffset(UINT Index);
+
+	// Size of the cbuffer as the shader sees it, a whole number of registers
+	UINT GetSize(VOID);
+
+	// Rows and columns of one element, a vector is a single row
+	static VOID GetDimensions(ConstantType Type, UINT& rRows, UINT& rColumns);
+
+	// pData holds nElements elements of rows * columns components each, without any padding. Padding in pBuffer is
+	// left untouched.
+	VOID Write(uint8_t* pBuffer, UINT Index, CONST VOID* pData);
+};
+
+#endif // CCONSTANTLAYOUT_HPP
@@ -0,0 +1,279 @@
+#include "CFileMapping.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Console.hpp"
+
+CFileMapping::CFileMapping()
+{
+	m_pData = NULL;
+	m_Size = 0;
+	m_bWritable = FALSE;
+}
+
+CFileMapping::~CFileMapping()
+{
+	Close();
+}
+
+BOOL CFileMapping::Open(LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+	PVOID pData = NULL;
+	SIZE_T Size = 0;
+
+	Close();
+
+#if defined(_WIN32)
+	HANDLE hFile = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	HANDLE hMapping = NULL;
+	LARGE_INTEGER FileSize = { };
+
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open %s\n", pPath);
+	}
+
+	if ((Status == TRUE) && ((GetFileSizeEx(hFile, &FileSize) == FALSE) || (FileSize.QuadPart == 0)))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s is empty or its size could not be read\n", pPath);
+	}
+
+	if (Status == TRUE)
+	{
+		Size = static_cast<SIZE_T>(FileSize.QuadPart);
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (hMapping == NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create a file mapping for %s\n", pPath);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (pData == NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not map a view of %s\n", pPath);
+		}
+	}
+
+	// The view keeps the mapping and the file alive
+	if (hMapping != NULL)
+	{
+		CloseHandle(hMapping);
+	}
+
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(hFile);
+	}
+#else
+	INT File = open(pPath, O_RDONLY);
+	struct stat FileInfo = { };
+
+	if (File < 0)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open %s\n", pPath);
+	}
+
+	if ((Status == TRUE) && ((fstat(File, &FileInfo) != 0) || (FileInfo.st_size == 0)))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s is empty or its size could not be read\n", pPath);
+	}
+
+	if (Status == TRUE)
+	{
+		Size = static_cast<SIZE_T>(FileInfo.st_size);
+		pData = mmap(NULL, Size, PROT_READ, MAP_PRIVATE, File, 0);
+
+		if (pData == MAP_FAILED)
+		{
+			pData = NULL;
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not map %s\n", pPath);
+		}
+	}
+
+	// The mapping keeps its own reference to the file
+	if (File >= 0)
+	{
+		close(File);
+	}
+#endif
+
+	if (Status == TRUE)
+	{
+		m_pData = reinterpret_cast<uint8_t*>(pData);
+		m_Size = Size;
+	}
+
+	return Status;
+}
+
+BOOL CFileMapping::Create(LPCSTR pPath, SIZE_T Size)
+{
+	BOOL Status = TRUE;
+	PVOID pData = NULL;
+
+	Close();
+
+	if (Size == 0)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Cannot create an empty mapping for %s\n", pPath);
+	}
+
+#if defined(_WIN32)
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = NULL;
+
+	if (Status == TRUE)
+	{
+		hFile = CreateFileA(pPath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create %s\n", pPath);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		// Mapping past the end of the file grows it to the requested size
+		UINT64 FileSize = static_cast<UINT64>(Size);
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, static_cast<DWORD>(FileSize >> 32), static_cast<DWORD>(FileSize & 0xFFFFFFFF), NULL);
+
+		if (hMapping == NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create a file mapping for %s\n", pPath);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		pData = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+
+		if (pData == NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not map a view of %s\n", pPath);
+		}
+	}
+
+	if (hMapping != NULL)
+	{
+		CloseHandle(hMapping);
+	}
+
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(hFile);
+	}
+#else
+	INT File = -1;
+
+	if (Status == TRUE)
+	{
+		File = open(pPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+		if (File < 0)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create %s\n", pPath);
+		}
+	}
+
+	if ((Status == TRUE) && (ftruncate(File, static_cast<off_t>(Size)) != 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not resize %s to %llu bytes\n", pPath, static_cast<UINT64>(Size));
+	}
+
+	if (Status == TRUE)
+	{
+		pData = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, File, 0);
+
+		if (pData == MAP_FAILED)
+		{
+			pData = NULL;
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not map %s\n", pPath);
+		}
+	}
+
+	if (File >= 0)
+	{
+		close(File);
+	}
+#endif
+
+	if (Status == TRUE)
+	{
+		m_pData = reinterpret_cast<uint8_t*>(pData);
+		m_Size = Size;
+		m_bWritable = TRUE;
+	}
+
+	return Status;
+}
+
+VOID CFileMapping::Close(VOID)
+{
+	if (m_pData != NULL)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(m_pData);
+#else
+		munmap(m_pData, m_Size);
+#endif
+
+		m_pData = NULL;
+		m_Size = 0;
+		m_bWritable = FALSE;
+	}
+}
+
+VOID CFileMapping::Flush(VOID)
+{
+	if ((m_pData != NULL) && (m_bWritable == TRUE))
+	{
+#if defined(_WIN32)
+		FlushViewOfFile(m_pData, 0);
+#else
+		msync(m_pData, m_Size, MS_ASYNC);
+#endif
+	}
+}
+
+CONST uint8_t* CFileMapping::GetData(VOID)
+{
+	return m_pData;
+}
+
+uint8_t* CFileMapping::GetWritableData(VOID)
+{
+	return (m_bWritable == TRUE) ? m_pData : NULL;
+}
+
+SIZE_T CFileMapping::GetSize(VOID)
+{
+	return m_Size;
+}
@@ -0,0 +1,31 @@
+#ifndef CFILEMAPPING_HPP
+#define CFILEMAPPING_HPP
+
+#include "Defines.hpp"
+
+// View of a whole file, the OS pages it in on first access. Open maps an existing file read-only,
+// Create makes a new file of a fixed size and maps it writable.
+class CFileMapping
+{
+protected:
+	uint8_t* m_pData;
+	SIZE_T	 m_Size;
+	BOOL	 m_bWritable;
+
+public:
+	CFileMapping();
+	~CFileMapping();
+
+	BOOL Open(LPCSTR pPath);
+	BOOL Create(LPCSTR pPath, SIZE_T Size);
+	VOID Close(VOID);
+
+	// Starts writing dirty pages back to the file, the mapping stays valid
+	VOID Flush(VOID);
+
+	CONST uint8_t* GetData(VOID);
+	uint8_t*	   GetWritableData(VOID);
+	SIZE_T		   GetSize(VOID);
+};
+
+#endif // CFILEMAPPING_HPP
@@ -0,0 +1,85 @@
+#include "CFrameArena.hpp"
+
+#include "CPageAllocator.hpp"
+
+CFrameArena::CFrameArena()
+{
+	m_pBase = NULL;
+	m_Capacity = 0;
+	m_Offset = 0;
+}
+
+CFrameArena::~CFrameArena()
+{
+}
+
+BOOL CFrameArena::Initialize(SIZE_T Capacity)
+{
+	BOOL Status = TRUE;
+
+	m_pBase = reinterpret_cast<uint8_t*>(CPageAllocator::Map(Capacity));
+
+	if (m_pBase != NULL)
+	{
+		m_Capacity = Capacity;
+		m_Offset = 0;
+	}
+	else
+	{
+		Status = FALSE;
+	}
+
+	return Status;
+}
+
+VOID CFrameArena::Uninitialize(VOID)
+{
+	if (m_pBase != NULL)
+	{
+		CPageAllocator::Unmap(m_pBase, m_Capacity);
+		m_pBase = NULL;
+	}
+
+	m_Capacity = 0;
+	m_Offset = 0;
+}
+
+VOID CFrameArena::Reset(VOID)
+{
+	m_Offset.store(0, std::memory_order_relaxed);
+}
+
+PVOID CFrameArena::Allocate(SIZE_T nBytes, SIZE_T Alignment)
+{
+	PVOID pMemory = NULL;
+	SIZE_T Offset = m_Offset.load(std::memory_order_relaxed);
+	SIZE_T Aligned = 0;
+
+	// Lock-free bump, so command recording threads can share the arena of the current frame
+	do
+	{
+		Aligned = (Offset + Alignment - 1) & ~(Alignment - 1);
+
+		if ((Aligned + nBytes) > m_Capacity)
+		{
+			break;
+		}
+	} while (m_Offset.compare_exchange_weak(Offset, Aligned + nBytes, std::memory_order_relaxed) == false);
+
+	if ((Aligned + nBytes) <= m_Capacity)
+	{
+		pMemory = m_pBase + Aligned;
+	}
+
+	return pMemory;
+}
+
+SIZE_T CFrameArena::GetUsed(VOID)
+{
+	return m_Offset.load(std::memory_order_relaxed);
+}
+
+SIZE_T CFrameArena::GetCapacity(VOID)
+{
+	return m_Capacity;
+}
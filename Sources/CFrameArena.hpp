@@ -0,0 +1,29 @@
+#ifndef CFRAMEARENA_HPP
+#define CFRAMEARENA_HPP
+
+#include <atomic>
+
+#include "Defines.hpp"
+
+class CFrameArena
+{
+protected:
+	uint8_t*			m_pBase;
+	SIZE_T				m_Capacity;
+	std::atomic<SIZE_T> m_Offset;
+
+public:
+	CFrameArena();
+	~CFrameArena();
+
+	BOOL Initialize(SIZE_T Capacity);
+	VOID Uninitialize(VOID);
+
+	VOID  Reset(VOID);
+	PVOID Allocate(SIZE_T nBytes, SIZE_T Alignment);
+
+	SIZE_T GetUsed(VOID);
+	SIZE_T GetCapacity(VOID);
+};
+
+#endif // CFRAMEARENA_HPP
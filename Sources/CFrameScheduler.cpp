@@ -0,0 +1,87 @@
+#include "CFrameScheduler.hpp"
+
+CFrameScheduler::CFrameScheduler()
+{
+	Uninitialize();
+}
+
+CFrameScheduler::~CFrameScheduler()
+{
+}
+
+BOOL CFrameScheduler::Initialize(UINT nFramesInFlight)
+{
+	BOOL Status = ((nFramesInFlight != 0) && (nFramesInFlight <= MaxFramesInFlight)) ? TRUE : FALSE;
+
+	if (Status == TRUE)
+	{
+		Uninitialize();
+
+		m_nFrames = nFramesInFlight;
+
+		// The first BeginFrame lands on slot 0
+		m_Slot = nFramesInFlight - 1;
+	}
+
+	return Status;
+}
+
+VOID CFrameScheduler::Uninitialize(VOID)
+{
+	m_nFrames = 0;
+	m_Slot = 0;
+	m_FrameNumber = 0;
+	m_LatestFence = 0;
+
+	for (UINT i = 0; i < MaxFramesInFlight; i++)
+	{
+		m_SlotFences[i] = 0;
+	}
+}
+
+UINT CFrameScheduler::BeginFrame(VOID)
+{
+	if (m_nFrames != 0)
+	{
+		m_Slot = (m_Slot + 1) % m_nFrames;
+		m_FrameNumber++;
+	}
+
+	return m_Slot;
+}
+
+VOID CFrameScheduler::EndFrame(UINT64 FenceValue)
+{
+	m_SlotFences[m_Slot] = FenceValue;
+	m_LatestFence = (FenceValue > m_LatestFence) ? FenceValue : m_LatestFence;
+}
+
+BOOL CFrameScheduler::MustWait(UINT64 CompletedFenceValue)
+{
+	return (CompletedFenceValue < m_SlotFences[m_Slot]) ? TRUE : FALSE;
+}
+
+UINT CFrameScheduler::GetFrameCount(VOID)
+{
+	return m_nFrames;
+}
+
+UINT CFrameScheduler::GetSlot(VOID)
+{
+	return m_Slot;
+}
+
+UINT64 CFrameScheduler::GetFrameNumber(VOID)
+{
+	return m_FrameNumber;
+}
+
+UINT64 CFrameScheduler::GetWaitFence(VOID)
+{
+	return m_SlotFences[m_Slot];
+}
+
+UINT64 CFrameScheduler::GetLatestFence(VOID)
+{
+	return m_LatestFence;
+}
@@ -0,0 +1,41 @@
+#ifndef CFRAMESCHEDULER_HPP
+#define CFRAMESCHEDULER_HPP
+
+#include "Defines.hpp"
+
+// Fence bookkeeping for N frames in flight, it never touches the GPU itself.
+// Each frame records into the resources of one slot. BeginFrame moves to the next slot and GetWaitFence returns
+// the fence the previous frame in that slot signalled, which has to complete before the slot is reused.
+class CFrameScheduler
+{
+public:
+	enum { MaxFramesInFlight = 8 };
+
+protected:
+	UINT   m_nFrames;
+	UINT   m_Slot;
+	UINT64 m_FrameNumber;
+	UINT64 m_LatestFence;
+	UINT64 m_SlotFences[MaxFramesInFlight];
+
+public:
+	CFrameScheduler();
+	~CFrameScheduler();
+
+	BOOL Initialize(UINT nFramesInFlight);
+	VOID Uninitialize(VOID);
+
+	UINT BeginFrame(VOID);
+	VOID EndFrame(UINT64 FenceValue);
+
+	// TRUE when the current slot is still in use by the GPU and the caller has to wait for GetWaitFence
+	BOOL MustWait(UINT64 CompletedFenceValue);
+
+	UINT   GetFrameCount(VOID);
+	UINT   GetSlot(VOID);
+	UINT64 GetFrameNumber(VOID);
+	UINT64 GetWaitFence(VOID);
+	UINT64 GetLatestFence(VOID);
+};
+
+#endif // CFRAMESCHEDULER_HPP
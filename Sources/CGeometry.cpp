@@ -0,0 +1,197 @@
+#include "CGeometry.hpp"
+
+#include "CMeshBuilder.hpp"
+#include "CMeshFile.hpp"
+#include "Console.hpp"
+
+CONST CHAR* CGeometry::CubeMeshPath = "C:/Workspace/DX12_HelloCube/Assets/Cube.mesh";
+
+// One full turn every 600 frames, ten seconds at 60 Hz
+static CONST UINT CubeRevolutionFrames = 600;
+
+VOID CGeometry::BuildCube(CMeshBuilder& rBuilder)
+{
+	/*
+	* 
+	*		   5 _______________ 6
+	*		    /| 			   /|
+	*		   / |			  / |
+	*		  /  |			 /  |
+	*	   1 /___|__________/ 2 |
+	*		 |	 |4 	   |	|
+	*		 |   |_________|____| 7
+	*		 |	 /		   |   /
+	*		 |	/		   |  /
+	*		 | /		   | /
+	*	   0 |/____________|/ 3
+	* 
+	* 0: { -0.5, -0.5, +0.5 }
+	* 1: { -0.5, +0.5, +0.5 }
+	* 2: { +0.5, +0.5, +0.5 }
+	* 3: { +0.5, -0.5, +0.5 }
+	* 4: { -0.5, -0.5, -0.5 }
+	* 5: { -0.5, +0.5, -0.5 }
+	* 6: { +0.5, +0.5, -0.5 }
+	* 7: { +0.5, -0.5, -0.5 }
+	*/
+
+	const float Vertices[][3] =
+	{
+		{ -0.5, -0.5, +0.5 },
+		{ -0.5, +0.5, +0.5 },
+		{ +0.5, +0.5, +0.5 },
+		{ +0.5, -0.5, +0.5 },
+		{ -0.5, -0.5, -0.5 },
+		{ -0.5, +0.5, -0.5 },
+		{ +0.5, +0.5, -0.5 },
+		{ +0.5, -0.5, -0.5 }
+	};
+
+	struct Triangle
+	{
+		unsigned short Indices[6];
+		float Normal[3];
+		float Colour[3];
+	};
+
+	const Triangle Triangles[] =
+	{
+		// front
+		{
+			{
+				0, 1, 2,
+				0, 2, 3
+			},
+			{ 0.0f, 0.0f, +1.0f },
+			{ 1.0f, 0.0f,  0.0f }
+		},
+
+		// back
+		{
+			{
+				4, 6, 5,
+				4, 7, 6
+			},
+			{ 0.0f, 0.0f, -1.0f },
+			{ 0.0f, 1.0f,  0.0f }
+		},
+
+		// left
+		{
+			{
+				0, 5, 1,
+				0, 4, 5
+			},
+			{ -1.0f, 0.0f, 0.0f },
+			{  0.0f, 0.0f, 1.0f }
+		},
+
+		// right
+		{
+			{
+				3, 2, 6,
+				3, 6, 7
+			},
+			{ +1.0f, 0.0f, 0.0f },
+			{  0.5f, 0.0f, 1.0f }
+		},
+
+		// top
+		{
+			{
+				1, 5, 2,
+				2, 5, 6
+			},
+			{ 0.0f, +1.0f, 0.0f },
+			{ 1.0f,  1.0f, 0.0f }
+		},
+
+		// bottom
+		{
+			{
+				0, 3, 4,
+				3, 7, 4
+			},
+			{ 0.0f, -1.0f, 0.0f },
+			{ 1.0f,  0.0f, 1.0f }
+		}
+	};
+
+	rBuilder.Reserve(sizeof(Triangles) / sizeof(Triangles[0]) * 6);
+
+	for (unsigned int i = 0; i < sizeof(Triangles) / sizeof(Triangles[0]); i++)
+	{
+		const Triangle& t = Triangles[i];
+		for (unsigned int j = 0; j < 6; j++)
+		{
+			Vertex v = { };
+			v.Position[0] = Vertices[t.Indices[j]][0];
+			v.Position[1] = Vertices[t.Indices[j]][1];
+			v.Position[2] = Vertices[t.Indices[j]][2];
+			v.Colour[0] = t.Colour[0];
+			v.Colour[1] = t.Colour[1];
+			v.Colour[2] = t.Colour[2];
+
+			rBuilder.AddVertex(v);
+		}
+	}
+}
+
+BOOL CGeometry::LoadCube(CMeshFile& rFile, CMeshBuilder& rBuilder, MeshData& rMesh)
+{
+	BOOL Status = TRUE;
+
+	if (rFile.Open(CubeMeshPath) == TRUE)
+	{
+		rFile.GetMeshData(rMesh);
+		Console::Write("Mesh Cube: mapped %u vertices, %u indices and %u meshlets from %s\n", rMesh.VertexCount, rMesh.IndexCount, rFile.GetHeader()->MeshletCount, CubeMeshPath);
+	}
+	else
+	{
+		Console::Write("Mesh Cube: building from source\n");
+
+		BuildCube(rBuilder);
+
+		if ((rBuilder.Optimize(CMeshOptimizer::DefaultCacheSize) == TRUE) && (rBuilder.Build() == TRUE))
+		{
+			rBuilder.PrintStatistics("Cube");
+			rBuilder.GetMeshData(rMesh);
+		}
+		else
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to build cube mesh\n");
+		}
+	}
+
+	return Status;
+}
+
+Quat CGeometry::GetCubeRotation(UINT64 FrameNumber)
+{
+	CONST FLOAT Angle = static_cast<FLOAT>(FrameNumber % CubeRevolutionFrames) * (2.0f * Math::Pi / CubeRevolutionFrames);
+
+	// Spin about y, then tip the top of the cube towards the camera
+	CONST Quat Spin = Math::AxisAngle(Vec3{ 0.0f, 1.0f, 0.0f }, Angle);
+	CONST Quat Tilt = Math::AxisAngle(Vec3{ 1.0f, 0.0f, 0.0f }, Math::Pi / 6.0f);
+
+	return Math::Multiply(Spin, Tilt);
+}
+
+VOID CGeometry::GetViewProjection(FLOAT AspectRatio, Mat4& rViewProjection)
+{
+	// The cube's faces are wound clockwise seen from outside in a right handed frame, which FrontCounterClockwise = FALSE
+	// treats as front facing
+	CONST Mat4 View = Math::LookAtRH(Vec3{ 0.0f, 0.0f, 3.0f }, Vec3{ 0.0f, 0.0f, 0.0f }, Vec3{ 0.0f, 1.0f, 0.0f });
+	CONST Mat4 Projection = Math::PerspectiveFovRH(Math::Pi / 4.0f, AspectRatio, 0.1f, 100.0f);
+
+	rViewProjection = Math::Multiply(View, Projection);
+}
+
+VOID CGeometry::GetCubeTransform(UINT64 FrameNumber, FLOAT AspectRatio, Mat4& rWorldViewProjection)
+{
+	Mat4 ViewProjection;
+	GetViewProjection(AspectRatio, ViewProjection);
+
+	rWorldViewProjection = Math::Multiply(Math::Rotation(GetCubeRotation(FrameNumber)), ViewProjection);
+}
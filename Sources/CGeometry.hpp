@@ -0,0 +1,27 @@
+#ifndef CGEOMETRY_HPP
+#define CGEOMETRY_HPP
+
+#include "Defines.hpp"
+#include "Math.hpp"
+
+class CMeshBuilder;
+class CMeshFile;
+struct MeshData;
+
+class CGeometry
+{
+public:
+	static CONST CHAR* CubeMeshPath;
+
+	static VOID BuildCube(CMeshBuilder& rBuilder);
+
+	// Maps the converted cube if it exists, otherwise builds it from the arrays in BuildCube
+	static BOOL LoadCube(CMeshFile& rFile, CMeshBuilder& rBuilder, MeshData& rMesh);
+
+	// The cube turns by a fixed step every frame, so both renderers draw the same picture for the same frame number
+	static Quat GetCubeRotation(UINT64 FrameNumber);
+	static VOID GetViewProjection(FLOAT AspectRatio, Mat4& rViewProjection);
+	static VOID GetCubeTransform(UINT64 FrameNumber, FLOAT AspectRatio, Mat4& rWorldViewProjection);
+};
+
+#endif // CGEOMETRY_HPP
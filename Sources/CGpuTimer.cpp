@@ -0,0 +1,164 @@
+#include "CGpuTimer.hpp"
+
+#include "Console.hpp"
+
+CGpuTimer::CGpuTimer()
+{
+	Uninitialize();
+}
+
+CGpuTimer::~CGpuTimer()
+{
+}
+
+BOOL CGpuTimer::Initialize(UINT nPasses, CONST LPCSTR* pPassNames, UINT64 Frequency)
+{
+	BOOL Status = TRUE;
+
+	Uninitialize();
+
+	if ((nPasses == 0) || (nPasses > MaxPasses) || (Frequency == 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Cannot time %u GPU passes with a timestamp frequency of %llu\n", nPasses, Frequency);
+	}
+
+	if (Status == TRUE)
+	{
+		m_nPasses = nPasses;
+		m_MillisecondsPerTick = 1000.0 / static_cast<double>(Frequency);
+
+		for (UINT i = 0; i < nPasses; i++)
+		{
+			m_PassNames[i] = pPassNames[i];
+		}
+	}
+
+	return Status;
+}
+
+VOID CGpuTimer::Uninitialize(VOID)
+{
+	m_nPasses = 0;
+	m_MillisecondsPerTick = 0.0;
+
+	for (UINT i = 0; i < MaxPasses; i++)
+	{
+		m_PassNames[i] = NULL;
+		m_nSamples[i] = 0;
+		m_NextSample[i] = 0;
+	}
+
+	for (UINT i = 0; i < CFrameScheduler::MaxFramesInFlight; i++)
+	{
+		m_bPending[i] = FALSE;
+	}
+}
+
+UINT CGpuTimer::GetQueryCount(VOID)
+{
+	return 2 * m_nPasses;
+}
+
+UINT CGpuTimer::GetBeginQuery(UINT Slot, UINT Pass)
+{
+	return Slot * GetQueryCount() + 2 * Pass;
+}
+
+UINT CGpuTimer::GetEndQuery(UINT Slot, UINT Pass)
+{
+	return Slot * GetQueryCount() + 2 * Pass + 1;
+}
+
+VOID CGpuTimer::Submit(UINT Slot)
+{
+	if (Slot < CFrameScheduler::MaxFramesInFlight)
+	{
+		m_bPending[Slot] = TRUE;
+	}
+}
+
+BOOL CGpuTimer::IsPending(UINT Slot)
+{
+	return (Slot < CFrameScheduler::MaxFramesInFlight) ? m_bPending[Slot] : FALSE;
+}
+
+VOID CGpuTimer::Resolve(UINT Slot, CONST UINT64* pTimestamps)
+{
+	if (IsPending(Slot) == TRUE)
+	{
+		for (UINT Pass = 0; Pass < m_nPasses; Pass++)
+		{
+			UINT64 Begin = pTimestamps[2 * Pass];
+			UINT64 End = pTimestamps[2 * Pass + 1];
+
+			// A pass that was not recorded, or that straddles a clock reset, has no meaningful duration
+			if ((Begin != 0) && (End >= Begin))
+			{
+				m_Samples[Pass][m_NextSample[Pass]] = static_cast<FLOAT>(static_cast<double>(End - Begin) * m_MillisecondsPerTick);
+				m_NextSample[Pass] = (m_NextSample[Pass] + 1) % WindowSize;
+				m_nSamples[Pass] = (m_nSamples[Pass] < WindowSize) ? (m_nSamples[Pass] + 1) : static_cast<UINT>(WindowSize);
+			}
+		}
+
+		m_bPending[Slot] = FALSE;
+	}
+}
+
+UINT CGpuTimer::GetPassCount(VOID)
+{
+	return m_nPasses;
+}
+
+BOOL CGpuTimer::GetPassTiming(UINT Pass, IRenderer::PassTiming& rTiming)
+{
+	BOOL Status = TRUE;
+
+	if (Pass >= m_nPasses)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		rTiming.pName = m_PassNames[Pass];
+		rTiming.Samples = m_nSamples[Pass];
+		rTiming.MinMs = 0.0f;
+		rTiming.AvgMs = 0.0f;
+		rTiming.MaxMs = 0.0f;
+
+		if (m_nSamples[Pass] != 0)
+		{
+			double Sum = 0.0;
+
+			rTiming.MinMs = m_Samples[Pass][0];
+			rTiming.MaxMs = m_Samples[Pass][0];
+
+			for (UINT i = 0; i < m_nSamples[Pass]; i++)
+			{
+				FLOAT Sample = m_Samples[Pass][i];
+
+				rTiming.MinMs = (Sample < rTiming.MinMs) ? Sample : rTiming.MinMs;
+				rTiming.MaxMs = (Sample > rTiming.MaxMs) ? Sample : rTiming.MaxMs;
+				Sum += Sample;
+			}
+
+			rTiming.AvgMs = static_cast<FLOAT>(Sum / m_nSamples[Pass]);
+		}
+	}
+
+	return Status;
+}
+
+VOID CGpuTimer::PrintStatistics(VOID)
+{
+	IRenderer::PassTiming Timing = { };
+
+	for (UINT Pass = 0; Pass < m_nPasses; Pass++)
+	{
+		if ((GetPassTiming(Pass, Timing) == TRUE) && (Timing.Samples != 0))
+		{
+			Console::Write("GPU %s: %.3f / %.3f / %.3f ms min / avg / max over %u frames\n", Timing.pName, Timing.MinMs, Timing.AvgMs, Timing.MaxMs, Timing.Samples);
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef CGPUTIMER_HPP
+#define CGPUTIMER_HPP
+
+#include "Defines.hpp"
+
+#include "IRenderer.hpp"
+
+#include "CFrameScheduler.hpp"
+
+// Bookkeeping for GPU timestamp queries, it never touches the GPU itself.
+// Every pass owns a begin and an end query, a frame in flight owns GetQueryCount consecutive queries. A slot's
+// timestamps are handed to Resolve once the fence of the frame that wrote them has completed, so reading them never
+// stalls. Durations are kept in milliseconds over a rolling window of the most recent frames.
+class CGpuTimer
+{
+public:
+	enum { MaxPasses = 8, WindowSize = 120 };
+
+protected:
+	UINT   m_nPasses;
+	LPCSTR m_PassNames[MaxPasses];
+	double m_MillisecondsPerTick;
+
+	FLOAT  m_Samples[MaxPasses][WindowSize];
+	UINT   m_nSamples[MaxPasses];
+	UINT   m_NextSample[MaxPasses];
+
+	BOOL   m_bPending[CFrameScheduler::MaxFramesInFlight];
+
+public:
+	CGpuTimer();
+	~CGpuTimer();
+
+	// Frequency is the GPU timestamp frequency in ticks per second
+	BOOL Initialize(UINT nPasses, CONST LPCSTR* pPassNames, UINT64 Frequency);
+	VOID Uninitialize(VOID);
+
+	UINT GetQueryCount(VOID);
+	UINT GetBeginQuery(UINT Slot, UINT Pass);
+	UINT GetEndQuery(UINT Slot, UINT Pass);
+
+	// Submit marks the slot's queries as written by the frame just submitted
+	VOID Submit(UINT Slot);
+	BOOL IsPending(UINT Slot);
+
+	// pTimestamps holds the slot's GetQueryCount resolved ticks, passes whose end precedes their begin are skipped
+	VOID Resolve(UINT Slot, CONST UINT64* pTimestamps);
+
+	UINT GetPassCount(VOID);
+	BOOL GetPassTiming(UINT Pass, IRenderer::PassTiming& rTiming);
+	VOID PrintStatistics(VOID);
+};
+
+#endif // CGPUTIMER_HPP
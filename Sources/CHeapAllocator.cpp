@@ -0,0 +1,596 @@
+#include "CHeapAllocator.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+CHeapAllocator::CHeapAllocator()
+{
+	m_Capacity = 0;
+	Uninitialize();
+}
+
+CHeapAllocator::~CHeapAllocator()
+{
+}
+
+UINT CHeapAllocator::FindLowestBit(uint64_t Bits)
+{
+#if defined(_MSC_VER)
+	unsigned long Index = 0;
+	_BitScanForward64(&Index, Bits);
+	return static_cast<UINT>(Index);
+#else
+	return static_cast<UINT>(__builtin_ctzll(Bits));
+#endif
+}
+
+UINT CHeapAllocator::FindHighestBit(uint64_t Bits)
+{
+#if defined(_MSC_VER)
+	unsigned long Index = 0;
+	_BitScanReverse64(&Index, Bits);
+	return static_cast<UINT>(Index);
+#else
+	return static_cast<UINT>(63 - __builtin_clzll(Bits));
+#endif
+}
+
+UINT64 CHeapAllocator::AlignUp(UINT64 Value, UINT64 Alignment)
+{
+	return (Value + Alignment - 1) & ~(Alignment - 1);
+}
+
+VOID CHeapAllocator::Mapping(UINT64 Size, UINT& rFl, UINT& rSl)
+{
+	// The first level is the power of two range of the size, the second level splits it into SlCount linear classes
+	UINT64 Units = Size >> GranularityLog2;
+
+	if (Units < SlCount)
+	{
+		rFl = 0;
+		rSl = static_cast<UINT>(Units);
+	}
+	else
+	{
+		UINT Highest = FindHighestBit(Units);
+
+		rFl = Highest - SlLog2 + 1;
+		rSl = static_cast<UINT>(Units >> (Highest - SlLog2)) - SlCount;
+	}
+}
+
+uint32_t CHeapAllocator::NewNode(VOID)
+{
+	uint32_t Node = InvalidHandle;
+
+	if (m_UnusedNodes.size() != 0)
+	{
+		Node = m_UnusedNodes.back();
+		m_UnusedNodes.pop_back();
+	}
+	else
+	{
+		Node = static_cast<uint32_t>(m_Blocks.size());
+		m_Blocks.push_back(Block());
+	}
+
+	Block& rBlock = m_Blocks[Node];
+	rBlock.Offset = 0;
+	rBlock.Size = 0;
+	rBlock.Alignment = Granularity;
+	rBlock.PrevPhysical = InvalidHandle;
+	rBlock.NextPhysical = InvalidHandle;
+	rBlock.PrevFree = InvalidHandle;
+	rBlock.NextFree = InvalidHandle;
+	rBlock.bFree = TRUE;
+
+	return Node;
+}
+
+VOID CHeapAllocator::ReleaseNode(uint32_t Node)
+{
+	m_Blocks[Node].Size = 0;
+	m_Blocks[Node].bFree = FALSE;
+	m_UnusedNodes.push_back(Node);
+}
+
+VOID CHeapAllocator::InsertFree(uint32_t Node)
+{
+	Block& rBlock = m_Blocks[Node];
+	UINT Fl = 0;
+	UINT Sl = 0;
+
+	Mapping(rBlock.Size, Fl, Sl);
+
+	uint32_t Head = m_FreeHeads[Fl][Sl];
+
+	rBlock.bFree = TRUE;
+	rBlock.PrevFree = InvalidHandle;
+	rBlock.NextFree = Head;
+
+	if (Head != InvalidHandle)
+	{
+		m_Blocks[Head].PrevFree = Node;
+	}
+
+	m_FreeHeads[Fl][Sl] = Node;
+	m_SlBitmaps[Fl] |= (1u << Sl);
+	m_FlBitmap |= (1ull << Fl);
+	m_FreeBlocks++;
+}
+
+VOID CHeapAllocator::RemoveFree(uint32_t Node)
+{
+	Block& rBlock = m_Blocks[Node];
+	UINT Fl = 0;
+	UINT Sl = 0;
+
+	Mapping(rBlock.Size, Fl, Sl);
+
+	if (rBlock.PrevFree != InvalidHandle)
+	{
+		m_Blocks[rBlock.PrevFree].NextFree = rBlock.NextFree;
+	}
+	else
+	{
+		m_FreeHeads[Fl][Sl] = rBlock.NextFree;
+	}
+
+	if (rBlock.NextFree != InvalidHandle)
+	{
+		m_Blocks[rBlock.NextFree].PrevFree = rBlock.PrevFree;
+	}
+
+	if (m_FreeHeads[Fl][Sl] == InvalidHandle)
+	{
+		m_SlBitmaps[Fl] &= ~(1u << Sl);
+
+		if (m_SlBitmaps[Fl] == 0)
+		{
+			m_FlBitmap &= ~(1ull << Fl);
+		}
+	}
+
+	rBlock.PrevFree = InvalidHandle;
+	rBlock.NextFree = InvalidHandle;
+	m_FreeBlocks--;
+}
+
+uint32_t CHeapAllocator::FindFree(UINT64 Size)
+{
+	uint32_t Node = InvalidHandle;
+	UINT64 Units = Size >> GranularityLog2;
+	UINT Fl = 0;
+	UINT Sl = 0;
+
+	// Round up to the next class so that any block found is large enough
+	if (Units >= SlCount)
+	{
+		Units += (1ull << (FindHighestBit(Units) - SlLog2)) - 1;
+	}
+
+	Mapping(Units << GranularityLog2, Fl, Sl);
+
+	if (Fl < FlCount)
+	{
+		uint32_t SlMap = m_SlBitmaps[Fl] & (~0u << Sl);
+
+		if (SlMap == 0)
+		{
+			uint64_t FlMap = ((Fl + 1) < 64) ? (m_FlBitmap & (~0ull << (Fl + 1))) : 0;
+
+			if (FlMap != 0)
+			{
+				Fl = FindLowestBit(FlMap);
+				SlMap = m_SlBitmaps[Fl];
+			}
+		}
+
+		if (SlMap != 0)
+		{
+			Node = m_FreeHeads[Fl][FindLowestBit(SlMap)];
+		}
+	}
+
+	return Node;
+}
+
+uint32_t CHeapAllocator::SplitFront(uint32_t Node, UINT64 Size)
+{
+	// The front part becomes a new free block, Node keeps its index so handles stay stable
+	uint32_t Front = NewNode();
+	Block& rFront = m_Blocks[Front];
+	Block& rBlock = m_Blocks[Node];
+
+	rFront.Offset = rBlock.Offset;
+	rFront.Size = Size;
+	rFront.PrevPhysical = rBlock.PrevPhysical;
+	rFront.NextPhysical = Node;
+
+	if (rBlock.PrevPhysical != InvalidHandle)
+	{
+		m_Blocks[rBlock.PrevPhysical].NextPhysical = Front;
+	}
+
+	rBlock.PrevPhysical = Front;
+	rBlock.Offset += Size;
+	rBlock.Size -= Size;
+
+	InsertFree(Front);
+
+	return Node;
+}
+
+VOID CHeapAllocator::SplitBack(uint32_t Node, UINT64 Size)
+{
+	uint32_t Back = NewNode();
+	Block& rBack = m_Blocks[Back];
+	Block& rBlock = m_Blocks[Node];
+
+	rBack.Offset = rBlock.Offset + Size;
+	rBack.Size = rBlock.Size - Size;
+	rBack.PrevPhysical = Node;
+	rBack.NextPhysical = rBlock.NextPhysical;
+
+	if (rBlock.NextPhysical != InvalidHandle)
+	{
+		m_Blocks[rBlock.NextPhysical].PrevPhysical = Back;
+	}
+
+	rBlock.NextPhysical = Back;
+	rBlock.Size = Size;
+
+	InsertFree(MergeFree(Back));
+}
+
+uint32_t CHeapAllocator::MergeFree(uint32_t Node)
+{
+	// Node is free but not on a free list, neighbours that are free get absorbed into a single block
+	uint32_t Prev = m_Blocks[Node].PrevPhysical;
+	uint32_t Next = m_Blocks[Node].NextPhysical;
+
+	if ((Prev != InvalidHandle) && (m_Blocks[Prev].bFree == TRUE))
+	{
+		RemoveFree(Prev);
+
+		m_Blocks[Prev].Size += m_Blocks[Node].Size;
+		m_Blocks[Prev].NextPhysical = Next;
+
+		if (Next != InvalidHandle)
+		{
+			m_Blocks[Next].PrevPhysical = Prev;
+		}
+
+		ReleaseNode(Node);
+		Node = Prev;
+	}
+
+	if ((Next != InvalidHandle) && (m_Blocks[Next].bFree == TRUE))
+	{
+		RemoveFree(Next);
+
+		m_Blocks[Node].Size += m_Blocks[Next].Size;
+		m_Blocks[Node].NextPhysical = m_Blocks[Next].NextPhysical;
+
+		if (m_Blocks[Next].NextPhysical != InvalidHandle)
+		{
+			m_Blocks[m_Blocks[Next].NextPhysical].PrevPhysical = Node;
+		}
+
+		ReleaseNode(Next);
+	}
+
+	m_Blocks[Node].bFree = TRUE;
+
+	return Node;
+}
+
+BOOL CHeapAllocator::Initialize(UINT64 Capacity)
+{
+	BOOL Status = ((Capacity != 0) && ((Capacity % Granularity) == 0)) ? TRUE : FALSE;
+
+	if (Status == TRUE)
+	{
+		Uninitialize();
+
+		m_Capacity = Capacity;
+
+		uint32_t Node = NewNode();
+		m_Blocks[Node].Size = Capacity;
+
+		InsertFree(Node);
+	}
+
+	return Status;
+}
+
+VOID CHeapAllocator::Uninitialize(VOID)
+{
+	m_Blocks.clear();
+	m_UnusedNodes.clear();
+
+	m_FlBitmap = 0;
+
+	for (UINT Fl = 0; Fl < FlCount; Fl++)
+	{
+		m_SlBitmaps[Fl] = 0;
+
+		for (UINT Sl = 0; Sl < SlCount; Sl++)
+		{
+			m_FreeHeads[Fl][Sl] = InvalidHandle;
+		}
+	}
+
+	m_Capacity = 0;
+	m_AllocatedBytes = 0;
+	m_Allocations = 0;
+	m_FreeBlocks = 0;
+}
+
+BOOL CHeapAllocator::Allocate(UINT64 nBytes, UINT64 Alignment, Allocation& rAllocation)
+{
+	BOOL Status = ((nBytes != 0) && (nBytes <= m_Capacity) && (Alignment != 0) && ((Alignment & (Alignment - 1)) == 0)) ? TRUE : FALSE;
+	uint32_t Node = InvalidHandle;
+
+	Alignment = (Alignment < Granularity) ? static_cast<UINT64>(Granularity) : Alignment;
+
+	CONST UINT64 Size = AlignUp(nBytes, Granularity);
+	CONST UINT64 SearchSize = Size + Alignment - Granularity;
+
+	if (Status == TRUE)
+	{
+		Node = FindFree(SearchSize);
+
+		// A block in the same class as SearchSize may still fit, look at that one list before giving up
+		if (Node == InvalidHandle)
+		{
+			UINT Fl = 0;
+			UINT Sl = 0;
+
+			Mapping(SearchSize, Fl, Sl);
+
+			for (uint32_t Candidate = (Fl < FlCount) ? m_FreeHeads[Fl][Sl] : InvalidHandle; Candidate != InvalidHandle; Candidate = m_Blocks[Candidate].NextFree)
+			{
+				CONST Block& rCandidate = m_Blocks[Candidate];
+
+				if ((AlignUp(rCandidate.Offset, Alignment) - rCandidate.Offset + Size) <= rCandidate.Size)
+				{
+					Node = Candidate;
+					break;
+				}
+			}
+		}
+
+		Status = (Node != InvalidHandle) ? TRUE : FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		RemoveFree(Node);
+
+		UINT64 Padding = AlignUp(m_Blocks[Node].Offset, Alignment) - m_Blocks[Node].Offset;
+
+		if (Padding != 0)
+		{
+			Node = SplitFront(Node, Padding);
+		}
+
+		// Mark the block used first so the tail split off below does not merge back into it
+		m_Blocks[Node].bFree = FALSE;
+		m_Blocks[Node].Alignment = Alignment;
+
+		if (m_Blocks[Node].Size > Size)
+		{
+			SplitBack(Node, Size);
+		}
+
+		m_AllocatedBytes += Size;
+		m_Allocations++;
+
+		GetAllocation(Node, rAllocation);
+	}
+
+	return Status;
+}
+
+VOID CHeapAllocator::Free(uint32_t Handle)
+{
+	if ((Handle < m_Blocks.size()) && (m_Blocks[Handle].bFree == FALSE) && (m_Blocks[Handle].Size != 0))
+	{
+		m_AllocatedBytes -= m_Blocks[Handle].Size;
+		m_Allocations--;
+
+		InsertFree(MergeFree(Handle));
+	}
+}
+
+BOOL CHeapAllocator::Reallocate(CONST Allocation& rOld, UINT64 nBytes, UINT64 Alignment, Allocation& rNew)
+{
+	// Released nodes are neither free nor sized, the same test Free uses keeps a stale handle from being resized
+	BOOL Status = ((rOld.Handle < m_Blocks.size()) && (m_Blocks[rOld.Handle].bFree == FALSE) && (m_Blocks[rOld.Handle].Size != 0) && (nBytes != 0) && (Alignment != 0) && ((Alignment & (Alignment - 1)) == 0)) ? TRUE : FALSE;
+	BOOL bInPlace = FALSE;
+
+	if (Status == TRUE)
+	{
+		Alignment = (Alignment < Granularity) ? static_cast<UINT64>(Granularity) : Alignment;
+
+		CONST UINT64 Size = AlignUp(nBytes, Granularity);
+		Block& rBlock = m_Blocks[rOld.Handle];
+		uint32_t Next = rBlock.NextPhysical;
+
+		if ((rBlock.Offset % Alignment) == 0)
+		{
+			if ((Size > rBlock.Size) && (Next != InvalidHandle) && (m_Blocks[Next].bFree == TRUE) && ((rBlock.Size + m_Blocks[Next].Size) >= Size))
+			{
+				// Grow into the free block that follows
+				m_AllocatedBytes += m_Blocks[Next].Size;
+
+				RemoveFree(Next);
+
+				rBlock.Size += m_Blocks[Next].Size;
+				rBlock.NextPhysical = m_Blocks[Next].NextPhysical;
+
+				if (rBlock.NextPhysical != InvalidHandle)
+				{
+					m_Blocks[rBlock.NextPhysical].PrevPhysical = rOld.Handle;
+				}
+
+				ReleaseNode(Next);
+			}
+
+			if (Size <= rBlock.Size)
+			{
+				if (Size < rBlock.Size)
+				{
+					m_AllocatedBytes -= rBlock.Size - Size;
+					SplitBack(rOld.Handle, Size);
+				}
+
+				// SplitBack may have grown m_Blocks, so rBlock can no longer be used
+				m_Blocks[rOld.Handle].Alignment = Alignment;
+				bInPlace = TRUE;
+			}
+		}
+	}
+
+	if ((Status == TRUE) && (bInPlace == TRUE))
+	{
+		GetAllocation(rOld.Handle, rNew);
+	}
+	else if (Status == TRUE)
+	{
+		Status = Allocate(nBytes, Alignment, rNew);
+	}
+
+	return Status;
+}
+
+VOID CHeapAllocator::GetAllocation(uint32_t Handle, Allocation& rAllocation)
+{
+	rAllocation.Offset = m_Blocks[Handle].Offset;
+	rAllocation.Size = m_Blocks[Handle].Size;
+	rAllocation.Handle = Handle;
+}
+
+VOID CHeapAllocator::GetStatistics(Statistics& rStatistics)
+{
+	UINT64 LargestFreeBlock = 0;
+
+	if (m_FlBitmap != 0)
+	{
+		UINT Fl = FindHighestBit(m_FlBitmap);
+		UINT Sl = FindHighestBit(m_SlBitmaps[Fl]);
+
+		for (uint32_t Node = m_FreeHeads[Fl][Sl]; Node != InvalidHandle; Node = m_Blocks[Node].NextFree)
+		{
+			LargestFreeBlock = (m_Blocks[Node].Size > LargestFreeBlock) ? m_Blocks[Node].Size : LargestFreeBlock;
+		}
+	}
+
+	rStatistics.Capacity = m_Capacity;
+	rStatistics.AllocatedBytes = m_AllocatedBytes;
+	rStatistics.FreeBytes = m_Capacity - m_AllocatedBytes;
+	rStatistics.LargestFreeBlock = LargestFreeBlock;
+	rStatistics.Allocations = m_Allocations;
+	rStatistics.FreeBlocks = m_FreeBlocks;
+
+	// 0 when all free space is one block, approaching 1 as it is scattered into small pieces
+	rStatistics.Fragmentation = (rStatistics.FreeBytes != 0) ? (1.0f - static_cast<FLOAT>(static_cast<double>(LargestFreeBlock) / static_cast<double>(rStatistics.FreeBytes))) : 0.0f;
+}
+
+VOID CHeapAllocator::PlanDefragmentation(UINT64 MaxBytes, std::vector<Move>& rMoves)
+{
+	std::vector<uint32_t> Used;
+	uint32_t First = InvalidHandle;
+
+	rMoves.clear();
+
+	for (uint32_t Node = 0; (Node < m_Blocks.size()) && (First == InvalidHandle); Node++)
+	{
+		if ((m_Blocks[Node].Size != 0) && (m_Blocks[Node].Offset == 0))
+		{
+			First = Node;
+		}
+	}
+
+	for (uint32_t Node = First; Node != InvalidHandle; Node = m_Blocks[Node].NextPhysical)
+	{
+		if (m_Blocks[Node].bFree == FALSE)
+		{
+			Used.push_back(Node);
+		}
+	}
+
+	UINT64 Cursor = 0;
+
+	for (SIZE_T i = 0; i < Used.size(); i++)
+	{
+		Block& rBlock = m_Blocks[Used[i]];
+		UINT64 Target = AlignUp(Cursor, rBlock.Alignment);
+
+		if (((Target + rBlock.Size) <= rBlock.Offset) && (rBlock.Size <= MaxBytes))
+		{
+			Move NewMove = { Used[i], rBlock.Offset, Target, rBlock.Size };
+			rMoves.push_back(NewMove);
+
+			MaxBytes -= rBlock.Size;
+			rBlock.Offset = Target;
+		}
+
+		Cursor = rBlock.Offset + rBlock.Size;
+	}
+
+	// Rebuild the free space around the new layout, allocation handles are kept
+	for (uint32_t Node = First; Node != InvalidHandle;)
+	{
+		uint32_t Next = m_Blocks[Node].NextPhysical;
+
+		if (m_Blocks[Node].bFree == TRUE)
+		{
+			RemoveFree(Node);
+			ReleaseNode(Node);
+		}
+
+		Node = Next;
+	}
+
+	uint32_t Prev = InvalidHandle;
+	UINT64 Position = 0;
+
+	for (SIZE_T i = 0; i <= Used.size(); i++)
+	{
+		UINT64 End = (i < Used.size()) ? m_Blocks[Used[i]].Offset : m_Capacity;
+
+		if (End > Position)
+		{
+			uint32_t Gap = NewNode();
+
+			m_Blocks[Gap].Offset = Position;
+			m_Blocks[Gap].Size = End - Position;
+			m_Blocks[Gap].PrevPhysical = Prev;
+
+			if (Prev != InvalidHandle)
+			{
+				m_Blocks[Prev].NextPhysical = Gap;
+			}
+
+			InsertFree(Gap);
+			Prev = Gap;
+		}
+
+		if (i < Used.size())
+		{
+			m_Blocks[Used[i]].PrevPhysical = Prev;
+			m_Blocks[Used[i]].NextPhysical = InvalidHandle;
+
+			if (Prev != InvalidHandle)
+			{
+				m_Blocks[Prev].NextPhysical = Used[i];
+			}
+
+			Prev = Used[i];
+			Position = m_Blocks[Used[i]].Offset + m_Blocks[Used[i]].Size;
+		}
+	}
+}
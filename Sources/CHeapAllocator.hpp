@@ -0,0 +1,115 @@
+#ifndef CHEAPALLOCATOR_HPP
+#define CHEAPALLOCATOR_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+// Two-level segregated fit (TLSF) bookkeeping for a range of offsets, typically an ID3D12Heap.
+// It only hands out offsets, the caller places resources at them. Allocations are rounded up to Granularity
+// and every operation other than defragmentation planning is O(1).
+class CHeapAllocator
+{
+public:
+	enum : uint32_t { InvalidHandle = 0xFFFFFFFF };
+
+	struct Allocation
+	{
+		UINT64	 Offset;
+		UINT64	 Size;
+		uint32_t Handle;
+	};
+
+	struct Statistics
+	{
+		UINT64 Capacity;
+		UINT64 AllocatedBytes;
+		UINT64 FreeBytes;
+		UINT64 LargestFreeBlock;
+		UINT   Allocations;
+		UINT   FreeBlocks;
+		FLOAT  Fragmentation;
+	};
+
+	// The allocation keeps its handle, its contents have to be copied from From to To by the caller
+	struct Move
+	{
+		uint32_t Handle;
+		UINT64	 From;
+		UINT64	 To;
+		UINT64	 Size;
+	};
+
+protected:
+	enum
+	{
+		Granularity = 256,
+		GranularityLog2 = 8,
+		SlLog2 = 4,
+		SlCount = 1 << SlLog2,
+		FlCount = 64 - GranularityLog2
+	};
+
+	struct Block
+	{
+		UINT64	 Offset;
+		UINT64	 Size;
+		UINT64	 Alignment;
+		uint32_t PrevPhysical;
+		uint32_t NextPhysical;
+		uint32_t PrevFree;
+		uint32_t NextFree;
+		BOOL	 bFree;
+	};
+
+	std::vector<Block>	  m_Blocks;
+	std::vector<uint32_t> m_UnusedNodes;
+
+	uint64_t			  m_FlBitmap;
+	uint32_t			  m_SlBitmaps[FlCount];
+	uint32_t			  m_FreeHeads[FlCount][SlCount];
+
+	UINT64				  m_Capacity;
+	UINT64				  m_AllocatedBytes;
+	UINT				  m_Allocations;
+	UINT				  m_FreeBlocks;
+
+	static UINT	  FindLowestBit(uint64_t Bits);
+	static UINT	  FindHighestBit(uint64_t Bits);
+	static UINT64 AlignUp(UINT64 Value, UINT64 Alignment);
+	static VOID	  Mapping(UINT64 Size, UINT& rFl, UINT& rSl);
+
+	uint32_t NewNode(VOID);
+	VOID	 ReleaseNode(uint32_t Node);
+
+	VOID	 InsertFree(uint32_t Node);
+	VOID	 RemoveFree(uint32_t Node);
+	uint32_t FindFree(UINT64 Size);
+
+	uint32_t SplitFront(uint32_t Node, UINT64 Size);
+	VOID	 SplitBack(uint32_t Node, UINT64 Size);
+	uint32_t MergeFree(uint32_t Node);
+
+public:
+	CHeapAllocator();
+	~CHeapAllocator();
+
+	BOOL Initialize(UINT64 Capacity);
+	VOID Uninitialize(VOID);
+
+	BOOL Allocate(UINT64 nBytes, UINT64 Alignment, Allocation& rAllocation);
+	VOID Free(uint32_t Handle);
+
+	// Resizes in place when the neighbouring space allows it, otherwise rNew is a separate allocation and
+	// rOld stays live until the caller has copied its contents and freed it
+	BOOL Reallocate(CONST Allocation& rOld, UINT64 nBytes, UINT64 Alignment, Allocation& rNew);
+
+	VOID GetAllocation(uint32_t Handle, Allocation& rAllocation);
+	VOID GetStatistics(Statistics& rStatistics);
+
+	// Slides allocations towards offset 0, moving at most MaxBytes. Moves never overlap their source so each
+	// one can be done with a single copy, the bookkeeping already reflects the planned layout on return
+	VOID PlanDefragmentation(UINT64 MaxBytes, std::vector<Move>& rMoves);
+};
+
+#endif // CHEAPALLOCATOR_HPP
@@ -0,0 +1,152 @@
+#include "CInstanceBuilder.hpp"
+
+#include <cstring>
+
+#include "CTransformHierarchy.hpp"
+#include "Jobs.hpp"
+#include "Profiler.hpp"
+
+CInstanceBuilder::CInstanceBuilder()
+{
+	m_pTransforms = NULL;
+
+	for (UINT i = 0; i < MaxChunks; i++)
+	{
+		m_ChunkVisible[i] = 0;
+	}
+}
+
+CInstanceBuilder::~CInstanceBuilder()
+{
+}
+
+VOID CInstanceBuilder::Clear(VOID)
+{
+	m_Nodes.clear();
+	m_Radii.clear();
+	m_Tints.clear();
+	m_Visible.clear();
+}
+
+VOID CInstanceBuilder::Reserve(UINT nInstances)
+{
+	m_Nodes.reserve(nInstances);
+	m_Radii.reserve(nInstances);
+	m_Tints.reserve(nInstances);
+	m_Visible.reserve(nInstances);
+}
+
+UINT CInstanceBuilder::Add(UINT Node, FLOAT Radius, CONST Vec4& rTint)
+{
+	m_Nodes.push_back(Node);
+	m_Radii.push_back(Radius);
+	m_Tints.push_back(rTint);
+
+	return static_cast<UINT>(m_Nodes.size() - 1);
+}
+
+VOID CInstanceBuilder::SetTint(UINT Instance, CONST Vec4& rTint)
+{
+	if (Instance < m_Tints.size())
+	{
+		m_Tints[Instance] = rTint;
+	}
+}
+
+UINT CInstanceBuilder::GetCount(VOID)
+{
+	return static_cast<UINT>(m_Nodes.size());
+}
+
+UINT CInstanceBuilder::CullRange(UINT First, UINT Count)
+{
+	UINT nVisible = 0;
+
+	for (UINT i = First; i < First + Count; i++)
+	{
+		CONST Mat4& rWorld = m_pTransforms->GetWorld(m_Nodes[i]);
+		CONST Vec3 Center = { rWorld.m[3][0], rWorld.m[3][1], rWorld.m[3][2] };
+
+		// The longest basis vector is the largest scale along any axis
+		CONST Vec3 X = { rWorld.m[0][0], rWorld.m[0][1], rWorld.m[0][2] };
+		CONST Vec3 Y = { rWorld.m[1][0], rWorld.m[1][1], rWorld.m[1][2] };
+		CONST Vec3 Z = { rWorld.m[2][0], rWorld.m[2][1], rWorld.m[2][2] };
+		CONST FLOAT Radius = m_Radii[i] * sqrtf(fmaxf(Math::Dot(X, X), fmaxf(Math::Dot(Y, Y), Math::Dot(Z, Z))));
+		BOOL bVisible = TRUE;
+
+		for (UINT p = 0; (bVisible == TRUE) && (p < 6); p++)
+		{
+			CONST Vec4& rPlane = m_Planes[p];
+
+			if (Math::Dot(Vec3{ rPlane.x, rPlane.y, rPlane.z }, Center) + rPlane.w < -Radius)
+			{
+				bVisible = FALSE;
+			}
+		}
+
+		// Each chunk compacts into the front of its own range, Build closes the gaps between chunks
+		if (bVisible == TRUE)
+		{
+			InstanceData& rInstance = m_Visible[First + nVisible];
+
+			for (UINT c = 0; c < 3; c++)
+			{
+				rInstance.World[c][0] = rWorld.m[0][c];
+				rInstance.World[c][1] = rWorld.m[1][c];
+				rInstance.World[c][2] = rWorld.m[2][c];
+				rInstance.World[c][3] = rWorld.m[3][c];
+			}
+
+			rInstance.Tint[0] = m_Tints[i].x;
+			rInstance.Tint[1] = m_Tints[i].y;
+			rInstance.Tint[2] = m_Tints[i].z;
+			rInstance.Tint[3] = m_Tints[i].w;
+
+			nVisible++;
+		}
+	}
+
+	return nVisible;
+}
+
+VOID CInstanceBuilder::CullChunk(PVOID pData, UINT Chunk, UINT First, UINT Count)
+{
+	CInstanceBuilder* pBuilder = reinterpret_cast<CInstanceBuilder*>(pData);
+
+	pBuilder->m_ChunkVisible[Chunk] = pBuilder->CullRange(First, Count);
+}
+
+UINT CInstanceBuilder::Build(CTransformHierarchy& rTransforms, CONST Mat4& rViewProjection, InstanceData* pOutput)
+{
+	PROFILE_FUNCTION();
+
+	CONST UINT nInstances = static_cast<UINT>(m_Nodes.size());
+	UINT nVisible = 0;
+
+	m_pTransforms = &rTransforms;
+	Math::FrustumPlanes(rViewProjection, m_Planes);
+
+	m_Visible.resize(nInstances);
+
+	UINT nChunks = nInstances / MinInstancesPerChunk;
+	nChunks = (nChunks < MaxChunks) ? nChunks : static_cast<UINT>(MaxChunks);
+	nChunks = (nChunks != 0) ? nChunks : 1;
+
+	Jobs::ParallelFor(nInstances, nChunks, CullChunk, this);
+
+	for (UINT Chunk = 0; Chunk < nChunks; Chunk++)
+	{
+		UINT First = 0;
+		UINT Count = 0;
+
+		Jobs::GetChunk(nInstances, nChunks, Chunk, First, Count);
+
+		if (m_ChunkVisible[Chunk] != 0)
+		{
+			memcpy(pOutput + nVisible, &m_Visible[First], m_ChunkVisible[Chunk] * sizeof(InstanceData));
+			nVisible += m_ChunkVisible[Chunk];
+		}
+	}
+
+	return nVisible;
+}
@@ -0,0 +1,60 @@
+#ifndef CINSTANCEBUILDER_HPP
+#define CINSTANCEBUILDER_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+#include "Math.hpp"
+
+class CTransformHierarchy;
+
+// One instance in the per instance vertex stream, 64 bytes. World holds the columns of the affine part of the world
+// matrix, so the shader transforms a position with three dot products.
+struct InstanceData
+{
+	FLOAT World[3][4];
+	FLOAT Tint[4];
+};
+
+// Gathers the instances a camera can see into one compact array per frame. Every instance is a transform hierarchy node
+// with a bounding sphere that is tested against the view frustum, the visible ones are written in the order they were
+// added. Large sets are culled in chunks over the job system.
+class CInstanceBuilder
+{
+public:
+	enum { MinInstancesPerChunk = 4096, MaxChunks = 64 };
+
+protected:
+	std::vector<UINT>		  m_Nodes;
+	std::vector<FLOAT>		  m_Radii;
+	std::vector<Vec4>		  m_Tints;
+	std::vector<InstanceData> m_Visible;
+
+	// The build in progress, shared with the jobs that help with it
+	CTransformHierarchy*	  m_pTransforms;
+	Vec4					  m_Planes[6];
+	UINT					  m_ChunkVisible[MaxChunks];
+
+	UINT CullRange(UINT First, UINT Count);
+
+	static VOID CullChunk(PVOID pData, UINT Chunk, UINT First, UINT Count);
+
+public:
+	CInstanceBuilder();
+	~CInstanceBuilder();
+
+	VOID Clear(VOID);
+	VOID Reserve(UINT nInstances);
+
+	// Radius bounds the mesh around the node's origin before the node's scale is applied. Returns the instance's index.
+	UINT Add(UINT Node, FLOAT Radius, CONST Vec4& rTint);
+	VOID SetTint(UINT Instance, CONST Vec4& rTint);
+
+	UINT GetCount(VOID);
+
+	// Writes the visible instances to pOutput, which must have room for GetCount of them, and returns how many there
+	// are. pOutput is written front to back and never read, so it can point into write combined upload memory.
+	UINT Build(CTransformHierarchy& rTransforms, CONST Mat4& rViewProjection, InstanceData* pOutput);
+};
+
+#endif // CINSTANCEBUILDER_HPP
@@ -0,0 +1,566 @@
+#include "Jobs.hpp"
+#include "CJobSystem.hpp"
+
+#include <cstdio>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+#include "Profiler.hpp"
+
+CJobSystem g_JobSystem;
+
+// Shared by the calling thread of a ParallelFor and the jobs that help it
+struct ParallelForData
+{
+	Jobs::RangeFunction pFunction;
+	PVOID				pData;
+	UINT				nItems;
+	UINT				nChunks;
+	std::atomic<UINT>	NextChunk;
+};
+
+thread_local UINT CJobSystem::t_ThreadIndex = Jobs::InvalidThreadIndex;
+thread_local UINT CJobSystem::t_StealSeed = 0;
+
+// A counter whose waiting list points back at itself is closed, jobs queued after it are started immediately
+Jobs::Counter::Counter()
+{
+	m_Pending = 0;
+	m_pWaiting = this;
+	m_nReleasing = 0;
+}
+
+UINT Jobs::Counter::GetPending(VOID)
+{
+	return m_Pending.load();
+}
+
+BOOL Jobs::Initialize(UINT nWorkers)
+{
+	return g_JobSystem.Initialize(nWorkers);
+}
+
+VOID Jobs::Uninitialize(VOID)
+{
+	g_JobSystem.Uninitialize();
+}
+
+BOOL Jobs::Run(JobFunction pFunction, PVOID pData, Counter* pCounter)
+{
+	return g_JobSystem.Run(ANY_THREAD, pFunction, pData, pCounter);
+}
+
+BOOL Jobs::RunOnMainThread(JobFunction pFunction, PVOID pData, Counter* pCounter)
+{
+	return g_JobSystem.Run(MAIN_THREAD, pFunction, pData, pCounter);
+}
+
+BOOL Jobs::RunAfter(Counter* pDependency, Affinity eAffinity, JobFunction pFunction, PVOID pData, Counter* pCounter)
+{
+	return g_JobSystem.RunAfter(pDependency, eAffinity, pFunction, pData, pCounter);
+}
+
+VOID Jobs::Wait(Counter* pCounter)
+{
+	g_JobSystem.Wait(pCounter);
+}
+
+VOID Jobs::PumpMainThread(VOID)
+{
+	g_JobSystem.PumpMainThread();
+}
+
+UINT Jobs::GetWorkerCount(VOID)
+{
+	return g_JobSystem.GetWorkerCount();
+}
+
+UINT Jobs::GetThreadIndex(VOID)
+{
+	return g_JobSystem.GetThreadIndex();
+}
+
+static VOID ParallelForJob(PVOID pData)
+{
+	ParallelForData* pParallelFor = reinterpret_cast<ParallelForData*>(pData);
+
+	for (UINT Chunk = pParallelFor->NextChunk.fetch_add(1); Chunk < pParallelFor->nChunks; Chunk = pParallelFor->NextChunk.fetch_add(1))
+	{
+		UINT First = 0;
+		UINT Count = 0;
+
+		Jobs::GetChunk(pParallelFor->nItems, pParallelFor->nChunks, Chunk, First, Count);
+		pParallelFor->pFunction(pParallelFor->pData, Chunk, First, Count);
+	}
+}
+
+VOID Jobs::ParallelFor(UINT nItems, UINT nChunks, RangeFunction pFunction, PVOID pData)
+{
+	ParallelForData ParallelFor;
+
+	ParallelFor.pFunction = pFunction;
+	ParallelFor.pData = pData;
+	ParallelFor.nItems = nItems;
+	ParallelFor.nChunks = (nChunks != 0) ? nChunks : 1;
+	ParallelFor.NextChunk = 0;
+
+	if (ParallelFor.nChunks == 1)
+	{
+		ParallelForJob(&ParallelFor);
+	}
+	else
+	{
+		// Jobs that start after every chunk has been claimed return straight away
+		Counter Chunks;
+
+		for (UINT i = 1; i < ParallelFor.nChunks; i++)
+		{
+			Run(ParallelForJob, &ParallelFor, &Chunks);
+		}
+
+		ParallelForJob(&ParallelFor);
+
+		Wait(&Chunks);
+	}
+}
+
+VOID Jobs::GetChunk(UINT nItems, UINT nChunks, UINT Chunk, UINT& rFirst, UINT& rCount)
+{
+	// Spread the remainder over the first chunks so no chunk gets more than one extra item
+	CONST UINT Base = (nChunks != 0) ? (nItems / nChunks) : nItems;
+	CONST UINT Extra = (nChunks != 0) ? (nItems % nChunks) : 0;
+
+	rFirst = Chunk * Base + ((Chunk < Extra) ? Chunk : Extra);
+	rCount = Base + ((Chunk < Extra) ? 1 : 0);
+}
+
+CJobSystem::CJobSystem()
+{
+	m_nInjected = 0;
+	m_Epoch = 0;
+	m_nSleeping = 0;
+	m_bQuit = FALSE;
+	m_bInitialized = FALSE;
+}
+
+CJobSystem::~CJobSystem()
+{
+	Uninitialize();
+}
+
+BOOL CJobSystem::Initialize(UINT nWorkers)
+{
+	BOOL Status = (m_bInitialized == FALSE) ? TRUE : FALSE;
+
+	if (Status == TRUE)
+	{
+		if (nWorkers == 0)
+		{
+			UINT nHardwareThreads = std::thread::hardware_concurrency();
+			nWorkers = (nHardwareThreads > 1) ? (nHardwareThreads - 1) : 0;
+		}
+
+		nWorkers = (nWorkers > MaxWorkers) ? static_cast<UINT>(MaxWorkers) : nWorkers;
+
+		m_bQuit = FALSE;
+		t_ThreadIndex = 0;
+
+		// Deque 0 belongs to the main thread, the others to the workers
+		for (UINT i = 0; (i <= nWorkers) && (Status == TRUE); i++)
+		{
+			CWorkStealingDeque* pDeque = new CWorkStealingDeque();
+
+			if (pDeque != NULL)
+			{
+				m_Deques.push_back(pDeque);
+			}
+			else
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to allocate job deque\n");
+			}
+		}
+
+		if (Status == TRUE)
+		{
+			for (UINT i = 1; i <= nWorkers; i++)
+			{
+				m_Workers.push_back(std::thread(&CJobSystem::WorkerMain, this, i));
+			}
+
+			m_bInitialized = TRUE;
+		}
+		else
+		{
+			for (SIZE_T i = 0; i < m_Deques.size(); i++)
+			{
+				delete m_Deques[i];
+			}
+
+			m_Deques.clear();
+		}
+	}
+
+	return Status;
+}
+
+VOID CJobSystem::Uninitialize(VOID)
+{
+	if (m_bInitialized == TRUE)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_SleepLock);
+			m_bQuit = TRUE;
+		}
+
+		m_WakeUp.notify_all();
+
+		for (SIZE_T i = 0; i < m_Workers.size(); i++)
+		{
+			m_Workers[i].join();
+		}
+
+		m_Workers.clear();
+
+		// Jobs that never ran are dropped, their counters are left as they are
+		UINT nDropped = 0;
+
+		for (SIZE_T i = 0; i < m_Deques.size(); i++)
+		{
+			for (PVOID pJob = m_Deques[i]->Steal(); pJob != NULL; pJob = m_Deques[i]->Steal())
+			{
+				Memory::Free(pJob);
+				nDropped++;
+			}
+
+			delete m_Deques[i];
+		}
+
+		m_Deques.clear();
+
+		for (SIZE_T i = 0; i < m_Injected.size(); i++)
+		{
+			Memory::Free(m_Injected[i]);
+			nDropped++;
+		}
+
+		for (SIZE_T i = 0; i < m_MainThreadJobs.size(); i++)
+		{
+			Memory::Free(m_MainThreadJobs[i]);
+			nDropped++;
+		}
+
+		m_Injected.clear();
+		m_MainThreadJobs.clear();
+		m_nInjected = 0;
+
+		if (nDropped != 0)
+		{
+			CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: %u jobs were still queued at shutdown\n", nDropped);
+		}
+
+		t_ThreadIndex = Jobs::InvalidThreadIndex;
+		m_bInitialized = FALSE;
+	}
+}
+
+CJobSystem::Job* CJobSystem::CreateJob(Jobs::Affinity eAffinity, Jobs::JobFunction pFunction, PVOID pData, Jobs::Counter* pCounter)
+{
+	Job* pJob = reinterpret_cast<Job*>(Memory::Allocate(sizeof(Job), FALSE));
+
+	if (pJob != NULL)
+	{
+		pJob->pFunction = pFunction;
+		pJob->pData = pData;
+		pJob->pCounter = pCounter;
+		pJob->pNext = NULL;
+		pJob->eAffinity = eAffinity;
+
+		// The first job on an idle counter opens its waiting list again. The Release that finished the previous jobs
+		// may not have closed it yet, and the jobs still on it are that Release's to schedule, so only a closed list
+		// is reopened.
+		if ((pCounter != NULL) && (pCounter->m_Pending.fetch_add(1) == 0))
+		{
+			PVOID pClosed = pCounter;
+
+			while (pCounter->m_pWaiting.compare_exchange_weak(pClosed, NULL) == false)
+			{
+				pClosed = pCounter;
+				std::this_thread::yield();
+			}
+		}
+	}
+	else
+	{
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to allocate job\n");
+	}
+
+	return pJob;
+}
+
+VOID CJobSystem::Wake(VOID)
+{
+	m_Epoch.fetch_add(1);
+
+	// Taking the lock orders this against a worker that is between its last check and going to sleep
+	if (m_nSleeping.load() != 0)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_SleepLock);
+		}
+
+		m_WakeUp.notify_one();
+	}
+}
+
+VOID CJobSystem::Schedule(Job* pJob)
+{
+	UINT ThreadIndex = t_ThreadIndex;
+
+	if (pJob->eAffinity == Jobs::MAIN_THREAD)
+	{
+		std::lock_guard<std::mutex> Lock(m_QueueLock);
+		m_MainThreadJobs.push_back(pJob);
+	}
+	else
+	{
+		if ((ThreadIndex >= m_Deques.size()) || (m_Deques[ThreadIndex]->Push(pJob) != TRUE))
+		{
+			std::lock_guard<std::mutex> Lock(m_QueueLock);
+			m_Injected.push_back(pJob);
+			m_nInjected++;
+		}
+
+		Wake();
+	}
+}
+
+VOID CJobSystem::Release(Jobs::Counter* pCounter)
+{
+	Job* pJob = NULL;
+
+	// Wait does not return while a Release is between its decrement and closing the list
+	pCounter->m_nReleasing.fetch_add(1);
+
+	if (pCounter->m_Pending.fetch_sub(1) == 1)
+	{
+		PVOID pWaiting = pCounter->m_pWaiting.exchange(pCounter);
+
+		// The closed marker is the counter itself, never a job
+		pJob = (pWaiting != pCounter) ? reinterpret_cast<Job*>(pWaiting) : NULL;
+	}
+
+	// Last access, once this is done the counter may already be gone
+	pCounter->m_nReleasing.fetch_sub(1);
+
+	while (pJob != NULL)
+	{
+		Job* pNext = pJob->pNext;
+
+		pJob->pNext = NULL;
+		Schedule(pJob);
+
+		pJob = pNext;
+	}
+}
+
+VOID CJobSystem::Execute(Job* pJob)
+{
+	Jobs::Counter* pCounter = pJob->pCounter;
+
+	pJob->pFunction(pJob->pData);
+
+	Memory::Free(pJob);
+
+	if (pCounter != NULL)
+	{
+		Release(pCounter);
+	}
+}
+
+CJobSystem::Job* CJobSystem::FindJob(BOOL bMainThread)
+{
+	Job* pJob = NULL;
+	UINT ThreadIndex = t_ThreadIndex;
+	UINT nDeques = static_cast<UINT>(m_Deques.size());
+
+	if (bMainThread == TRUE)
+	{
+		std::lock_guard<std::mutex> Lock(m_QueueLock);
+
+		if (m_MainThreadJobs.size() != 0)
+		{
+			pJob = m_MainThreadJobs.front();
+			m_MainThreadJobs.pop_front();
+		}
+	}
+
+	if ((pJob == NULL) && (ThreadIndex < nDeques))
+	{
+		pJob = reinterpret_cast<Job*>(m_Deques[ThreadIndex]->Pop());
+	}
+
+	if ((pJob == NULL) && (m_nInjected.load() != 0))
+	{
+		std::lock_guard<std::mutex> Lock(m_QueueLock);
+
+		if (m_Injected.size() != 0)
+		{
+			pJob = m_Injected.front();
+			m_Injected.pop_front();
+			m_nInjected--;
+		}
+	}
+
+	// Steal, starting at a different victim every time so thieves spread out
+	if ((pJob == NULL) && (nDeques != 0))
+	{
+		t_StealSeed = t_StealSeed * 1664525u + 1013904223u;
+
+		UINT First = (t_StealSeed >> 16) % nDeques;
+
+		for (UINT i = 0; (pJob == NULL) && (i < nDeques); i++)
+		{
+			UINT Victim = (First + i) % nDeques;
+
+			if (Victim != ThreadIndex)
+			{
+				pJob = reinterpret_cast<Job*>(m_Deques[Victim]->Steal());
+			}
+		}
+	}
+
+	return pJob;
+}
+
+VOID CJobSystem::WorkerMain(UINT ThreadIndex)
+{
+	t_ThreadIndex = ThreadIndex;
+	t_StealSeed = ThreadIndex * 2654435761u;
+
+	CHAR Name[32] = { };
+	snprintf(Name, sizeof(Name), "Worker %u", ThreadIndex);
+	Profiler::SetThreadName(Name);
+
+	UINT nIdle = 0;
+
+	while (m_bQuit.load() == FALSE)
+	{
+		UINT64 Epoch = m_Epoch.load();
+		Job* pJob = FindJob(FALSE);
+
+		if (pJob != NULL)
+		{
+			Execute(pJob);
+			nIdle = 0;
+		}
+		else if (nIdle < SpinCount)
+		{
+			std::this_thread::yield();
+			nIdle++;
+		}
+		else
+		{
+			// Nothing was found after Epoch was read, any job scheduled since then has moved it on
+			std::unique_lock<std::mutex> Lock(m_SleepLock);
+
+			m_nSleeping++;
+			m_WakeUp.wait(Lock, [&] { return (m_bQuit.load() == TRUE) || (m_Epoch.load() != Epoch); });
+			m_nSleeping--;
+
+			nIdle = 0;
+		}
+	}
+}
+
+BOOL CJobSystem::Run(Jobs::Affinity eAffinity, Jobs::JobFunction pFunction, PVOID pData, Jobs::Counter* pCounter)
+{
+	Job* pJob = CreateJob(eAffinity, pFunction, pData, pCounter);
+
+	if (pJob != NULL)
+	{
+		Schedule(pJob);
+	}
+
+	return (pJob != NULL) ? TRUE : FALSE;
+}
+
+BOOL CJobSystem::RunAfter(Jobs::Counter* pDependency, Jobs::Affinity eAffinity, Jobs::JobFunction pFunction, PVOID pData, Jobs::Counter* pCounter)
+{
+	Job* pJob = CreateJob(eAffinity, pFunction, pData, pCounter);
+
+	if ((pJob != NULL) && (pDependency != NULL))
+	{
+		PVOID pHead = pDependency->m_pWaiting.load();
+
+		while (TRUE)
+		{
+			if (pHead == pDependency)
+			{
+				// Already finished
+				Schedule(pJob);
+				break;
+			}
+
+			pJob->pNext = reinterpret_cast<Job*>(pHead);
+
+			if (pDependency->m_pWaiting.compare_exchange_weak(pHead, pJob) == true)
+			{
+				break;
+			}
+		}
+	}
+	else if (pJob != NULL)
+	{
+		Schedule(pJob);
+	}
+
+	return (pJob != NULL) ? TRUE : FALSE;
+}
+
+VOID CJobSystem::Wait(Jobs::Counter* pCounter)
+{
+	BOOL bMainThread = (t_ThreadIndex == 0) ? TRUE : FALSE;
+
+	// Finished means no pending jobs, the waiting list closed and no Release still using it, after that nothing
+	// touches the counter again. Every Release is counted before its decrement, so reading them in this order sees it.
+	while ((pCounter != NULL) && ((pCounter->m_Pending.load() != 0) || (pCounter->m_pWaiting.load() != pCounter) || (pCounter->m_nReleasing.load() != 0)))
+	{
+		Job* pJob = FindJob(bMainThread);
+
+		if (pJob != NULL)
+		{
+			Execute(pJob);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+VOID CJobSystem::PumpMainThread(VOID)
+{
+	std::deque<Job*> MainThreadJobs;
+
+	{
+		std::lock_guard<std::mutex> Lock(m_QueueLock);
+		MainThreadJobs.swap(m_MainThreadJobs);
+	}
+
+	// Jobs queued while these run are picked up by the next pump
+	for (SIZE_T i = 0; i < MainThreadJobs.size(); i++)
+	{
+		Execute(MainThreadJobs[i]);
+	}
+}
+
+UINT CJobSystem::GetWorkerCount(VOID)
+{
+	return static_cast<UINT>(m_Workers.size());
+}
+
+UINT CJobSystem::GetThreadIndex(VOID)
+{
+	return t_ThreadIndex;
+}
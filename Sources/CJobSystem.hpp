@@ -0,0 +1,76 @@
+#ifndef CJOBSYSTEM_HPP
+#define CJOBSYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "Jobs.hpp"
+
+#include "CWorkStealingDeque.hpp"
+
+class CJobSystem
+{
+protected:
+	enum { MaxWorkers = 63, SpinCount = 64 };
+
+	struct Job
+	{
+		Jobs::JobFunction pFunction;
+		PVOID			  pData;
+		Jobs::Counter*	  pCounter;
+		Job*			  pNext;
+		Jobs::Affinity	  eAffinity;
+	};
+
+	static thread_local UINT t_ThreadIndex;
+	static thread_local UINT t_StealSeed;
+
+	std::vector<std::thread>		 m_Workers;
+	std::vector<CWorkStealingDeque*> m_Deques;
+
+	// Jobs from threads that do not own a deque, and jobs that may only run on the main thread
+	std::mutex						 m_QueueLock;
+	std::deque<Job*>				 m_Injected;
+	std::deque<Job*>				 m_MainThreadJobs;
+	std::atomic<UINT>				 m_nInjected;
+
+	std::mutex						 m_SleepLock;
+	std::condition_variable			 m_WakeUp;
+	std::atomic<UINT64>				 m_Epoch;
+	std::atomic<UINT>				 m_nSleeping;
+	std::atomic<BOOL>				 m_bQuit;
+	BOOL							 m_bInitialized;
+
+	Job* CreateJob(Jobs::Affinity eAffinity, Jobs::JobFunction pFunction, PVOID pData, Jobs::Counter* pCounter);
+	VOID Schedule(Job* pJob);
+	VOID Execute(Job* pJob);
+	VOID Release(Jobs::Counter* pCounter);
+	VOID Wake(VOID);
+
+	Job* FindJob(BOOL bMainThread);
+	VOID WorkerMain(UINT ThreadIndex);
+
+public:
+	CJobSystem();
+	~CJobSystem();
+
+	BOOL Initialize(UINT nWorkers);
+	VOID Uninitialize(VOID);
+
+	BOOL Run(Jobs::Affinity eAffinity, Jobs::JobFunction pFunction, PVOID pData, Jobs::Counter* pCounter);
+	BOOL RunAfter(Jobs::Counter* pDependency, Jobs::Affinity eAffinity, Jobs::JobFunction pFunction, PVOID pData, Jobs::Counter* pCounter);
+
+	VOID Wait(Jobs::Counter* pCounter);
+	VOID PumpMainThread(VOID);
+
+	UINT GetWorkerCount(VOID);
+	UINT GetThreadIndex(VOID);
+};
+
+#endif // CJOBSYSTEM_HPP
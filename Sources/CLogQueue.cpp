@@ -0,0 +1,140 @@
+#include "CLogQueue.hpp"
+
+#include "Memory.hpp"
+
+CLogQueue::CLogQueue()
+{
+	m_pRecords = NULL;
+	m_EnqueuePosition = 0;
+	m_DequeuePosition = 0;
+	m_Dropped = 0;
+}
+
+CLogQueue::~CLogQueue()
+{
+	Uninitialize();
+}
+
+BOOL CLogQueue::Initialize(VOID)
+{
+	BOOL Status = TRUE;
+
+	Uninitialize();
+
+	m_pRecords = reinterpret_cast<Record*>(Memory::Allocate(sizeof(Record) * Capacity, TRUE));
+
+	if (m_pRecords == NULL)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		// A record is free for the producer at position p when its sequence is p, and ready for the consumer at p + 1
+		for (UINT i = 0; i < Capacity; i++)
+		{
+			m_pRecords[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		m_EnqueuePosition = 0;
+		m_DequeuePosition = 0;
+		m_Dropped = 0;
+	}
+
+	return Status;
+}
+
+VOID CLogQueue::Uninitialize(VOID)
+{
+	if (m_pRecords != NULL)
+	{
+		Memory::Free(m_pRecords);
+		m_pRecords = NULL;
+	}
+}
+
+CLogQueue::Record* CLogQueue::Acquire(VOID)
+{
+	Record* pRecord = NULL;
+	UINT64 Position = m_EnqueuePosition.load(std::memory_order_relaxed);
+
+	while (m_pRecords != NULL)
+	{
+		Record* pCandidate = &m_pRecords[Position & Mask];
+		int64_t Difference = static_cast<int64_t>(pCandidate->Sequence.load(std::memory_order_acquire) - Position);
+
+		if (Difference == 0)
+		{
+			if (m_EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed) == true)
+			{
+				pRecord = pCandidate;
+				break;
+			}
+		}
+		else if (Difference < 0)
+		{
+			// The consumer has not released this record yet, the queue is full
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			break;
+		}
+		else
+		{
+			Position = m_EnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	return pRecord;
+}
+
+VOID CLogQueue::Publish(Record* pRecord)
+{
+	// The record was free at position Sequence, mark it ready
+	pRecord->Sequence.store(pRecord->Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+CLogQueue::Record* CLogQueue::Peek(VOID)
+{
+	Record* pRecord = NULL;
+	UINT64 Position = m_DequeuePosition.load(std::memory_order_relaxed);
+
+	if (m_pRecords != NULL)
+	{
+		Record* pCandidate = &m_pRecords[Position & Mask];
+
+		if (pCandidate->Sequence.load(std::memory_order_acquire) == (Position + 1))
+		{
+			pRecord = pCandidate;
+		}
+	}
+
+	return pRecord;
+}
+
+VOID CLogQueue::Pop(VOID)
+{
+	UINT64 Position = m_DequeuePosition.load(std::memory_order_relaxed);
+
+	// Hand the record back to the producers for the next lap
+	m_pRecords[Position & Mask].Sequence.store(Position + Capacity, std::memory_order_release);
+	m_DequeuePosition.store(Position + 1, std::memory_order_release);
+}
+
+BOOL CLogQueue::IsEmpty(VOID)
+{
+	return (Peek() == NULL) ? TRUE : FALSE;
+}
+
+UINT64 CLogQueue::GetEnqueued(VOID)
+{
+	return m_EnqueuePosition.load(std::memory_order_acquire);
+}
+
+UINT64 CLogQueue::GetDequeued(VOID)
+{
+	return m_DequeuePosition.load(std::memory_order_acquire);
+}
+
+UINT64 CLogQueue::TakeDropped(VOID)
+{
+	return m_Dropped.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,54 @@
+#ifndef CLOGQUEUE_HPP
+#define CLOGQUEUE_HPP
+
+#include <atomic>
+
+#include "Defines.hpp"
+
+// Bounded lock-free queue of formatted log records, any number of producers and a single consumer.
+// Producers claim a record, format straight into it and publish it. When the queue is full the message is dropped
+// and counted instead of blocking the caller.
+class CLogQueue
+{
+public:
+	enum { Capacity = 1024, MaxLength = 1024 };
+
+	struct Record
+	{
+		std::atomic<UINT64> Sequence;
+		uint8_t				Level;
+		UINT				Length;
+		CHAR				Text[MaxLength];
+	};
+
+protected:
+	enum { Mask = Capacity - 1 };
+
+	Record*				m_pRecords;
+
+	alignas(64) std::atomic<UINT64> m_EnqueuePosition;
+	alignas(64) std::atomic<UINT64> m_DequeuePosition;
+	alignas(64) std::atomic<UINT64> m_Dropped;
+
+public:
+	CLogQueue();
+	~CLogQueue();
+
+	BOOL Initialize(VOID);
+	VOID Uninitialize(VOID);
+
+	// Producer side, every successful Acquire has to be followed by Publish
+	Record* Acquire(VOID);
+	VOID	Publish(Record* pRecord);
+
+	// Consumer side
+	Record* Peek(VOID);
+	VOID	Pop(VOID);
+
+	BOOL   IsEmpty(VOID);
+	UINT64 GetEnqueued(VOID);
+	UINT64 GetDequeued(VOID);
+	UINT64 TakeDropped(VOID);
+};
+
+#endif // CLOGQUEUE_HPP
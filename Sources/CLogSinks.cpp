@@ -0,0 +1,187 @@
+#include "CLogSinks.hpp"
+
+#include "Console.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cstdio>
+#endif
+
+CStdOutLogSink::CStdOutLogSink()
+{
+	m_hStdOut = NULL;
+	m_hStdErr = NULL;
+	m_MinLevel = Console::LEVEL_INFO;
+}
+
+CStdOutLogSink::~CStdOutLogSink()
+{
+}
+
+BOOL CStdOutLogSink::Initialize(VOID)
+{
+	BOOL Status = TRUE;
+
+#if defined(_WIN32)
+	m_hStdOut = GetStdHandle(STD_OUTPUT_HANDLE);
+	m_hStdErr = GetStdHandle(STD_ERROR_HANDLE);
+
+	if ((m_hStdOut == NULL) || (m_hStdOut == INVALID_HANDLE_VALUE) || (m_hStdErr == NULL) || (m_hStdErr == INVALID_HANDLE_VALUE))
+	{
+		Status = FALSE;
+	}
+#else
+	m_hStdOut = stdout;
+	m_hStdErr = stderr;
+#endif
+
+	return Status;
+}
+
+VOID CStdOutLogSink::SetMinLevel(uint8_t MinLevel)
+{
+	m_MinLevel = MinLevel;
+}
+
+VOID CStdOutLogSink::Write(uint8_t Level, LPCSTR pText, SIZE_T Length)
+{
+	if (Level >= m_MinLevel)
+	{
+#if defined(_WIN32)
+		DWORD CharsWritten = 0;
+		WriteConsoleA((Level >= Console::LEVEL_WARNING) ? m_hStdErr : m_hStdOut, pText, static_cast<DWORD>(Length), &CharsWritten, NULL);
+#else
+		if (Level >= Console::LEVEL_WARNING)
+		{
+			// Standard error is unbuffered, what is still buffered for standard output was written first
+			fflush(reinterpret_cast<FILE*>(m_hStdOut));
+			fwrite(pText, 1, Length, reinterpret_cast<FILE*>(m_hStdErr));
+		}
+		else
+		{
+			fwrite(pText, 1, Length, reinterpret_cast<FILE*>(m_hStdOut));
+		}
+#endif
+	}
+}
+
+VOID CStdOutLogSink::Flush(VOID)
+{
+#if !defined(_WIN32)
+	fflush(reinterpret_cast<FILE*>(m_hStdOut));
+#endif
+}
+
+CFileLogSink::CFileLogSink()
+{
+	m_MinLevel = Console::LEVEL_DEBUG;
+}
+
+CFileLogSink::~CFileLogSink()
+{
+	Close();
+}
+
+BOOL CFileLogSink::Open(LPCSTR pPath, uint8_t MinLevel)
+{
+	Close();
+
+	m_File.open(pPath, std::ios::binary | std::ios::trunc);
+	m_MinLevel = MinLevel;
+
+	return (m_File.is_open() == true) ? TRUE : FALSE;
+}
+
+VOID CFileLogSink::Close(VOID)
+{
+	if (m_File.is_open() == true)
+	{
+		m_File.close();
+	}
+}
+
+BOOL CFileLogSink::IsOpen(VOID)
+{
+	return (m_File.is_open() == true) ? TRUE : FALSE;
+}
+
+VOID CFileLogSink::Write(uint8_t Level, LPCSTR pText, SIZE_T Length)
+{
+	if ((m_File.is_open() == true) && (Level >= m_MinLevel))
+	{
+		m_File.write(pText, static_cast<std::streamsize>(Length));
+	}
+}
+
+VOID CFileLogSink::Flush(VOID)
+{
+	if (m_File.is_open() == true)
+	{
+		m_File.flush();
+	}
+}
+
+CRingLogSink::CRingLogSink()
+{
+	m_Head = 0;
+	m_Size = 0;
+}
+
+CRingLogSink::~CRingLogSink()
+{
+}
+
+VOID CRingLogSink::Write(uint8_t Level, LPCSTR pText, SIZE_T Length)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+
+	// Only the tail of an oversized message can survive anyway
+	if (Length > Capacity)
+	{
+		pText += Length - Capacity;
+		Length = Capacity;
+	}
+
+	for (SIZE_T i = 0; i < Length; i++)
+	{
+		m_Buffer[m_Head] = pText[i];
+		m_Levels[m_Head] = Level;
+		m_Head = (m_Head + 1) % Capacity;
+	}
+
+	m_Size = ((m_Size + Length) > Capacity) ? static_cast<SIZE_T>(Capacity) : (m_Size + Length);
+}
+
+VOID CRingLogSink::Flush(VOID)
+{
+}
+
+SIZE_T CRingLogSink::Copy(PCHAR pBuffer, SIZE_T BufferSize, uint8_t MinLevel)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+
+	SIZE_T nChars = 0;
+	SIZE_T nScanned = 0;
+
+	// Walk back from the newest character until the buffer is full, then copy forward from there
+	for (; (nScanned < m_Size) && (nChars < BufferSize); nScanned++)
+	{
+		nChars += (m_Levels[(m_Head + Capacity - 1 - nScanned) % Capacity] >= MinLevel) ? 1 : 0;
+	}
+
+	SIZE_T Start = (m_Head + Capacity - nScanned) % Capacity;
+	SIZE_T nCopied = 0;
+
+	for (SIZE_T i = 0; i < nScanned; i++)
+	{
+		SIZE_T Index = (Start + i) % Capacity;
+
+		if (m_Levels[Index] >= MinLevel)
+		{
+			pBuffer[nCopied++] = m_Buffer[Index];
+		}
+	}
+
+	return nCopied;
+}
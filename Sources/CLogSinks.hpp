@@ -0,0 +1,72 @@
+#ifndef CLOGSINKS_HPP
+#define CLOGSINKS_HPP
+
+#include <fstream>
+#include <mutex>
+
+#include "Defines.hpp"
+
+#include "ILogSink.hpp"
+
+// Warnings and errors go to standard error, everything else at or above the minimum level to standard output
+class CStdOutLogSink : public ILogSink
+{
+protected:
+	HANDLE	m_hStdOut;
+	HANDLE	m_hStdErr;
+	uint8_t m_MinLevel;
+
+public:
+	CStdOutLogSink();
+	~CStdOutLogSink();
+
+	BOOL Initialize(VOID);
+	VOID SetMinLevel(uint8_t MinLevel);
+
+	virtual VOID Write(uint8_t Level, LPCSTR pText, SIZE_T Length);
+	virtual VOID Flush(VOID);
+};
+
+class CFileLogSink : public ILogSink
+{
+protected:
+	std::ofstream m_File;
+	uint8_t		  m_MinLevel;
+
+public:
+	CFileLogSink();
+	~CFileLogSink();
+
+	BOOL Open(LPCSTR pPath, uint8_t MinLevel);
+	VOID Close(VOID);
+	BOOL IsOpen(VOID);
+
+	virtual VOID Write(uint8_t Level, LPCSTR pText, SIZE_T Length);
+	virtual VOID Flush(VOID);
+};
+
+// Keeps the last Capacity characters of output in memory, so they can be shown or dumped after the fact. Every
+// character remembers the level of its message, so the errors can be picked out of the chatter around them.
+class CRingLogSink : public ILogSink
+{
+protected:
+	enum { Capacity = 64 * 1024 };
+
+	std::mutex m_Lock;
+	CHAR	   m_Buffer[Capacity];
+	uint8_t	   m_Levels[Capacity];
+	SIZE_T	   m_Head;
+	SIZE_T	   m_Size;
+
+public:
+	CRingLogSink();
+	~CRingLogSink();
+
+	// Copies the most recent output of messages at MinLevel or above, oldest first
+	SIZE_T Copy(PCHAR pBuffer, SIZE_T BufferSize, uint8_t MinLevel);
+
+	virtual VOID Write(uint8_t Level, LPCSTR pText, SIZE_T Length);
+	virtual VOID Flush(VOID);
+};
+
+#endif // CLOGSINKS_HPP
@@ -1,10 +1,21 @@
 #include "Memory.hpp"
 #include "CMemory.hpp"
 
-#include <windows.h>
+#include <cstdint>
+#include <cstring>
+
+#include "Console.hpp"
+#include "CPageAllocator.hpp"
 
 CMemory g_Memory;
 
+CONST SIZE_T CMemory::SizeClasses[NumSizeClasses] =
+{
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+thread_local CMemory::ThreadCache CMemory::t_Cache;
+
 BOOL Memory::Initialize(VOID)
 {
 	return g_Memory.Initialize();
@@ -25,9 +36,101 @@ BOOL Memory::Free(PVOID pMemory)
 	return g_Memory.Free(pMemory);
 }
 
+BOOL Memory::CreateFrameArenas(UINT nArenas, SIZE_T nBytesPerArena)
+{
+	return g_Memory.CreateFrameArenas(nArenas, nBytesPerArena);
+}
+
+VOID Memory::DestroyFrameArenas(VOID)
+{
+	g_Memory.DestroyFrameArenas();
+}
+
+VOID Memory::BeginFrame(UINT FrameIndex)
+{
+	g_Memory.BeginFrame(FrameIndex);
+}
+
+PVOID Memory::AllocateFrame(SIZE_T nBytes, SIZE_T Alignment)
+{
+	return g_Memory.AllocateFrame(nBytes, Alignment);
+}
+
+VOID Memory::EndFrame(VOID)
+{
+	g_Memory.EndFrame();
+}
+
+UINT Memory::GetSizeClassCount(VOID)
+{
+	return g_Memory.GetSizeClassCount();
+}
+
+BOOL Memory::GetStatistics(UINT SizeClass, Statistics& rStatistics)
+{
+	return g_Memory.GetStatistics(SizeClass, rStatistics);
+}
+
+BOOL Memory::GetFrameStatistics(FrameStatistics& rStatistics)
+{
+	return g_Memory.GetFrameStatistics(rStatistics);
+}
+
+VOID Memory::ReportStatistics(VOID)
+{
+	Statistics Stats = { };
+
+	Console::Write("Memory statistics:\n");
+
+	for (UINT i = 0; GetStatistics(i, Stats) == TRUE; i++)
+	{
+		if ((Stats.Hits + Stats.Misses) != 0)
+		{
+			Console::Write("\t%4u bytes: %llu hits, %llu misses\n", static_cast<UINT>(Stats.BlockSize), Stats.Hits, Stats.Misses);
+		}
+	}
+
+	Console::Write("\tLarge: %llu allocations\n", g_Memory.GetLargeAllocationCount());
+
+	FrameStatistics FrameStats = { };
+
+	if (GetFrameStatistics(FrameStats) == TRUE)
+	{
+		Console::Write("\tFrame arena: %llu bytes last frame, %llu bytes high-water mark, %llu bytes capacity\n", static_cast<UINT64>(FrameStats.LastFrameUsed), static_cast<UINT64>(FrameStats.HighWaterMark), static_cast<UINT64>(FrameStats.Capacity));
+	}
+}
+
 CMemory::CMemory()
 {
-	m_hHeap = NULL;
+	m_PageSize = 0;
+	m_Epoch = 1;
+	m_bInitialized = FALSE;
+	m_pSlabs = NULL;
+	m_LargeAllocations = 0;
+
+	m_nFrameArenas = 0;
+	m_pCurrentFrameArena = NULL;
+	m_FrameArenaCapacity = 0;
+	m_LastFrameUsed = 0;
+	m_FrameHighWaterMark = 0;
+
+	for (UINT i = 0; i < NumSizeClasses; i++)
+	{
+		m_Central[i].pHead = NULL;
+		m_Central[i].Count = 0;
+		m_Central[i].Hits = 0;
+		m_Central[i].Misses = 0;
+	}
+
+	for (UINT i = 0, SizeClass = 0; i < sizeof(m_SizeClassLookup); i++)
+	{
+		while (SizeClasses[SizeClass] < i * LookupGranularity)
+		{
+			SizeClass++;
+		}
+
+		m_SizeClassLookup[i] = static_cast<uint8_t>(SizeClass);
+	}
 }
 
 CMemory::~CMemory()
@@ -38,38 +141,475 @@ BOOL CMemory::Initialize(VOID)
 {
 	BOOL Status = TRUE;
 
-	m_hHeap = GetProcessHeap();
+	m_PageSize = CPageAllocator::GetPageSize();
 
-	if (m_hHeap == NULL)
+	if (m_PageSize == 0)
 	{
 		Status = FALSE;
 	}
 
+	if (Status == TRUE)
+	{
+		m_bInitialized = TRUE;
+	}
+
 	return Status;
 }
 
 VOID CMemory::Uninitialize(VOID)
 {
-	m_hHeap = NULL;
+	m_bInitialized = FALSE;
+
+	DestroyFrameArenas();
+
+	// Invalidates every thread cache, they still point into the slabs released below
+	m_Epoch++;
+
+	for (UINT i = 0; i < NumSizeClasses; i++)
+	{
+		std::lock_guard<std::mutex> Lock(m_Central[i].Lock);
+
+		m_Central[i].pHead = NULL;
+		m_Central[i].Count = 0;
+	}
+
+	std::lock_guard<std::mutex> Lock(m_SlabLock);
+
+	while (m_pSlabs != NULL)
+	{
+		Slab* pSlab = m_pSlabs;
+		m_pSlabs = pSlab->pNext;
+
+		CPageAllocator::Unmap(pSlab, pSlab->Size);
+	}
+}
+
+UINT CMemory::GetSizeClass(SIZE_T nBytes)
+{
+	UINT SizeClass = LargeSizeClass;
+
+	if (nBytes <= MaxSmallSize)
+	{
+		SizeClass = m_SizeClassLookup[(nBytes + LookupGranularity - 1) / LookupGranularity];
+	}
+
+	return SizeClass;
+}
+
+UINT CMemory::GetBatchSize(UINT SizeClass)
+{
+	UINT BatchSize = static_cast<UINT>((SlabSize - sizeof(Slab)) / (sizeof(BlockHeader) + SizeClasses[SizeClass]));
+
+	return (BatchSize < MaxBatchSize) ? BatchSize : static_cast<UINT>(MaxBatchSize);
+}
+
+CMemory::ThreadCache& CMemory::GetThreadCache(VOID)
+{
+	ThreadCache& rCache = t_Cache;
+	UINT64 Epoch = m_Epoch.load(std::memory_order_acquire);
+
+	if (rCache.Epoch != Epoch)
+	{
+		memset(rCache.pHeads, 0, sizeof(rCache.pHeads));
+		memset(rCache.Counts, 0, sizeof(rCache.Counts));
+		memset(rCache.Hits, 0, sizeof(rCache.Hits));
+		rCache.Epoch = Epoch;
+	}
+
+	return rCache;
+}
+
+BOOL CMemory::Refill(ThreadCache& rCache, UINT SizeClass)
+{
+	BOOL Status = TRUE;
+	CentralList& rList = m_Central[SizeClass];
+	CONST UINT BatchSize = GetBatchSize(SizeClass);
+
+	rList.Misses.fetch_add(1, std::memory_order_relaxed);
+	rList.Hits.fetch_add(rCache.Hits[SizeClass], std::memory_order_relaxed);
+	rCache.Hits[SizeClass] = 0;
+
+	{
+		std::lock_guard<std::mutex> Lock(rList.Lock);
+
+		while ((rList.pHead != NULL) && (rCache.Counts[SizeClass] < BatchSize))
+		{
+			FreeBlock* pBlock = rList.pHead;
+			rList.pHead = pBlock->pNext;
+			rList.Count--;
+
+			pBlock->pNext = rCache.pHeads[SizeClass];
+			rCache.pHeads[SizeClass] = pBlock;
+			rCache.Counts[SizeClass]++;
+		}
+	}
+
+	if (rCache.pHeads[SizeClass] == NULL)
+	{
+		Slab* pSlab = reinterpret_cast<Slab*>(CPageAllocator::Map(SlabSize));
+
+		if (pSlab != NULL)
+		{
+			pSlab->Size = SlabSize;
+
+			{
+				std::lock_guard<std::mutex> Lock(m_SlabLock);
+				pSlab->pNext = m_pSlabs;
+				m_pSlabs = pSlab;
+			}
+
+			CONST SIZE_T Stride = sizeof(BlockHeader) + SizeClasses[SizeClass];
+			uint8_t* pCursor = reinterpret_cast<uint8_t*>(pSlab) + sizeof(Slab);
+			uint8_t* pEnd = reinterpret_cast<uint8_t*>(pSlab) + SlabSize;
+
+			FreeBlock* pSpill = NULL;
+			FreeBlock* pSpillTail = NULL;
+			UINT nSpill = 0;
+
+			// One batch goes to this thread, the rest of the slab is shared through the central list
+			for (; (pCursor + Stride) <= pEnd; pCursor += Stride)
+			{
+				BlockHeader* pHeader = reinterpret_cast<BlockHeader*>(pCursor);
+				pHeader->SizeClass = SizeClass;
+				pHeader->Magic = BlockMagic;
+				pHeader->Size = SizeClasses[SizeClass];
+
+				FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pCursor + sizeof(BlockHeader));
+
+				if (rCache.Counts[SizeClass] < BatchSize)
+				{
+					pBlock->pNext = rCache.pHeads[SizeClass];
+					rCache.pHeads[SizeClass] = pBlock;
+					rCache.Counts[SizeClass]++;
+				}
+				else
+				{
+					pBlock->pNext = pSpill;
+					pSpillTail = (pSpill == NULL) ? pBlock : pSpillTail;
+					pSpill = pBlock;
+					nSpill++;
+				}
+			}
+
+			if (pSpill != NULL)
+			{
+				std::lock_guard<std::mutex> Lock(rList.Lock);
+
+				pSpillTail->pNext = rList.pHead;
+				rList.pHead = pSpill;
+				rList.Count += nSpill;
+			}
+		}
+		else
+		{
+			Status = FALSE;
+		}
+	}
+
+	return Status;
+}
+
+VOID CMemory::Drain(ThreadCache& rCache, UINT SizeClass, UINT Count)
+{
+	FreeBlock* pHead = rCache.pHeads[SizeClass];
+	FreeBlock* pTail = pHead;
+
+	for (UINT i = 1; i < Count; i++)
+	{
+		pTail = pTail->pNext;
+	}
+
+	rCache.pHeads[SizeClass] = pTail->pNext;
+	rCache.Counts[SizeClass] -= Count;
+
+	CentralList& rList = m_Central[SizeClass];
+	std::lock_guard<std::mutex> Lock(rList.Lock);
+
+	pTail->pNext = rList.pHead;
+	rList.pHead = pHead;
+	rList.Count += Count;
+}
+
+VOID CMemory::ReleaseThreadCache(ThreadCache& rCache)
+{
+	// A cache from before the last Uninitialize points into slabs that are gone
+	if ((m_bInitialized == TRUE) && (rCache.Epoch == m_Epoch.load(std::memory_order_acquire)))
+	{
+		for (UINT SizeClass = 0; SizeClass < NumSizeClasses; SizeClass++)
+		{
+			m_Central[SizeClass].Hits.fetch_add(rCache.Hits[SizeClass], std::memory_order_relaxed);
+			rCache.Hits[SizeClass] = 0;
+
+			if (rCache.Counts[SizeClass] != 0)
+			{
+				Drain(rCache, SizeClass, rCache.Counts[SizeClass]);
+			}
+		}
+	}
+}
+
+CMemory::ThreadCache::~ThreadCache()
+{
+	// Blocks cached by an exiting thread go back to the central lists instead of leaking with it
+	g_Memory.ReleaseThreadCache(*this);
+}
+
+PVOID CMemory::AllocateLarge(SIZE_T nBytes)
+{
+	PVOID pMemory = NULL;
+
+	// Rounding up to whole pages would wrap around
+	if (nBytes <= (SIZE_MAX - sizeof(BlockHeader) - m_PageSize))
+	{
+		SIZE_T nMapped = (nBytes + sizeof(BlockHeader) + m_PageSize - 1) & ~(m_PageSize - 1);
+
+		// Fresh pages are zero filled by the OS, so bClear needs no extra work here
+		BlockHeader* pHeader = reinterpret_cast<BlockHeader*>(CPageAllocator::Map(nMapped));
+
+		if (pHeader != NULL)
+		{
+			pHeader->SizeClass = LargeSizeClass;
+			pHeader->Magic = BlockMagic;
+			pHeader->Size = nMapped;
+
+			pMemory = pHeader + 1;
+
+			m_LargeAllocations.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	return pMemory;
 }
 
 PVOID CMemory::Allocate(SIZE_T nBytes, BOOL bClear)
 {
-	DWORD Flags = 0;
+	PVOID pMemory = NULL;
 
-	if (bClear)
+	if (m_bInitialized == TRUE)
 	{
-		Flags |= HEAP_ZERO_MEMORY;
+		UINT SizeClass = GetSizeClass(nBytes);
+
+		if (SizeClass == LargeSizeClass)
+		{
+			pMemory = AllocateLarge(nBytes);
+		}
+		else
+		{
+			ThreadCache& rCache = GetThreadCache();
+
+			if (rCache.pHeads[SizeClass] != NULL)
+			{
+				if (++rCache.Hits[SizeClass] == HitFlushInterval)
+				{
+					m_Central[SizeClass].Hits.fetch_add(HitFlushInterval, std::memory_order_relaxed);
+					rCache.Hits[SizeClass] = 0;
+				}
+			}
+			else
+			{
+				Refill(rCache, SizeClass);
+			}
+
+			FreeBlock* pBlock = rCache.pHeads[SizeClass];
+
+			if (pBlock != NULL)
+			{
+				rCache.pHeads[SizeClass] = pBlock->pNext;
+				rCache.Counts[SizeClass]--;
+
+				pMemory = pBlock;
+
+				if (bClear)
+				{
+					memset(pMemory, 0, SizeClasses[SizeClass]);
+				}
+			}
+		}
 	}
 
-	return HeapAlloc(m_hHeap, Flags, nBytes);
+	return pMemory;
 }
 
 BOOL CMemory::Free(PVOID pMemory)
 {
 	BOOL Status = TRUE;
 
-	Status = HeapFree(m_hHeap, 0, pMemory);
+	// The slabs are unmapped once uninitialized, a block's header may no longer be readable
+	if (m_bInitialized == FALSE)
+	{
+		Status = FALSE;
+	}
+	else if (pMemory != NULL)
+	{
+		BlockHeader* pHeader = reinterpret_cast<BlockHeader*>(pMemory) - 1;
+
+		if (pHeader->Magic != BlockMagic)
+		{
+			Status = FALSE;
+		}
+		else if (pHeader->SizeClass == LargeSizeClass)
+		{
+			Status = CPageAllocator::Unmap(pHeader, static_cast<SIZE_T>(pHeader->Size));
+		}
+		else
+		{
+			ThreadCache& rCache = GetThreadCache();
+			UINT SizeClass = pHeader->SizeClass;
+			UINT BatchSize = GetBatchSize(SizeClass);
+
+			// Blocks freed on a thread other than the allocating one simply migrate to this thread's cache
+			FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pMemory);
+			pBlock->pNext = rCache.pHeads[SizeClass];
+			rCache.pHeads[SizeClass] = pBlock;
+			rCache.Counts[SizeClass]++;
+
+			if (rCache.Counts[SizeClass] > (2 * BatchSize))
+			{
+				Drain(rCache, SizeClass, BatchSize);
+			}
+		}
+	}
+
+	return Status;
+}
+
+BOOL CMemory::CreateFrameArenas(UINT nArenas, SIZE_T nBytesPerArena)
+{
+	BOOL Status = TRUE;
+
+	if ((nArenas == 0) || (nArenas > MaxFrameArenas) || (m_nFrameArenas != 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create %u frame arenas\n", nArenas);
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < nArenas); i++)
+	{
+		Status = m_FrameArenas[i].Initialize(nBytesPerArena);
+
+		if (Status == TRUE)
+		{
+			m_nFrameArenas++;
+		}
+		else
+		{
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not allocate frame arena %u\n", i);
+		}
+	}
+
+	if (Status == FALSE)
+	{
+		DestroyFrameArenas();
+	}
+
+	m_FrameArenaCapacity = (Status == TRUE) ? nBytesPerArena : 0;
+	m_LastFrameUsed = 0;
+	m_FrameHighWaterMark = 0;
+
+	return Status;
+}
+
+VOID CMemory::DestroyFrameArenas(VOID)
+{
+	for (UINT i = 0; i < m_nFrameArenas; i++)
+	{
+		m_FrameArenas[i].Uninitialize();
+	}
+
+	m_nFrameArenas = 0;
+	m_pCurrentFrameArena = NULL;
+}
+
+VOID CMemory::BeginFrame(UINT FrameIndex)
+{
+	if (m_nFrameArenas != 0)
+	{
+		// Everything allocated NumArenas frames ago is released at once
+		m_pCurrentFrameArena = &m_FrameArenas[FrameIndex % m_nFrameArenas];
+		m_pCurrentFrameArena->Reset();
+	}
+}
+
+PVOID CMemory::AllocateFrame(SIZE_T nBytes, SIZE_T Alignment)
+{
+	PVOID pMemory = NULL;
+
+	if (m_pCurrentFrameArena != NULL)
+	{
+		pMemory = m_pCurrentFrameArena->Allocate(nBytes, Alignment);
+
+		if (pMemory == NULL)
+		{
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Frame arena exhausted (%llu of %llu bytes used)\n", static_cast<UINT64>(m_pCurrentFrameArena->GetUsed()), static_cast<UINT64>(m_pCurrentFrameArena->GetCapacity()));
+		}
+	}
+
+	return pMemory;
+}
+
+VOID CMemory::EndFrame(VOID)
+{
+	if (m_pCurrentFrameArena != NULL)
+	{
+		m_LastFrameUsed = m_pCurrentFrameArena->GetUsed();
+
+		if (m_LastFrameUsed > m_FrameHighWaterMark)
+		{
+			m_FrameHighWaterMark = m_LastFrameUsed;
+		}
+
+		m_pCurrentFrameArena = NULL;
+	}
+}
+
+UINT CMemory::GetSizeClassCount(VOID)
+{
+	return NumSizeClasses;
+}
+
+BOOL CMemory::GetStatistics(UINT SizeClass, Memory::Statistics& rStatistics)
+{
+	BOOL Status = TRUE;
+
+	if (SizeClass >= NumSizeClasses)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		// Hits are counted per thread and folded into the central counters periodically and on every miss
+		ThreadCache& rCache = GetThreadCache();
+
+		rStatistics.BlockSize = SizeClasses[SizeClass];
+		rStatistics.Hits = m_Central[SizeClass].Hits.load(std::memory_order_relaxed) + rCache.Hits[SizeClass];
+		rStatistics.Misses = m_Central[SizeClass].Misses.load(std::memory_order_relaxed);
+	}
+
+	return Status;
+}
+
+BOOL CMemory::GetFrameStatistics(Memory::FrameStatistics& rStatistics)
+{
+	BOOL Status = TRUE;
+
+	// Kept after the arenas are destroyed so that the statistics can be reported on shutdown
+	if (m_FrameArenaCapacity == 0)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		rStatistics.Capacity = m_FrameArenaCapacity;
+		rStatistics.LastFrameUsed = m_LastFrameUsed;
+		rStatistics.HighWaterMark = m_FrameHighWaterMark;
+	}
 
 	return Status;
 }
+
+UINT64 CMemory::GetLargeAllocationCount(VOID)
+{
+	return m_LargeAllocations.load(std::memory_order_relaxed);
+}
@@ -1,12 +1,97 @@
 #ifndef CMEMORY_HPP
 #define CMEMORY_HPP
 
+#include <atomic>
+#include <mutex>
+
 #include "Defines.hpp"
 
+#include "Memory.hpp"
+
+#include "CFrameArena.hpp"
+
 class CMemory
 {
 protected:
-	HANDLE m_hHeap;
+	enum { NumSizeClasses = 16, MaxSmallSize = 4096, LargeSizeClass = 0xFFFF };
+	enum { SlabSize = 64 * 1024, MaxBatchSize = 64, HitFlushInterval = 256 };
+	enum { MaxFrameArenas = 8 };
+	enum { BlockMagic = 0x4D454D43, LookupGranularity = 16 };
+
+	static CONST SIZE_T SizeClasses[NumSizeClasses];
+
+	// Precedes every block so that Free can find its size class, keeps the payload 16-byte aligned
+	struct BlockHeader
+	{
+		uint32_t SizeClass;
+		uint32_t Magic;
+		uint64_t Size;
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* pNext;
+	};
+
+	struct Slab
+	{
+		Slab*  pNext;
+		SIZE_T Size;
+	};
+
+	struct CentralList
+	{
+		std::mutex			 Lock;
+		FreeBlock*			 pHead;
+		UINT				 Count;
+		std::atomic<UINT64>	 Hits;
+		std::atomic<UINT64>	 Misses;
+	};
+
+	struct ThreadCache
+	{
+		UINT64		Epoch;
+		FreeBlock*	pHeads[NumSizeClasses];
+		UINT		Counts[NumSizeClasses];
+		UINT64		Hits[NumSizeClasses];
+
+		~ThreadCache();
+	};
+
+	static thread_local ThreadCache t_Cache;
+
+	uint8_t				m_SizeClassLookup[MaxSmallSize / LookupGranularity + 1];
+
+	SIZE_T				m_PageSize;
+	std::atomic<UINT64> m_Epoch;
+	std::atomic<BOOL>	m_bInitialized;
+
+	std::mutex			m_SlabLock;
+	Slab*				m_pSlabs;
+
+	CentralList			m_Central[NumSizeClasses];
+
+	std::atomic<UINT64> m_LargeAllocations;
+
+	CFrameArena			m_FrameArenas[MaxFrameArenas];
+	UINT				m_nFrameArenas;
+	CFrameArena*		m_pCurrentFrameArena;
+	SIZE_T				m_FrameArenaCapacity;
+	SIZE_T				m_LastFrameUsed;
+	SIZE_T				m_FrameHighWaterMark;
+
+protected:
+	static UINT GetBatchSize(UINT SizeClass);
+
+	UINT GetSizeClass(SIZE_T nBytes);
+
+	ThreadCache& GetThreadCache(VOID);
+
+	BOOL  Refill(ThreadCache& rCache, UINT SizeClass);
+	VOID  Drain(ThreadCache& rCache, UINT SizeClass, UINT Count);
+	VOID  ReleaseThreadCache(ThreadCache& rCache);
+
+	PVOID AllocateLarge(SIZE_T nBytes);
 
 public:
 	CMemory();
@@ -17,6 +102,18 @@ public:
 
 	PVOID Allocate(SIZE_T nBytes, BOOL bClear);
 	BOOL Free(PVOID pMemory);
+
+	BOOL  CreateFrameArenas(UINT nArenas, SIZE_T nBytesPerArena);
+	VOID  DestroyFrameArenas(VOID);
+
+	VOID  BeginFrame(UINT FrameIndex);
+	PVOID AllocateFrame(SIZE_T nBytes, SIZE_T Alignment);
+	VOID  EndFrame(VOID);
+
+	UINT   GetSizeClassCount(VOID);
+	BOOL   GetStatistics(UINT SizeClass, Memory::Statistics& rStatistics);
+	BOOL   GetFrameStatistics(Memory::FrameStatistics& rStatistics);
+	UINT64 GetLargeAllocationCount(VOID);
 };
 
-#endif // CMEMORY_HPP
\ No newline at end of file
+#endif // CMEMORY_HPP
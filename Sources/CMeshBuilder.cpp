@@ -0,0 +1,339 @@
+#include "CMeshBuilder.hpp"
+
+#include <cstring>
+
+#include "Console.hpp"
+
+CONST FLOAT CMeshBuilder::OverdrawAcmrThreshold = 1.05f;
+
+CMeshBuilder::CMeshBuilder()
+{
+	m_nInputVertices = 0;
+	m_bBuilt = FALSE;
+	m_bOptimized = FALSE;
+
+	for (UINT i = 0; i < 3; i++)
+	{
+		m_BoundsMin[i] = 0.0f;
+		m_BoundsMax[i] = 0.0f;
+	}
+
+	m_CacheBefore = { };
+	m_CacheAfter = { };
+}
+
+CMeshBuilder::~CMeshBuilder()
+{
+}
+
+VOID CMeshBuilder::Reset(VOID)
+{
+	m_Vertices.clear();
+	m_Indices.clear();
+	m_Indices16.clear();
+	m_Table.clear();
+	m_nInputVertices = 0;
+	m_bBuilt = FALSE;
+	m_bOptimized = FALSE;
+}
+
+VOID CMeshBuilder::Reserve(UINT nVertices)
+{
+	m_Vertices.reserve(nVertices);
+	m_Indices.reserve(nVertices);
+
+	SIZE_T TableSize = MinTableSize;
+
+	while (TableSize < (2 * static_cast<SIZE_T>(nVertices)))
+	{
+		TableSize *= 2;
+	}
+
+	if (TableSize > m_Table.size())
+	{
+		Rehash(TableSize);
+	}
+}
+
+Vertex CMeshBuilder::Canonicalize(CONST Vertex& rVertex)
+{
+	Vertex Result = rVertex;
+
+	// -0.0f and +0.0f compare equal but hash differently, fold them before comparing bit patterns
+	for (UINT i = 0; i < 3; i++)
+	{
+		Result.Position[i] = (Result.Position[i] == 0.0f) ? 0.0f : Result.Position[i];
+		Result.Colour[i] = (Result.Colour[i] == 0.0f) ? 0.0f : Result.Colour[i];
+	}
+
+	return Result;
+}
+
+uint32_t CMeshBuilder::Hash(CONST Vertex& rVertex)
+{
+	CONST uint8_t* pBytes = reinterpret_cast<CONST uint8_t*>(&rVertex);
+	uint32_t Hash = 2166136261u;
+
+	for (SIZE_T i = 0; i < sizeof(Vertex); i++)
+	{
+		Hash = (Hash ^ pBytes[i]) * 16777619u;
+	}
+
+	return Hash;
+}
+
+BOOL CMeshBuilder::Equal(CONST Vertex& rLeft, CONST Vertex& rRight)
+{
+	return (memcmp(&rLeft, &rRight, sizeof(Vertex)) == 0) ? TRUE : FALSE;
+}
+
+VOID CMeshBuilder::Rehash(SIZE_T TableSize)
+{
+	m_Table.assign(TableSize, InvalidIndex);
+
+	for (SIZE_T i = 0; i < m_Vertices.size(); i++)
+	{
+		SIZE_T Slot = Hash(m_Vertices[i]) & (TableSize - 1);
+
+		while (m_Table[Slot] != InvalidIndex)
+		{
+			Slot = (Slot + 1) & (TableSize - 1);
+		}
+
+		m_Table[Slot] = static_cast<uint32_t>(i);
+	}
+}
+
+UINT CMeshBuilder::AddVertex(CONST Vertex& rVertex)
+{
+	Vertex Key = Canonicalize(rVertex);
+
+	// Keep the open addressing table at most half full
+	if ((2 * (m_Vertices.size() + 1)) > m_Table.size())
+	{
+		Rehash((m_Table.size() < static_cast<SIZE_T>(MinTableSize)) ? static_cast<SIZE_T>(MinTableSize) : (2 * m_Table.size()));
+	}
+
+	SIZE_T Mask = m_Table.size() - 1;
+	SIZE_T Slot = Hash(Key) & Mask;
+	uint32_t Index = InvalidIndex;
+
+	while (m_Table[Slot] != InvalidIndex)
+	{
+		if (Equal(m_Vertices[m_Table[Slot]], Key) == TRUE)
+		{
+			Index = m_Table[Slot];
+			break;
+		}
+
+		Slot = (Slot + 1) & Mask;
+	}
+
+	if (Index == InvalidIndex)
+	{
+		Index = static_cast<uint32_t>(m_Vertices.size());
+
+		m_Vertices.push_back(Key);
+		m_Table[Slot] = Index;
+	}
+
+	m_Indices.push_back(Index);
+	m_nInputVertices++;
+	m_bBuilt = FALSE;
+	m_bOptimized = FALSE;
+
+	return Index;
+}
+
+VOID CMeshBuilder::AddTriangle(CONST Vertex& rV0, CONST Vertex& rV1, CONST Vertex& rV2)
+{
+	AddVertex(rV0);
+	AddVertex(rV1);
+	AddVertex(rV2);
+}
+
+BOOL CMeshBuilder::Optimize(UINT CacheSize)
+{
+	BOOL Status = TRUE;
+
+	if ((m_Indices.size() == 0) || ((m_Indices.size() % 3) != 0) || (CacheSize < 3))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Cannot optimize a mesh with %u indices for a cache of %u vertices\n", static_cast<UINT>(m_Indices.size()), CacheSize);
+	}
+
+	if (Status == TRUE)
+	{
+		CONST UINT nIndices = static_cast<UINT>(m_Indices.size());
+		CONST UINT nVertices = static_cast<UINT>(m_Vertices.size());
+
+		CMeshOptimizer::SimulateCache(m_Indices.data(), nIndices, nVertices, CacheSize, m_CacheBefore);
+
+		std::vector<uint32_t> Ordered(m_Indices);
+		std::vector<UINT> Clusters;
+		CMeshOptimizer::CacheStatistics OrderedStats = { };
+
+		CMeshOptimizer::OptimizeTriangleOrder(Ordered.data(), nIndices, nVertices, CacheSize, Clusters);
+		CMeshOptimizer::SimulateCache(Ordered.data(), nIndices, nVertices, CacheSize, OrderedStats);
+
+		std::vector<uint32_t> Sorted(Ordered);
+		CMeshOptimizer::CacheStatistics SortedStats = { };
+
+		CMeshOptimizer::OptimizeOverdraw(Sorted.data(), nIndices, m_Vertices.data(), Clusters);
+		CMeshOptimizer::SimulateCache(Sorted.data(), nIndices, nVertices, CacheSize, SortedStats);
+
+		if (SortedStats.Acmr <= (OrderedStats.Acmr * OverdrawAcmrThreshold))
+		{
+			Ordered.swap(Sorted);
+			OrderedStats = SortedStats;
+		}
+
+		// Never ship an order that transforms more vertices than the one we were given
+		if (OrderedStats.Acmr <= m_CacheBefore.Acmr)
+		{
+			m_Indices.swap(Ordered);
+		}
+		else
+		{
+			CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: Optimized ACMR %.3f is worse than %.3f, keeping the original triangle order\n", OrderedStats.Acmr, m_CacheBefore.Acmr);
+		}
+
+		CMeshOptimizer::OptimizeVertexFetch(m_Vertices.data(), m_Indices.data(), nIndices, nVertices);
+		CMeshOptimizer::SimulateCache(m_Indices.data(), nIndices, nVertices, CacheSize, m_CacheAfter);
+
+		// Vertices moved, so the weld table has to follow them
+		Rehash(m_Table.size());
+
+		m_bBuilt = FALSE;
+		m_bOptimized = TRUE;
+	}
+
+	return Status;
+}
+
+VOID CMeshBuilder::GetCacheStatistics(CMeshOptimizer::CacheStatistics& rBefore, CMeshOptimizer::CacheStatistics& rAfter)
+{
+	rBefore = m_CacheBefore;
+	rAfter = m_CacheAfter;
+}
+
+BOOL CMeshBuilder::Build(VOID)
+{
+	BOOL Status = TRUE;
+
+	if ((m_Indices.size() == 0) || ((m_Indices.size() % 3) != 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Mesh has %u indices, expected a non-empty triangle list\n", static_cast<UINT>(m_Indices.size()));
+	}
+
+	if (Status == TRUE)
+	{
+		m_Indices16.clear();
+
+		// Strip cuts are disabled, so every 16-bit value including 0xFFFF is a valid index
+		if (m_Vertices.size() <= 0x10000)
+		{
+			m_Indices16.resize(m_Indices.size());
+
+			for (SIZE_T i = 0; i < m_Indices.size(); i++)
+			{
+				m_Indices16[i] = static_cast<uint16_t>(m_Indices[i]);
+			}
+		}
+
+		for (UINT i = 0; i < 3; i++)
+		{
+			m_BoundsMin[i] = (m_Vertices.size() != 0) ? m_Vertices[0].Position[i] : 0.0f;
+			m_BoundsMax[i] = m_BoundsMin[i];
+		}
+
+		for (SIZE_T v = 0; v < m_Vertices.size(); v++)
+		{
+			for (UINT i = 0; i < 3; i++)
+			{
+				m_BoundsMin[i] = (m_Vertices[v].Position[i] < m_BoundsMin[i]) ? m_Vertices[v].Position[i] : m_BoundsMin[i];
+				m_BoundsMax[i] = (m_Vertices[v].Position[i] > m_BoundsMax[i]) ? m_Vertices[v].Position[i] : m_BoundsMax[i];
+			}
+		}
+
+		m_bBuilt = TRUE;
+	}
+
+	return Status;
+}
+
+CONST Vertex* CMeshBuilder::GetVertices(VOID)
+{
+	return m_Vertices.data();
+}
+
+UINT CMeshBuilder::GetVertexCount(VOID)
+{
+	return static_cast<UINT>(m_Vertices.size());
+}
+
+CONST VOID* CMeshBuilder::GetIndices(VOID)
+{
+	CONST VOID* pIndices = NULL;
+
+	if (m_bBuilt == TRUE)
+	{
+		pIndices = (m_Indices16.size() != 0) ? static_cast<CONST VOID*>(m_Indices16.data()) : static_cast<CONST VOID*>(m_Indices.data());
+	}
+
+	return pIndices;
+}
+
+UINT CMeshBuilder::GetIndexCount(VOID)
+{
+	return static_cast<UINT>(m_Indices.size());
+}
+
+UINT CMeshBuilder::GetIndexSize(VOID)
+{
+	return (m_Indices16.size() != 0) ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+VOID CMeshBuilder::GetMeshData(MeshData& rMesh)
+{
+	rMesh.pVertices = GetVertices();
+	rMesh.VertexCount = GetVertexCount();
+	rMesh.VertexStride = sizeof(Vertex);
+	rMesh.Format = VERTEX_FORMAT_FLOAT;
+	rMesh.pIndices = GetIndices();
+	rMesh.IndexCount = GetIndexCount();
+	rMesh.IndexSize = GetIndexSize();
+
+	for (UINT i = 0; i < 3; i++)
+	{
+		rMesh.BoundsMin[i] = m_BoundsMin[i];
+		rMesh.BoundsMax[i] = m_BoundsMax[i];
+	}
+}
+
+VOID CMeshBuilder::GetStatistics(Statistics& rStatistics)
+{
+	rStatistics.InputVertices = m_nInputVertices;
+	rStatistics.UniqueVertices = GetVertexCount();
+	rStatistics.Indices = GetIndexCount();
+	rStatistics.IndexSize = GetIndexSize();
+	rStatistics.SoupBytes = sizeof(Vertex) * static_cast<SIZE_T>(m_nInputVertices);
+	rStatistics.IndexedBytes = sizeof(Vertex) * static_cast<SIZE_T>(rStatistics.UniqueVertices) + static_cast<SIZE_T>(rStatistics.IndexSize) * rStatistics.Indices;
+}
+
+VOID CMeshBuilder::PrintStatistics(LPCSTR pName)
+{
+	Statistics Stats = { };
+	GetStatistics(Stats);
+
+	long long Saved = static_cast<long long>(Stats.SoupBytes) - static_cast<long long>(Stats.IndexedBytes);
+
+	Console::Write("Mesh %s: %u vertices welded to %u, %u indices (%u-bit)\n", pName, Stats.InputVertices, Stats.UniqueVertices, Stats.Indices, Stats.IndexSize * 8);
+	Console::Write("Mesh %s: %llu bytes as triangle soup, %llu bytes indexed, %lld bytes saved\n", pName, static_cast<UINT64>(Stats.SoupBytes), static_cast<UINT64>(Stats.IndexedBytes), Saved);
+
+	if (m_bOptimized == TRUE)
+	{
+		Console::Write("Mesh %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", pName, m_CacheBefore.Acmr, m_CacheAfter.Acmr, m_CacheBefore.Atvr, m_CacheAfter.Atvr);
+	}
+}
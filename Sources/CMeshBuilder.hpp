@@ -0,0 +1,102 @@
+#ifndef CMESHBUILDER_HPP
+#define CMESHBUILDER_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CMeshOptimizer.hpp"
+
+// Matches the POSITION/COLOR input layout, 24 bytes per vertex
+struct Vertex
+{
+	FLOAT Position[3];
+	FLOAT Colour[3];
+};
+
+enum VertexFormat : uint32_t
+{
+	VERTEX_FORMAT_FLOAT = 0,
+	VERTEX_FORMAT_QUANTIZED = 1
+};
+
+// Vertex and index streams ready for upload, either owned by a CMeshBuilder or mapped from a CMeshFile
+struct MeshData
+{
+	CONST VOID*	 pVertices;
+	UINT		 VertexCount;
+	UINT		 VertexStride;
+	VertexFormat Format;
+	CONST VOID*	 pIndices;
+	UINT		 IndexCount;
+	UINT		 IndexSize;
+	FLOAT		 BoundsMin[3];
+	FLOAT		 BoundsMax[3];
+};
+
+class CMeshBuilder
+{
+public:
+	struct Statistics
+	{
+		UINT   InputVertices;
+		UINT   UniqueVertices;
+		UINT   Indices;
+		UINT   IndexSize;
+		SIZE_T SoupBytes;
+		SIZE_T IndexedBytes;
+	};
+
+protected:
+	enum { InvalidIndex = 0xFFFFFFFF, MinTableSize = 64 };
+
+	// Cluster sorting may cost a little vertex reuse, it is dropped if ACMR rises by more than 5%
+	static CONST FLOAT OverdrawAcmrThreshold;
+
+	std::vector<Vertex>		m_Vertices;
+	std::vector<uint32_t>	m_Indices;
+	std::vector<uint16_t>	m_Indices16;
+	std::vector<uint32_t>	m_Table;
+	UINT					m_nInputVertices;
+	FLOAT					m_BoundsMin[3];
+	FLOAT					m_BoundsMax[3];
+	BOOL					m_bBuilt;
+	BOOL					m_bOptimized;
+
+	CMeshOptimizer::CacheStatistics m_CacheBefore;
+	CMeshOptimizer::CacheStatistics m_CacheAfter;
+
+	static uint32_t Hash(CONST Vertex& rVertex);
+	static BOOL		Equal(CONST Vertex& rLeft, CONST Vertex& rRight);
+	static Vertex	Canonicalize(CONST Vertex& rVertex);
+
+	VOID Rehash(SIZE_T TableSize);
+
+public:
+	CMeshBuilder();
+	~CMeshBuilder();
+
+	VOID Reset(VOID);
+	VOID Reserve(UINT nVertices);
+
+	UINT AddVertex(CONST Vertex& rVertex);
+	VOID AddTriangle(CONST Vertex& rV0, CONST Vertex& rV1, CONST Vertex& rV2);
+
+	BOOL Optimize(UINT CacheSize);
+	BOOL Build(VOID);
+
+	CONST Vertex* GetVertices(VOID);
+	UINT		  GetVertexCount(VOID);
+
+	CONST VOID*	  GetIndices(VOID);
+	UINT		  GetIndexCount(VOID);
+	UINT		  GetIndexSize(VOID);
+
+	VOID		  GetMeshData(MeshData& rMesh);
+
+	VOID		  GetStatistics(Statistics& rStatistics);
+	VOID		  GetCacheStatistics(CMeshOptimizer::CacheStatistics& rBefore, CMeshOptimizer::CacheStatistics& rAfter);
+	VOID		  PrintStatistics(LPCSTR pName);
+};
+
+#endif // CMESHBUILDER_HPP
@@ -0,0 +1,322 @@
+#include "CMeshFile.hpp"
+
+#include <fstream>
+
+#include "Console.hpp"
+
+static_assert(sizeof(CMeshFile::Header) == 136, "Mesh file header layout changed, bump CMeshFile::Version");
+static_assert(sizeof(Meshlet) == 16, "Meshlet layout changed, bump CMeshFile::Version");
+
+CMeshFile::CMeshFile()
+{
+	m_pHeader = NULL;
+}
+
+CMeshFile::~CMeshFile()
+{
+	Close();
+}
+
+BOOL CMeshFile::Open(LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+
+	Close();
+
+	Status = m_Mapping.Open(pPath);
+
+	if (Status == TRUE)
+	{
+		Status = Validate(pPath);
+	}
+
+	if (Status == TRUE)
+	{
+		m_pHeader = reinterpret_cast<CONST Header*>(m_Mapping.GetData());
+	}
+	else
+	{
+		m_Mapping.Close();
+	}
+
+	return Status;
+}
+
+VOID CMeshFile::Close(VOID)
+{
+	m_pHeader = NULL;
+	m_Mapping.Close();
+}
+
+BOOL CMeshFile::Validate(LPCSTR pPath)
+{
+	// Only the header is inspected, the payload is handed out as is
+	BOOL Status = TRUE;
+
+	CONST SIZE_T FileSize = m_Mapping.GetSize();
+	CONST Header* pHeader = reinterpret_cast<CONST Header*>(m_Mapping.GetData());
+
+	if ((FileSize < sizeof(Header)) || (pHeader->Magic != Magic))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s is not a mesh file\n", pPath);
+	}
+
+	if ((Status == TRUE) && (pHeader->Version != Version))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s has version %u, expected %u\n", pPath, pHeader->Version, static_cast<UINT>(Version));
+	}
+
+	if ((Status == TRUE) && (pHeader->VertexFormat != VERTEX_FORMAT_FLOAT) && (pHeader->VertexFormat != VERTEX_FORMAT_QUANTIZED))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s has unknown vertex format %u\n", pPath, pHeader->VertexFormat);
+	}
+
+	if (Status == TRUE)
+	{
+		CONST UINT VertexStride = (pHeader->VertexFormat == VERTEX_FORMAT_QUANTIZED) ? sizeof(QuantizedVertex) : sizeof(Vertex);
+
+		if ((pHeader->VertexStride != VertexStride) || ((pHeader->IndexSize != sizeof(uint16_t)) && (pHeader->IndexSize != sizeof(uint32_t))))
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s has a %u byte vertex and %u byte index layout\n", pPath, pHeader->VertexStride, pHeader->IndexSize);
+		}
+	}
+
+	if ((Status == TRUE) && ((pHeader->IndexCount == 0) || ((pHeader->IndexCount % 3) != 0)))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s has %u indices, expected a non-empty triangle list\n", pPath, pHeader->IndexCount);
+	}
+
+	if (Status == TRUE)
+	{
+		CONST uint64_t ExpectedSizes[SECTION_COUNT] =
+		{
+			static_cast<uint64_t>(pHeader->VertexCount) * pHeader->VertexStride,
+			static_cast<uint64_t>(pHeader->IndexCount) * pHeader->IndexSize,
+			static_cast<uint64_t>(pHeader->MeshletCount) * sizeof(Meshlet),
+			pHeader->Sections[MESHLET_VERTICES].Size,
+			pHeader->Sections[MESHLET_TRIANGLES].Size
+		};
+
+		for (UINT i = 0; (Status == TRUE) && (i < SECTION_COUNT); i++)
+		{
+			CONST SectionEntry& rSection = pHeader->Sections[i];
+
+			if ((rSection.Size != ExpectedSizes[i]) ||
+				((rSection.Offset % SectionAlignment) != 0) ||
+				(rSection.Offset > FileSize) ||
+				(rSection.Size > (FileSize - rSection.Offset)))
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Section %u of %s is out of bounds or misaligned\n", i, pPath);
+			}
+		}
+	}
+
+	return Status;
+}
+
+BOOL CMeshFile::ValidateIndices(LPCSTR pPath, CONST uint32_t* pIndices, UINT nIndices, UINT nVertices)
+{
+	BOOL Status = TRUE;
+
+	for (UINT i = 0; (Status == TRUE) && (i < nIndices); i++)
+	{
+		if (pIndices[i] >= nVertices)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Index %u of %s is past the last of its %u vertices\n", pIndices[i], pPath, nVertices);
+		}
+	}
+
+	return Status;
+}
+
+CONST VOID* CMeshFile::GetSection(Section Index)
+{
+	CONST VOID* pSection = NULL;
+
+	if ((m_pHeader != NULL) && (m_pHeader->Sections[Index].Size != 0))
+	{
+		pSection = m_Mapping.GetData() + m_pHeader->Sections[Index].Offset;
+	}
+
+	return pSection;
+}
+
+CONST CMeshFile::Header* CMeshFile::GetHeader(VOID)
+{
+	return m_pHeader;
+}
+
+VOID CMeshFile::GetMeshData(MeshData& rMesh)
+{
+	rMesh.pVertices = GetSection(VERTICES);
+	rMesh.VertexCount = (m_pHeader != NULL) ? m_pHeader->VertexCount : 0;
+	rMesh.VertexStride = (m_pHeader != NULL) ? m_pHeader->VertexStride : 0;
+	rMesh.pIndices = GetSection(INDICES);
+	rMesh.IndexCount = (m_pHeader != NULL) ? m_pHeader->IndexCount : 0;
+	rMesh.IndexSize = (m_pHeader != NULL) ? m_pHeader->IndexSize : 0;
+	rMesh.Format = (m_pHeader != NULL) ? static_cast<VertexFormat>(m_pHeader->VertexFormat) : VERTEX_FORMAT_FLOAT;
+
+	for (UINT i = 0; i < 3; i++)
+	{
+		rMesh.BoundsMin[i] = (m_pHeader != NULL) ? m_pHeader->BoundsMin[i] : 0.0f;
+		rMesh.BoundsMax[i] = (m_pHeader != NULL) ? m_pHeader->BoundsMax[i] : 0.0f;
+	}
+}
+
+CONST Meshlet* CMeshFile::GetMeshlets(VOID)
+{
+	return reinterpret_cast<CONST Meshlet*>(GetSection(MESHLETS));
+}
+
+CONST uint32_t* CMeshFile::GetMeshletVertices(VOID)
+{
+	return reinterpret_cast<CONST uint32_t*>(GetSection(MESHLET_VERTICES));
+}
+
+CONST uint8_t* CMeshFile::GetMeshletTriangles(VOID)
+{
+	return reinterpret_cast<CONST uint8_t*>(GetSection(MESHLET_TRIANGLES));
+}
+
+BOOL CMeshFile::Write(LPCSTR pPath, CONST MeshData& rMesh)
+{
+	BOOL Status = TRUE;
+
+	if ((rMesh.pVertices == NULL) || (rMesh.pIndices == NULL))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Mesh must be built before it is written to %s\n", pPath);
+	}
+
+	Header FileHeader = { };
+	std::vector<uint32_t> Indices;
+	std::vector<Meshlet> Meshlets;
+	std::vector<uint32_t> MeshletVertices;
+	std::vector<uint8_t> MeshletTriangles;
+
+	if (Status == TRUE)
+	{
+		Indices.resize(rMesh.IndexCount);
+
+		for (UINT i = 0; i < rMesh.IndexCount; i++)
+		{
+			Indices[i] = (rMesh.IndexSize == sizeof(uint16_t)) ? reinterpret_cast<CONST uint16_t*>(rMesh.pIndices)[i] : reinterpret_cast<CONST uint32_t*>(rMesh.pIndices)[i];
+		}
+
+		// Readers hand the sections to the GPU as they are, so nothing out of range may reach the file
+		Status = ValidateIndices(pPath, Indices.data(), rMesh.IndexCount, rMesh.VertexCount);
+	}
+
+	if ((Status == TRUE) && (CMeshOptimizer::BuildMeshlets(Indices.data(), rMesh.IndexCount, rMesh.VertexCount, Meshlets, MeshletVertices, MeshletTriangles) != TRUE))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to build the meshlets of %s\n", pPath);
+	}
+
+	for (SIZE_T m = 0; (Status == TRUE) && (m < Meshlets.size()); m++)
+	{
+		CONST Meshlet& rMeshlet = Meshlets[m];
+
+		Status = ValidateIndices(pPath, MeshletVertices.data() + rMeshlet.VertexOffset, rMeshlet.VertexCount, rMesh.VertexCount);
+
+		for (UINT i = 0; (Status == TRUE) && (i < (rMeshlet.TriangleCount * 3)); i++)
+		{
+			if (MeshletTriangles[rMeshlet.TriangleOffset * 3 + i] >= rMeshlet.VertexCount)
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Meshlet %u of %s refers to a vertex it does not have\n", static_cast<UINT>(m), pPath);
+			}
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		FileHeader.Magic = Magic;
+		FileHeader.Version = Version;
+		FileHeader.VertexCount = rMesh.VertexCount;
+		FileHeader.VertexStride = rMesh.VertexStride;
+		FileHeader.IndexCount = rMesh.IndexCount;
+		FileHeader.IndexSize = rMesh.IndexSize;
+		FileHeader.MeshletCount = static_cast<uint32_t>(Meshlets.size());
+		FileHeader.VertexFormat = rMesh.Format;
+
+		for (UINT i = 0; i < 3; i++)
+		{
+			FileHeader.BoundsMin[i] = rMesh.BoundsMin[i];
+			FileHeader.BoundsMax[i] = rMesh.BoundsMax[i];
+		}
+	}
+
+	CONST VOID* pSections[SECTION_COUNT] =
+	{
+		rMesh.pVertices,
+		rMesh.pIndices,
+		Meshlets.data(),
+		MeshletVertices.data(),
+		MeshletTriangles.data()
+	};
+
+	if (Status == TRUE)
+	{
+		FileHeader.Sections[VERTICES].Size = static_cast<uint64_t>(rMesh.VertexCount) * rMesh.VertexStride;
+		FileHeader.Sections[INDICES].Size = static_cast<uint64_t>(rMesh.IndexCount) * rMesh.IndexSize;
+		FileHeader.Sections[MESHLETS].Size = Meshlets.size() * sizeof(Meshlet);
+		FileHeader.Sections[MESHLET_VERTICES].Size = MeshletVertices.size() * sizeof(uint32_t);
+		FileHeader.Sections[MESHLET_TRIANGLES].Size = MeshletTriangles.size();
+
+		uint64_t Offset = sizeof(Header);
+
+		for (UINT i = 0; i < SECTION_COUNT; i++)
+		{
+			Offset = (Offset + SectionAlignment - 1) & ~static_cast<uint64_t>(SectionAlignment - 1);
+			FileHeader.Sections[i].Offset = Offset;
+			Offset += FileHeader.Sections[i].Size;
+		}
+	}
+
+	std::ofstream File;
+
+	if (Status == TRUE)
+	{
+		File.open(pPath, std::ios::binary | std::ios::trunc);
+
+		if (File.is_open() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create %s\n", pPath);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		CONST CHAR Padding[SectionAlignment] = { };
+		uint64_t Written = sizeof(Header);
+
+		File.write(reinterpret_cast<CONST CHAR*>(&FileHeader), sizeof(Header));
+
+		for (UINT i = 0; i < SECTION_COUNT; i++)
+		{
+			File.write(Padding, static_cast<std::streamsize>(FileHeader.Sections[i].Offset - Written));
+			File.write(reinterpret_cast<CONST CHAR*>(pSections[i]), static_cast<std::streamsize>(FileHeader.Sections[i].Size));
+
+			Written = FileHeader.Sections[i].Offset + FileHeader.Sections[i].Size;
+		}
+
+		File.close();
+
+		if (File.fail() == true)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to write %s\n", pPath);
+		}
+	}
+
+	return Status;
+}
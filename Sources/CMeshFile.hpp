@@ -0,0 +1,94 @@
+#ifndef CMESHFILE_HPP
+#define CMESHFILE_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CFileMapping.hpp"
+#include "CMeshBuilder.hpp"
+#include "CMeshOptimizer.hpp"
+#include "CVertexQuantizer.hpp"
+
+/*
+* Binary mesh container, little endian:
+*
+*	Header
+*	Vertices			VertexCount * VertexStride bytes, Vertex or QuantizedVertex depending on VertexFormat
+*	Indices				IndexCount * IndexSize bytes
+*	Meshlets			MeshletCount * sizeof(Meshlet) bytes
+*	Meshlet vertices	uint32_t per meshlet vertex
+*	Meshlet triangles	three uint8_t local indices per meshlet triangle
+*
+* Every section starts on a SectionAlignment boundary so it can be read in place from the mapped file.
+*/
+class CMeshFile
+{
+public:
+	enum : uint32_t
+	{
+		Magic = 0x4853454D, // "MESH"
+		Version = 2,
+		SectionAlignment = 256
+	};
+
+	enum Section : uint32_t
+	{
+		VERTICES = 0,
+		INDICES = 1,
+		MESHLETS = 2,
+		MESHLET_VERTICES = 3,
+		MESHLET_TRIANGLES = 4,
+		SECTION_COUNT = 5
+	};
+
+	struct SectionEntry
+	{
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	struct Header
+	{
+		uint32_t	 Magic;
+		uint32_t	 Version;
+		uint32_t	 VertexCount;
+		uint32_t	 VertexStride;
+		uint32_t	 IndexCount;
+		uint32_t	 IndexSize;
+		uint32_t	 MeshletCount;
+		uint32_t	 VertexFormat;
+		FLOAT		 BoundsMin[3];
+		FLOAT		 BoundsMax[3];
+		SectionEntry Sections[SECTION_COUNT];
+	};
+
+protected:
+	CFileMapping  m_Mapping;
+	CONST Header* m_pHeader;
+
+	BOOL Validate(LPCSTR pPath);
+
+	CONST VOID* GetSection(Section Index);
+
+public:
+	CMeshFile();
+	~CMeshFile();
+
+	BOOL Open(LPCSTR pPath);
+	VOID Close(VOID);
+
+	CONST Header*	GetHeader(VOID);
+	VOID			GetMeshData(MeshData& rMesh);
+
+	CONST Meshlet*	GetMeshlets(VOID);
+	CONST uint32_t* GetMeshletVertices(VOID);
+	CONST uint8_t*	GetMeshletTriangles(VOID);
+
+	static BOOL Write(LPCSTR pPath, CONST MeshData& rMesh);
+
+	// Open only checks the layout, code that reads vertices through the indices on the CPU checks them with this first
+	static BOOL ValidateIndices(LPCSTR pPath, CONST uint32_t* pIndices, UINT nIndices, UINT nVertices);
+};
+
+#endif // CMESHFILE_HPP
@@ -0,0 +1,377 @@
+#include "CMeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CMeshBuilder.hpp"
+
+VOID CMeshOptimizer::SimulateCache(CONST uint32_t* pIndices, UINT nIndices, UINT nVertices, UINT CacheSize, CacheStatistics& rStatistics)
+{
+	// FIFO post-transform cache: a vertex is resident while fewer than CacheSize misses happened since it was loaded
+	std::vector<UINT> Stamps(nVertices, 0);
+	UINT Misses = 0;
+	UINT Referenced = 0;
+
+	for (UINT i = 0; i < nIndices; i++)
+	{
+		uint32_t v = pIndices[i];
+
+		if (Stamps[v] == 0)
+		{
+			Referenced++;
+		}
+
+		if ((Stamps[v] == 0) || ((Misses - Stamps[v]) >= CacheSize))
+		{
+			Misses++;
+			Stamps[v] = Misses;
+		}
+	}
+
+	rStatistics.Triangles = nIndices / 3;
+	rStatistics.Vertices = Referenced;
+	rStatistics.Misses = Misses;
+	rStatistics.Acmr = (rStatistics.Triangles != 0) ? static_cast<FLOAT>(Misses) / static_cast<FLOAT>(rStatistics.Triangles) : 0.0f;
+	rStatistics.Atvr = (Referenced != 0) ? static_cast<FLOAT>(Misses) / static_cast<FLOAT>(Referenced) : 0.0f;
+}
+
+INT CMeshOptimizer::GetNextVertex(UINT CacheSize, CONST std::vector<uint32_t>& rCandidates, CONST std::vector<UINT>& rTimestamps, UINT Timestamp, CONST std::vector<UINT>& rLiveTriangles)
+{
+	INT Best = -1;
+	INT BestPriority = -1;
+
+	for (SIZE_T i = 0; i < rCandidates.size(); i++)
+	{
+		uint32_t v = rCandidates[i];
+
+		if (rLiveTriangles[v] > 0)
+		{
+			INT Priority = 0;
+
+			// Prefer the oldest vertex that is still going to be in the cache after fanning all of its triangles
+			if ((Timestamp - rTimestamps[v] + 2 * rLiveTriangles[v]) <= CacheSize)
+			{
+				Priority = static_cast<INT>(Timestamp - rTimestamps[v]);
+			}
+
+			if (Priority > BestPriority)
+			{
+				BestPriority = Priority;
+				Best = static_cast<INT>(v);
+			}
+		}
+	}
+
+	return Best;
+}
+
+INT CMeshOptimizer::SkipDeadEnd(CONST std::vector<UINT>& rLiveTriangles, std::vector<uint32_t>& rDeadEnds, UINT& rCursor, UINT nVertices)
+{
+	INT Next = -1;
+
+	while ((Next < 0) && (rDeadEnds.size() != 0))
+	{
+		uint32_t v = rDeadEnds.back();
+		rDeadEnds.pop_back();
+
+		if (rLiveTriangles[v] > 0)
+		{
+			Next = static_cast<INT>(v);
+		}
+	}
+
+	while ((Next < 0) && (rCursor < nVertices))
+	{
+		if (rLiveTriangles[rCursor] > 0)
+		{
+			Next = static_cast<INT>(rCursor);
+		}
+
+		rCursor++;
+	}
+
+	return Next;
+}
+
+VOID CMeshOptimizer::OptimizeTriangleOrder(uint32_t* pIndices, UINT nIndices, UINT nVertices, UINT CacheSize, std::vector<UINT>& rClusters)
+{
+	// Tipsify (Sander, Nehab, Barczak 2007): fan around the vertex that keeps the most of its triangles in the cache
+	CONST UINT nTriangles = nIndices / 3;
+
+	std::vector<UINT> LiveTriangles(nVertices, 0);
+	std::vector<UINT> Offsets(nVertices + 1, 0);
+	std::vector<UINT> Adjacency(nIndices);
+
+	for (UINT i = 0; i < nIndices; i++)
+	{
+		LiveTriangles[pIndices[i]]++;
+	}
+
+	for (UINT v = 0; v < nVertices; v++)
+	{
+		Offsets[v + 1] = Offsets[v] + LiveTriangles[v];
+	}
+
+	std::vector<UINT> Fill(Offsets.begin(), Offsets.end() - 1);
+
+	for (UINT i = 0; i < nIndices; i++)
+	{
+		Adjacency[Fill[pIndices[i]]++] = i / 3;
+	}
+
+	std::vector<UINT> Timestamps(nVertices, 0);
+	std::vector<uint8_t> Emitted(nTriangles, 0);
+	std::vector<uint32_t> DeadEnds;
+	std::vector<uint32_t> Candidates;
+	std::vector<uint32_t> Output;
+
+	Output.reserve(nIndices);
+	DeadEnds.reserve(nIndices);
+
+	UINT Timestamp = CacheSize + 1;
+	UINT Cursor = 1;
+	INT Fanning = (nVertices != 0) ? 0 : -1;
+
+	rClusters.clear();
+	rClusters.push_back(0);
+
+	while (Fanning >= 0)
+	{
+		Candidates.clear();
+
+		for (UINT k = Offsets[Fanning]; k < Offsets[Fanning + 1]; k++)
+		{
+			UINT t = Adjacency[k];
+
+			if (Emitted[t] == 0)
+			{
+				for (UINT c = 0; c < 3; c++)
+				{
+					uint32_t v = pIndices[3 * t + c];
+
+					Output.push_back(v);
+					DeadEnds.push_back(v);
+					Candidates.push_back(v);
+					LiveTriangles[v]--;
+
+					if ((Timestamp - Timestamps[v]) > CacheSize)
+					{
+						Timestamps[v] = Timestamp;
+						Timestamp++;
+					}
+				}
+
+				Emitted[t] = 1;
+			}
+		}
+
+		Fanning = GetNextVertex(CacheSize, Candidates, Timestamps, Timestamp, LiveTriangles);
+
+		if (Fanning < 0)
+		{
+			Fanning = SkipDeadEnd(LiveTriangles, DeadEnds, Cursor, nVertices);
+
+			// Dead ends break locality, they are the cluster boundaries used by the overdraw pass
+			if ((Fanning >= 0) && ((Output.size() / 3) != rClusters.back()))
+			{
+				rClusters.push_back(static_cast<UINT>(Output.size() / 3));
+			}
+		}
+	}
+
+	std::copy(Output.begin(), Output.end(), pIndices);
+}
+
+VOID CMeshOptimizer::OptimizeOverdraw(uint32_t* pIndices, UINT nIndices, CONST Vertex* pVertices, CONST std::vector<UINT>& rClusters)
+{
+	// Sorts clusters so that the ones facing away from the mesh centre are drawn first, they are the most likely occluders
+	CONST UINT nTriangles = nIndices / 3;
+	CONST UINT nClusters = static_cast<UINT>(rClusters.size());
+
+	std::vector<FLOAT> Keys(nClusters, 0.0f);
+	std::vector<FLOAT> Centroids(3 * nClusters, 0.0f);
+	std::vector<FLOAT> Normals(3 * nClusters, 0.0f);
+	std::vector<FLOAT> Areas(nClusters, 0.0f);
+	FLOAT MeshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	FLOAT MeshArea = 0.0f;
+
+	for (UINT c = 0; c < nClusters; c++)
+	{
+		UINT End = ((c + 1) < nClusters) ? rClusters[c + 1] : nTriangles;
+
+		for (UINT t = rClusters[c]; t < End; t++)
+		{
+			CONST FLOAT* p0 = pVertices[pIndices[3 * t + 0]].Position;
+			CONST FLOAT* p1 = pVertices[pIndices[3 * t + 1]].Position;
+			CONST FLOAT* p2 = pVertices[pIndices[3 * t + 2]].Position;
+
+			FLOAT e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			FLOAT e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+			// Clockwise front faces, so this points out of the surface
+			FLOAT n[3] =
+			{
+				e0[1] * e1[2] - e0[2] * e1[1],
+				e0[2] * e1[0] - e0[0] * e1[2],
+				e0[0] * e1[1] - e0[1] * e1[0]
+			};
+
+			FLOAT Area = 0.5f * sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (UINT i = 0; i < 3; i++)
+			{
+				FLOAT Centroid = (p0[i] + p1[i] + p2[i]) / 3.0f;
+
+				Centroids[3 * c + i] += Centroid * Area;
+				Normals[3 * c + i] += n[i];
+				MeshCentroid[i] += Centroid * Area;
+			}
+
+			Areas[c] += Area;
+			MeshArea += Area;
+		}
+	}
+
+	for (UINT i = 0; (i < 3) && (MeshArea > 0.0f); i++)
+	{
+		MeshCentroid[i] /= MeshArea;
+	}
+
+	for (UINT c = 0; c < nClusters; c++)
+	{
+		FLOAT* n = &Normals[3 * c];
+		FLOAT Length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+		if ((Length > 0.0f) && (Areas[c] > 0.0f))
+		{
+			for (UINT i = 0; i < 3; i++)
+			{
+				Keys[c] += ((Centroids[3 * c + i] / Areas[c]) - MeshCentroid[i]) * (n[i] / Length);
+			}
+		}
+	}
+
+	std::vector<UINT> Order(nClusters);
+
+	for (UINT c = 0; c < nClusters; c++)
+	{
+		Order[c] = c;
+	}
+
+	std::stable_sort(Order.begin(), Order.end(), [&Keys](UINT Left, UINT Right) { return Keys[Left] > Keys[Right]; });
+
+	std::vector<uint32_t> Output;
+	Output.reserve(nIndices);
+
+	for (UINT o = 0; o < nClusters; o++)
+	{
+		UINT c = Order[o];
+		UINT End = ((c + 1) < nClusters) ? rClusters[c + 1] : nTriangles;
+
+		Output.insert(Output.end(), pIndices + 3 * rClusters[c], pIndices + 3 * End);
+	}
+
+	std::copy(Output.begin(), Output.end(), pIndices);
+}
+
+VOID CMeshOptimizer::OptimizeVertexFetch(Vertex* pVertices, uint32_t* pIndices, UINT nIndices, UINT nVertices)
+{
+	// Renumber vertices in first-use order so that vertex fetches walk the buffer linearly
+	CONST uint32_t Unused = 0xFFFFFFFF;
+
+	std::vector<uint32_t> Remap(nVertices, Unused);
+	uint32_t Next = 0;
+
+	for (UINT i = 0; i < nIndices; i++)
+	{
+		if (Remap[pIndices[i]] == Unused)
+		{
+			Remap[pIndices[i]] = Next++;
+		}
+
+		pIndices[i] = Remap[pIndices[i]];
+	}
+
+	for (UINT v = 0; v < nVertices; v++)
+	{
+		if (Remap[v] == Unused)
+		{
+			Remap[v] = Next++;
+		}
+	}
+
+	std::vector<Vertex> Original(pVertices, pVertices + nVertices);
+
+	for (UINT v = 0; v < nVertices; v++)
+	{
+		pVertices[Remap[v]] = Original[v];
+	}
+}
+
+BOOL CMeshOptimizer::BuildMeshlets(CONST uint32_t* pIndices, UINT nIndices, UINT nVertices, std::vector<Meshlet>& rMeshlets, std::vector<uint32_t>& rMeshletVertices, std::vector<uint8_t>& rMeshletTriangles)
+{
+	// Greedy: walk the (cache optimized) triangle order and start a new meshlet whenever the next triangle does not fit
+	BOOL Status = TRUE;
+	CONST uint32_t Unused = 0xFFFFFFFF;
+
+	std::vector<uint32_t> Slots(nVertices, Unused);
+	Meshlet Current = { 0, 0, 0, 0 };
+
+	rMeshlets.clear();
+	rMeshletVertices.clear();
+	rMeshletTriangles.clear();
+
+	// Indices index the slot table, one past the vertices would write outside it
+	for (UINT i = 0; (Status == TRUE) && (i < nIndices); i++)
+	{
+		Status = (pIndices[i] < nVertices) ? TRUE : FALSE;
+	}
+
+	for (UINT t = 0; (Status == TRUE) && ((t + 2) < nIndices); t += 3)
+	{
+		uint32_t v0 = pIndices[t + 0];
+		uint32_t v1 = pIndices[t + 1];
+		uint32_t v2 = pIndices[t + 2];
+
+		UINT New = ((Slots[v0] == Unused) ? 1 : 0) +
+				   (((Slots[v1] == Unused) && (v1 != v0)) ? 1 : 0) +
+				   (((Slots[v2] == Unused) && (v2 != v0) && (v2 != v1)) ? 1 : 0);
+
+		if (((Current.VertexCount + New) > MaxMeshletVertices) || ((Current.TriangleCount + 1) > MaxMeshletTriangles))
+		{
+			for (UINT i = 0; i < Current.VertexCount; i++)
+			{
+				Slots[rMeshletVertices[Current.VertexOffset + i]] = Unused;
+			}
+
+			rMeshlets.push_back(Current);
+
+			Current.VertexOffset = static_cast<uint32_t>(rMeshletVertices.size());
+			Current.TriangleOffset = static_cast<uint32_t>(rMeshletTriangles.size() / 3);
+			Current.VertexCount = 0;
+			Current.TriangleCount = 0;
+		}
+
+		for (UINT c = 0; c < 3; c++)
+		{
+			uint32_t v = pIndices[t + c];
+
+			if (Slots[v] == Unused)
+			{
+				Slots[v] = Current.VertexCount++;
+				rMeshletVertices.push_back(v);
+			}
+
+			rMeshletTriangles.push_back(static_cast<uint8_t>(Slots[v]));
+		}
+
+		Current.TriangleCount++;
+	}
+
+	if (Current.TriangleCount != 0)
+	{
+		rMeshlets.push_back(Current);
+	}
+
+	return Status;
+}
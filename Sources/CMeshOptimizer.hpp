@@ -0,0 +1,47 @@
+#ifndef CMESHOPTIMIZER_HPP
+#define CMESHOPTIMIZER_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+struct Vertex;
+
+// A cluster of up to MaxMeshletTriangles triangles over MaxMeshletVertices vertices, triangles use 8-bit local indices
+struct Meshlet
+{
+	uint32_t VertexOffset;
+	uint32_t TriangleOffset;
+	uint32_t VertexCount;
+	uint32_t TriangleCount;
+};
+
+class CMeshOptimizer
+{
+public:
+	enum { DefaultCacheSize = 16, MaxMeshletVertices = 64, MaxMeshletTriangles = 124 };
+
+	struct CacheStatistics
+	{
+		UINT  Triangles;
+		UINT  Vertices;
+		UINT  Misses;
+		FLOAT Acmr;
+		FLOAT Atvr;
+	};
+
+protected:
+	static INT  GetNextVertex(UINT CacheSize, CONST std::vector<uint32_t>& rCandidates, CONST std::vector<UINT>& rTimestamps, UINT Timestamp, CONST std::vector<UINT>& rLiveTriangles);
+	static INT  SkipDeadEnd(CONST std::vector<UINT>& rLiveTriangles, std::vector<uint32_t>& rDeadEnds, UINT& rCursor, UINT nVertices);
+
+public:
+	static VOID SimulateCache(CONST uint32_t* pIndices, UINT nIndices, UINT nVertices, UINT CacheSize, CacheStatistics& rStatistics);
+
+	static VOID OptimizeTriangleOrder(uint32_t* pIndices, UINT nIndices, UINT nVertices, UINT CacheSize, std::vector<UINT>& rClusters);
+	static VOID OptimizeOverdraw(uint32_t* pIndices, UINT nIndices, CONST Vertex* pVertices, CONST std::vector<UINT>& rClusters);
+	static VOID OptimizeVertexFetch(Vertex* pVertices, uint32_t* pIndices, UINT nIndices, UINT nVertices);
+
+	static BOOL BuildMeshlets(CONST uint32_t* pIndices, UINT nIndices, UINT nVertices, std::vector<Meshlet>& rMeshlets, std::vector<uint32_t>& rMeshletVertices, std::vector<uint8_t>& rMeshletTriangles);
+};
+
+#endif // CMESHOPTIMIZER_HPP
@@ -0,0 +1,51 @@
+#include "CPageAllocator.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+SIZE_T CPageAllocator::GetPageSize(VOID)
+{
+#if defined(_WIN32)
+	SYSTEM_INFO Info = { };
+	GetSystemInfo(&Info);
+
+	return Info.dwPageSize;
+#else
+	return static_cast<SIZE_T>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+PVOID CPageAllocator::Map(SIZE_T nBytes)
+{
+	PVOID pMemory = NULL;
+
+#if defined(_WIN32)
+	pMemory = VirtualAlloc(NULL, nBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	pMemory = mmap(NULL, nBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (pMemory == MAP_FAILED)
+	{
+		pMemory = NULL;
+	}
+#endif
+
+	return pMemory;
+}
+
+BOOL CPageAllocator::Unmap(PVOID pMemory, SIZE_T nBytes)
+{
+	BOOL Status = TRUE;
+
+#if defined(_WIN32)
+	Status = (VirtualFree(pMemory, 0, MEM_RELEASE) != FALSE) ? TRUE : FALSE;
+#else
+	Status = (munmap(pMemory, nBytes) == 0) ? TRUE : FALSE;
+#endif
+
+	return Status;
+}
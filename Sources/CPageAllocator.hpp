@@ -0,0 +1,15 @@
+#ifndef CPAGEALLOCATOR_HPP
+#define CPAGEALLOCATOR_HPP
+
+#include "Defines.hpp"
+
+class CPageAllocator
+{
+public:
+	static SIZE_T GetPageSize(VOID);
+
+	static PVOID  Map(SIZE_T nBytes);
+	static BOOL   Unmap(PVOID pMemory, SIZE_T nBytes);
+};
+
+#endif // CPAGEALLOCATOR_HPP
@@ -0,0 +1,151 @@
+#include "CPermutationRegistry.hpp"
+
+#include <cstring>
+
+#include "Console.hpp"
+
+CPermutationRegistry::CPermutationRegistry()
+{
+	m_Report = { };
+}
+
+CPermutationRegistry::~CPermutationRegistry()
+{
+}
+
+UINT CPermutationRegistry::AddShader(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, CShaderPermutation Features)
+{
+	UINT Index = static_cast<UINT>(m_Shaders.size());
+
+	for (UINT i = 0; i < m_Shaders.size(); i++)
+	{
+		if ((strcmp(m_Shaders[i].pFileName, pFileName) == 0) && (strcmp(m_Shaders[i].pEntrypoint, pEntrypoint) == 0) && (strcmp(m_Shaders[i].pTarget, pTarget) == 0))
+		{
+			Index = InvalidShader;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader %s %s %s was added twice\n", pFileName, pEntrypoint, pTarget);
+		}
+	}
+
+	if (Index != InvalidShader)
+	{
+		m_Shaders.push_back({ pFileName, pEntrypoint, pTarget, Features });
+	}
+
+	return Index;
+}
+
+VOID CPermutationRegistry::Fix(ShaderFeature Feature, BOOL bEnabled)
+{
+	m_FixedMask = m_FixedMask.With(Feature, TRUE);
+	m_FixedValues = m_FixedValues.With(Feature, bEnabled);
+}
+
+VOID CPermutationRegistry::Require(ShaderFeature Feature, ShaderFeature Required)
+{
+	m_Requires[Feature] = m_Requires[Feature].With(Required, TRUE);
+}
+
+BOOL CPermutationRegistry::IsReachable(CShaderPermutation Permutation) const
+{
+	BOOL Reachable = (Permutation.GetBits() < CShaderPermutation::GetCombinationCount()) ? TRUE : FALSE;
+
+	if ((Reachable == TRUE) && (Permutation.Mask(m_FixedMask) != m_FixedValues))
+	{
+		Reachable = FALSE;
+	}
+
+	for (UINT i = 0; (Reachable == TRUE) && (i < NumShaderFeatures); i++)
+	{
+		if ((Permutation.Has(static_cast<ShaderFeature>(i)) == TRUE) && (Permutation.Mask(m_Requires[i]) != m_Requires[i]))
+		{
+			Reachable = FALSE;
+		}
+	}
+
+	return Reachable;
+}
+
+UINT CPermutationRegistry::GetShaderCount(VOID) const
+{
+	return static_cast<UINT>(m_Shaders.size());
+}
+
+CONST CPermutationRegistry::Shader* CPermutationRegistry::GetShader(UINT Index) const
+{
+	return (Index < m_Shaders.size()) ? &m_Shaders[Index] : NULL;
+}
+
+VOID CPermutationRegistry::GetVariants(std::vector<Variant>& rVariants) const
+{
+	CONST UINT nCombinations = CShaderPermutation::GetCombinationCount();
+
+	rVariants.clear();
+
+	// Reachable combinations are masked to the shader's features, the keys they land on are its variants
+	std::vector<bool> Added(nCombinations);
+
+	for (UINT i = 0; i < m_Shaders.size(); i++)
+	{
+		Added.assign(nCombinations, false);
+
+		for (UINT Bits = 0; Bits < nCombinations; Bits++)
+		{
+			if (IsReachable(CShaderPermutation(Bits)) == TRUE)
+			{
+				Added[CShaderPermutation(Bits).Mask(m_Shaders[i].Features).GetBits()] = true;
+			}
+		}
+
+		for (UINT Bits = 0; Bits < nCombinations; Bits++)
+		{
+			if (Added[Bits] == true)
+			{
+				rVariants.push_back({ i, CShaderPermutation(Bits) });
+			}
+		}
+	}
+}
+
+BOOL CPermutationRegistry::Compile(CompileFunction pFunction, PVOID pContext)
+{
+	BOOL Status = TRUE;
+	std::vector<Variant> Variants;
+
+	GetVariants(Variants);
+
+	m_Report = { };
+	m_Report.nShaders = static_cast<UINT>(m_Shaders.size());
+	m_Report.nReachable = static_cast<UINT>(Variants.size());
+
+	for (UINT i = 0; i < m_Shaders.size(); i++)
+	{
+		UINT nFeatures = 0;
+
+		for (UINT j = 0; j < NumShaderFeatures; j++)
+		{
+			nFeatures += (m_Shaders[i].Features.Has(static_cast<ShaderFeature>(j)) == TRUE) ? 1 : 0;
+		}
+
+		m_Report.nPossible += 1u << nFeatures;
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < Variants.size()); i++)
+	{
+		SIZE_T BytecodeSize = 0;
+
+		Status = pFunction(pContext, m_Shaders[Variants[i].ShaderIndex], Variants[i], BytecodeSize);
+
+		if (Status == TRUE)
+		{
+			m_Report.nCompiled++;
+			m_Report.BytecodeSize += BytecodeSize;
+		}
+	}
+
+	return Status;
+}
+
+CONST CPermutationRegistry::Report& CPermutationRegistry::GetReport(VOID) const
+{
+	return m_Report;
+}
@@ -0,0 +1,83 @@
+#ifndef CPERMUTATIONREGISTRY_HPP
+#define CPERMUTATIONREGISTRY_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CShaderPermutation.hpp"
+
+/*
+* The shaders of a scene, the features each of them reads and the rules on which feature combinations the renderer can
+* actually reach. Only reachable variants are compiled: a combination is reachable when it keeps every Fix and Require
+* rule, and each shader sees it masked to its own features, so combinations that only differ in features a shader
+* ignores are one variant of that shader.
+*
+* Nothing here touches D3D, compiling is left to the CompileFunction passed to Compile.
+*/
+class CPermutationRegistry
+{
+public:
+	enum { InvalidShader = 0xFFFFFFFF };
+
+	struct Shader
+	{
+		LPCSTR			   pFileName;
+		LPCSTR			   pEntrypoint;
+		LPCSTR			   pTarget;
+		CShaderPermutation Features;
+	};
+
+	struct Variant
+	{
+		UINT			   ShaderIndex;
+		CShaderPermutation Permutation;
+	};
+
+	struct Report
+	{
+		UINT   nShaders;
+		UINT   nPossible;
+		UINT   nReachable;
+		UINT   nCompiled;
+		UINT64 BytecodeSize;
+	};
+
+	// Compiles one variant and returns the size of its bytecode in rBytecodeSize
+	typedef BOOL (*CompileFunction)(PVOID pContext, CONST Shader& rShader, CONST Variant& rVariant, SIZE_T& rBytecodeSize);
+
+protected:
+	std::vector<Shader> m_Shaders;
+	CShaderPermutation	m_FixedMask;
+	CShaderPermutation	m_FixedValues;
+	CShaderPermutation	m_Requires[NumShaderFeatures];
+	Report				m_Report;
+
+public:
+	CPermutationRegistry();
+	~CPermutationRegistry();
+
+	// Returns the shader's index, or InvalidShader if it was added already
+	UINT AddShader(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, CShaderPermutation Features);
+
+	// The feature always has this value
+	VOID Fix(ShaderFeature Feature, BOOL bEnabled);
+
+	// Feature can only be enabled together with Required
+	VOID Require(ShaderFeature Feature, ShaderFeature Required);
+
+	BOOL IsReachable(CShaderPermutation Permutation) const;
+
+	UINT		  GetShaderCount(VOID) const;
+	CONST Shader* GetShader(UINT Index) const;
+
+	// Every reachable variant of every shader, ordered by shader and then by key
+	VOID GetVariants(std::vector<Variant>& rVariants) const;
+
+	// Stops at the first variant that fails to compile
+	BOOL Compile(CompileFunction pFunction, PVOID pContext);
+
+	CONST Report& GetReport(VOID) const;
+};
+
+#endif // CPERMUTATIONREGISTRY_HPP
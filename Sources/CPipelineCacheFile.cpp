@@ -0,0 +1,180 @@
+#include "CPipelineCacheFile.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "Console.hpp"
+
+static_assert(sizeof(CPipelineCacheFile::Header) == 48, "Pipeline cache header layout changed, bump CPipelineCacheFile::Version");
+
+CPipelineCacheFile::CPipelineCacheFile()
+{
+	m_pBlob = NULL;
+	m_BlobSize = 0;
+}
+
+CPipelineCacheFile::~CPipelineCacheFile()
+{
+	Close();
+}
+
+BOOL CPipelineCacheFile::Open(LPCSTR pPath, CONST AdapterIdentity& rAdapter)
+{
+	BOOL Status = TRUE;
+
+	Close();
+
+	// Checked first so the first run does not report a missing file as an error
+	if (std::ifstream(pPath, std::ios::binary).is_open() == false)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = m_Mapping.Open(pPath);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Validate(pPath, rAdapter);
+	}
+
+	if (Status == TRUE)
+	{
+		CONST Header* pHeader = reinterpret_cast<CONST Header*>(m_Mapping.GetData());
+
+		m_pBlob = m_Mapping.GetData() + pHeader->BlobOffset;
+		m_BlobSize = static_cast<SIZE_T>(pHeader->BlobSize);
+	}
+	else
+	{
+		m_Mapping.Close();
+	}
+
+	return Status;
+}
+
+VOID CPipelineCacheFile::Close(VOID)
+{
+	m_pBlob = NULL;
+	m_BlobSize = 0;
+	m_Mapping.Close();
+}
+
+BOOL CPipelineCacheFile::Validate(LPCSTR pPath, CONST AdapterIdentity& rAdapter)
+{
+	BOOL Status = TRUE;
+
+	CONST SIZE_T FileSize = m_Mapping.GetSize();
+	CONST Header* pHeader = reinterpret_cast<CONST Header*>(m_Mapping.GetData());
+
+	if ((FileSize < sizeof(Header)) || (pHeader->Magic != Magic))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: %s is not a pipeline cache, starting with an empty one\n", pPath);
+	}
+
+	if ((Status == TRUE) && (pHeader->Version != Version))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: %s has version %u, expected %u, starting with an empty pipeline cache\n", pPath, pHeader->Version, static_cast<UINT>(Version));
+	}
+
+	if ((Status == TRUE) &&
+		((pHeader->Adapter.VendorId != rAdapter.VendorId) ||
+		 (pHeader->Adapter.DeviceId != rAdapter.DeviceId) ||
+		 (pHeader->Adapter.SubSysId != rAdapter.SubSysId) ||
+		 (pHeader->Adapter.Revision != rAdapter.Revision)))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: %s was written for adapter %04x:%04x, starting with an empty pipeline cache\n", pPath, pHeader->Adapter.VendorId, pHeader->Adapter.DeviceId);
+	}
+
+	if ((Status == TRUE) && (pHeader->Adapter.DriverVersion != rAdapter.DriverVersion))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: %s was written by another driver version, starting with an empty pipeline cache\n", pPath);
+	}
+
+	if ((Status == TRUE) &&
+		(((pHeader->BlobOffset % BlobAlignment) != 0) ||
+		 (pHeader->BlobOffset > FileSize) ||
+		 (pHeader->BlobSize > (FileSize - pHeader->BlobOffset))))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: The blob in %s is out of bounds, starting with an empty pipeline cache\n", pPath);
+	}
+
+	return Status;
+}
+
+CONST VOID* CPipelineCacheFile::GetBlob(VOID)
+{
+	return m_pBlob;
+}
+
+SIZE_T CPipelineCacheFile::GetBlobSize(VOID)
+{
+	return m_BlobSize;
+}
+
+BOOL CPipelineCacheFile::Write(LPCSTR pPath, CONST AdapterIdentity& rAdapter, CONST VOID* pBlob, SIZE_T nBytes)
+{
+	BOOL Status = ((pBlob != NULL) || (nBytes == 0)) ? TRUE : FALSE;
+	CONST std::string TempPath = std::string(pPath) + ".tmp";
+
+	Header FileHeader = { };
+	FileHeader.Magic = Magic;
+	FileHeader.Version = Version;
+	FileHeader.Adapter = rAdapter;
+	FileHeader.BlobOffset = (sizeof(Header) + BlobAlignment - 1) & ~static_cast<uint64_t>(BlobAlignment - 1);
+	FileHeader.BlobSize = nBytes;
+
+	std::ofstream File;
+
+	if (Status == TRUE)
+	{
+		File.open(TempPath, std::ios::binary | std::ios::trunc);
+
+		if (File.is_open() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create %s\n", TempPath.c_str());
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		CONST CHAR Padding[BlobAlignment] = { };
+
+		File.write(reinterpret_cast<CONST CHAR*>(&FileHeader), sizeof(Header));
+		File.write(Padding, static_cast<std::streamsize>(FileHeader.BlobOffset - sizeof(Header)));
+		File.write(reinterpret_cast<CONST CHAR*>(pBlob), static_cast<std::streamsize>(nBytes));
+		File.close();
+
+		if (File.fail() == true)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to write %s\n", TempPath.c_str());
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		std::remove(pPath);
+
+		if (std::rename(TempPath.c_str(), pPath) != 0)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not replace %s\n", pPath);
+		}
+	}
+	else
+	{
+		std::remove(TempPath.c_str());
+	}
+
+	return Status;
+}
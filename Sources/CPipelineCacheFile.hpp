@@ -0,0 +1,69 @@
+#ifndef CPIPELINECACHEFILE_HPP
+#define CPIPELINECACHEFILE_HPP
+
+#include "Defines.hpp"
+
+#include "CFileMapping.hpp"
+
+/*
+* A driver's pipeline cache blob saved between runs, little endian:
+*
+*	Header
+*	Blob		BlobSize bytes at BlobOffset, on a BlobAlignment boundary
+*
+* The blob only means something to the driver that wrote it, so the header records the adapter and the driver version
+* and Open refuses a file written for any other. The blob is read in place from the mapped file, which stays open until
+* Close.
+*/
+class CPipelineCacheFile
+{
+public:
+	enum : uint32_t
+	{
+		Magic = 0x4C4F5350, // "PSOL"
+		Version = 1,
+		BlobAlignment = 256
+	};
+
+	struct AdapterIdentity
+	{
+		uint32_t VendorId;
+		uint32_t DeviceId;
+		uint32_t SubSysId;
+		uint32_t Revision;
+		uint64_t DriverVersion;
+	};
+
+	struct Header
+	{
+		uint32_t		Magic;
+		uint32_t		Version;
+		AdapterIdentity Adapter;
+		uint64_t		BlobOffset;
+		uint64_t		BlobSize;
+	};
+
+protected:
+	CFileMapping   m_Mapping;
+	CONST uint8_t* m_pBlob;
+	SIZE_T		   m_BlobSize;
+
+	BOOL Validate(LPCSTR pPath, CONST AdapterIdentity& rAdapter);
+
+public:
+	CPipelineCacheFile();
+	~CPipelineCacheFile();
+
+	// FALSE when there is no blob to use: the file is missing, damaged, from another version or for another adapter or
+	// driver. Only the last three are reported, a missing file is the normal first run.
+	BOOL Open(LPCSTR pPath, CONST AdapterIdentity& rAdapter);
+	VOID Close(VOID);
+
+	CONST VOID* GetBlob(VOID);
+	SIZE_T		GetBlobSize(VOID);
+
+	// Written next to pPath and swapped in, so a failed write leaves the old file alone. pPath must not be open.
+	static BOOL Write(LPCSTR pPath, CONST AdapterIdentity& rAdapter, CONST VOID* pBlob, SIZE_T nBytes);
+};
+
+#endif // CPIPELINECACHEFILE_HPP
@@ -0,0 +1,118 @@
+#include "CPipelineCompiler.hpp"
+
+#include "CPipelineKey.hpp"
+#include "Console.hpp"
+
+CPipelineCompiler::CPipelineCompiler()
+{
+	m_pLibrary = NULL;
+}
+
+CPipelineCompiler::~CPipelineCompiler()
+{
+	Uninitialize();
+}
+
+BOOL CPipelineCompiler::Initialize(CPipelineLibrary* pLibrary)
+{
+	m_pLibrary = pLibrary;
+
+	return (pLibrary != NULL) ? TRUE : FALSE;
+}
+
+VOID CPipelineCompiler::Uninitialize(VOID)
+{
+	m_pLibrary = NULL;
+}
+
+VOID CPipelineCompiler::CopyShader(CONST D3D12_SHADER_BYTECODE& rShader, std::vector<uint8_t>& rCopy, D3D12_SHADER_BYTECODE& rDesc)
+{
+	CONST uint8_t* pBytes = reinterpret_cast<CONST uint8_t*>(rShader.pShaderBytecode);
+
+	if ((pBytes != NULL) && (rShader.BytecodeLength != 0))
+	{
+		rCopy.assign(pBytes, pBytes + rShader.BytecodeLength);
+		rDesc.pShaderBytecode = rCopy.data();
+		rDesc.BytecodeLength = rCopy.size();
+	}
+	else
+	{
+		rDesc.pShaderBytecode = NULL;
+		rDesc.BytecodeLength = 0;
+	}
+}
+
+PVOID CPipelineCompiler::CreateRequest(CONST D3D12_GRAPHICS_PIPELINE_STATE_DESC& rDesc, UINT64 RootSignatureKey, UINT64& rKey)
+{
+	Request* pRequest = NULL;
+
+	if ((rDesc.StreamOutput.NumEntries != 0) || (rDesc.StreamOutput.NumStrides != 0))
+	{
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Pipelines with stream output cannot be compiled in the background\n");
+	}
+	else
+	{
+		pRequest = new Request();
+	}
+
+	if (pRequest != NULL)
+	{
+		CPipelineKey Key;
+		Key.AddValue(RootSignatureKey);
+		Key.AddGraphicsDesc(rDesc);
+
+		rKey = Key.GetKey();
+
+		pRequest->Desc = rDesc;
+		pRequest->RootSignatureKey = RootSignatureKey;
+
+		CopyShader(rDesc.VS, pRequest->Shaders[0], pRequest->Desc.VS);
+		CopyShader(rDesc.PS, pRequest->Shaders[1], pRequest->Desc.PS);
+		CopyShader(rDesc.DS, pRequest->Shaders[2], pRequest->Desc.DS);
+		CopyShader(rDesc.HS, pRequest->Shaders[3], pRequest->Desc.HS);
+		CopyShader(rDesc.GS, pRequest->Shaders[4], pRequest->Desc.GS);
+
+		CONST UINT nElements = (rDesc.InputLayout.pInputElementDescs != NULL) ? rDesc.InputLayout.NumElements : 0;
+
+		pRequest->Elements.assign(rDesc.InputLayout.pInputElementDescs, rDesc.InputLayout.pInputElementDescs + nElements);
+		pRequest->SemanticNames.resize(nElements);
+
+		// Filled before any pointer into it is taken, the strings do not move afterwards
+		for (UINT i = 0; i < nElements; i++)
+		{
+			pRequest->SemanticNames[i] = rDesc.InputLayout.pInputElementDescs[i].SemanticName;
+			pRequest->Elements[i].SemanticName = pRequest->SemanticNames[i].c_str();
+		}
+
+		pRequest->Desc.InputLayout.pInputElementDescs = (nElements != 0) ? pRequest->Elements.data() : NULL;
+		pRequest->Desc.InputLayout.NumElements = nElements;
+
+		pRequest->Desc.CachedPSO.pCachedBlob = NULL;
+		pRequest->Desc.CachedPSO.CachedBlobSizeInBytes = 0;
+	}
+
+	return pRequest;
+}
+
+PVOID CPipelineCompiler::Compile(PVOID pRequest)
+{
+	Request* pPipelineRequest = reinterpret_cast<Request*>(pRequest);
+	ID3D12PipelineState* pIPipelineState = NULL;
+
+	if (m_pLibrary->GetGraphicsPipeline(pPipelineRequest->Desc, pPipelineRequest->RootSignatureKey, &pIPipelineState) != TRUE)
+	{
+		pIPipelineState = NULL;
+	}
+
+	return pIPipelineState;
+}
+
+VOID CPipelineCompiler::ReleaseRequest(PVOID pRequest)
+{
+	delete reinterpret_cast<Request*>(pRequest);
+}
+
+VOID CPipelineCompiler::ReleasePipeline(PVOID pPipeline)
+{
+	reinterpret_cast<ID3D12PipelineState*>(pPipeline)->Release();
+}
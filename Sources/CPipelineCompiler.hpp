@@ -0,0 +1,47 @@
+#ifndef CPIPELINECOMPILER_HPP
+#define CPIPELINECOMPILER_HPP
+
+#include <d3d12.h>
+
+#include <string>
+#include <vector>
+
+#include "CPipelineLibrary.hpp"
+#include "IPipelineCompiler.hpp"
+
+// Compiles graphics pipelines for CPipelineQueue through a CPipelineLibrary. The library is not thread safe, so the
+// queue has to run a single thread. Pipelines are ID3D12PipelineState pointers, each holding its own reference.
+class CPipelineCompiler : public IPipelineCompiler
+{
+protected:
+	// The desc points into the copies next to it, so the caller's shaders and input layout may go away once the request
+	// is created. The root signature is not copied and has to outlive the request.
+	struct Request
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC	  Desc;
+		UINT64								  RootSignatureKey;
+		std::vector<uint8_t>				  Shaders[5];
+		std::vector<D3D12_INPUT_ELEMENT_DESC> Elements;
+		std::vector<std::string>			  SemanticNames;
+	};
+
+	CPipelineLibrary* m_pLibrary;
+
+	static VOID CopyShader(CONST D3D12_SHADER_BYTECODE& rShader, std::vector<uint8_t>& rCopy, D3D12_SHADER_BYTECODE& rDesc);
+
+public:
+	CPipelineCompiler();
+	~CPipelineCompiler();
+
+	BOOL Initialize(CPipelineLibrary* pLibrary);
+	VOID Uninitialize(VOID);
+
+	// rKey is the pipeline's CPipelineKey, the key to request it under. Stream output is not supported.
+	PVOID CreateRequest(CONST D3D12_GRAPHICS_PIPELINE_STATE_DESC& rDesc, UINT64 RootSignatureKey, UINT64& rKey);
+
+	virtual PVOID Compile(PVOID pRequest);
+	virtual VOID  ReleaseRequest(PVOID pRequest);
+	virtual VOID  ReleasePipeline(PVOID pPipeline);
+};
+
+#endif // CPIPELINECOMPILER_HPP
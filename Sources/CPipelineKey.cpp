@@ -0,0 +1,42 @@
+#include "CPipelineKey.hpp"
+
+#include <cstring>
+
+#include "Hash.hpp"
+
+CPipelineKey::CPipelineKey()
+{
+	m_Hash = Hash::OffsetBasis;
+}
+
+CPipelineKey::~CPipelineKey()
+{
+}
+
+VOID CPipelineKey::Add(CONST VOID* pData, SIZE_T nBytes)
+{
+	m_Hash = Hash::Fnv1a(pData, nBytes, m_Hash);
+}
+
+VOID CPipelineKey::AddValue(UINT64 Value)
+{
+	m_Hash = Hash::Fnv1aValue(Value, m_Hash);
+}
+
+VOID CPipelineKey::AddFloat(FLOAT Value)
+{
+	uint32_t Bits = 0;
+	memcpy(&Bits, &Value, sizeof(Bits));
+
+	m_Hash = Hash::Fnv1aValue(Bits, m_Hash);
+}
+
+VOID CPipelineKey::AddString(LPCSTR pString)
+{
+	m_Hash = Hash::Fnv1aString(pString, m_Hash);
+}
+
+UINT64 CPipelineKey::GetKey(VOID)
+{
+	return m_Hash;
+}
@@ -0,0 +1,168 @@
+#ifndef CPIPELINEKEY_HPP
+#define CPIPELINEKEY_HPP
+
+#include "Defines.hpp"
+
+/*
+* Key of a graphics pipeline, built from every field of its D3D12_GRAPHICS_PIPELINE_STATE_DESC. Pointers are followed:
+* the key covers the bytecode, the input layout's semantic names and the stream output declarations, not where they
+* happen to live. pRootSignature is a live object that means nothing to the next run, so the caller adds a key for it
+* instead, such as a hash of its serialized form. CachedPSO is left out, it is an input to creation and not part of the
+* pipeline.
+*
+* AddGraphicsDesc only names the desc's fields, so it builds against d3d12.h or against a stand-in with the same layout
+* and no device at all.
+*/
+class CPipelineKey
+{
+protected:
+	UINT64 m_Hash;
+
+	// DXBC carries a checksum of its contents at bytes 4 to 19, which is all the key needs from it. Anything else is
+	// hashed in full.
+	template <typename TBytecode>
+	VOID AddShader(CONST TBytecode& rShader)
+	{
+		CONST uint8_t* pBytes = reinterpret_cast<CONST uint8_t*>(rShader.pShaderBytecode);
+		CONST SIZE_T nBytes = (pBytes != NULL) ? static_cast<SIZE_T>(rShader.BytecodeLength) : 0;
+
+		AddValue(nBytes);
+
+		if ((nBytes >= 20) && (pBytes[0] == 'D') && (pBytes[1] == 'X') && (pBytes[2] == 'B') && (pBytes[3] == 'C'))
+		{
+			Add(pBytes + 4, 16);
+		}
+		else
+		{
+			Add(pBytes, nBytes);
+		}
+	}
+
+public:
+	CPipelineKey();
+	~CPipelineKey();
+
+	VOID Add(CONST VOID* pData, SIZE_T nBytes);
+	VOID AddValue(UINT64 Value);
+	VOID AddFloat(FLOAT Value);
+	VOID AddString(LPCSTR pString);
+
+	template <typename TDesc>
+	VOID AddGraphicsDesc(CONST TDesc& rDesc)
+	{
+		AddShader(rDesc.VS);
+		AddShader(rDesc.PS);
+		AddShader(rDesc.DS);
+		AddShader(rDesc.HS);
+		AddShader(rDesc.GS);
+
+		CONST UINT nEntries = (rDesc.StreamOutput.pSODeclaration != NULL) ? rDesc.StreamOutput.NumEntries : 0;
+		CONST UINT nStrides = (rDesc.StreamOutput.pBufferStrides != NULL) ? rDesc.StreamOutput.NumStrides : 0;
+
+		AddValue(nEntries);
+
+		for (UINT i = 0; i < nEntries; i++)
+		{
+			AddValue(rDesc.StreamOutput.pSODeclaration[i].Stream);
+			AddString(rDesc.StreamOutput.pSODeclaration[i].SemanticName);
+			AddValue(rDesc.StreamOutput.pSODeclaration[i].SemanticIndex);
+			AddValue(rDesc.StreamOutput.pSODeclaration[i].StartComponent);
+			AddValue(rDesc.StreamOutput.pSODeclaration[i].ComponentCount);
+			AddValue(rDesc.StreamOutput.pSODeclaration[i].OutputSlot);
+		}
+
+		AddValue(nStrides);
+
+		for (UINT i = 0; i < nStrides; i++)
+		{
+			AddValue(rDesc.StreamOutput.pBufferStrides[i]);
+		}
+
+		AddValue(rDesc.StreamOutput.RasterizedStream);
+
+		// Field by field, the structs have padding that a plain copy would drag into the key
+		AddValue(rDesc.BlendState.AlphaToCoverageEnable);
+		AddValue(rDesc.BlendState.IndependentBlendEnable);
+
+		for (UINT i = 0; i < 8; i++)
+		{
+			AddValue(rDesc.BlendState.RenderTarget[i].BlendEnable);
+			AddValue(rDesc.BlendState.RenderTarget[i].LogicOpEnable);
+			AddValue(rDesc.BlendState.RenderTarget[i].SrcBlend);
+			AddValue(rDesc.BlendState.RenderTarget[i].DestBlend);
+			AddValue(rDesc.BlendState.RenderTarget[i].BlendOp);
+			AddValue(rDesc.BlendState.RenderTarget[i].SrcBlendAlpha);
+			AddValue(rDesc.BlendState.RenderTarget[i].DestBlendAlpha);
+			AddValue(rDesc.BlendState.RenderTarget[i].BlendOpAlpha);
+			AddValue(rDesc.BlendState.RenderTarget[i].LogicOp);
+			AddValue(rDesc.BlendState.RenderTarget[i].RenderTargetWriteMask);
+		}
+
+		AddValue(rDesc.SampleMask);
+
+		AddValue(rDesc.RasterizerState.FillMode);
+		AddValue(rDesc.RasterizerState.CullMode);
+		AddValue(rDesc.RasterizerState.FrontCounterClockwise);
+		AddValue(static_cast<UINT64>(rDesc.RasterizerState.DepthBias));
+		AddFloat(rDesc.RasterizerState.DepthBiasClamp);
+		AddFloat(rDesc.RasterizerState.SlopeScaledDepthBias);
+		AddValue(rDesc.RasterizerState.DepthClipEnable);
+		AddValue(rDesc.RasterizerState.MultisampleEnable);
+		AddValue(rDesc.RasterizerState.AntialiasedLineEnable);
+		AddValue(rDesc.RasterizerState.ForcedSampleCount);
+		AddValue(rDesc.RasterizerState.ConservativeRaster);
+
+		AddValue(rDesc.DepthStencilState.DepthEnable);
+		AddValue(rDesc.DepthStencilState.DepthWriteMask);
+		AddValue(rDesc.DepthStencilState.DepthFunc);
+		AddValue(rDesc.DepthStencilState.StencilEnable);
+		AddValue(rDesc.DepthStencilState.StencilReadMask);
+		AddValue(rDesc.DepthStencilState.StencilWriteMask);
+		AddValue(rDesc.DepthStencilState.FrontFace.StencilFailOp);
+		AddValue(rDesc.DepthStencilState.FrontFace.StencilDepthFailOp);
+		AddValue(rDesc.DepthStencilState.FrontFace.StencilPassOp);
+		AddValue(rDesc.DepthStencilState.FrontFace.StencilFunc);
+		AddValue(rDesc.DepthStencilState.BackFace.StencilFailOp);
+		AddValue(rDesc.DepthStencilState.BackFace.StencilDepthFailOp);
+		AddValue(rDesc.DepthStencilState.BackFace.StencilPassOp);
+		AddValue(rDesc.DepthStencilState.BackFace.StencilFunc);
+
+		CONST UINT nElements = (rDesc.InputLayout.pInputElementDescs != NULL) ? rDesc.InputLayout.NumElements : 0;
+
+		AddValue(nElements);
+
+		for (UINT i = 0; i < nElements; i++)
+		{
+			AddString(rDesc.InputLayout.pInputElementDescs[i].SemanticName);
+			AddValue(rDesc.InputLayout.pInputElementDescs[i].SemanticIndex);
+			AddValue(rDesc.InputLayout.pInputElementDescs[i].Format);
+			AddValue(rDesc.InputLayout.pInputElementDescs[i].InputSlot);
+			AddValue(rDesc.InputLayout.pInputElementDescs[i].AlignedByteOffset);
+			AddValue(rDesc.InputLayout.pInputElementDescs[i].InputSlotClass);
+			AddValue(rDesc.InputLayout.pInputElementDescs[i].InstanceDataStepRate);
+		}
+
+		AddValue(rDesc.IBStripCutValue);
+		AddValue(rDesc.PrimitiveTopologyType);
+
+		// Formats past NumRenderTargets are ignored by the runtime, so they are left out of the key too
+		CONST UINT nRenderTargets = (rDesc.NumRenderTargets < 8) ? rDesc.NumRenderTargets : 8;
+
+		AddValue(nRenderTargets);
+
+		for (UINT i = 0; i < nRenderTargets; i++)
+		{
+			AddValue(rDesc.RTVFormats[i]);
+		}
+
+		AddValue(rDesc.DSVFormat);
+		AddValue(rDesc.SampleDesc.Count);
+		AddValue(rDesc.SampleDesc.Quality);
+		AddValue(rDesc.NodeMask);
+		AddValue(rDesc.Flags);
+	}
+
+	UINT64 GetKey(VOID);
+};
+
+#endif // CPIPELINEKEY_HPP
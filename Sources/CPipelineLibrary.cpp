@@ -0,0 +1,265 @@
+#include "CPipelineLibrary.hpp"
+
+#include <cwchar>
+#include <vector>
+
+#include "CPipelineKey.hpp"
+#include "Console.hpp"
+
+CPipelineLibrary::CPipelineLibrary()
+{
+	m_pIDevice = NULL;
+	m_pILibrary = NULL;
+	m_Adapter = { };
+	m_bDirty = FALSE;
+	m_nLoaded = 0;
+	m_nCreated = 0;
+}
+
+CPipelineLibrary::~CPipelineLibrary()
+{
+	Uninitialize();
+}
+
+BOOL CPipelineLibrary::Initialize(ID3D12Device* pIDevice, IDXGIAdapter* pIAdapter, LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+
+	Uninitialize();
+
+	m_Path = pPath;
+
+	if (pIDevice->QueryInterface(__uuidof(ID3D12Device1), reinterpret_cast<VOID**>(&m_pIDevice)) != S_OK)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Pipeline libraries need an ID3D12Device1\n");
+	}
+
+	if (Status == TRUE)
+	{
+		Status = GetAdapterIdentity(pIAdapter, m_Adapter);
+	}
+
+	// Without library support every pipeline is created directly and nothing is saved
+	if (Status == TRUE)
+	{
+		D3D12_FEATURE_DATA_SHADER_CACHE ShaderCache = { };
+
+		if ((m_pIDevice->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &ShaderCache, sizeof(ShaderCache)) == S_OK) &&
+			((ShaderCache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) != 0))
+		{
+			Status = CreateLibrary();
+		}
+		else
+		{
+			CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: The driver has no pipeline library support, pipelines will not be cached\n");
+		}
+	}
+
+	return Status;
+}
+
+VOID CPipelineLibrary::Uninitialize(VOID)
+{
+	if ((m_pILibrary != NULL) && (m_bDirty == TRUE) && (Save() != TRUE))
+	{
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: Pipeline cache %s was not updated\n", m_Path.c_str());
+	}
+
+	if (m_pILibrary != NULL)
+	{
+		m_pILibrary->Release();
+		m_pILibrary = NULL;
+	}
+
+	m_File.Close();
+
+	for (std::unordered_map<UINT64, ID3D12PipelineState*>::iterator it = m_Pipelines.begin(); it != m_Pipelines.end(); it++)
+	{
+		it->second->Release();
+	}
+
+	m_Pipelines.clear();
+
+	if (m_pIDevice != NULL)
+	{
+		m_pIDevice->Release();
+		m_pIDevice = NULL;
+	}
+
+	m_Adapter = { };
+	m_Path.clear();
+	m_bDirty = FALSE;
+	m_nLoaded = 0;
+	m_nCreated = 0;
+}
+
+BOOL CPipelineLibrary::GetAdapterIdentity(IDXGIAdapter* pIAdapter, CPipelineCacheFile::AdapterIdentity& rAdapter)
+{
+	BOOL Status = TRUE;
+
+	DXGI_ADAPTER_DESC Desc = { };
+	LARGE_INTEGER DriverVersion = { };
+
+	if (pIAdapter->GetDesc(&Desc) != S_OK)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not get the adapter description\n");
+	}
+
+	// Only answers for IDXGIDevice, where it reports the user mode driver version
+	if ((Status == TRUE) && (pIAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &DriverVersion) != S_OK))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not get the driver version\n");
+	}
+
+	if (Status == TRUE)
+	{
+		rAdapter.VendorId = Desc.VendorId;
+		rAdapter.DeviceId = Desc.DeviceId;
+		rAdapter.SubSysId = Desc.SubSysId;
+		rAdapter.Revision = Desc.Revision;
+		rAdapter.DriverVersion = static_cast<uint64_t>(DriverVersion.QuadPart);
+	}
+
+	return Status;
+}
+
+BOOL CPipelineLibrary::CreateLibrary(VOID)
+{
+	BOOL Status = TRUE;
+
+	// The library reads the blob in place, the file stays mapped until the library is released
+	if (m_File.Open(m_Path.c_str(), m_Adapter) == TRUE)
+	{
+		if (m_pIDevice->CreatePipelineLibrary(m_File.GetBlob(), m_File.GetBlobSize(), __uuidof(ID3D12PipelineLibrary), reinterpret_cast<VOID**>(&m_pILibrary)) != S_OK)
+		{
+			m_File.Close();
+			CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: The driver rejected pipeline cache %s, starting with an empty one\n", m_Path.c_str());
+		}
+	}
+
+	if (m_pILibrary == NULL)
+	{
+		if (m_pIDevice->CreatePipelineLibrary(NULL, 0, __uuidof(ID3D12PipelineLibrary), reinterpret_cast<VOID**>(&m_pILibrary)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create a pipeline library\n");
+		}
+	}
+
+	return Status;
+}
+
+BOOL CPipelineLibrary::Save(VOID)
+{
+	BOOL Status = TRUE;
+
+	std::vector<uint8_t> Blob(m_pILibrary->GetSerializedSize());
+
+	if (m_pILibrary->Serialize(Blob.data(), Blob.size()) != S_OK)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not serialize the pipeline library\n");
+	}
+
+	// The old file cannot be replaced while the library still reads from its mapping
+	m_pILibrary->Release();
+	m_pILibrary = NULL;
+	m_File.Close();
+
+	if (Status == TRUE)
+	{
+		Status = CPipelineCacheFile::Write(m_Path.c_str(), m_Adapter, Blob.data(), Blob.size());
+	}
+
+	if (Status == TRUE)
+	{
+		m_bDirty = FALSE;
+	}
+
+	return Status;
+}
+
+BOOL CPipelineLibrary::GetGraphicsPipeline(CONST D3D12_GRAPHICS_PIPELINE_STATE_DESC& rDesc, UINT64 RootSignatureKey, ID3D12PipelineState** ppIPipelineState)
+{
+	BOOL Status = (m_pIDevice != NULL) ? TRUE : FALSE;
+	ID3D12PipelineState* pIPipelineState = NULL;
+
+	CPipelineKey Key;
+	Key.AddValue(RootSignatureKey);
+	Key.AddGraphicsDesc(rDesc);
+
+	CONST UINT64 PipelineKey = Key.GetKey();
+
+	WCHAR Name[17] = { };
+	swprintf_s(Name, L"%016llx", PipelineKey);
+
+	if (Status == TRUE)
+	{
+		std::unordered_map<UINT64, ID3D12PipelineState*>::iterator it = m_Pipelines.find(PipelineKey);
+
+		if (it != m_Pipelines.end())
+		{
+			pIPipelineState = it->second;
+		}
+	}
+
+	// A pipeline the library does not hold fails with E_INVALIDARG and is created below instead
+	if ((Status == TRUE) && (pIPipelineState == NULL) && (m_pILibrary != NULL))
+	{
+		if (m_pILibrary->LoadGraphicsPipeline(Name, &rDesc, __uuidof(ID3D12PipelineState), reinterpret_cast<VOID**>(&pIPipelineState)) == S_OK)
+		{
+			m_Pipelines[PipelineKey] = pIPipelineState;
+			m_nLoaded++;
+		}
+		else
+		{
+			pIPipelineState = NULL;
+		}
+	}
+
+	if ((Status == TRUE) && (pIPipelineState == NULL))
+	{
+		if (m_pIDevice->CreateGraphicsPipelineState(&rDesc, __uuidof(ID3D12PipelineState), reinterpret_cast<VOID**>(&pIPipelineState)) == S_OK)
+		{
+			m_Pipelines[PipelineKey] = pIPipelineState;
+			m_nCreated++;
+
+			if ((m_pILibrary != NULL) && (m_pILibrary->StorePipeline(Name, pIPipelineState) == S_OK))
+			{
+				m_bDirty = TRUE;
+			}
+		}
+		else
+		{
+			Status = FALSE;
+			pIPipelineState = NULL;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create graphics pipeline %016llx\n", PipelineKey);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		pIPipelineState->AddRef();
+		*ppIPipelineState = pIPipelineState;
+	}
+
+	return Status;
+}
+
+UINT CPipelineLibrary::GetPipelineCount(VOID)
+{
+	return static_cast<UINT>(m_Pipelines.size());
+}
+
+UINT CPipelineLibrary::GetLoadedCount(VOID)
+{
+	return m_nLoaded;
+}
+
+UINT CPipelineLibrary::GetCreatedCount(VOID)
+{
+	return m_nCreated;
+}
@@ -0,0 +1,48 @@
+#ifndef CPIPELINELIBRARY_HPP
+#define CPIPELINELIBRARY_HPP
+
+#include <dxgi.h>
+#include <d3d12.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "CPipelineCacheFile.hpp"
+
+// Live pipeline states by CPipelineKey, backed by an ID3D12PipelineLibrary that is saved to a CPipelineCacheFile on
+// Uninitialize. A pipeline found in the library is loaded without compiling its shaders for the GPU again, the rest are
+// created and stored so the next run can load them. A driver without pipeline library support still gets the map, it
+// just starts cold every run.
+class CPipelineLibrary
+{
+protected:
+	ID3D12Device1*									 m_pIDevice;
+	ID3D12PipelineLibrary*							 m_pILibrary;
+	CPipelineCacheFile								 m_File;
+	CPipelineCacheFile::AdapterIdentity				 m_Adapter;
+	std::string										 m_Path;
+	std::unordered_map<UINT64, ID3D12PipelineState*> m_Pipelines;
+	BOOL											 m_bDirty;
+	UINT											 m_nLoaded;
+	UINT											 m_nCreated;
+
+	BOOL GetAdapterIdentity(IDXGIAdapter* pIAdapter, CPipelineCacheFile::AdapterIdentity& rAdapter);
+	BOOL CreateLibrary(VOID);
+	BOOL Save(VOID);
+
+public:
+	CPipelineLibrary();
+	~CPipelineLibrary();
+
+	BOOL Initialize(ID3D12Device* pIDevice, IDXGIAdapter* pIAdapter, LPCSTR pPath);
+	VOID Uninitialize(VOID);
+
+	// RootSignatureKey stands in for rDesc.pRootSignature in the key. The caller owns the reference it gets back.
+	BOOL GetGraphicsPipeline(CONST D3D12_GRAPHICS_PIPELINE_STATE_DESC& rDesc, UINT64 RootSignatureKey, ID3D12PipelineState** ppIPipelineState);
+
+	UINT GetPipelineCount(VOID);
+	UINT GetLoadedCount(VOID);
+	UINT GetCreatedCount(VOID);
+};
+
+#endif // CPIPELINELIBRARY_HPP
@@ -0,0 +1,249 @@
+#include "CPipelineQueue.hpp"
+
+#include "Console.hpp"
+
+CPipelineQueue::CPipelineQueue()
+{
+	m_pCompiler = NULL;
+	m_Sequence = 0;
+	m_bQuit = FALSE;
+	m_Report = { };
+}
+
+CPipelineQueue::~CPipelineQueue()
+{
+	Uninitialize();
+}
+
+BOOL CPipelineQueue::Initialize(IPipelineCompiler* pCompiler, UINT nThreads)
+{
+	BOOL Status = ((pCompiler != NULL) && (nThreads != 0) && (nThreads <= MaxThreads)) ? TRUE : FALSE;
+
+	Uninitialize();
+
+	if (Status == FALSE)
+	{
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Cannot compile pipelines on %u threads\n", nThreads);
+	}
+
+	if (Status == TRUE)
+	{
+		m_pCompiler = pCompiler;
+		m_bQuit = FALSE;
+
+		for (UINT i = 0; i < nThreads; i++)
+		{
+			m_Threads.push_back(std::thread(&CPipelineQueue::ThreadMain, this));
+		}
+	}
+
+	return Status;
+}
+
+VOID CPipelineQueue::Uninitialize(VOID)
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Lock);
+		m_bQuit = TRUE;
+	}
+
+	m_WakeUp.notify_all();
+
+	for (UINT i = 0; i < m_Threads.size(); i++)
+	{
+		m_Threads[i].join();
+	}
+
+	m_Threads.clear();
+
+	for (std::unordered_map<UINT64, Entry>::iterator it = m_Entries.begin(); it != m_Entries.end(); it++)
+	{
+		if (it->second.pRequest != NULL)
+		{
+			m_pCompiler->ReleaseRequest(it->second.pRequest);
+		}
+
+		if (it->second.pPipeline != NULL)
+		{
+			m_pCompiler->ReleasePipeline(it->second.pPipeline);
+		}
+	}
+
+	m_Entries.clear();
+	m_Queue = std::priority_queue<QueueItem>();
+	m_pCompiler = NULL;
+	m_Sequence = 0;
+	m_Report = { };
+}
+
+BOOL CPipelineQueue::Request(UINT64 Key, Priority ePriority, PVOID pRequest)
+{
+	BOOL Status = ((m_pCompiler != NULL) && (pRequest != NULL)) ? TRUE : FALSE;
+	BOOL bKept = FALSE;
+	BOOL bQueued = FALSE;
+
+	if (Status == TRUE)
+	{
+		std::lock_guard<std::mutex> Lock(m_Lock);
+		std::unordered_map<UINT64, Entry>::iterator it = m_Entries.find(Key);
+
+		if (it == m_Entries.end())
+		{
+			m_Entries[Key] = { PIPELINE_PENDING, ePriority, pRequest, NULL };
+			m_Queue.push({ ePriority, m_Sequence++, Key });
+			m_Report.nPending++;
+			bKept = TRUE;
+			bQueued = TRUE;
+		}
+		else if ((it->second.eStatus == PIPELINE_PENDING) && (it->second.ePriority < ePriority))
+		{
+			it->second.ePriority = ePriority;
+			m_Queue.push({ ePriority, m_Sequence++, Key });
+			bQueued = TRUE;
+		}
+	}
+
+	if (bQueued == TRUE)
+	{
+		m_WakeUp.notify_one();
+	}
+
+	if ((Status == TRUE) && (bKept == FALSE))
+	{
+		m_pCompiler->ReleaseRequest(pRequest);
+	}
+
+	return Status;
+}
+
+CPipelineQueue::PipelineStatus CPipelineQueue::GetStatus(UINT64 Key)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	std::unordered_map<UINT64, Entry>::iterator it = m_Entries.find(Key);
+
+	return (it != m_Entries.end()) ? it->second.eStatus : PIPELINE_UNKNOWN;
+}
+
+PVOID CPipelineQueue::Acquire(UINT64 Key)
+{
+	return Resolve(Key, NULL);
+}
+
+PVOID CPipelineQueue::Acquire(UINT64 Key, UINT64 FallbackKey)
+{
+	return Resolve(Key, &FallbackKey);
+}
+
+PVOID CPipelineQueue::Resolve(UINT64 Key, CONST UINT64* pFallbackKey)
+{
+	PVOID pPipeline = NULL;
+
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	std::unordered_map<UINT64, Entry>::iterator it = m_Entries.find(Key);
+
+	if ((it != m_Entries.end()) && (it->second.eStatus == PIPELINE_READY))
+	{
+		pPipeline = it->second.pPipeline;
+		m_Report.nDrawsReady++;
+	}
+
+	if ((pPipeline == NULL) && (pFallbackKey != NULL))
+	{
+		it = m_Entries.find(*pFallbackKey);
+
+		if ((it != m_Entries.end()) && (it->second.eStatus == PIPELINE_READY))
+		{
+			pPipeline = it->second.pPipeline;
+			m_Report.nDrawsFallback++;
+		}
+	}
+
+	if (pPipeline == NULL)
+	{
+		m_Report.nDrawsSkipped++;
+	}
+
+	return pPipeline;
+}
+
+VOID CPipelineQueue::WaitIdle(VOID)
+{
+	std::unique_lock<std::mutex> Lock(m_Lock);
+
+	m_Idle.wait(Lock, [this] { return ((m_Report.nPending == 0) && (m_Report.nCompiling == 0)) || (m_Threads.empty() == true); });
+}
+
+VOID CPipelineQueue::BeginFrame(VOID)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+
+	m_Report.nDrawsReady = 0;
+	m_Report.nDrawsFallback = 0;
+	m_Report.nDrawsSkipped = 0;
+}
+
+VOID CPipelineQueue::GetReport(Report& rReport)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+
+	rReport = m_Report;
+}
+
+VOID CPipelineQueue::ThreadMain(VOID)
+{
+	std::unique_lock<std::mutex> Lock(m_Lock);
+
+	while (true)
+	{
+		m_WakeUp.wait(Lock, [this] { return (m_bQuit == TRUE) || (m_Queue.empty() == false); });
+
+		if (m_bQuit == TRUE)
+		{
+			break;
+		}
+
+		CONST QueueItem Item = m_Queue.top();
+		m_Queue.pop();
+
+		// Entries are never erased while the threads run, so the reference survives the unlocked compile below
+		Entry& rEntry = m_Entries[Item.Key];
+
+		if ((rEntry.eStatus != PIPELINE_PENDING) || (rEntry.ePriority != Item.ePriority))
+		{
+			continue;
+		}
+
+		PVOID pRequest = rEntry.pRequest;
+
+		rEntry.eStatus = PIPELINE_COMPILING;
+		rEntry.pRequest = NULL;
+		m_Report.nPending--;
+		m_Report.nCompiling++;
+
+		Lock.unlock();
+
+		PVOID pPipeline = m_pCompiler->Compile(pRequest);
+		m_pCompiler->ReleaseRequest(pRequest);
+
+		Lock.lock();
+
+		rEntry.eStatus = (pPipeline != NULL) ? PIPELINE_READY : PIPELINE_FAILED;
+		rEntry.pPipeline = pPipeline;
+		m_Report.nCompiling--;
+
+		if (pPipeline != NULL)
+		{
+			m_Report.nReady++;
+		}
+		else
+		{
+			m_Report.nFailed++;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Pipeline %016llx failed to compile, its draws will fall back or be skipped\n", Item.Key);
+		}
+
+		if ((m_Report.nPending == 0) && (m_Report.nCompiling == 0))
+		{
+			m_Idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,123 @@
+#ifndef CPIPELINEQUEUE_HPP
+#define CPIPELINEQUEUE_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "IPipelineCompiler.hpp"
+
+/*
+* Compiles pipelines on background threads so asking for one never stalls a frame. A pipeline moves through
+*
+*	PIPELINE_PENDING	requested, waiting for a thread
+*	PIPELINE_COMPILING	a thread is inside IPipelineCompiler::Compile
+*	PIPELINE_READY		Acquire hands it out
+*	PIPELINE_FAILED		Acquire never will
+*
+* Higher priorities are compiled first, requests of equal priority in the order they were made. Asking again for a
+* pending pipeline with a higher priority moves it up. Draws call Acquire every frame, which falls back to another
+* pipeline or returns NULL while theirs is not ready, and is counted in the frame's report either way.
+*/
+class CPipelineQueue
+{
+public:
+	enum Priority : UINT
+	{
+		PRIORITY_LOW = 0,
+		PRIORITY_NORMAL = 1,
+		PRIORITY_HIGH = 2
+	};
+
+	enum PipelineStatus : UINT
+	{
+		PIPELINE_UNKNOWN = 0,
+		PIPELINE_PENDING = 1,
+		PIPELINE_COMPILING = 2,
+		PIPELINE_READY = 3,
+		PIPELINE_FAILED = 4
+	};
+
+	enum { MaxThreads = 8 };
+
+	// Pipeline counts as of the call, draw counts since the last BeginFrame
+	struct Report
+	{
+		UINT nPending;
+		UINT nCompiling;
+		UINT nReady;
+		UINT nFailed;
+		UINT nDrawsReady;
+		UINT nDrawsFallback;
+		UINT nDrawsSkipped;
+	};
+
+protected:
+	struct Entry
+	{
+		PipelineStatus eStatus;
+		Priority	   ePriority;
+		PVOID		   pRequest;
+		PVOID		   pPipeline;
+	};
+
+	// Reprioritizing pushes another item, the one left behind no longer matches its entry and is skipped
+	struct QueueItem
+	{
+		Priority ePriority;
+		UINT64	 Sequence;
+		UINT64	 Key;
+
+		bool operator<(CONST QueueItem& rOther) CONST
+		{
+			return (ePriority != rOther.ePriority) ? (ePriority < rOther.ePriority) : (Sequence > rOther.Sequence);
+		}
+	};
+
+	IPipelineCompiler*					m_pCompiler;
+	std::vector<std::thread>			m_Threads;
+
+	std::mutex							m_Lock;
+	std::condition_variable				m_WakeUp;
+	std::condition_variable				m_Idle;
+	std::unordered_map<UINT64, Entry>	m_Entries;
+	std::priority_queue<QueueItem>		m_Queue;
+	UINT64								m_Sequence;
+	BOOL								m_bQuit;
+	Report								m_Report;
+
+	VOID ThreadMain(VOID);
+	PVOID Resolve(UINT64 Key, CONST UINT64* pFallbackKey);
+
+public:
+	CPipelineQueue();
+	~CPipelineQueue();
+
+	BOOL Initialize(IPipelineCompiler* pCompiler, UINT nThreads);
+
+	// Waits for the pipelines being compiled, drops the pending ones and releases every pipeline handed out
+	VOID Uninitialize(VOID);
+
+	// The queue owns pRequest once this returns TRUE. A key that was requested before keeps its first request and only
+	// has its priority raised.
+	BOOL Request(UINT64 Key, Priority ePriority, PVOID pRequest);
+
+	PipelineStatus GetStatus(UINT64 Key);
+
+	// The pipeline stays valid until Uninitialize. The first form returns NULL when the draw has to be skipped.
+	PVOID Acquire(UINT64 Key);
+	PVOID Acquire(UINT64 Key, UINT64 FallbackKey);
+
+	// Returns once nothing is pending or compiling
+	VOID WaitIdle(VOID);
+
+	VOID BeginFrame(VOID);
+	VOID GetReport(Report& rReport);
+};
+
+#endif // CPIPELINEQUEUE_HPP
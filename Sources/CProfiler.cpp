@@ -0,0 +1,264 @@
+#include "Profiler.hpp"
+#include "CProfiler.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <thread>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+CProfiler g_Profiler;
+
+thread_local CProfiler::ThreadBuffer* CProfiler::t_pBuffer = NULL;
+thread_local UINT CProfiler::t_Generation = 0;
+
+BOOL Profiler::Initialize(VOID)
+{
+	return g_Profiler.Initialize();
+}
+
+VOID Profiler::Uninitialize(VOID)
+{
+	g_Profiler.Uninitialize();
+}
+
+VOID Profiler::SetThreadName(LPCSTR pName)
+{
+	g_Profiler.SetThreadName(pName);
+}
+
+VOID Profiler::RecordZone(LPCSTR pName, UINT64 Start, UINT64 End)
+{
+	g_Profiler.RecordZone(pName, Start, End);
+}
+
+BOOL Profiler::ExportChromeTrace(LPCSTR pPath)
+{
+	return g_Profiler.ExportChromeTrace(pPath);
+}
+
+CProfiler::CProfiler()
+{
+	m_Generation = 0;
+	m_bInitialized = FALSE;
+	m_nRecording = 0;
+	m_BaseTimestamp = 0;
+}
+
+CProfiler::~CProfiler()
+{
+	Uninitialize();
+}
+
+BOOL CProfiler::Initialize(VOID)
+{
+	Uninitialize();
+
+	m_BaseTime = std::chrono::steady_clock::now();
+	m_BaseTimestamp = Profiler::GetTimestamp();
+
+	// Buffers handed out before this point belong to an earlier session
+	m_Generation.fetch_add(1);
+	m_bInitialized = TRUE;
+
+	return TRUE;
+}
+
+VOID CProfiler::Uninitialize(VOID)
+{
+	m_bInitialized = FALSE;
+
+	// A thread that saw the profiler initialized may still be writing to its buffer
+	while (m_nRecording != 0)
+	{
+		std::this_thread::yield();
+	}
+
+	std::lock_guard<std::mutex> Lock(m_BufferLock);
+
+	for (SIZE_T i = 0; i < m_Buffers.size(); i++)
+	{
+		Memory::Free(m_Buffers[i]);
+	}
+
+	m_Buffers.clear();
+}
+
+CProfiler::ThreadBuffer* CProfiler::GetThreadBuffer(VOID)
+{
+	CONST UINT Generation = m_Generation.load(std::memory_order_relaxed);
+
+	if ((t_pBuffer == NULL) || (t_Generation != Generation))
+	{
+		ThreadBuffer* pBuffer = reinterpret_cast<ThreadBuffer*>(Memory::Allocate(sizeof(ThreadBuffer), TRUE));
+
+		if (pBuffer != NULL)
+		{
+			std::lock_guard<std::mutex> Lock(m_BufferLock);
+
+			new (&pBuffer->Written) std::atomic<UINT64>(0);
+			pBuffer->ThreadId = static_cast<UINT>(m_Buffers.size());
+			snprintf(pBuffer->Name, MaxNameLength, "Thread %u", pBuffer->ThreadId);
+
+			m_Buffers.push_back(pBuffer);
+		}
+
+		t_pBuffer = pBuffer;
+		t_Generation = Generation;
+	}
+
+	return t_pBuffer;
+}
+
+VOID CProfiler::SetThreadName(LPCSTR pName)
+{
+	m_nRecording++;
+
+	if (m_bInitialized == TRUE)
+	{
+		ThreadBuffer* pBuffer = GetThreadBuffer();
+
+		if (pBuffer != NULL)
+		{
+			std::lock_guard<std::mutex> Lock(m_BufferLock);
+			snprintf(pBuffer->Name, MaxNameLength, "%s", pName);
+		}
+	}
+
+	m_nRecording--;
+}
+
+VOID CProfiler::RecordZone(LPCSTR pName, UINT64 Start, UINT64 End)
+{
+	// Counted before the check, so Uninitialize either waits for this zone or this zone sees the profiler stopped
+	m_nRecording++;
+
+	if (m_bInitialized == TRUE)
+	{
+		ThreadBuffer* pBuffer = GetThreadBuffer();
+
+		if (pBuffer != NULL)
+		{
+			CONST UINT64 Index = pBuffer->Written.load(std::memory_order_relaxed);
+			Event& rEvent = pBuffer->Events[Index & EventMask];
+
+			rEvent.pName = pName;
+			rEvent.Start = Start;
+			rEvent.End = End;
+
+			pBuffer->Written.store(Index + 1, std::memory_order_release);
+		}
+	}
+
+	m_nRecording--;
+}
+
+double CProfiler::GetMicrosecondsPerTick(VOID)
+{
+#if PROFILER_RDTSC
+	// Calibrate the time stamp counter against the wall clock over at least a millisecond
+	std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+
+	while ((Now - m_BaseTime) < std::chrono::milliseconds(1))
+	{
+		std::this_thread::yield();
+		Now = std::chrono::steady_clock::now();
+	}
+
+	CONST UINT64 Ticks = Profiler::GetTimestamp() - m_BaseTimestamp;
+	CONST double Microseconds = std::chrono::duration<double, std::micro>(Now - m_BaseTime).count();
+
+	return Microseconds / static_cast<double>(Ticks);
+#else
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::duration(1)).count();
+#endif
+}
+
+BOOL CProfiler::ExportChromeTrace(LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+	std::ofstream File;
+
+	if (m_bInitialized == FALSE)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: The profiler is not initialized\n");
+	}
+
+	if (Status == TRUE)
+	{
+		File.open(pPath, std::ios::out | std::ios::trunc);
+
+		if (File.is_open() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open %s\n", pPath);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		CONST double MicrosecondsPerTick = GetMicrosecondsPerTick();
+
+		std::vector<Event> Events;
+		CHAR Line[256] = { };
+		UINT64 nZones = 0;
+		BOOL bFirst = TRUE;
+
+		std::lock_guard<std::mutex> Lock(m_BufferLock);
+
+		File << "{ \"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+
+		for (SIZE_T b = 0; b < m_Buffers.size(); b++)
+		{
+			ThreadBuffer* pBuffer = m_Buffers[b];
+
+			UINT64 Written = pBuffer->Written.load(std::memory_order_acquire);
+			UINT64 First = (Written > EventCapacity) ? (Written - EventCapacity) : 0;
+
+			Events.clear();
+
+			for (UINT64 i = First; i < Written; i++)
+			{
+				Events.push_back(pBuffer->Events[i & EventMask]);
+			}
+
+			// The owning thread may have wrapped around onto entries while they were copied
+			UINT64 Overwritten = pBuffer->Written.load(std::memory_order_acquire);
+			UINT64 Skip = ((Overwritten > EventCapacity) && ((Overwritten - EventCapacity) > First)) ? ((Overwritten - EventCapacity) - First) : 0;
+
+			snprintf(Line, sizeof(Line), "%s  { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": { \"name\": \"%s\" } }", (bFirst == TRUE) ? "" : ",\n", pBuffer->ThreadId, pBuffer->Name);
+			File << Line;
+			bFirst = FALSE;
+
+			for (SIZE_T i = static_cast<SIZE_T>(Skip); i < Events.size(); i++)
+			{
+				CONST Event& rEvent = Events[i];
+				CONST double Start = static_cast<double>(static_cast<int64_t>(rEvent.Start - m_BaseTimestamp)) * MicrosecondsPerTick;
+				CONST double Duration = static_cast<double>(rEvent.End - rEvent.Start) * MicrosecondsPerTick;
+
+				// Zone names are identifiers or function names, neither needs escaping
+				snprintf(Line, sizeof(Line), ",\n  { \"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f }", rEvent.pName, pBuffer->ThreadId, Start, Duration);
+				File << Line;
+				nZones++;
+			}
+		}
+
+		File << "\n] }\n";
+
+		if (File.good() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not write %s\n", pPath);
+		}
+		else
+		{
+			Console::Write("Wrote %llu profiler zones from %u threads to %s\n", nZones, static_cast<UINT>(m_Buffers.size()), pPath);
+		}
+	}
+
+	return Status;
+}
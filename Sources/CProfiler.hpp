@@ -0,0 +1,64 @@
+#ifndef CPROFILER_HPP
+#define CPROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "Defines.hpp"
+
+class CProfiler
+{
+protected:
+	enum { EventCapacity = 32768, EventMask = EventCapacity - 1, MaxNameLength = 32 };
+
+	struct Event
+	{
+		LPCSTR pName;
+		UINT64 Start;
+		UINT64 End;
+	};
+
+	// Written only by its own thread, the newest EventCapacity zones are kept
+	struct ThreadBuffer
+	{
+		std::atomic<UINT64> Written;
+		UINT				ThreadId;
+		CHAR				Name[MaxNameLength];
+		Event				Events[EventCapacity];
+	};
+
+	static thread_local ThreadBuffer* t_pBuffer;
+	static thread_local UINT		  t_Generation;
+
+	std::mutex					m_BufferLock;
+	std::vector<ThreadBuffer*>	m_Buffers;
+
+	std::atomic<UINT>			m_Generation;
+	std::atomic<BOOL>			m_bInitialized;
+
+	// Threads between their m_bInitialized check and their last use of a buffer, Uninitialize waits for them
+	std::atomic<UINT>			m_nRecording;
+
+	// Pairs a timestamp with wall clock time so timestamps can be converted to microseconds
+	UINT64						m_BaseTimestamp;
+	std::chrono::steady_clock::time_point m_BaseTime;
+
+	ThreadBuffer* GetThreadBuffer(VOID);
+	double		  GetMicrosecondsPerTick(VOID);
+
+public:
+	CProfiler();
+	~CProfiler();
+
+	BOOL Initialize(VOID);
+	VOID Uninitialize(VOID);
+
+	VOID SetThreadName(LPCSTR pName);
+	VOID RecordZone(LPCSTR pName, UINT64 Start, UINT64 End);
+
+	BOOL ExportChromeTrace(LPCSTR pPath);
+};
+
+#endif // CPROFILER_HPP
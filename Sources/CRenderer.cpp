@@ -5,22 +5,26 @@
 
 #include <d3dcompiler.h>
 
+#include <chrono>
 #include <cmath>
-#include <vector>
+#include <string>
 
+#include "CGeometry.hpp"
+#include "CMeshBuilder.hpp"
+#include "CMeshFile.hpp"
+#include "CSceneShaders.hpp"
+#include "CShaderRegistry.hpp"
 #include "Console.hpp"
+#include "Hash.hpp"
+#include "Memory.hpp"
+#include "Profiler.hpp"
 
 CONST FLOAT CRenderer::ClearColor[] = { 50.0f / 255.0f, 135.0f / 255.0f, 235.0f / 255.0f, 1.0f };
-
-IRenderer* IRenderer::Create(HWND hWND, ULONG Width, ULONG Height)
-{
-	return CRenderer::Create(hWND, Width, Height);
-}
-
-VOID IRenderer::Destroy(IRenderer* pRenderer)
-{
-	CRenderer::Destroy(static_cast<CRenderer*>(pRenderer));
-}
+CONST LPCSTR CRenderer::GpuPassNames[] = { "Frame", "Clear", "Draw", "Barrier" };
+CONST DXGI_FORMAT CRenderer::DepthFormat = DXGI_FORMAT_D32_FLOAT;
+CONST LPCSTR CRenderer::ShaderDirectory = "C:/Workspace/DX12_HelloCube/Shaders/";
+CONST LPCSTR CRenderer::ShaderCachePath = "C:/Workspace/DX12_HelloCube/Output/ShaderCache.bin";
+CONST LPCSTR CRenderer::PipelineCachePath = "C:/Workspace/DX12_HelloCube/Output/PipelineCache.bin";
 
 CRenderer* CRenderer::Create(HWND hWND, ULONG Width, ULONG Height)
 {
@@ -59,20 +63,53 @@ CRenderer::CRenderer()
 	m_pIDevice = NULL;
 	m_pICommandQueue = NULL;
 	m_pIDescriptorHeap = NULL;
+	m_pIDsvHeap = NULL;
+	m_pIDepthBuffer = NULL;
 	m_pIRenderBuffers[0] = NULL;
 	m_pIRenderBuffers[1] = NULL;
-	m_pICommandAllocator = NULL;
 	m_pIRootSignature = NULL;
-	m_pIPipelineState = NULL;
 	m_pIVertexBuffer = NULL;
+	m_pIIndexBuffer = NULL;
+	m_pIUploadHeap = NULL;
+	m_pIUploadBuffer = NULL;
+	m_pIPrimaryHeap = NULL;
+	m_pITimestampHeap = NULL;
+	m_pITimestampBuffer = NULL;
+	m_pIConstantBuffer = NULL;
+	m_pIInstanceBuffer = NULL;
 
 	m_pIFence = NULL;
 	m_hFenceEvent = NULL;
 	m_pICommandList = NULL;
+	m_pIPresentCommandList = NULL;
 
 	m_FrameIndex = 0;
 	m_FenceValue = 0;
+	m_pUploadData = NULL;
+	m_pTimestampData = NULL;
+	m_pConstantData = NULL;
+	m_pInstanceData = NULL;
+	m_RootSignatureKey = 0;
+	m_PipelineKey = 0;
+	m_PipelineReport = { };
+	m_VertexAllocation = { 0, 0, CHeapAllocator::InvalidHandle };
+	m_IndexAllocation = { 0, 0, CHeapAllocator::InvalidHandle };
+	m_VertexFormat = VERTEX_FORMAT_FLOAT;
 	m_RtvDescriptorIncrement = 0;
+	m_CubeNode = CTransformHierarchy::InvalidNode;
+	m_FieldNode = CTransformHierarchy::InvalidNode;
+	m_InstanceBufferView = { 0, 0, 0 };
+
+	for (UINT i = 0; i < NumFramesInFlight; i++)
+	{
+		m_pICommandAllocators[i] = NULL;
+	}
+
+	for (UINT i = 0; i < 3; i++)
+	{
+		m_BoundsMin[i] = 0.0f;
+		m_BoundsExtent[i] = 0.0f;
+	}
 }
 
 CRenderer::~CRenderer()
@@ -92,7 +129,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 	else
 	{
 		Status = FALSE;
-		Console::Write("Error: Failed to get dx12 debug interface\n");
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to get dx12 debug interface\n");
 	}
 
 #if _DEBUG
@@ -107,13 +144,13 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 			if (m_pfnDxgiGetDebugInterface == NULL)
 			{
 				Status = FALSE;
-				Console::Write("Error: Could not find function DXGIGetDebugInterface in the dxgi debug module\n");
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not find function DXGIGetDebugInterface in the dxgi debug module\n");
 			}
 		}
 		else
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not load the dxgi debug module\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not load the dxgi debug module\n");
 		}
 	}
 
@@ -122,7 +159,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		if (m_pfnDxgiGetDebugInterface(__uuidof(IDXGIDebug), reinterpret_cast<VOID**>(&m_pIDxgiDebugInterface)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to get dxgi debug interface\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to get dxgi debug interface\n");
 		}
 	}
 #endif
@@ -138,7 +175,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		if (CreateDXGIFactory2(Flags, __uuidof(IDXGIFactory7), reinterpret_cast<VOID**>(&m_pIDxgiFactory)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create dxgi factory\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create dxgi factory\n");
 		}
 	}
 
@@ -149,7 +186,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		if (Status == FALSE)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not get dxgi adapter\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not get dxgi adapter\n");
 		}
 	}
 
@@ -160,10 +197,26 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		if (m_pIDevice == NULL)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not create a DX12 device\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create a DX12 device\n");
 		}
 	}
 
+	if (Status == TRUE)
+	{
+		Status = m_PipelineLibrary.Initialize(m_pIDevice, m_pIDxgiAdapter, PipelineCachePath);
+	}
+
+	// One thread, the pipeline library behind the compiler is not thread safe
+	if (Status == TRUE)
+	{
+		Status = m_PipelineCompiler.Initialize(&m_PipelineLibrary);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = m_PipelineQueue.Initialize(&m_PipelineCompiler, 1);
+	}
+
 	if (Status == TRUE)
 	{
 		D3D12_COMMAND_QUEUE_DESC cmdQueueDesc = { };
@@ -175,7 +228,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		if (m_pIDevice->CreateCommandQueue(&cmdQueueDesc, __uuidof(ID3D12CommandQueue), reinterpret_cast<VOID**>(&m_pICommandQueue)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create command queue\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create command queue\n");
 		}
 	}
 
@@ -207,7 +260,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		else
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create swap chain\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create swap chain\n");
 		}
 	}
 
@@ -226,7 +279,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		else
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create descriptor heap\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create descriptor heap\n");
 		}
 	}
 
@@ -239,7 +292,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 			if (m_pISwapChain->GetBuffer(i, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(&m_pIRenderBuffers[i])) != S_OK)
 			{
 				Status = FALSE;
-				Console::Write("Error: Could not get swap chain buffer %u\n", i);
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not get swap chain buffer %u\n", i);
 			}
 
 			m_pIDevice->CreateRenderTargetView(m_pIRenderBuffers[i], NULL, cpuDescHandle);
@@ -250,18 +303,48 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 
 	if (Status == TRUE)
 	{
-		if (m_pIDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator), reinterpret_cast<VOID**>(&m_pICommandAllocator)) != S_OK)
+		Status = CreateDepthBuffer(Width, Height);
+	}
+
+	// Every frame in flight records into its own allocator, it is only reset once the GPU is done with that frame
+	for (UINT i = 0; (Status == TRUE) && (i < NumFramesInFlight); i++)
+	{
+		if (m_pIDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator), reinterpret_cast<VOID**>(&m_pICommandAllocators[i])) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not create command allocator\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create command allocator %u\n", i);
 		}
 	}
 
 	if (Status == TRUE)
 	{
+		Status = m_FrameScheduler.Initialize(NumFramesInFlight);
+	}
+
+	// Setup commands are recorded as the first frame, in slot 0
+	if (Status == TRUE)
+	{
+		m_FrameScheduler.BeginFrame();
+	}
+
+	if (Status == TRUE)
+	{
+		// Small per draw data goes straight into the root signature, anything larger is read from the frame's constant buffer
+		D3D12_ROOT_PARAMETER parameters[NumRootParameters] = { };
+		parameters[ROOT_PARAMETER_CONSTANTS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		parameters[ROOT_PARAMETER_CONSTANTS].Constants.ShaderRegister = 0;
+		parameters[ROOT_PARAMETER_CONSTANTS].Constants.RegisterSpace = 0;
+		parameters[ROOT_PARAMETER_CONSTANTS].Constants.Num32BitValues = NumRootConstants;
+		parameters[ROOT_PARAMETER_CONSTANTS].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+
+		parameters[ROOT_PARAMETER_DRAW_CONSTANTS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		parameters[ROOT_PARAMETER_DRAW_CONSTANTS].Descriptor.ShaderRegister = 1;
+		parameters[ROOT_PARAMETER_DRAW_CONSTANTS].Descriptor.RegisterSpace = 0;
+		parameters[ROOT_PARAMETER_DRAW_CONSTANTS].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+
 		D3D12_ROOT_SIGNATURE_DESC desc = { };
-		desc.NumParameters = 0;
-		desc.pParameters = NULL;
+		desc.NumParameters = _countof(parameters);
+		desc.pParameters = parameters;
 		desc.NumStaticSamplers = 0;
 		desc.pStaticSamplers = NULL;
 		desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
@@ -274,17 +357,20 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 			if (m_pIDevice->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), __uuidof(ID3D12RootSignature), reinterpret_cast<VOID**>(&m_pIRootSignature)) != S_OK)
 			{
 				Status = FALSE;
-				Console::Write("Error: Could not create root signature\n");
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create root signature\n");
 			}
+
+			// Stands in for the root signature in pipeline keys, the same serialized form means the same signature
+			m_RootSignatureKey = Hash::Fnv1a(pSignature->GetBufferPointer(), pSignature->GetBufferSize());
 		}
 		else
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not initialize root signature\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not initialize root signature\n");
 
 			if (pError != NULL)
 			{
-				Console::Write("Error Info: %s\n", pError->GetBufferPointer());
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error Info: %s\n", pError->GetBufferPointer());
 			}
 		}
 
@@ -303,18 +389,32 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 
 	if (Status == TRUE)
 	{
-		Status = CompileShaders();
+		if (m_pIDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_pICommandAllocators[0], NULL, __uuidof(ID3D12GraphicsCommandList), reinterpret_cast<VOID**>(&m_pICommandList)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create command list\n");
+		}
 	}
 
 	if (Status == TRUE)
 	{
-		if (m_pIDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_pICommandAllocator, m_pIPipelineState, __uuidof(ID3D12GraphicsCommandList), reinterpret_cast<VOID**>(&m_pICommandList)) != S_OK)
+		if (m_pIDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_pICommandAllocators[0], NULL, __uuidof(ID3D12GraphicsCommandList), reinterpret_cast<VOID**>(&m_pIPresentCommandList)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create present command list\n");
+		}
+		else if (m_pIPresentCommandList->Close() != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not create command list\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not close present command list\n");
 		}
 	}
 
+	for (UINT i = 0; (Status == TRUE) && (i < NumRecordingThreads); i++)
+	{
+		Status = m_CommandListSinks[i].Initialize(m_pIDevice, NumFramesInFlight);
+	}
+
 	if (Status == TRUE)
 	{
 		if (m_pIDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, __uuidof(ID3D12Fence), reinterpret_cast<VOID**>(&m_pIFence)) == S_OK)
@@ -324,7 +424,7 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		else
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not create fence\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create fence\n");
 		}
 	}
 
@@ -335,15 +435,47 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 		if (m_hFenceEvent == NULL)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not create fence event\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create fence event\n");
 		}
 	}
 
+	if (Status == TRUE)
+	{
+		Status = Memory::CreateFrameArenas(NumFramesInFlight, FrameArenaSize);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = CreateGpuTimer();
+	}
+
+	if (Status == TRUE)
+	{
+		Status = CreateUploadRing();
+	}
+
+	if (Status == TRUE)
+	{
+		Status = CreateConstantBuffer();
+	}
+
 	if (Status == TRUE)
 	{
 		Status = CreateBuffers();
 	}
 
+	// Sized for every instance in the scene, so it can only be created once the scene exists
+	if (Status == TRUE)
+	{
+		Status = CreateInstanceBuffer();
+	}
+
+	// The input layout depends on the vertex format of the loaded mesh
+	if (Status == TRUE)
+	{
+		Status = CompileShaders();
+	}
+
 	if (Status == TRUE)
 	{
 		m_Viewport.TopLeftX = 0;
@@ -364,12 +496,84 @@ BOOL CRenderer::Initialize(HWND hWND, ULONG Width, ULONG Height)
 
 VOID CRenderer::Uninitialize(VOID)
 {
+	// Uploads are not waited for when they are submitted, drain the queue before releasing anything it may still read
+	if ((m_pIFence != NULL) && (m_hFenceEvent != NULL) && (m_FrameScheduler.GetLatestFence() != 0))
+	{
+		WaitForFence(m_FrameScheduler.GetLatestFence());
+	}
+
+	m_FrameScheduler.Uninitialize();
+
+	m_GpuTimer.PrintStatistics();
+	m_GpuTimer.Uninitialize();
+
+	if (m_pITimestampBuffer != NULL)
+	{
+		m_pITimestampBuffer->Unmap(0, NULL);
+		m_pITimestampBuffer->Release();
+		m_pITimestampBuffer = NULL;
+		m_pTimestampData = NULL;
+	}
+
+	if (m_pITimestampHeap != NULL)
+	{
+		m_pITimestampHeap->Release();
+		m_pITimestampHeap = NULL;
+	}
+
+	for (UINT i = 0; i < NumRecordingThreads; i++)
+	{
+		m_CommandListSinks[i].Uninitialize();
+	}
+
+	Memory::DestroyFrameArenas();
+
+	m_UploadRing.Uninitialize();
+	m_ConstantAllocator.Uninitialize();
+	m_InstanceAllocator.Uninitialize();
+
+	if (m_pIInstanceBuffer != NULL)
+	{
+		m_pIInstanceBuffer->Unmap(0, NULL);
+		m_pIInstanceBuffer->Release();
+		m_pIInstanceBuffer = NULL;
+		m_pInstanceData = NULL;
+	}
+
+	if (m_pIConstantBuffer != NULL)
+	{
+		m_pIConstantBuffer->Unmap(0, NULL);
+		m_pIConstantBuffer->Release();
+		m_pIConstantBuffer = NULL;
+		m_pConstantData = NULL;
+	}
+
+	if (m_pIUploadBuffer != NULL)
+	{
+		m_pIUploadBuffer->Unmap(0, NULL);
+		m_pIUploadBuffer->Release();
+		m_pIUploadBuffer = NULL;
+		m_pUploadData = NULL;
+	}
+
+	if (m_pIIndexBuffer != NULL)
+	{
+		m_pIIndexBuffer->Release();
+		m_pIIndexBuffer = NULL;
+	}
+
 	if (m_pIVertexBuffer != NULL)
 	{
 		m_pIVertexBuffer->Release();
 		m_pIVertexBuffer = NULL;
 	}
 
+	m_PrimaryHeapAllocator.Free(m_IndexAllocation.Handle);
+	m_PrimaryHeapAllocator.Free(m_VertexAllocation.Handle);
+	m_PrimaryHeapAllocator.Uninitialize();
+	m_IndexAllocation.Handle = CHeapAllocator::InvalidHandle;
+	m_VertexAllocation.Handle = CHeapAllocator::InvalidHandle;
+
 	if (m_pIUploadHeap != NULL)
 	{
 		m_pIUploadHeap->Release();
@@ -382,11 +586,9 @@ VOID CRenderer::Uninitialize(VOID)
 		m_pIPrimaryHeap = NULL;
 	}
 
-	if (m_pIPipelineState != NULL)
-	{
-		m_pIPipelineState->Release();
-		m_pIPipelineState = NULL;
-	}
+	// Pending requests still point at the root signature, and the pipelines are released through the library
+	m_PipelineQueue.Uninitialize();
+	m_PipelineCompiler.Uninitialize();
 
 	if (m_pIRootSignature != NULL)
 	{
@@ -394,6 +596,9 @@ VOID CRenderer::Uninitialize(VOID)
 		m_pIRootSignature = NULL;
 	}
 
+	// Saves the pipelines created this run, needs the device
+	m_PipelineLibrary.Uninitialize();
+
 	if (m_hFenceEvent != NULL)
 	{
 		CloseHandle(m_hFenceEvent);
@@ -405,16 +610,25 @@ VOID CRenderer::Uninitialize(VOID)
 		m_pIFence = NULL;
 	}
 
+	if (m_pIPresentCommandList != NULL)
+	{
+		m_pIPresentCommandList->Release();
+		m_pIPresentCommandList = NULL;
+	}
+
 	if (m_pICommandList != NULL)
 	{
 		m_pICommandList->Release();
 		m_pICommandList = NULL;
 	}
 
-	if (m_pICommandAllocator != NULL)
+	for (UINT i = 0; i < NumFramesInFlight; i++)
 	{
-		m_pICommandAllocator->Release();
-		m_pICommandAllocator = NULL;
+		if (m_pICommandAllocators[i] != NULL)
+		{
+			m_pICommandAllocators[i]->Release();
+			m_pICommandAllocators[i] = NULL;
+		}
 	}
 
 	for (UINT i = 0; i < NumBuffers; i++)
@@ -426,6 +640,18 @@ VOID CRenderer::Uninitialize(VOID)
 		}
 	}
 
+	if (m_pIDepthBuffer != NULL)
+	{
+		m_pIDepthBuffer->Release();
+		m_pIDepthBuffer = NULL;
+	}
+
+	if (m_pIDsvHeap != NULL)
+	{
+		m_pIDsvHeap->Release();
+		m_pIDsvHeap = NULL;
+	}
+
 	if (m_pIDescriptorHeap != NULL)
 	{
 		m_pIDescriptorHeap->Release();
@@ -588,7 +814,7 @@ BOOL CRenderer::PrintAdapterDesc(UINT uIndex, IDXGIAdapter4* pIAdapter)
 	else
 	{
 		Status = FALSE;
-		Console::Write("Error: Could not get description for adapter %u\n", uIndex);
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not get description for adapter %u\n", uIndex);
 	}
 
 	return Status;
@@ -612,7 +838,7 @@ BOOL CRenderer::EnumerateDxgiAdapters(VOID)
 		else if (result != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not enumerate adapters\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not enumerate adapters\n");
 			break;
 		}
 		else
@@ -646,28 +872,96 @@ BOOL CRenderer::EnumerateDxgiAdapters(VOID)
 	return Status;
 }
 
-BOOL CRenderer::CompileShader(LPCWSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, ID3DBlob** pShader)
+#if EMBEDDED_SHADERS
+BOOL CRenderer::CompileShader(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, CONST D3D_SHADER_MACRO* pDefines, D3D12_SHADER_BYTECODE& rShader)
+{
+	BOOL Status = TRUE;
+
+	// Compiled ahead of time by Tools/ShaderCompiler, the bytecode is part of the binary
+	CONST std::string Name = CShaderRegistry::GetName(pFileName, pEntrypoint, pTarget, pDefines);
+
+	if (CShaderRegistry::Find(Name.c_str(), &rShader.pShaderBytecode, &rShader.BytecodeLength) != TRUE)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader %s is not embedded, CSceneShaders does not reach it\n", Name.c_str());
+	}
+
+	return Status;
+}
+#else
+BOOL CRenderer::CompileShader(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, CONST D3D_SHADER_MACRO* pDefines, D3D12_SHADER_BYTECODE& rShader)
 {
 	BOOL Status = TRUE;
+	ID3DBlob* pShader = NULL;
 	ID3DBlob* pError = NULL;
 	UINT Flags = 0;
+	CShaderKey Key;
 
 #if _DEBUG
 	Flags |= D3DCOMPILE_DEBUG;
 	Flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
-	if (D3DCompileFromFile(pFileName, NULL, NULL, pEntrypoint, pTarget, Flags, 0, pShader, &pError) != S_OK)
+	// Everything the compiler sees goes into the key, including its version
+	Status = Key.AddFile(pFileName);
+
+	if (Status == TRUE)
+	{
+		Key.AddString(pEntrypoint);
+		Key.AddString(pTarget);
+		Key.AddValue(Flags);
+		Key.AddValue(D3D_COMPILER_VERSION);
+
+		for (CONST D3D_SHADER_MACRO* pDefine = pDefines; (pDefine != NULL) && (pDefine->Name != NULL); pDefine++)
+		{
+			Key.AddString(pDefine->Name);
+			Key.AddString(pDefine->Definition);
+		}
+
+		rShader.pShaderBytecode = NULL;
+		rShader.BytecodeLength = 0;
+	}
+
+	if ((Status == TRUE) && (m_ShaderCache.Find(Key.GetKey(), &rShader.pShaderBytecode, &rShader.BytecodeLength) != TRUE))
 	{
-		Status = FALSE;
-		Console::Write("Error: Could not compile shader %s\n", pFileName);
+		WCHAR WideFileName[MAX_PATH] = { };
 
-		if (pError != NULL)
+		if (MultiByteToWideChar(CP_UTF8, 0, pFileName, -1, WideFileName, MAX_PATH) == 0)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader path %s is too long\n", pFileName);
+		}
+
+		if ((Status == TRUE) && (D3DCompileFromFile(WideFileName, pDefines, D3D_COMPILE_STANDARD_FILE_INCLUDE, pEntrypoint, pTarget, Flags, 0, &pShader, &pError) != S_OK))
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not compile shader %s\n", pFileName);
+
+			if (pError != NULL)
+			{
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error Info: %s\n", pError->GetBufferPointer());
+			}
+		}
+
+		// The cache keeps a copy until it is saved, the blob can go straight away
+		if ((Status == TRUE) && (m_ShaderCache.Store(Key.GetKey(), pShader->GetBufferPointer(), pShader->GetBufferSize(), &rShader.pShaderBytecode) != TRUE))
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not keep the bytecode of %s\n", pFileName);
+		}
+
+		if (Status == TRUE)
 		{
-			Console::Write("Error Info: %s\n", pError->GetBufferPointer());
+			rShader.BytecodeLength = pShader->GetBufferSize();
 		}
 	}
 
+	if (pShader != NULL)
+	{
+		pShader->Release();
+		pShader = NULL;
+	}
+
 	if (pError != NULL)
 	{
 		pError->Release();
@@ -676,35 +970,73 @@ BOOL CRenderer::CompileShader(LPCWSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTar
 
 	return Status;
 }
+#endif
 
 BOOL CRenderer::CompileShaders(VOID)
 {
+	PROFILE_FUNCTION();
+
 	BOOL Status = TRUE;
-	ID3DBlob* pVertexShader = NULL;
-	ID3DBlob* pPixelShader = NULL;
+	CPermutationRegistry Permutations;
+	D3D12_SHADER_BYTECODE Shaders[CSceneShaders::NumSceneShaders] = { };
 
-	if (Status == TRUE)
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+#if !EMBEDDED_SHADERS
+	// Hits point straight into the mapped cache file until Save below, CreateRequest copies the bytecode before that
+	Status = m_ShaderCache.Open(ShaderCachePath);
+#endif
+
+	// Only the permutation the loaded mesh needs is compiled, release builds embed every reachable one
+	CONST CShaderPermutation Permutation = CShaderPermutation::Make<SHADER_FEATURE_INSTANCED>().With(SHADER_FEATURE_QUANTIZED, (m_VertexFormat == VERTEX_FORMAT_QUANTIZED) ? TRUE : FALSE);
+
+	if ((Status == TRUE) && (CSceneShaders::Declare(Permutations) != TRUE))
 	{
-		if (CompileShader(L"C:/Workspace/DX12_HelloCube/Shaders/VertexShader.hlsl", "main", "vs_5_0", &pVertexShader) != TRUE)
-		{
-			Status = FALSE;
-			Console::Write("Error: Failed to compile vertex shader\n");
-		}
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to declare the scene's shaders\n");
 	}
 
-	if (Status == TRUE)
+	if ((Status == TRUE) && (Permutations.IsReachable(Permutation) != TRUE))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader permutation 0x%x is not reachable in CSceneShaders\n", Permutation.GetBits());
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < CSceneShaders::NumSceneShaders); i++)
 	{
-		if (CompileShader(L"C:/Workspace/DX12_HelloCube/Shaders/PixelShader.hlsl", "main", "ps_5_0", &pPixelShader) != TRUE)
+		CONST CPermutationRegistry::Shader* pShader = Permutations.GetShader(i);
+		CONST std::string Path = std::string(ShaderDirectory) + pShader->pFileName;
+		D3D_SHADER_MACRO Defines[NumShaderFeatures + 1] = { };
+
+		Permutation.GetDefines(pShader->Features, Defines);
+
+		if (CompileShader(Path.c_str(), pShader->pEntrypoint, pShader->pTarget, Defines, Shaders[i]) != TRUE)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to compile pixel shader\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to compile %s\n", pShader->pFileName);
 		}
 	}
 
 	D3D12_INPUT_ELEMENT_DESC InputDescriptors[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "TINT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+	};
+
+	// Matches QuantizedVertex, 16 bytes per vertex
+	D3D12_INPUT_ELEMENT_DESC QuantizedInputDescriptors[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "TINT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
 	};
 
 	if (Status == TRUE)
@@ -713,10 +1045,8 @@ BOOL CRenderer::CompileShaders(VOID)
 
 		desc.pRootSignature = m_pIRootSignature;
 
-		desc.VS.pShaderBytecode = pVertexShader->GetBufferPointer();
-		desc.VS.BytecodeLength = pVertexShader->GetBufferSize();
-		desc.PS.pShaderBytecode = pPixelShader->GetBufferPointer();
-		desc.PS.BytecodeLength = pPixelShader->GetBufferSize();
+		desc.VS = Shaders[CSceneShaders::SCENE_SHADER_VERTEX];
+		desc.PS = Shaders[CSceneShaders::SCENE_SHADER_PIXEL];
 		desc.DS.pShaderBytecode = 0;
 		desc.DS.BytecodeLength = 0;
 		desc.HS.pShaderBytecode = 0;
@@ -760,9 +1090,9 @@ BOOL CRenderer::CompileShaders(VOID)
 		desc.RasterizerState.ForcedSampleCount = 0;
 		desc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
 
-		desc.DepthStencilState.DepthEnable = FALSE;
-		desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
-		desc.DepthStencilState.DepthFunc = static_cast<D3D12_COMPARISON_FUNC>(0);
+		desc.DepthStencilState.DepthEnable = TRUE;
+		desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+		desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
 		desc.DepthStencilState.StencilEnable = FALSE;
 		desc.DepthStencilState.StencilReadMask = 0;
 		desc.DepthStencilState.StencilWriteMask = 0;
@@ -775,15 +1105,23 @@ BOOL CRenderer::CompileShaders(VOID)
 		desc.DepthStencilState.BackFace.StencilPassOp = static_cast<D3D12_STENCIL_OP>(0);
 		desc.DepthStencilState.BackFace.StencilFunc = static_cast<D3D12_COMPARISON_FUNC>(0);
 
-		desc.InputLayout.pInputElementDescs = InputDescriptors;
-		desc.InputLayout.NumElements = _countof(InputDescriptors);
+		if (m_VertexFormat == VERTEX_FORMAT_QUANTIZED)
+		{
+			desc.InputLayout.pInputElementDescs = QuantizedInputDescriptors;
+			desc.InputLayout.NumElements = _countof(QuantizedInputDescriptors);
+		}
+		else
+		{
+			desc.InputLayout.pInputElementDescs = InputDescriptors;
+			desc.InputLayout.NumElements = _countof(InputDescriptors);
+		}
 
 		desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
 		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 		
 		desc.NumRenderTargets = 1;
 		desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-		desc.DSVFormat = DXGI_FORMAT_UNKNOWN;
+		desc.DSVFormat = DepthFormat;
 
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709;
@@ -795,184 +1133,153 @@ BOOL CRenderer::CompileShaders(VOID)
 
 		desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-		if (m_pIDevice->CreateGraphicsPipelineState(&desc, __uuidof(ID3D12PipelineState), reinterpret_cast<VOID**>(&m_pIPipelineState)) != S_OK)
+		// Compiled in the background, the cubes are drawn once it is ready
+		PVOID pRequest = m_PipelineCompiler.CreateRequest(desc, m_RootSignatureKey, m_PipelineKey);
+
+		if ((pRequest == NULL) || (m_PipelineQueue.Request(m_PipelineKey, CPipelineQueue::PRIORITY_HIGH, pRequest) != TRUE))
 		{
-			Status = false;
-			Console::Write("Error: Failed to create graphics pipeline state object\n");
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to queue graphics pipeline state object\n");
 		}
 	}
 
-	if (pVertexShader != NULL)
+#if EMBEDDED_SHADERS
+	if (Status == TRUE)
+	{
+		CONST double Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		UINT64 EmbeddedSize = 0;
+
+		for (UINT i = 0; i < CShaderRegistry::GetCount(); i++)
+		{
+			EmbeddedSize += CShaderRegistry::GetBlob(i)->Size;
+		}
+
+		Console::Write("Shaders: %u embedded in %llu bytes, ready in %.2f ms\n", CShaderRegistry::GetCount(), EmbeddedSize, Milliseconds);
+	}
+#else
+	// A cold start compiles every shader, a warm one only maps the cache file and looks them up
+	if (Status == TRUE)
 	{
-		pVertexShader->Release();
-		pVertexShader = NULL;
+		CONST UINT nHits = m_ShaderCache.GetHitCount();
+		CONST UINT nShaders = nHits + m_ShaderCache.GetMissCount();
+		CONST double Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+		Console::Write("Shaders: %u of %u from the cache (%s start), ready in %.2f ms\n", nHits, nShaders, (nHits == nShaders) ? "warm" : "cold", Milliseconds);
 	}
 
-	if (pPixelShader != NULL)
+	// A cache that cannot be written only costs the next start its compile time
+	if (m_ShaderCache.Save() != TRUE)
 	{
-		pPixelShader->Release();
-		pPixelShader = NULL;
+		CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: Shader cache %s was not updated\n", ShaderCachePath);
 	}
+#endif
 
 	return Status;
 }
 
-BOOL CRenderer::CreateBuffers(VOID)
+BOOL CRenderer::CreateGpuTimer(VOID)
 {
 	BOOL Status = TRUE;
+	UINT64 Frequency = 0;
 
-	/*
-	* 
-	*		   5 _______________ 6
-	*		    /| 			   /|
-	*		   / |			  / |
-	*		  /  |			 /  |
-	*	   1 /___|__________/ 2 |
-	*		 |	 |4 	   |	|
-	*		 |   |_________|____| 7
-	*		 |	 /		   |   /
-	*		 |	/		   |  /
-	*		 | /		   | /
-	*	   0 |/____________|/ 3
-	* 
-	* 0: { -0.5, -0.5, +0.5 }
-	* 1: { -0.5, +0.5, +0.5 }
-	* 2: { +0.5, +0.5, +0.5 }
-	* 3: { +0.5, -0.5, +0.5 }
-	* 4: { -0.5, -0.5, -0.5 }
-	* 5: { -0.5, +0.5, -0.5 }
-	* 6: { +0.5, +0.5, -0.5 }
-	* 7: { +0.5, -0.5, -0.5 }
-	*/
-
-	const float Vertices[][3] =
-	{
-		{ -0.5, -0.5, +0.5 },
-		{ -0.5, +0.5, +0.5 },
-		{ +0.5, +0.5, +0.5 },
-		{ +0.5, -0.5, +0.5 },
-		{ -0.5, -0.5, -0.5 },
-		{ -0.5, +0.5, -0.5 },
-		{ +0.5, +0.5, -0.5 },
-		{ +0.5, -0.5, -0.5 }
-	};
-
-	struct Triangle
+	if (m_pICommandQueue->GetTimestampFrequency(&Frequency) != S_OK)
 	{
-		unsigned short Indices[6];
-		float Normal[3];
-		float Colour[3];
-	};
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not get the timestamp frequency of the command queue\n");
+	}
 
-	const Triangle Triangles[] =
+	if (Status == TRUE)
 	{
-		// front
-		{
-			{
-				0, 1, 2,
-				0, 2, 3
-			},
-			{ 0.0f, 0.0f, +1.0f },
-			{ 1.0f, 0.0f,  0.0f }
-		},
-
-		// back
-		{
-			{
-				4, 5, 6,
-				4, 6, 7
-			},
-			{ 0.0f, 0.0f, -1.0f },
-			{ 0.0f, 1.0f,  0.0f }
-		},
+		Status = m_GpuTimer.Initialize(NumGpuPasses, GpuPassNames, Frequency);
+	}
 
-		// left
-		{
-			{
-				0, 1, 5,
-				0, 5, 4
-			},
-			{ -1.0f, 0.0f, 0.0f },
-			{  0.0f, 0.0f, 1.0f }
-		},
+	// Every frame in flight writes its own range of queries, so a frame can be read back while later ones record
+	UINT nQueries = NumFramesInFlight * m_GpuTimer.GetQueryCount();
 
-		// right
-		{
-			{
-				3, 2, 6,
-				3, 6, 7
-			},
-			{ +1.0f, 0.0f, 0.0f },
-			{  0.5f, 0.0f, 1.0f }
-		},
+	if (Status == TRUE)
+	{
+		D3D12_QUERY_HEAP_DESC queryHeapDesc = { };
+		queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+		queryHeapDesc.Count = nQueries;
+		queryHeapDesc.NodeMask = 0;
 
-		// top
+		if (m_pIDevice->CreateQueryHeap(&queryHeapDesc, __uuidof(ID3D12QueryHeap), reinterpret_cast<VOID**>(&m_pITimestampHeap)) != S_OK)
 		{
-			{
-				1, 2, 5,
-				2, 5, 6
-			},
-			{ 0.0f, +1.0f, 0.0f },
-			{ 1.0f,  1.0f, 0.0f }
-		},
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create timestamp query heap\n");
+		}
+	}
 
-		// bottom
+	if (Status == TRUE)
+	{
+		D3D12_HEAP_PROPERTIES readbackHeapProperties = { };
+		readbackHeapProperties.Type = D3D12_HEAP_TYPE_READBACK;
+		readbackHeapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		readbackHeapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		readbackHeapProperties.CreationNodeMask = 1;
+		readbackHeapProperties.VisibleNodeMask = 1;
+
+		D3D12_RESOURCE_DESC readbackDesc = { };
+		readbackDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		readbackDesc.Alignment = 0;
+		readbackDesc.Width = nQueries * sizeof(UINT64);
+		readbackDesc.Height = 1;
+		readbackDesc.DepthOrArraySize = 1;
+		readbackDesc.MipLevels = 1;
+		readbackDesc.Format = DXGI_FORMAT_UNKNOWN;
+		readbackDesc.SampleDesc.Count = 1;
+		readbackDesc.SampleDesc.Quality = 0;
+		readbackDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		readbackDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		if (m_pIDevice->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, NULL, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(&m_pITimestampBuffer)) != S_OK)
 		{
-			{
-				0, 3, 4,
-				3, 4, 7
-			},
-			{ 0.0f, -1.0f, 0.0f },
-			{ 1.0f,  0.0f, 1.0f }
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create timestamp readback buffer\n");
 		}
-	};
+	}
 
-	std::vector<float> VertexArray;
-	for (unsigned int i = 0; i < _countof(Triangles); i++)
+	// Readback buffers may stay mapped, a slot is only read after the fence of the frame that resolved into it
+	if (Status == TRUE)
 	{
-		const Triangle& t = Triangles[i];
-		for (unsigned int j = 0; j < 6; j++)
+		D3D12_RANGE range = { };
+		range.Begin = 0;
+		range.End = nQueries * sizeof(UINT64);
+
+		if (m_pITimestampBuffer->Map(0, &range, reinterpret_cast<VOID**>(&m_pTimestampData)) != S_OK)
 		{
-			VertexArray.insert(VertexArray.end(), Vertices[t.Indices[j]], Vertices[t.Indices[j]] + 3);
-			VertexArray.insert(VertexArray.end(), t.Colour, t.Colour + 3);
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to map timestamp readback buffer\n");
 		}
 	}
 
-	// DEBUG:
-	VertexArray.clear();
-	VertexArray =
-	{
-		// top
-		0.0f, 0.25f, 0.0f, // position
-		1.0f, 0.00f, 0.0f, // color
+	return Status;
+}
 
-		// right
-		0.25f, 0.0f, 0.0f, // position
-		0.0f, 1.0f, 0.0f,
+VOID CRenderer::WriteTimestamp(ID3D12GraphicsCommandList* pICommandList, UINT Query)
+{
+	pICommandList->EndQuery(m_pITimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, Query);
+}
 
-		// left
-		-0.25f, 0.0f, 0.0f, // position
-		0.0f, 0.0f, 1.0f, // color
-	};
+BOOL CRenderer::CreateUploadRing(VOID)
+{
+	BOOL Status = TRUE;
 
-	const uint32_t UPLOAD_HEAP_SIZE = 64 * 1024 * 1024; // 64 KB
-	const uint32_t PRIMARY_HEAP_SIZE = 64 * 1024 * 1024; // 64 KB
+	D3D12_RESOURCE_DESC uploadResourceDesc = { };
+	uploadResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	uploadResourceDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	uploadResourceDesc.Width = UploadRingSize;
+	uploadResourceDesc.Height = 1;
+	uploadResourceDesc.DepthOrArraySize = 1;
+	uploadResourceDesc.MipLevels = 1;
+	uploadResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+	uploadResourceDesc.SampleDesc.Count = 1;
+	uploadResourceDesc.SampleDesc.Quality = 0;
+	uploadResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	uploadResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
 	if (Status == TRUE)
 	{
-		D3D12_RESOURCE_DESC uploadResourceDesc = { };
-		uploadResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		uploadResourceDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		uploadResourceDesc.Width = UPLOAD_HEAP_SIZE;
-		uploadResourceDesc.Height = 1;
-		uploadResourceDesc.DepthOrArraySize = 1;
-		uploadResourceDesc.MipLevels = 1;
-		uploadResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
-		uploadResourceDesc.SampleDesc.Count = 1;
-		uploadResourceDesc.SampleDesc.Quality = 0;
-		uploadResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		uploadResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
 		D3D12_RESOURCE_ALLOCATION_INFO uploadAllocationInfo = m_pIDevice->GetResourceAllocationInfo(0, 1, &uploadResourceDesc);
 
 		D3D12_HEAP_DESC uploadHeapDesc = { };
@@ -986,113 +1293,278 @@ BOOL CRenderer::CreateBuffers(VOID)
 		if (m_pIDevice->CreateHeap(&uploadHeapDesc, __uuidof(ID3D12Heap), reinterpret_cast<VOID**>(&m_pIUploadHeap)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create upload heap\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create upload heap\n");
 		}
 	}
 
+	// One buffer spans the whole heap and stays mapped for the lifetime of the renderer
 	if (Status == TRUE)
 	{
-		D3D12_RESOURCE_DESC primaryResourceDesc = { };
-		primaryResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		primaryResourceDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		primaryResourceDesc.Width = PRIMARY_HEAP_SIZE;
-		primaryResourceDesc.Height = 1;
-		primaryResourceDesc.DepthOrArraySize = 1;
-		primaryResourceDesc.MipLevels = 1;
-		primaryResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
-		primaryResourceDesc.SampleDesc.Count = 1;
-		primaryResourceDesc.SampleDesc.Quality = 0;
-		primaryResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		primaryResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-		D3D12_RESOURCE_ALLOCATION_INFO primaryAllocationInfo = m_pIDevice->GetResourceAllocationInfo(0, 1, &primaryResourceDesc);
+		if (m_pIDevice->CreatePlacedResource(m_pIUploadHeap, 0, &uploadResourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(&m_pIUploadBuffer)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create upload ring buffer\n");
+		}
+	}
 
-		D3D12_HEAP_DESC primaryHeapDesc = { };
-		primaryHeapDesc.SizeInBytes = primaryAllocationInfo.SizeInBytes;
-		primaryHeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
-		primaryHeapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		primaryHeapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		primaryHeapDesc.Properties.CreationNodeMask = 1;
-		primaryHeapDesc.Properties.VisibleNodeMask = 1;
+	if (Status == TRUE)
+	{
+		D3D12_RANGE range = {};
+		range.Begin = 0;
+		range.End = 0;
 
-		if (m_pIDevice->CreateHeap(&primaryHeapDesc, __uuidof(ID3D12Heap), reinterpret_cast<VOID**>(&m_pIPrimaryHeap)) != S_OK)
+		if (m_pIUploadBuffer->Map(0, &range, reinterpret_cast<VOID**>(&m_pUploadData)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create primary heap\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to map upload ring buffer\n");
 		}
 	}
 
-	ID3D12Resource* vertexDataUploadBuffer = NULL;
+	if (Status == TRUE)
+	{
+		Status = m_UploadRing.Initialize(UploadRingSize);
+	}
+
+	return Status;
+}
+
+BOOL CRenderer::CreateFrameBuffer(CConstantAllocator& rAllocator, SIZE_T FrameCapacity, LPCSTR pName, ID3D12Resource** ppIBuffer, BYTE** ppData)
+{
+	BOOL Status = rAllocator.Initialize(NumFramesInFlight, FrameCapacity);
+
+	if (Status == TRUE)
+	{
+		D3D12_HEAP_PROPERTIES uploadHeapProperties = { };
+		uploadHeapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
+		uploadHeapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		uploadHeapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		uploadHeapProperties.CreationNodeMask = 1;
+		uploadHeapProperties.VisibleNodeMask = 1;
+
+		D3D12_RESOURCE_DESC bufferDesc = { };
+		bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		bufferDesc.Alignment = 0;
+		bufferDesc.Width = rAllocator.GetCapacity();
+		bufferDesc.Height = 1;
+		bufferDesc.DepthOrArraySize = 1;
+		bufferDesc.MipLevels = 1;
+		bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+		bufferDesc.SampleDesc.Count = 1;
+		bufferDesc.SampleDesc.Quality = 0;
+		bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		bufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		if (m_pIDevice->CreateCommittedResource(&uploadHeapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(ppIBuffer)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create %s buffer\n", pName);
+		}
+	}
 
+	// Stays mapped, a frame's region is only rewritten once the fence of the frame that last used it has completed
 	if (Status == TRUE)
 	{
-		D3D12_RESOURCE_DESC vertexBufferDesc = {};
-		vertexBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		vertexBufferDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		vertexBufferDesc.Width = sizeof(float) * VertexArray.size();
-		vertexBufferDesc.Height = 1;
-		vertexBufferDesc.DepthOrArraySize = 1;
-		vertexBufferDesc.MipLevels = 1;
-		vertexBufferDesc.Format = DXGI_FORMAT_UNKNOWN;
-		vertexBufferDesc.SampleDesc.Count = 1;
-		vertexBufferDesc.SampleDesc.Quality = 0;
-		vertexBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		vertexBufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+		D3D12_RANGE range = { };
+		range.Begin = 0;
+		range.End = 0;
 
-		if (m_pIDevice->CreatePlacedResource(m_pIUploadHeap, 0, &vertexBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(&vertexDataUploadBuffer)) != S_OK)
+		if ((*ppIBuffer)->Map(0, &range, reinterpret_cast<VOID**>(ppData)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create vertex buffer upload allocation\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to map %s buffer\n", pName);
 		}
+	}
+
+	return Status;
+}
+
+BOOL CRenderer::CreateConstantBuffer(VOID)
+{
+	return CreateFrameBuffer(m_ConstantAllocator, ConstantFrameSize, "constant", &m_pIConstantBuffer, &m_pConstantData);
+}
+
+BOOL CRenderer::CreateInstanceBuffer(VOID)
+{
+	// Room for every instance, the allocator rounds the capacity down to its alignment
+	CONST SIZE_T nBytes = static_cast<SIZE_T>(m_Instances.GetCount()) * sizeof(InstanceData);
+	CONST SIZE_T FrameCapacity = (nBytes + CConstantAllocator::Alignment - 1) & ~static_cast<SIZE_T>(CConstantAllocator::Alignment - 1);
+
+	return CreateFrameBuffer(m_InstanceAllocator, FrameCapacity, "instance", &m_pIInstanceBuffer, &m_pInstanceData);
+}
+
+BOOL CRenderer::Upload(ID3D12Resource* pIDestination, UINT64 DestinationOffset, CONST VOID* pData, SIZE_T nBytes)
+{
+	BOOL Status = TRUE;
+	SIZE_T Offset = 0;
+
+	if (m_UploadRing.Allocate(nBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, Offset) != TRUE)
+	{
+		// Take back whatever the GPU has already consumed, but never wait for it
+		m_UploadRing.Reclaim(m_pIFence->GetCompletedValue());
 
-		if (m_pIDevice->CreatePlacedResource(m_pIPrimaryHeap, 0, &vertexBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, NULL, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(&m_pIVertexBuffer)) != S_OK)
+		if (m_UploadRing.Allocate(nBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, Offset) != TRUE)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to create vertex buffer primary allocation\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Upload ring cannot fit %llu bytes, %llu of %llu in use\n", static_cast<UINT64>(nBytes), static_cast<UINT64>(m_UploadRing.GetUsed()), static_cast<UINT64>(m_UploadRing.GetCapacity()));
 		}
 	}
 
-	// Copy the vertex data to the upload heap
 	if (Status == TRUE)
 	{
-		BYTE* pVertexData = NULL;
+		CopyMemory(m_pUploadData + Offset, pData, nBytes);
+		m_pICommandList->CopyBufferRegion(pIDestination, DestinationOffset, m_pIUploadBuffer, Offset, nBytes);
+	}
 
-		D3D12_RANGE range = {};
-		range.Begin = 0;
-		range.End = 0;
+	return Status;
+}
 
-		if (vertexDataUploadBuffer->Map(0, &range, reinterpret_cast<VOID**>(&pVertexData)) != S_OK)
+BOOL CRenderer::CreatePlacedBuffer(UINT64 nBytes, LPCSTR pName, CHeapAllocator::Allocation& rAllocation, ID3D12Resource** ppIResource)
+{
+	BOOL Status = TRUE;
+
+	D3D12_RESOURCE_DESC bufferDesc = {};
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	bufferDesc.Width = nBytes;
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.SampleDesc.Quality = 0;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	bufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	// The device reports the footprint the placed resource needs, the allocator picks where it goes
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = m_pIDevice->GetResourceAllocationInfo(0, 1, &bufferDesc);
+
+	if (m_PrimaryHeapAllocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment, rAllocation) != TRUE)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Primary heap cannot fit %llu bytes for the %s\n", allocationInfo.SizeInBytes, pName);
+	}
+
+	if (Status == TRUE)
+	{
+		if (m_pIDevice->CreatePlacedResource(m_pIPrimaryHeap, rAllocation.Offset, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, NULL, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(ppIResource)) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to map vertex buffer allocation\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create %s primary allocation\n", pName);
 		}
+	}
 
-		if (Status == TRUE)
+	return Status;
+}
+
+BOOL CRenderer::CreateBuffers(VOID)
+{
+	PROFILE_FUNCTION();
+
+	BOOL Status = TRUE;
+
+	// The mapped file stays open until the data has been copied into the upload heap
+	CMeshFile MeshFile;
+	CMeshBuilder MeshBuilder;
+	MeshData Mesh = { };
+
+	Status = CGeometry::LoadCube(MeshFile, MeshBuilder, Mesh);
+
+	const UINT64 VertexDataSize = static_cast<UINT64>(Mesh.VertexStride) * Mesh.VertexCount;
+	const UINT64 IndexDataSize = static_cast<UINT64>(Mesh.IndexSize) * Mesh.IndexCount;
+
+	const uint32_t PRIMARY_HEAP_SIZE = 64 * 1024 * 1024; // 64 KB
+
+	if (Status == TRUE)
+	{
+		D3D12_RESOURCE_DESC primaryResourceDesc = { };
+		primaryResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		primaryResourceDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		primaryResourceDesc.Width = PRIMARY_HEAP_SIZE;
+		primaryResourceDesc.Height = 1;
+		primaryResourceDesc.DepthOrArraySize = 1;
+		primaryResourceDesc.MipLevels = 1;
+		primaryResourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+		primaryResourceDesc.SampleDesc.Count = 1;
+		primaryResourceDesc.SampleDesc.Quality = 0;
+		primaryResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		primaryResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		D3D12_RESOURCE_ALLOCATION_INFO primaryAllocationInfo = m_pIDevice->GetResourceAllocationInfo(0, 1, &primaryResourceDesc);
+
+		D3D12_HEAP_DESC primaryHeapDesc = { };
+		primaryHeapDesc.SizeInBytes = primaryAllocationInfo.SizeInBytes;
+		primaryHeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		primaryHeapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		primaryHeapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		primaryHeapDesc.Properties.CreationNodeMask = 1;
+		primaryHeapDesc.Properties.VisibleNodeMask = 1;
+
+		if (m_pIDevice->CreateHeap(&primaryHeapDesc, __uuidof(ID3D12Heap), reinterpret_cast<VOID**>(&m_pIPrimaryHeap)) != S_OK)
 		{
-			CopyMemory(pVertexData, VertexArray.data(), sizeof(float) * VertexArray.size());
-			vertexDataUploadBuffer->Unmap(0, NULL);
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create primary heap\n");
 		}
 	}
 
-	// Copy the vertex data from the upload heap to the primary heap
 	if (Status == TRUE)
 	{
-		m_pICommandList->CopyBufferRegion(m_pIVertexBuffer, 0, vertexDataUploadBuffer, 0, sizeof(float) * VertexArray.size());
+		Status = m_PrimaryHeapAllocator.Initialize(m_pIPrimaryHeap->GetDesc().SizeInBytes);
 
-		D3D12_RESOURCE_BARRIER barrier = {};
-		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		barrier.Transition.pResource = m_pIVertexBuffer;
-		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-		barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-		barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+		if (Status != TRUE)
+		{
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to initialize primary heap allocator\n");
+		}
+	}
 
-		m_pICommandList->ResourceBarrier(1, &barrier);
+	if (Status == TRUE)
+	{
+		Status = CreatePlacedBuffer(VertexDataSize, "vertex buffer", m_VertexAllocation, &m_pIVertexBuffer);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = CreatePlacedBuffer(IndexDataSize, "index buffer", m_IndexAllocation, &m_pIIndexBuffer);
+	}
+
+	if (Status == TRUE)
+	{
+		CHeapAllocator::Statistics HeapStats = { };
+		m_PrimaryHeapAllocator.GetStatistics(HeapStats);
+
+		Console::Write("Primary heap: %llu of %llu bytes in %u allocations, fragmentation %.3f\n", HeapStats.AllocatedBytes, HeapStats.Capacity, HeapStats.Allocations, HeapStats.Fragmentation);
+	}
+
+	// Stage the vertex and index data in the upload ring and copy it to the primary heap
+	if (Status == TRUE)
+	{
+		Status = Upload(m_pIVertexBuffer, 0, Mesh.pVertices, static_cast<SIZE_T>(VertexDataSize));
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Upload(m_pIIndexBuffer, 0, Mesh.pIndices, static_cast<SIZE_T>(IndexDataSize));
+	}
+
+	if (Status == TRUE)
+	{
+		D3D12_RESOURCE_BARRIER barriers[2] = {};
+		barriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		barriers[0].Transition.pResource = m_pIVertexBuffer;
+		barriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+		barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+
+		barriers[1] = barriers[0];
+		barriers[1].Transition.pResource = m_pIIndexBuffer;
+		barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_INDEX_BUFFER;
+
+		m_pICommandList->ResourceBarrier(_countof(barriers), barriers);
 
 		if (m_pICommandList->Close() != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not finalize command list\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not finalize command list\n");
 		}
 
 		if (Status == TRUE)
@@ -1101,53 +1573,337 @@ BOOL CRenderer::CreateBuffers(VOID)
 			m_pICommandQueue->ExecuteCommandLists(_countof(pICommandLists), pICommandLists);
 
 			m_VertexBufferView.BufferLocation = m_pIVertexBuffer->GetGPUVirtualAddress();
-			m_VertexBufferView.SizeInBytes = sizeof(float) * VertexArray.size();
-			m_VertexBufferView.StrideInBytes = sizeof(float) * 6;
+			m_VertexBufferView.SizeInBytes = static_cast<UINT>(VertexDataSize);
+			m_VertexBufferView.StrideInBytes = Mesh.VertexStride;
+
+			m_IndexBufferView.BufferLocation = m_pIIndexBuffer->GetGPUVirtualAddress();
+			m_IndexBufferView.SizeInBytes = static_cast<UINT>(IndexDataSize);
+			m_IndexBufferView.Format = (Mesh.IndexSize == sizeof(uint16_t)) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+			m_VertexFormat = Mesh.Format;
+
+			for (UINT i = 0; i < 3; i++)
+			{
+				m_BoundsMin[i] = Mesh.BoundsMin[i];
+				m_BoundsExtent[i] = Mesh.BoundsMax[i] - Mesh.BoundsMin[i];
+			}
+
+			// The instances' bounding spheres come from the mesh bounds
+			CreateScene(Mesh.IndexCount);
 		}
 	}
 
+	// The draw that consumes the buffers is queued behind the copy, so there is nothing to wait for here
 	if (Status == TRUE)
 	{
-		Status = WaitForFrame();
+		Status = EndFrame();
 	}
 
-	if (vertexDataUploadBuffer != NULL)
+	return Status;
+}
+
+BOOL CRenderer::CreateDepthBuffer(ULONG Width, ULONG Height)
+{
+	BOOL Status = TRUE;
+
+	if (Status == TRUE)
 	{
-		vertexDataUploadBuffer->Release();
+		D3D12_DESCRIPTOR_HEAP_DESC descHeap = { };
+		descHeap.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+		descHeap.NumDescriptors = 1;
+		descHeap.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+		descHeap.NodeMask = 0;
+
+		if (m_pIDevice->CreateDescriptorHeap(&descHeap, __uuidof(ID3D12DescriptorHeap), reinterpret_cast<VOID**>(&m_pIDsvHeap)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create depth stencil descriptor heap\n");
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		D3D12_HEAP_PROPERTIES heapProperties = { };
+		heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		heapProperties.CreationNodeMask = 1;
+		heapProperties.VisibleNodeMask = 1;
+
+		D3D12_RESOURCE_DESC depthDesc = { };
+		depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		depthDesc.Alignment = 0;
+		depthDesc.Width = Width;
+		depthDesc.Height = Height;
+		depthDesc.DepthOrArraySize = 1;
+		depthDesc.MipLevels = 1;
+		depthDesc.Format = DepthFormat;
+		depthDesc.SampleDesc.Count = 1;
+		depthDesc.SampleDesc.Quality = 0;
+		depthDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+
+		D3D12_CLEAR_VALUE clearValue = { };
+		clearValue.Format = DepthFormat;
+		clearValue.DepthStencil.Depth = 1.0f;
+		clearValue.DepthStencil.Stencil = 0;
+
+		// Never leaves the depth write state, so it needs no barriers
+		if (m_pIDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &depthDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clearValue, __uuidof(ID3D12Resource), reinterpret_cast<VOID**>(&m_pIDepthBuffer)) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create depth buffer\n");
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = { };
+		dsvDesc.Format = DepthFormat;
+		dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+		dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+		dsvDesc.Texture2D.MipSlice = 0;
+
+		m_pIDevice->CreateDepthStencilView(m_pIDepthBuffer, &dsvDesc, m_pIDsvHeap->GetCPUDescriptorHandleForHeapStart());
 	}
 
 	return Status;
 }
 
-BOOL CRenderer::Render(VOID)
+VOID CRenderer::CreateScene(UINT IndexCount)
 {
+	CONST CTransformHierarchy::LocalTransform Cube = { Vec3{ 1.0f, 1.0f, 1.0f }, Quat{ 0.0f, 0.0f, 0.0f, 1.0f }, Vec3{ 0.0f, 0.0f, 0.0f } };
+
+	// Smaller cubes around the big one, they turn with it because they are its children
+	CONST Vec3 Offsets[NumOrbitingCubes] =
+	{
+		Vec3{ +1.1f, 0.0f, 0.0f },
+		Vec3{ -1.1f, 0.0f, 0.0f },
+		Vec3{ 0.0f, 0.0f, +1.1f },
+		Vec3{ 0.0f, 0.0f, -1.1f }
+	};
+
+	// The colour each small cube is pulled towards in xyz, and how far in w
+	CONST Vec4 Tints[NumOrbitingCubes] =
+	{
+		Vec4{ 1.0f, 0.2f, 0.2f, 0.6f },
+		Vec4{ 0.2f, 1.0f, 0.2f, 0.6f },
+		Vec4{ 0.2f, 0.2f, 1.0f, 0.6f },
+		Vec4{ 1.0f, 1.0f, 0.2f, 0.6f }
+	};
+
+	// A sphere around the mesh's origin that holds its bounding box
+	CONST Vec3 Center = { m_BoundsMin[0] + 0.5f * m_BoundsExtent[0], m_BoundsMin[1] + 0.5f * m_BoundsExtent[1], m_BoundsMin[2] + 0.5f * m_BoundsExtent[2] };
+	CONST FLOAT Radius = Math::Length(Center) + 0.5f * Math::Length(Vec3{ m_BoundsExtent[0], m_BoundsExtent[1], m_BoundsExtent[2] });
+
+	CONST UINT nInstances = 1 + NumOrbitingCubes + FieldColumns * FieldRows;
+
+	m_Transforms.Clear();
+	m_Transforms.Reserve(nInstances + 1);
+	m_Instances.Clear();
+	m_Instances.Reserve(nInstances);
+
+	m_CubeNode = m_Transforms.AddNode(CTransformHierarchy::InvalidNode, Cube);
+	m_Instances.Add(m_CubeNode, Radius, Vec4{ 0.0f, 0.0f, 0.0f, 0.0f });
+
+	for (UINT i = 0; i < NumOrbitingCubes; i++)
+	{
+		CONST CTransformHierarchy::LocalTransform Child = { Vec3{ 0.3f, 0.3f, 0.3f }, Quat{ 0.0f, 0.0f, 0.0f, 1.0f }, Offsets[i] };
+		m_Instances.Add(m_Transforms.AddNode(m_CubeNode, Child), Radius, Tints[i]);
+	}
+
+	// A floor of small cubes below the big one that slowly turns as a whole, most of it is outside the view at any time
+	CONST CTransformHierarchy::LocalTransform Field = { Vec3{ 1.0f, 1.0f, 1.0f }, Quat{ 0.0f, 0.0f, 0.0f, 1.0f }, Vec3{ 0.0f, -1.5f, 0.0f } };
+	CONST FLOAT Spacing = 0.3f;
+
+	m_FieldNode = m_Transforms.AddNode(CTransformHierarchy::InvalidNode, Field);
+
+	for (UINT Row = 0; Row < FieldRows; Row++)
+	{
+		for (UINT Column = 0; Column < FieldColumns; Column++)
+		{
+			CONST FLOAT u = static_cast<FLOAT>(Column) / (FieldColumns - 1);
+			CONST FLOAT v = static_cast<FLOAT>(Row) / (FieldRows - 1);
+			CONST Vec3 Position = { (u - 0.5f) * Spacing * (FieldColumns - 1), 0.0f, (v - 0.5f) * Spacing * (FieldRows - 1) };
+
+			CONST CTransformHierarchy::LocalTransform Child = { Vec3{ 0.1f, 0.1f, 0.1f }, Quat{ 0.0f, 0.0f, 0.0f, 1.0f }, Position };
+			m_Instances.Add(m_Transforms.AddNode(m_FieldNode, Child), Radius, Vec4{ u, 0.5f, v, 0.8f });
+		}
+	}
+
+	// Every instance draws the same mesh in a single call, UpdateScene fills in the instance count and the constants
+	DrawCommand Draw = { IndexCount, 0, 0, 0, 0, NULL, 0, 0, NULL };
+	m_Draws.assign(1, Draw);
+	m_FrameDraws.reserve(m_Draws.size());
+
+	// Added in the order of the DrawConstant enum, which follows the cbuffer declaration
+	m_DrawConstantLayout.Clear();
+	m_DrawConstantLayout.Add(CConstantLayout::CONSTANT_FLOAT3);
+	m_DrawConstantLayout.Add(CConstantLayout::CONSTANT_FLOAT3);
+}
+
+BOOL CRenderer::UpdateScene(VOID)
+{
+	PROFILE_FUNCTION();
+
 	BOOL Status = TRUE;
+	CONST UINT64 FrameNumber = m_FrameScheduler.GetFrameNumber();
+
+	CTransformHierarchy::LocalTransform Cube = { };
+	m_Transforms.GetLocal(m_CubeNode, Cube);
+	Cube.Rotation = CGeometry::GetCubeRotation(FrameNumber);
+	m_Transforms.SetLocal(m_CubeNode, Cube);
+
+	CTransformHierarchy::LocalTransform Field = { };
+	m_Transforms.GetLocal(m_FieldNode, Field);
+	Field.Rotation = Math::AxisAngle(Vec3{ 0.0f, 1.0f, 0.0f }, static_cast<FLOAT>(FrameNumber % FieldRevolutionFrames) * (2.0f * Math::Pi / FieldRevolutionFrames));
+	m_Transforms.SetLocal(m_FieldNode, Field);
 
-	if (m_pICommandAllocator->Reset() != S_OK)
+	m_Transforms.Update();
+
+	// The recorded lists copy the root constants, so the matrix only has to live until recording is done
+	Mat4* pViewProjection = reinterpret_cast<Mat4*>(Memory::AllocateFrame(sizeof(Mat4), alignof(Mat4)));
+	SIZE_T InstanceOffset = 0;
+	SIZE_T ConstantOffset = 0;
+
+	if (pViewProjection == NULL)
 	{
 		Status = FALSE;
-		Console::Write("Error: Failed to reset command allocator\n");
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not allocate the view projection matrix\n");
 	}
 
 	if (Status == TRUE)
 	{
-		if (m_pICommandList->Reset(m_pICommandAllocator, m_pIPipelineState) != S_OK)
+		if (m_InstanceAllocator.Allocate(m_Instances.GetCount() * sizeof(InstanceData), InstanceOffset) != TRUE)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to reset command list\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Instance buffer cannot fit %u instances\n", m_Instances.GetCount());
 		}
 	}
 
 	if (Status == TRUE)
 	{
-		m_pICommandList->SetGraphicsRootSignature(m_pIRootSignature);
-		m_pICommandList->RSSetViewports(1, &m_Viewport);
-		m_pICommandList->RSSetScissorRects(1, &m_ScissorRect);
+		if (m_ConstantAllocator.Allocate(m_DrawConstantLayout.GetSize(), ConstantOffset) != TRUE)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Constant buffer cannot fit the draw constants, %llu of %llu bytes in use\n", static_cast<UINT64>(m_ConstantAllocator.GetUsed()), static_cast<UINT64>(m_ConstantAllocator.GetFrameCapacity()));
+		}
 	}
 
 	if (Status == TRUE)
 	{
-		D3D12_RESOURCE_BARRIER barrier = {};
+		CGeometry::GetViewProjection(m_Viewport.Width / m_Viewport.Height, *pViewProjection);
+
+		CONST UINT nVisible = m_Instances.Build(m_Transforms, *pViewProjection, reinterpret_cast<InstanceData*>(m_pInstanceData + InstanceOffset));
+
+		m_InstanceBufferView.BufferLocation = m_pIInstanceBuffer->GetGPUVirtualAddress() + InstanceOffset;
+		m_InstanceBufferView.SizeInBytes = static_cast<UINT>(nVisible * sizeof(InstanceData));
+		m_InstanceBufferView.StrideInBytes = sizeof(InstanceData);
+
+		BYTE* pDrawConstants = m_pConstantData + ConstantOffset;
+		m_DrawConstantLayout.Write(pDrawConstants, DRAW_CONSTANT_BOUNDS_MIN, m_BoundsMin);
+		m_DrawConstantLayout.Write(pDrawConstants, DRAW_CONSTANT_BOUNDS_EXTENT, m_BoundsExtent);
+
+		m_Draws[0].InstanceCount = nVisible;
+		m_Draws[0].pConstants = &pViewProjection->m[0][0];
+		m_Draws[0].nConstants = static_cast<UINT>(sizeof(Mat4) / sizeof(FLOAT));
+		m_Draws[0].ConstantBufferAddress = m_pIConstantBuffer->GetGPUVirtualAddress() + ConstantOffset;
+		m_Draws[0].pPipeline = m_PipelineQueue.Acquire(m_PipelineKey);
+	}
+
+	// Draws whose pipeline is still compiling are skipped this frame
+	m_FrameDraws.clear();
+
+	for (UINT i = 0; (Status == TRUE) && (i < m_Draws.size()); i++)
+	{
+		if (m_Draws[i].pPipeline != NULL)
+		{
+			m_FrameDraws.push_back(m_Draws[i]);
+		}
+	}
+
+	return Status;
+}
+
+VOID CRenderer::ReportPipelines(VOID)
+{
+	CPipelineQueue::Report Report = { };
+	m_PipelineQueue.GetReport(Report);
+
+	// Taken every frame, logged when a pipeline has changed state
+	if ((Report.nPending != m_PipelineReport.nPending) || (Report.nCompiling != m_PipelineReport.nCompiling) ||
+		(Report.nReady != m_PipelineReport.nReady) || (Report.nFailed != m_PipelineReport.nFailed))
+	{
+		Console::Write("Pipelines: %u pending, %u compiling, %u ready, %u failed, this frame %u draws ready, %u fell back, %u skipped\n",
+			Report.nPending, Report.nCompiling, Report.nReady, Report.nFailed, Report.nDrawsReady, Report.nDrawsFallback, Report.nDrawsSkipped);
+
+		// Nothing is compiling, so the library's counts are settled
+		if ((Report.nPending == 0) && (Report.nCompiling == 0))
+		{
+			Console::Write("Pipelines: %u loaded from the pipeline cache, %u created\n", m_PipelineLibrary.GetLoadedCount(), m_PipelineLibrary.GetCreatedCount());
+		}
+	}
+
+	m_PipelineReport = Report;
+}
+
+IRenderer::RendererType CRenderer::GetType(VOID)
+{
+	return RendererType::D3D12;
+}
+
+UINT CRenderer::GetPassCount(VOID)
+{
+	return m_GpuTimer.GetPassCount();
+}
+
+BOOL CRenderer::GetPassTiming(UINT Pass, PassTiming& rTiming)
+{
+	return m_GpuTimer.GetPassTiming(Pass, rTiming);
+}
+
+BOOL CRenderer::Render(VOID)
+{
+	PROFILE_FUNCTION();
+
+	BOOL Status = BeginFrame();
+	UINT Slot = m_FrameScheduler.GetSlot();
+
+	Memory::BeginFrame(Slot);
+	m_ConstantAllocator.BeginFrame(Slot);
+	m_InstanceAllocator.BeginFrame(Slot);
+	m_PipelineQueue.BeginFrame();
+
+	D3D12_RESOURCE_BARRIER* pBarriers = reinterpret_cast<D3D12_RESOURCE_BARRIER*>(Memory::AllocateFrame(sizeof(D3D12_RESOURCE_BARRIER) * 2, alignof(D3D12_RESOURCE_BARRIER)));
+
+	if ((Status == TRUE) && (pBarriers == NULL))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to allocate frame barriers\n");
+	}
+
+	if ((Status == TRUE) && (m_pICommandAllocators[Slot]->Reset() != S_OK))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to reset command allocator\n");
+	}
+
+	if (Status == TRUE)
+	{
+		if (m_pICommandList->Reset(m_pICommandAllocators[Slot], NULL) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to reset command list\n");
+		}
+		else
+		{
+			WriteTimestamp(m_pICommandList, m_GpuTimer.GetBeginQuery(Slot, GPU_PASS_FRAME));
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		D3D12_RESOURCE_BARRIER& barrier = pBarriers[0];
 		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
 		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		barrier.Transition.pResource = m_pIRenderBuffers[m_FrameIndex];
@@ -1158,26 +1914,79 @@ BOOL CRenderer::Render(VOID)
 		m_pICommandList->ResourceBarrier(1, &barrier);
 	}
 
-	if (Status == TRUE)
-	{
-		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_pIDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-		rtvHandle.ptr += m_FrameIndex * m_RtvDescriptorIncrement;
+	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_pIDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+	rtvHandle.ptr += m_FrameIndex * m_RtvDescriptorIncrement;
 
-		m_pICommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_pIDsvHeap->GetCPUDescriptorHandleForHeapStart();
 
+	if (Status == TRUE)
+	{
 		// Clear the screen
+		WriteTimestamp(m_pICommandList, m_GpuTimer.GetBeginQuery(Slot, GPU_PASS_CLEAR));
 		m_pICommandList->ClearRenderTargetView(rtvHandle, ClearColor, 0, NULL);
+		m_pICommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, NULL);
+		WriteTimestamp(m_pICommandList, m_GpuTimer.GetEndQuery(Slot, GPU_PASS_CLEAR));
+
+		// The recorded lists run between the end of this list and the start of the present list
+		WriteTimestamp(m_pICommandList, m_GpuTimer.GetBeginQuery(Slot, GPU_PASS_DRAW));
+
+		if (m_pICommandList->Close() != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not finalize command list\n");
+		}
+	}
 
-		// Draw the cube
-		m_pICommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		m_pICommandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
-		//m_pICommandList->DrawInstanced(36, 1, 0, 0);
-		m_pICommandList->DrawInstanced(3, 1, 0, 0);
+	// World matrices and per draw constants for this frame
+	if (Status == TRUE)
+	{
+		Status = UpdateScene();
+	}
+
+	if (Status == TRUE)
+	{
+		ReportPipelines();
+	}
+
+	// Draw the scene, each recording thread fills its own command list
+	UINT nSinksUsed = 0;
+
+	if (Status == TRUE)
+	{
+		CCommandListSink::PassState State = { };
+		State.pIRootSignature = m_pIRootSignature;
+		State.Viewport = m_Viewport;
+		State.ScissorRect = m_ScissorRect;
+		State.RenderTarget = rtvHandle;
+		State.DepthStencil = dsvHandle;
+		State.VertexBufferView = m_VertexBufferView;
+		State.InstanceBufferView = m_InstanceBufferView;
+		State.IndexBufferView = m_IndexBufferView;
+
+		ICommandSink* pSinks[NumRecordingThreads] = { };
+
+		for (UINT i = 0; i < NumRecordingThreads; i++)
+		{
+			m_CommandListSinks[i].SetFrame(Slot, &State);
+			pSinks[i] = &m_CommandListSinks[i];
+		}
+
+		Status = m_CommandRecorder.Record(m_FrameDraws.data(), static_cast<UINT>(m_FrameDraws.size()), pSinks, NumRecordingThreads, nSinksUsed);
+	}
+
+	if (Status == TRUE)
+	{
+		// Recording into the main list has finished, so the slot allocator can back the present list as well
+		if (m_pIPresentCommandList->Reset(m_pICommandAllocators[Slot], NULL) != S_OK)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to reset present command list\n");
+		}
 	}
 
 	if (Status == TRUE)
 	{
-		D3D12_RESOURCE_BARRIER barrier = {};
+		D3D12_RESOURCE_BARRIER& barrier = pBarriers[1];
 		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
 		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		barrier.Transition.pResource = m_pIRenderBuffers[m_FrameIndex];
@@ -1185,22 +1994,48 @@ BOOL CRenderer::Render(VOID)
 		barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
 		barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
 
-		m_pICommandList->ResourceBarrier(1, &barrier);
-	}
+		WriteTimestamp(m_pIPresentCommandList, m_GpuTimer.GetEndQuery(Slot, GPU_PASS_DRAW));
+		WriteTimestamp(m_pIPresentCommandList, m_GpuTimer.GetBeginQuery(Slot, GPU_PASS_BARRIER));
+		m_pIPresentCommandList->ResourceBarrier(1, &barrier);
+		WriteTimestamp(m_pIPresentCommandList, m_GpuTimer.GetEndQuery(Slot, GPU_PASS_BARRIER));
+		WriteTimestamp(m_pIPresentCommandList, m_GpuTimer.GetEndQuery(Slot, GPU_PASS_FRAME));
 
-	if (Status == TRUE)
-	{
-		if (m_pICommandList->Close() != S_OK)
+		// Read back N frames later, when BeginFrame has made sure this slot's fence completed
+		UINT FirstQuery = m_GpuTimer.GetBeginQuery(Slot, 0);
+		m_pIPresentCommandList->ResolveQueryData(m_pITimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, FirstQuery, m_GpuTimer.GetQueryCount(), m_pITimestampBuffer, FirstQuery * sizeof(UINT64));
+
+		if (m_pIPresentCommandList->Close() != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not finalize command list\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not finalize present command list\n");
 		}
 	}
 
+	// One ordered batch: clear, the recorded draws in sink order, then the transition to present
 	if (Status == TRUE)
 	{
-		ID3D12CommandList* pICommandLists[] = { m_pICommandList };
-		m_pICommandQueue->ExecuteCommandLists(_countof(pICommandLists), pICommandLists);
+		UINT nCommandLists = nSinksUsed + 2;
+		ID3D12CommandList** ppICommandLists = reinterpret_cast<ID3D12CommandList**>(Memory::AllocateFrame(sizeof(ID3D12CommandList*) * nCommandLists, alignof(ID3D12CommandList*)));
+
+		if (ppICommandLists != NULL)
+		{
+			ppICommandLists[0] = m_pICommandList;
+
+			for (UINT i = 0; i < nSinksUsed; i++)
+			{
+				ppICommandLists[1 + i] = m_CommandListSinks[i].GetCommandList();
+			}
+
+			ppICommandLists[nCommandLists - 1] = m_pIPresentCommandList;
+
+			m_pICommandQueue->ExecuteCommandLists(nCommandLists, ppICommandLists);
+			m_GpuTimer.Submit(Slot);
+		}
+		else
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to allocate frame command lists\n");
+		}
 	}
 
 	if (Status == TRUE)
@@ -1208,51 +2043,106 @@ BOOL CRenderer::Render(VOID)
 		if (m_pISwapChain->Present(1, 0) != S_OK)
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to present\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to present\n");
 		}
 	}
 
 	if (Status == TRUE)
 	{
-		Status = WaitForFrame();
+		Status = EndFrame();
 	}
 
+	Memory::EndFrame();
+
 	return Status;
 }
 
-BOOL CRenderer::WaitForFrame(VOID)
+BOOL CRenderer::SignalFence(UINT64& rFenceValue)
 {
 	BOOL Status = TRUE;
 
-	if (Status == TRUE)
+	if (m_pICommandQueue->Signal(m_pIFence, m_FenceValue) == S_OK)
 	{
-		if (m_pICommandQueue->Signal(m_pIFence, m_FenceValue) != S_OK)
+		CONSOLE_TRACE(Console::LEVEL_INFO, "Signal fence %llu", m_FenceValue);
+
+		rFenceValue = m_FenceValue;
+		m_FenceValue++;
+	}
+	else
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to signal command queue fence\n");
+	}
+
+	return Status;
+}
+
+BOOL CRenderer::WaitForFence(UINT64 FenceValue)
+{
+	PROFILE_FUNCTION();
+
+	BOOL Status = TRUE;
+
+	UINT64 CompletedValue = m_pIFence->GetCompletedValue();
+
+	if (CompletedValue < FenceValue)
+	{
+		CONSOLE_TRACE(Console::LEVEL_INFO, "Wait for fence %llu, %llu completed", FenceValue, CompletedValue);
+
+		if (m_pIFence->SetEventOnCompletion(FenceValue, m_hFenceEvent) == S_OK)
+		{
+			WaitForSingleObject(m_hFenceEvent, INFINITE);
+
+			CONSOLE_TRACE(Console::LEVEL_INFO, "Fence %llu reached", FenceValue);
+		}
+		else
 		{
 			Status = FALSE;
-			Console::Write("Error: Failed to signal command queue fence\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to wait for completion fence\n");
 		}
 	}
 
+	return Status;
+}
+
+BOOL CRenderer::BeginFrame(VOID)
+{
+	PROFILE_FUNCTION();
+
+	BOOL Status = TRUE;
+
+	m_FrameScheduler.BeginFrame();
+
+	// Only block when the slot about to be reused still belongs to a frame the GPU has not finished
+	if (m_FrameScheduler.MustWait(m_pIFence->GetCompletedValue()) == TRUE)
+	{
+		Status = WaitForFence(m_FrameScheduler.GetWaitFence());
+	}
+
 	if (Status == TRUE)
 	{
-		if (m_pIFence->GetCompletedValue() < m_FenceValue)
-		{
-			if (m_pIFence->SetEventOnCompletion(m_FenceValue, m_hFenceEvent) == S_OK)
-			{
-				WaitForSingleObject(m_hFenceEvent, INFINITE);
-			}
-			else
-			{
-				Status = FALSE;
-				Console::Write("Error: Failed to wait for completion fence\n");
-			}
-		}
+		m_UploadRing.Reclaim(m_pIFence->GetCompletedValue());
 
-		m_FenceValue++;
+		// The last frame that used this slot has completed, its timestamps can be read without stalling
+		UINT Slot = m_FrameScheduler.GetSlot();
+		m_GpuTimer.Resolve(Slot, m_pTimestampData + m_GpuTimer.GetBeginQuery(Slot, 0));
 	}
 
+	return Status;
+}
+
+BOOL CRenderer::EndFrame(VOID)
+{
+	PROFILE_FUNCTION();
+
+	UINT64 FenceValue = 0;
+	BOOL Status = SignalFence(FenceValue);
+
 	if (Status == TRUE)
 	{
+		m_UploadRing.Submit(FenceValue);
+		m_FrameScheduler.EndFrame(FenceValue);
+
 		m_FrameIndex = m_pISwapChain->GetCurrentBackBufferIndex();
 	}
 
@@ -6,7 +6,24 @@
 
 #include <d3d12.h>
 
+#include <vector>
+
 #include "CBase.hpp"
+#include "CCommandListSink.hpp"
+#include "CCommandRecorder.hpp"
+#include "CConstantAllocator.hpp"
+#include "CConstantLayout.hpp"
+#include "CFrameScheduler.hpp"
+#include "CGpuTimer.hpp"
+#include "CHeapAllocator.hpp"
+#include "CInstanceBuilder.hpp"
+#include "CMeshBuilder.hpp"
+#include "CPipelineCompiler.hpp"
+#include "CPipelineLibrary.hpp"
+#include "CPipelineQueue.hpp"
+#include "CShaderCache.hpp"
+#include "CTransformHierarchy.hpp"
+#include "CUploadRing.hpp"
 
 #include "IRenderer.hpp"
 
@@ -16,8 +33,46 @@ class CRenderer : public IRenderer, public CBase
 {
 protected:
 	enum								{ NumBuffers = 2 };
+	enum								{ NumFramesInFlight = 3 };
+	enum								{ NumRecordingThreads = 4 };
+	enum								{ FrameArenaSize = 1024 * 1024 };
+	enum								{ NumRootConstants = 16 };
+	enum								{ ConstantFrameSize = 1024 * 1024 };
+	enum								{ UploadRingSize = 64 * 1024 * 1024 };
+	enum								{ NumOrbitingCubes = 4 };
+	enum								{ FieldColumns = 400, FieldRows = 250 };
+	enum								{ FieldRevolutionFrames = 7200 };
+
+	enum RootParameter : UINT
+	{
+		ROOT_PARAMETER_CONSTANTS = 0,
+		ROOT_PARAMETER_DRAW_CONSTANTS = 1,
+		NumRootParameters = 2
+	};
+
+	// Members of the DrawConstants cbuffer in VertexShader.hlsl, in declaration order
+	enum DrawConstant : UINT
+	{
+		DRAW_CONSTANT_BOUNDS_MIN = 0,
+		DRAW_CONSTANT_BOUNDS_EXTENT = 1,
+		NumDrawConstants = 2
+	};
+
+	enum GpuPass : UINT
+	{
+		GPU_PASS_FRAME = 0,
+		GPU_PASS_CLEAR = 1,
+		GPU_PASS_DRAW = 2,
+		GPU_PASS_BARRIER = 3,
+		NumGpuPasses = 4
+	};
 
 	static CONST FLOAT					ClearColor[];
+	static CONST DXGI_FORMAT			DepthFormat;
+	static CONST LPCSTR					GpuPassNames[];
+	static CONST LPCSTR					ShaderDirectory;
+	static CONST LPCSTR					ShaderCachePath;
+	static CONST LPCSTR					PipelineCachePath;
 
 	HWND								m_hWND;
 
@@ -36,24 +91,67 @@ protected:
 	ID3D12Device*						m_pIDevice;
 	ID3D12CommandQueue*					m_pICommandQueue;
 	ID3D12DescriptorHeap*				m_pIDescriptorHeap;
+	ID3D12DescriptorHeap*				m_pIDsvHeap;
+	ID3D12Resource*						m_pIDepthBuffer;
 	ID3D12Resource*						m_pIRenderBuffers[NumBuffers];
-	ID3D12CommandAllocator*				m_pICommandAllocator;
+	ID3D12CommandAllocator*				m_pICommandAllocators[NumFramesInFlight];
 	ID3D12GraphicsCommandList*			m_pICommandList;
+	ID3D12GraphicsCommandList*			m_pIPresentCommandList;
 	ID3D12Fence*						m_pIFence;
 	ID3D12RootSignature*				m_pIRootSignature;
-	ID3D12PipelineState*				m_pIPipelineState;
 	ID3D12Resource*						m_pIVertexBuffer;
+	ID3D12Resource*						m_pIIndexBuffer;
 	ID3D12Heap*							m_pIUploadHeap;
+	ID3D12Resource*						m_pIUploadBuffer;
 	ID3D12Heap*							m_pIPrimaryHeap;
+	ID3D12QueryHeap*					m_pITimestampHeap;
+	ID3D12Resource*						m_pITimestampBuffer;
+	ID3D12Resource*						m_pIConstantBuffer;
+	ID3D12Resource*						m_pIInstanceBuffer;
 
 	D3D12_RECT							m_ScissorRect;
 	D3D12_VIEWPORT						m_Viewport;
 	D3D12_VERTEX_BUFFER_VIEW			m_VertexBufferView;
+	D3D12_INDEX_BUFFER_VIEW				m_IndexBufferView;
+	D3D12_VERTEX_BUFFER_VIEW			m_InstanceBufferView;
 
 	HANDLE								m_hFenceEvent;
 
+	CHeapAllocator						m_PrimaryHeapAllocator;
+	CHeapAllocator::Allocation			m_VertexAllocation;
+	CHeapAllocator::Allocation			m_IndexAllocation;
+
+	CFrameScheduler						m_FrameScheduler;
+	CCommandRecorder					m_CommandRecorder;
+	CCommandListSink					m_CommandListSinks[NumRecordingThreads];
+	CUploadRing							m_UploadRing;
+	BYTE*								m_pUploadData;
+	CGpuTimer							m_GpuTimer;
+	UINT64*								m_pTimestampData;
+	CConstantAllocator					m_ConstantAllocator;
+	CConstantLayout						m_DrawConstantLayout;
+	CShaderCache						m_ShaderCache;
+	CPipelineLibrary					m_PipelineLibrary;
+	CPipelineCompiler					m_PipelineCompiler;
+	CPipelineQueue						m_PipelineQueue;
+	CPipelineQueue::Report				m_PipelineReport;
+	UINT64								m_RootSignatureKey;
+	UINT64								m_PipelineKey;
+	BYTE*								m_pConstantData;
+	CConstantAllocator					m_InstanceAllocator;
+	BYTE*								m_pInstanceData;
+
 	UINT								m_FrameIndex;
 	UINT64								m_FenceValue;
+	std::vector<DrawCommand>			m_Draws;
+	std::vector<DrawCommand>			m_FrameDraws;
+	CTransformHierarchy					m_Transforms;
+	CInstanceBuilder					m_Instances;
+	UINT								m_CubeNode;
+	UINT								m_FieldNode;
+	VertexFormat						m_VertexFormat;
+	FLOAT								m_BoundsMin[3];
+	FLOAT								m_BoundsExtent[3];
 	SIZE_T								m_RtvDescriptorIncrement;
 
 protected:
@@ -66,19 +164,40 @@ protected:
 	BOOL PrintAdapterDesc(UINT uIndex, IDXGIAdapter4* pIAdapter);
 	BOOL EnumerateDxgiAdapters(VOID);
 
-	BOOL WaitForFrame(VOID);
+	BOOL SignalFence(UINT64& rFenceValue);
+	BOOL WaitForFence(UINT64 FenceValue);
+	BOOL BeginFrame(VOID);
+	BOOL EndFrame(VOID);
 
 	BOOL CompileShaders(VOID);
-	BOOL CompileShader(LPCWSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, ID3DBlob** pShader);
+	BOOL CompileShader(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, CONST D3D_SHADER_MACRO* pDefines, D3D12_SHADER_BYTECODE& rShader);
+
+	BOOL CreateGpuTimer(VOID);
+	VOID WriteTimestamp(ID3D12GraphicsCommandList* pICommandList, UINT Query);
 
+	BOOL CreateUploadRing(VOID);
+	BOOL CreateFrameBuffer(CConstantAllocator& rAllocator, SIZE_T FrameCapacity, LPCSTR pName, ID3D12Resource** ppIBuffer, BYTE** ppData);
+	BOOL CreateConstantBuffer(VOID);
+	BOOL CreateInstanceBuffer(VOID);
+	BOOL Upload(ID3D12Resource* pIDestination, UINT64 DestinationOffset, CONST VOID* pData, SIZE_T nBytes);
+
+	BOOL CreatePlacedBuffer(UINT64 nBytes, LPCSTR pName, CHeapAllocator::Allocation& rAllocation, ID3D12Resource** ppIResource);
 	BOOL CreateBuffers(VOID);
+	BOOL CreateDepthBuffer(ULONG Width, ULONG Height);
+	VOID CreateScene(UINT IndexCount);
+	BOOL UpdateScene(VOID);
+	VOID ReportPipelines(VOID);
 
 public:
 	static CRenderer* Create(HWND hWND, ULONG Width, ULONG Height);
 	static VOID		  Destroy(CRenderer* pRenderer);
 
 public:
-	virtual BOOL Render(VOID);
+	virtual RendererType GetType(VOID);
+	virtual BOOL		 Render(VOID);
+
+	virtual UINT		 GetPassCount(VOID);
+	virtual BOOL		 GetPassTiming(UINT Pass, PassTiming& rTiming);
 };
 
 #endif // CRENDERER_HPP
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "CSceneShaders.hpp"
+
+BOOL CSceneShaders::Declare(CPermutationRegistry& rRegistry)
+{
+	BOOL Status = TRUE;
+
+	CONST CShaderPermutation VertexFeatures = CShaderPermutation::Make<SHADER_FEATURE_INSTANCED, SHADER_FEATURE_QUANTIZED, SHADER_FEATURE_LIT>();
+	CONST CShaderPermutation PixelFeatures = CShaderPermutation::Make<SHADER_FEATURE_LIT>();
+
+	// Added in SceneShader order
+	if (rRegistry.AddShader("VertexShader.hlsl", "main", "vs_5_0", VertexFeatures) != SCENE_SHADER_VERTEX)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (rRegistry.AddShader("PixelShader.hlsl", "main", "ps_5_0", PixelFeatures) != SCENE_SHADER_PIXEL))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		// Every cube is drawn by one instanced call
+		rRegistry.Fix(SHADER_FEATURE_INSTANCED, TRUE);
+
+		// CSoftwareRenderer does not light the cubes and both renderers draw the same picture
+		rRegistry.Fix(SHADER_FEATURE_LIT, FALSE);
+
+		// Only quantized vertices carry normals
+		rRegistry.Require(SHADER_FEATURE_LIT, SHADER_FEATURE_QUANTIZED);
+	}
+
+	return Status;
+}
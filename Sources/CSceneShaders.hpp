@@ -0,0 +1,23 @@
+#ifndef CSCENESHADERS_HPP
+#define CSCENESHADERS_HPP
+
+#include "Defines.hpp"
+
+#include "CPermutationRegistry.hpp"
+
+// The shaders CRenderer draws the scene with and the feature combinations it can reach. Tools/ShaderCompiler embeds
+// exactly these variants in release builds, so the two have to change together.
+class CSceneShaders
+{
+public:
+	enum SceneShader : UINT
+	{
+		SCENE_SHADER_VERTEX = 0,
+		SCENE_SHADER_PIXEL = 1,
+		NumSceneShaders = 2
+	};
+
+	static BOOL Declare(CPermutationRegistry& rRegistry);
+};
+
+#endif // CSCENESHADERS_HPP
@@ -0,0 +1,377 @@
+#include "CShaderCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Console.hpp"
+#include "Hash.hpp"
+
+static_assert(sizeof(CShaderCache::Header) == 16, "Shader cache header layout changed, bump CShaderCache::Version");
+static_assert(sizeof(CShaderCache::Entry) == 24, "Shader cache entry layout changed, bump CShaderCache::Version");
+
+CShaderKey::CShaderKey()
+{
+	m_Hash = Hash::OffsetBasis;
+}
+
+CShaderKey::~CShaderKey()
+{
+}
+
+VOID CShaderKey::Add(CONST VOID* pData, SIZE_T nBytes)
+{
+	m_Hash = Hash::Fnv1a(pData, nBytes, m_Hash);
+}
+
+VOID CShaderKey::AddValue(UINT64 Value)
+{
+	m_Hash = Hash::Fnv1aValue(Value, m_Hash);
+}
+
+VOID CShaderKey::AddString(LPCSTR pString)
+{
+	m_Hash = Hash::Fnv1aString(pString, m_Hash);
+}
+
+BOOL CShaderKey::AddFile(LPCSTR pPath)
+{
+	return AddFile(std::string(pPath), 0);
+}
+
+BOOL CShaderKey::AddFile(CONST std::string& rPath, UINT Depth)
+{
+	BOOL Status = TRUE;
+	std::string Source;
+
+	if (Depth > MaxIncludeDepth)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Includes nest deeper than %u levels at %s\n", static_cast<UINT>(MaxIncludeDepth), rPath.c_str());
+	}
+
+	if (Status == TRUE)
+	{
+		std::ifstream File(rPath, std::ios::binary);
+		std::ostringstream Contents;
+
+		if (File.is_open() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open shader source %s\n", rPath.c_str());
+		}
+		else
+		{
+			Contents << File.rdbuf();
+			Source = Contents.str();
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		// The length separates this file from the ones it includes
+		AddValue(Source.size());
+		Add(Source.data(), Source.size());
+	}
+
+	if (Status == TRUE)
+	{
+		CONST SIZE_T Slash = rPath.find_last_of("/\\");
+		CONST std::string Directory = (Slash != std::string::npos) ? rPath.substr(0, Slash + 1) : std::string();
+
+		SIZE_T LineStart = 0;
+
+		// Only #include "..." lines at the start of a line are followed, which is all the shaders use
+		while ((Status == TRUE) && (LineStart < Source.size()))
+		{
+			SIZE_T LineEnd = Source.find('\n', LineStart);
+			LineEnd = (LineEnd != std::string::npos) ? LineEnd : Source.size();
+
+			SIZE_T i = Source.find_first_not_of(" \t", LineStart);
+
+			if ((i < LineEnd) && (Source[i] == '#'))
+			{
+				i = Source.find_first_not_of(" \t", i + 1);
+
+				if ((i < LineEnd) && (Source.compare(i, 7, "include") == 0))
+				{
+					CONST SIZE_T Open = Source.find('"', i + 7);
+					CONST SIZE_T Close = (Open < LineEnd) ? Source.find('"', Open + 1) : std::string::npos;
+
+					if (Close < LineEnd)
+					{
+						Status = AddFile(Directory + Source.substr(Open + 1, Close - Open - 1), Depth + 1);
+					}
+				}
+			}
+
+			LineStart = LineEnd + 1;
+		}
+	}
+
+	return Status;
+}
+
+UINT64 CShaderKey::GetKey(VOID)
+{
+	return m_Hash;
+}
+
+CShaderCache::CShaderCache()
+{
+	m_pEntries = NULL;
+	m_nEntries = 0;
+	m_nHits = 0;
+	m_nMisses = 0;
+}
+
+CShaderCache::~CShaderCache()
+{
+	Close();
+}
+
+BOOL CShaderCache::Open(LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+
+	Close();
+
+	m_Path = pPath;
+
+	// Checked first so a cold start does not report a missing file as an error
+	if (std::ifstream(pPath, std::ios::binary).is_open() == true)
+	{
+		if ((m_Mapping.Open(pPath) == TRUE) && (Validate() == TRUE))
+		{
+			m_pEntries = reinterpret_cast<CONST Entry*>(m_Mapping.GetData() + sizeof(Header));
+			m_nEntries = reinterpret_cast<CONST Header*>(m_Mapping.GetData())->EntryCount;
+		}
+		else
+		{
+			m_Mapping.Close();
+			CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: Ignoring shader cache %s, it will be rebuilt\n", pPath);
+		}
+	}
+
+	return Status;
+}
+
+VOID CShaderCache::Close(VOID)
+{
+	m_Mapping.Close();
+	m_pEntries = NULL;
+	m_nEntries = 0;
+	m_NewBlobs.clear();
+	m_Path.clear();
+	m_nHits = 0;
+	m_nMisses = 0;
+}
+
+BOOL CShaderCache::Validate(VOID)
+{
+	BOOL Status = TRUE;
+
+	CONST SIZE_T FileSize = m_Mapping.GetSize();
+	CONST Header* pHeader = reinterpret_cast<CONST Header*>(m_Mapping.GetData());
+
+	if ((FileSize < sizeof(Header)) || (pHeader->Magic != Magic) || (pHeader->Version != Version))
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (pHeader->EntryCount > ((FileSize - sizeof(Header)) / sizeof(Entry))))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		CONST Entry* pEntries = reinterpret_cast<CONST Entry*>(m_Mapping.GetData() + sizeof(Header));
+
+		// Find relies on the order, a duplicate key counts as out of order
+		for (UINT i = 0; (Status == TRUE) && (i < pHeader->EntryCount); i++)
+		{
+			if (((i != 0) && (pEntries[i - 1].Key >= pEntries[i].Key)) ||
+				((pEntries[i].Offset % BlobAlignment) != 0) ||
+				(pEntries[i].Offset > FileSize) ||
+				(pEntries[i].Size > (FileSize - pEntries[i].Offset)))
+			{
+				Status = FALSE;
+			}
+		}
+	}
+
+	return Status;
+}
+
+BOOL CShaderCache::Find(UINT64 Key, CONST VOID** ppData, SIZE_T* pSize)
+{
+	BOOL Status = FALSE;
+
+	CONST Entry* pEnd = m_pEntries + m_nEntries;
+	CONST Entry* pEntry = std::lower_bound(m_pEntries, pEnd, Key, [](CONST Entry& rEntry, UINT64 Value) { return rEntry.Key < Value; });
+
+	if ((pEntry != pEnd) && (pEntry->Key == Key))
+	{
+		Status = TRUE;
+		*ppData = m_Mapping.GetData() + pEntry->Offset;
+		*pSize = static_cast<SIZE_T>(pEntry->Size);
+	}
+
+	// Shaders stored since the cache was opened, a frame only ever adds a handful
+	for (SIZE_T i = 0; (Status == FALSE) && (i < m_NewBlobs.size()); i++)
+	{
+		if (m_NewBlobs[i].Key == Key)
+		{
+			Status = TRUE;
+			*ppData = m_NewBlobs[i].Data.data();
+			*pSize = m_NewBlobs[i].Data.size();
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		m_nHits++;
+	}
+	else
+	{
+		m_nMisses++;
+	}
+
+	return Status;
+}
+
+BOOL CShaderCache::Store(UINT64 Key, CONST VOID* pData, SIZE_T nBytes, CONST VOID** ppCopy)
+{
+	BOOL Status = ((pData != NULL) && (nBytes != 0)) ? TRUE : FALSE;
+
+	if (Status == TRUE)
+	{
+		NewBlob Blob = { Key, std::vector<uint8_t>(reinterpret_cast<CONST uint8_t*>(pData), reinterpret_cast<CONST uint8_t*>(pData) + nBytes) };
+		m_NewBlobs.push_back(std::move(Blob));
+
+		if (ppCopy != NULL)
+		{
+			*ppCopy = m_NewBlobs.back().Data.data();
+		}
+	}
+
+	return Status;
+}
+
+BOOL CShaderCache::Save(VOID)
+{
+	BOOL Status = (m_Path.empty() == false) ? TRUE : FALSE;
+
+	struct Source
+	{
+		Entry		Item;
+		CONST VOID* pData;
+	};
+
+	std::vector<Source> Sources;
+	CONST std::string TempPath = m_Path + ".tmp";
+
+	if ((Status == TRUE) && (m_NewBlobs.empty() == false))
+	{
+		// New blobs come first so the stable sort and unique keep them over an old entry with the same key
+		for (SIZE_T i = 0; i < m_NewBlobs.size(); i++)
+		{
+			Sources.push_back({ { m_NewBlobs[i].Key, 0, m_NewBlobs[i].Data.size() }, m_NewBlobs[i].Data.data() });
+		}
+
+		for (UINT i = 0; i < m_nEntries; i++)
+		{
+			Sources.push_back({ m_pEntries[i], m_Mapping.GetData() + m_pEntries[i].Offset });
+		}
+
+		std::stable_sort(Sources.begin(), Sources.end(), [](CONST Source& rA, CONST Source& rB) { return rA.Item.Key < rB.Item.Key; });
+		Sources.erase(std::unique(Sources.begin(), Sources.end(), [](CONST Source& rA, CONST Source& rB) { return rA.Item.Key == rB.Item.Key; }), Sources.end());
+
+		uint64_t Offset = sizeof(Header) + Sources.size() * sizeof(Entry);
+
+		for (SIZE_T i = 0; i < Sources.size(); i++)
+		{
+			Offset = (Offset + BlobAlignment - 1) & ~static_cast<uint64_t>(BlobAlignment - 1);
+			Sources[i].Item.Offset = Offset;
+			Offset += Sources[i].Item.Size;
+		}
+
+		Header FileHeader = { Magic, Version, static_cast<uint32_t>(Sources.size()), 0 };
+		std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+
+		if (File.is_open() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create %s\n", TempPath.c_str());
+		}
+
+		if (Status == TRUE)
+		{
+			CONST CHAR Padding[BlobAlignment] = { };
+			uint64_t Written = sizeof(Header) + Sources.size() * sizeof(Entry);
+
+			File.write(reinterpret_cast<CONST CHAR*>(&FileHeader), sizeof(Header));
+
+			for (SIZE_T i = 0; i < Sources.size(); i++)
+			{
+				File.write(reinterpret_cast<CONST CHAR*>(&Sources[i].Item), sizeof(Entry));
+			}
+
+			for (SIZE_T i = 0; i < Sources.size(); i++)
+			{
+				File.write(Padding, static_cast<std::streamsize>(Sources[i].Item.Offset - Written));
+				File.write(reinterpret_cast<CONST CHAR*>(Sources[i].pData), static_cast<std::streamsize>(Sources[i].Item.Size));
+
+				Written = Sources[i].Item.Offset + Sources[i].Item.Size;
+			}
+
+			File.close();
+
+			if (File.fail() == true)
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to write %s\n", TempPath.c_str());
+			}
+		}
+
+		// The old file cannot be replaced while it is mapped
+		m_Mapping.Close();
+
+		if (Status == TRUE)
+		{
+			std::remove(m_Path.c_str());
+
+			if (std::rename(TempPath.c_str(), m_Path.c_str()) != 0)
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not replace %s\n", m_Path.c_str());
+			}
+		}
+		else
+		{
+			std::remove(TempPath.c_str());
+		}
+	}
+
+	Close();
+
+	return Status;
+}
+
+UINT CShaderCache::GetEntryCount(VOID)
+{
+	return m_nEntries;
+}
+
+UINT CShaderCache::GetHitCount(VOID)
+{
+	return m_nHits;
+}
+
+UINT CShaderCache::GetMissCount(VOID)
+{
+	return m_nMisses;
+}
@@ -0,0 +1,112 @@
+#ifndef CSHADERCACHE_HPP
+#define CSHADERCACHE_HPP
+
+#include <string>
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CFileMapping.hpp"
+
+// Builds the key of one compiled shader from everything that decides its bytecode: the source and the files it
+// includes, the entry point, the target, the compile flags and the defines. Hashed in the order the caller adds things,
+// so two keys only match when the same things were added in the same order.
+class CShaderKey
+{
+public:
+	enum { MaxIncludeDepth = 16 };
+
+protected:
+	UINT64 m_Hash;
+
+	BOOL AddFile(CONST std::string& rPath, UINT Depth);
+
+public:
+	CShaderKey();
+	~CShaderKey();
+
+	VOID Add(CONST VOID* pData, SIZE_T nBytes);
+	VOID AddValue(UINT64 Value);
+	VOID AddString(LPCSTR pString);
+
+	// Hashes the contents of the file and of every file it names in an #include "..." line, relative to the directory
+	// of the file that includes it. The path itself is not hashed, moving the sources keeps their keys.
+	BOOL AddFile(LPCSTR pPath);
+
+	UINT64 GetKey(VOID);
+};
+
+/*
+* Compiled shaders stored by key in a single file, little endian:
+*
+*	Header
+*	Entries		EntryCount entries sorted by key
+*	Blobs		the bytecode of each entry, every blob starts on a BlobAlignment boundary
+*
+* Open maps the file and Find hands out pointers into the mapping, so a hit costs a binary search. Bytecode compiled
+* on a miss is handed to Store, which keeps a copy until Save writes the old and the new entries to a new file and
+* swaps it in. Every pointer from Find or Store is invalid once Save or Close has been called.
+*/
+class CShaderCache
+{
+public:
+	enum : uint32_t
+	{
+		Magic = 0x43524853, // "SHRC"
+		Version = 1,
+		BlobAlignment = 16
+	};
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t EntryCount;
+		uint32_t Reserved;
+	};
+
+	struct Entry
+	{
+		uint64_t Key;
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+protected:
+	// Moving a std::vector keeps its buffer, so the pointers Store hands out survive m_NewBlobs growing
+	struct NewBlob
+	{
+		uint64_t			 Key;
+		std::vector<uint8_t> Data;
+	};
+
+	std::string			 m_Path;
+	CFileMapping		 m_Mapping;
+	CONST Entry*		 m_pEntries;
+	UINT				 m_nEntries;
+	std::vector<NewBlob> m_NewBlobs;
+	UINT				 m_nHits;
+	UINT				 m_nMisses;
+
+	BOOL Validate(VOID);
+
+public:
+	CShaderCache();
+	~CShaderCache();
+
+	// A missing file is an empty cache. A file that is corrupt or from another version is ignored and replaced by Save.
+	BOOL Open(LPCSTR pPath);
+	VOID Close(VOID);
+
+	BOOL Find(UINT64 Key, CONST VOID** ppData, SIZE_T* pSize);
+	BOOL Store(UINT64 Key, CONST VOID* pData, SIZE_T nBytes, CONST VOID** ppCopy);
+
+	// Does nothing when nothing was stored, closes the cache either way
+	BOOL Save(VOID);
+
+	UINT GetEntryCount(VOID);
+	UINT GetHitCount(VOID);
+	UINT GetMissCount(VOID);
+};
+
+#endif // CSHADERCACHE_HPP
@@ -0,0 +1,14 @@
+#include "CShaderPermutation.hpp"
+
+// Indexed by ShaderFeature, QUANTIZED_VERTICES predates the other features and keeps its name
+static CONST LPCSTR DefineNames[NumShaderFeatures] =
+{
+	"INSTANCED",
+	"QUANTIZED_VERTICES",
+	"LIT"
+};
+
+LPCSTR CShaderPermutation::GetDefineName(ShaderFeature Feature)
+{
+	return (Feature < NumShaderFeatures) ? DefineNames[Feature] : NULL;
+}
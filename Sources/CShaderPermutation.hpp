@@ -0,0 +1,91 @@
+#ifndef CSHADERPERMUTATION_HPP
+#define CSHADERPERMUTATION_HPP
+
+#include "Defines.hpp"
+
+// Each feature is one bit of a CShaderPermutation and one define the shaders test with #if
+enum ShaderFeature : UINT
+{
+	SHADER_FEATURE_INSTANCED = 0,
+	SHADER_FEATURE_QUANTIZED = 1,
+	SHADER_FEATURE_LIT = 2,
+	NumShaderFeatures = 3
+};
+
+/*
+* Key of a shader variant, one bit per ShaderFeature. Keys known at compile time are built with Make, the features a
+* frame only knows at runtime are added with With:
+*
+*	CShaderPermutation::Make<SHADER_FEATURE_INSTANCED>().With(SHADER_FEATURE_QUANTIZED, bQuantized)
+*
+* A shader only sees the features it was declared with, so GetDefines takes that mask and defines each of its features
+* as 1 or 0, in feature order. Features outside the mask are left undefined and the shader's #ifndef defaults apply.
+*/
+class CShaderPermutation
+{
+protected:
+	UINT m_Bits;
+
+public:
+	constexpr CShaderPermutation() : m_Bits(0) { }
+	constexpr explicit CShaderPermutation(UINT Bits) : m_Bits(Bits) { }
+
+	template <ShaderFeature... TFeatures>
+	static constexpr CShaderPermutation Make(VOID)
+	{
+		CONST UINT Bits[] = { 0, (1u << TFeatures)... };
+		UINT Key = 0;
+
+		for (UINT i = 0; i < sizeof(Bits) / sizeof(Bits[0]); i++)
+		{
+			Key |= Bits[i];
+		}
+
+		return CShaderPermutation(Key);
+	}
+
+	// Every combination of features fits below this
+	static constexpr UINT GetCombinationCount(VOID) { return 1u << NumShaderFeatures; }
+
+	constexpr UINT GetBits(VOID) const { return m_Bits; }
+	constexpr BOOL Has(ShaderFeature Feature) const { return ((m_Bits >> Feature) & 1) != 0 ? TRUE : FALSE; }
+
+	constexpr CShaderPermutation With(ShaderFeature Feature, BOOL bEnabled) const
+	{
+		return CShaderPermutation((bEnabled == TRUE) ? (m_Bits | (1u << Feature)) : (m_Bits & ~(1u << Feature)));
+	}
+
+	constexpr CShaderPermutation Mask(CShaderPermutation Features) const { return CShaderPermutation(m_Bits & Features.m_Bits); }
+
+	constexpr bool operator==(CShaderPermutation Other) const { return m_Bits == Other.m_Bits; }
+	constexpr bool operator!=(CShaderPermutation Other) const { return m_Bits != Other.m_Bits; }
+
+	static LPCSTR GetDefineName(ShaderFeature Feature);
+
+	// TMacro is D3D_SHADER_MACRO or anything else with Name and Definition. rDefines ends at a NULL Name, the same as
+	// CompileShader expects.
+	template <typename TMacro>
+	UINT GetDefines(CShaderPermutation Features, TMacro (&rDefines)[NumShaderFeatures + 1]) const
+	{
+		UINT nDefines = 0;
+
+		for (UINT i = 0; i < NumShaderFeatures; i++)
+		{
+			CONST ShaderFeature Feature = static_cast<ShaderFeature>(i);
+
+			if (Features.Has(Feature) == TRUE)
+			{
+				rDefines[nDefines].Name = GetDefineName(Feature);
+				rDefines[nDefines].Definition = (Has(Feature) == TRUE) ? "1" : "0";
+				nDefines++;
+			}
+		}
+
+		rDefines[nDefines].Name = NULL;
+		rDefines[nDefines].Definition = NULL;
+
+		return nDefines;
+	}
+};
+
+#endif // CSHADERPERMUTATION_HPP
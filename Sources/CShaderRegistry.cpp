@@ -0,0 +1,188 @@
+#include "CShaderRegistry.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "Console.hpp"
+
+#if EMBEDDED_SHADERS
+// Generated by Tools/ShaderCompiler before the build, defines EmbeddedShaders sorted by name
+#include "EmbeddedShaders.inl"
+
+static CONST CShaderRegistry::Blob* CONST pEmbeddedShaders = EmbeddedShaders;
+static CONST UINT nEmbeddedShaders = sizeof(EmbeddedShaders) / sizeof(EmbeddedShaders[0]);
+#else
+static CONST CShaderRegistry::Blob* CONST pEmbeddedShaders = NULL;
+static CONST UINT nEmbeddedShaders = 0;
+#endif
+
+std::string CShaderRegistry::GetName(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget)
+{
+	// Only the file name, the binary must not care where the sources were
+	LPCSTR pBaseName = pFileName;
+
+	for (LPCSTR pChar = pFileName; *pChar != 0; pChar++)
+	{
+		if ((*pChar == '/') || (*pChar == '\\'))
+		{
+			pBaseName = pChar + 1;
+		}
+	}
+
+	std::string Name = pBaseName;
+	Name += "|";
+	Name += pEntrypoint;
+	Name += "|";
+	Name += pTarget;
+
+	return Name;
+}
+
+BOOL CShaderRegistry::Find(LPCSTR pName, CONST VOID** ppData, SIZE_T* pSize)
+{
+	BOOL Status = FALSE;
+	UINT Low = 0;
+	UINT High = nEmbeddedShaders;
+
+	while (Low < High)
+	{
+		CONST UINT Middle = Low + (High - Low) / 2;
+		CONST INT Order = strcmp(pEmbeddedShaders[Middle].pName, pName);
+
+		if (Order < 0)
+		{
+			Low = Middle + 1;
+		}
+		else if (Order > 0)
+		{
+			High = Middle;
+		}
+		else
+		{
+			Status = TRUE;
+			*ppData = pEmbeddedShaders[Middle].pData;
+			*pSize = pEmbeddedShaders[Middle].Size;
+			break;
+		}
+	}
+
+	return Status;
+}
+
+UINT CShaderRegistry::GetCount(VOID)
+{
+	return nEmbeddedShaders;
+}
+
+CONST CShaderRegistry::Blob* CShaderRegistry::GetBlob(UINT Index)
+{
+	return (Index < nEmbeddedShaders) ? &pEmbeddedShaders[Index] : NULL;
+}
+
+BOOL CShaderRegistry::Write(LPCSTR pPath, CONST Blob* pBlobs, UINT nBlobs)
+{
+	BOOL Status = TRUE;
+	std::vector<CONST Blob*> Sorted;
+
+	// An empty table would be a zero sized array
+	if (nBlobs == 0)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: There are no shaders to embed\n");
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < nBlobs); i++)
+	{
+		Sorted.push_back(&pBlobs[i]);
+	}
+
+	std::sort(Sorted.begin(), Sorted.end(), [](CONST Blob* pA, CONST Blob* pB) { return strcmp(pA->pName, pB->pName) < 0; });
+
+	for (UINT i = 1; (Status == TRUE) && (i < Sorted.size()); i++)
+	{
+		if (strcmp(Sorted[i - 1]->pName, Sorted[i]->pName) == 0)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader %s is listed twice\n", Sorted[i]->pName);
+		}
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < Sorted.size()); i++)
+	{
+		if (strpbrk(Sorted[i]->pName, "\"\\\n") != NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader name %s cannot be written as a string literal\n", Sorted[i]->pName);
+		}
+		else if (Sorted[i]->Size == 0)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader %s has no bytecode\n", Sorted[i]->pName);
+		}
+	}
+
+	std::ostringstream Table;
+
+	if (Status == TRUE)
+	{
+		CHAR Byte[8] = { };
+
+		Table << "// Generated by ShaderCompiler, do not edit\n";
+
+		for (UINT i = 0; i < Sorted.size(); i++)
+		{
+			Table << "\n// " << Sorted[i]->pName << "\n";
+			Table << "alignas(4) static CONST uint8_t EmbeddedShader" << i << "[] =\n{";
+
+			for (SIZE_T j = 0; j < Sorted[i]->Size; j++)
+			{
+				snprintf(Byte, sizeof(Byte), "0x%02x,", Sorted[i]->pData[j]);
+				Table << (((j % 16) == 0) ? "\n\t" : " ") << Byte;
+			}
+
+			Table << "\n};\n";
+		}
+
+		Table << "\nstatic CONST CShaderRegistry::Blob EmbeddedShaders[] =\n{\n";
+
+		for (UINT i = 0; i < Sorted.size(); i++)
+		{
+			Table << "\t{ \"" << Sorted[i]->pName << "\", EmbeddedShader" << i << ", sizeof(EmbeddedShader" << i << ") },\n";
+		}
+
+		Table << "};\n";
+	}
+
+	// An unchanged table is left alone, so the build does not recompile what includes it
+	if (Status == TRUE)
+	{
+		std::ifstream Existing(pPath, std::ios::binary);
+		std::ostringstream Contents;
+
+		Contents << Existing.rdbuf();
+
+		if ((Existing.is_open() == true) && (Contents.str() == Table.str()))
+		{
+			Console::Write("%s is up to date\n", pPath);
+		}
+		else
+		{
+			std::ofstream File(pPath, std::ios::binary | std::ios::trunc);
+
+			File << Table.str();
+			File.close();
+
+			if (File.fail() == true)
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to write %s\n", pPath);
+			}
+		}
+	}
+
+	return Status;
+}
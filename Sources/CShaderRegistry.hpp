@@ -0,0 +1,54 @@
+#ifndef CSHADERREGISTRY_HPP
+#define CSHADERREGISTRY_HPP
+
+#include <string>
+
+#include "Defines.hpp"
+
+/*
+* Bytecode compiled ahead of time by Tools/ShaderCompiler and linked into the binary, looked up by name. Builds with
+* EMBEDDED_SHADERS include the table the tool generates, others have an empty registry and compile at runtime.
+*
+* A variant's name is its file name without the directory, its entry point, its target and its defines in order:
+*
+*	VertexShader.hlsl|main|vs_5_0|INSTANCED=1|QUANTIZED_VERTICES=1|LIT=0
+*/
+class CShaderRegistry
+{
+public:
+	struct Blob
+	{
+		LPCSTR		   pName;
+		CONST uint8_t* pData;
+		SIZE_T		   Size;
+	};
+
+	// TMacro is D3D_SHADER_MACRO or anything else with Name and Definition, pDefines ends at a NULL Name
+	template <typename TMacro>
+	static std::string GetName(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget, CONST TMacro* pDefines)
+	{
+		std::string Name = GetName(pFileName, pEntrypoint, pTarget);
+
+		for (CONST TMacro* pDefine = pDefines; (pDefine != NULL) && (pDefine->Name != NULL); pDefine++)
+		{
+			Name += "|";
+			Name += pDefine->Name;
+			Name += "=";
+			Name += (pDefine->Definition != NULL) ? pDefine->Definition : "";
+		}
+
+		return Name;
+	}
+
+	static std::string GetName(LPCSTR pFileName, LPCSTR pEntrypoint, LPCSTR pTarget);
+
+	static BOOL Find(LPCSTR pName, CONST VOID** ppData, SIZE_T* pSize);
+
+	static UINT		   GetCount(VOID);
+	static CONST Blob* GetBlob(UINT Index);
+
+	// Writes the C++ table an EMBEDDED_SHADERS build includes, sorted by name. Used by Tools/ShaderCompiler.
+	static BOOL Write(LPCSTR pPath, CONST Blob* pBlobs, UINT nBlobs);
+};
+
+#endif // CSHADERREGISTRY_HPP
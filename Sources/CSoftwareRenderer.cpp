@@ -0,0 +1,508 @@
+#include "IRenderer.hpp"
+#include "CSoftwareRenderer.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "CGeometry.hpp"
+#include "CMeshFile.hpp"
+#include "CVertexQuantizer.hpp"
+#include "Console.hpp"
+#include "Memory.hpp"
+#include "Profiler.hpp"
+
+CONST FLOAT CSoftwareRenderer::ClearColor[] = { 50.0f / 255.0f, 135.0f / 255.0f, 235.0f / 255.0f, 1.0f };
+
+// Triangles reaching further than this outside of the viewport (in NDC) are rejected instead of clipped
+static CONST FLOAT GuardBand = 16.0f;
+
+CSoftwareRenderer* CSoftwareRenderer::Create(ULONG Width, ULONG Height)
+{
+	CSoftwareRenderer* pRenderer = new CSoftwareRenderer();
+
+	if (pRenderer->Initialize(Width, Height) == FALSE)
+	{
+		CSoftwareRenderer::Destroy(pRenderer);
+		pRenderer = NULL;
+	}
+
+	return pRenderer;
+}
+
+VOID CSoftwareRenderer::Destroy(CSoftwareRenderer* pRenderer)
+{
+	if (pRenderer != NULL)
+	{
+		pRenderer->Uninitialize();
+		delete pRenderer;
+	}
+}
+
+CSoftwareRenderer::CSoftwareRenderer()
+{
+	m_Width = 0;
+	m_Height = 0;
+	m_TilesX = 0;
+	m_TilesY = 0;
+	m_pFrameBuffer = NULL;
+	m_ClearValue = 0;
+
+	m_NextTile = 0;
+	m_Generation = 0;
+	m_nBusyWorkers = 0;
+	m_bExit = FALSE;
+
+	m_FrameCount = 0;
+}
+
+CSoftwareRenderer::~CSoftwareRenderer()
+{
+}
+
+BOOL CSoftwareRenderer::Initialize(ULONG Width, ULONG Height)
+{
+	BOOL Status = TRUE;
+
+	if ((Width == 0) || (Height == 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Invalid software render target size %ux%u\n", static_cast<UINT>(Width), static_cast<UINT>(Height));
+	}
+
+	if (Status == TRUE)
+	{
+		m_Width = Width;
+		m_Height = Height;
+		m_TilesX = (Width + TileSize - 1) / TileSize;
+		m_TilesY = (Height + TileSize - 1) / TileSize;
+		m_ClearValue = PackColour(ClearColor);
+
+		m_pFrameBuffer = reinterpret_cast<uint32_t*>(Memory::Allocate(sizeof(uint32_t) * Width * Height, TRUE));
+
+		if (m_pFrameBuffer == NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not allocate software render target\n");
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		m_Bins.resize(m_TilesX * m_TilesY);
+
+		Status = CreateBuffers();
+	}
+
+	if (Status == TRUE)
+	{
+		UINT nThreads = std::thread::hardware_concurrency();
+
+		if (nThreads > MaxWorkers)
+		{
+			nThreads = MaxWorkers;
+		}
+
+		// The calling thread rasterizes tiles as well, so it is not counted as a worker
+		for (UINT i = 1; i < nThreads; i++)
+		{
+			m_Workers.emplace_back(&CSoftwareRenderer::WorkerMain, this);
+		}
+
+		Console::Write("Software renderer: %ux%u, %u tiles, %u worker threads\n", static_cast<UINT>(m_Width), static_cast<UINT>(m_Height), m_TilesX * m_TilesY, static_cast<UINT>(m_Workers.size()));
+	}
+
+	return Status;
+}
+
+VOID CSoftwareRenderer::Uninitialize(VOID)
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_bExit = TRUE;
+	}
+
+	m_WorkCondition.notify_all();
+
+	for (SIZE_T i = 0; i < m_Workers.size(); i++)
+	{
+		m_Workers[i].join();
+	}
+
+	m_Workers.clear();
+
+	if (m_pFrameBuffer != NULL)
+	{
+		Memory::Free(m_pFrameBuffer);
+		m_pFrameBuffer = NULL;
+	}
+}
+
+BOOL CSoftwareRenderer::CreateBuffers(VOID)
+{
+	BOOL Status = TRUE;
+
+	CMeshFile MeshFile;
+	CMeshBuilder MeshBuilder;
+	MeshData Mesh = { };
+
+	Status = CGeometry::LoadCube(MeshFile, MeshBuilder, Mesh);
+
+	// Same vertex and index streams as CRenderer, indices are widened to 32 bits
+	if (Status == TRUE)
+	{
+		if (Mesh.Format == VERTEX_FORMAT_QUANTIZED)
+		{
+			Status = CVertexQuantizer::Dequantize(Mesh, m_Vertices);
+		}
+		else
+		{
+			CONST Vertex* pVertices = reinterpret_cast<CONST Vertex*>(Mesh.pVertices);
+			m_Vertices.assign(pVertices, pVertices + Mesh.VertexCount);
+		}
+	}
+
+	// The file is mapped as is, an index past the vertices would read outside m_ClipPositions
+	if (Status == TRUE)
+	{
+		m_Indices.resize(Mesh.IndexCount);
+
+		for (UINT i = 0; i < Mesh.IndexCount; i++)
+		{
+			m_Indices[i] = (Mesh.IndexSize == sizeof(uint16_t)) ? reinterpret_cast<CONST uint16_t*>(Mesh.pIndices)[i] : reinterpret_cast<CONST uint32_t*>(Mesh.pIndices)[i];
+		}
+
+		Status = CMeshFile::ValidateIndices(CGeometry::CubeMeshPath, m_Indices.data(), Mesh.IndexCount, Mesh.VertexCount);
+	}
+
+	if (Status == TRUE)
+	{
+		m_ClipPositions.resize(m_Vertices.size());
+		m_Triangles.reserve(m_Indices.size() / 3);
+	}
+
+	return Status;
+}
+
+uint32_t CSoftwareRenderer::PackColour(CONST FLOAT* pColour)
+{
+	uint32_t Packed = 0;
+
+	for (UINT i = 0; i < 4; i++)
+	{
+		FLOAT Value = (i < 3) ? pColour[i] : 1.0f;
+
+		Value = (Value < 0.0f) ? 0.0f : ((Value > 1.0f) ? 1.0f : Value);
+
+		Packed |= static_cast<uint32_t>(Value * 255.0f + 0.5f) << (i * 8);
+	}
+
+	return Packed;
+}
+
+VOID CSoftwareRenderer::SetupTriangles(VOID)
+{
+	CONST FLOAT SubpixelScale = static_cast<FLOAT>(1 << SubpixelBits);
+	CONST SIZE_T nIndices = m_Indices.size();
+
+	m_Triangles.clear();
+
+	// Every vertex goes through the same transform as in VertexShader.hlsl, once per frame
+	if (m_Vertices.empty() == false)
+	{
+		Mat4 WorldViewProjection;
+		CGeometry::GetCubeTransform(m_FrameCount, static_cast<FLOAT>(m_Width) / static_cast<FLOAT>(m_Height), WorldViewProjection);
+
+		Math::TransformPoints(WorldViewProjection, m_Vertices[0].Position, sizeof(Vertex), m_ClipPositions.data(), m_Vertices.size());
+	}
+
+	for (SIZE_T i = 0; i < m_Bins.size(); i++)
+	{
+		m_Bins[i].clear();
+	}
+
+	for (SIZE_T n = 0; (n + 2) < nIndices; n += 3)
+	{
+		Triangle t = { };
+		BOOL bVisible = TRUE;
+
+		for (UINT i = 0; i < 3; i++)
+		{
+			CONST Vec4& rClip = m_ClipPositions[m_Indices[n + i]];
+			CONST FLOAT* pColour = m_Vertices[m_Indices[n + i]].Colour;
+
+			// There is no near plane clipping, triangles reaching behind the camera are rejected
+			if (!(rClip.w > 0.0f))
+			{
+				bVisible = FALSE;
+				break;
+			}
+
+			CONST FLOAT InvW = 1.0f / rClip.w;
+			CONST FLOAT x = rClip.x * InvW;
+			CONST FLOAT y = rClip.y * InvW;
+
+			if (!(fabsf(x) <= GuardBand) || !(fabsf(y) <= GuardBand))
+			{
+				bVisible = FALSE;
+				break;
+			}
+
+			FLOAT ScreenX = (x * 0.5f + 0.5f) * static_cast<FLOAT>(m_Width);
+			FLOAT ScreenY = (0.5f - y * 0.5f) * static_cast<FLOAT>(m_Height);
+
+			t.X[i] = static_cast<INT>(floorf(ScreenX * SubpixelScale + 0.5f));
+			t.Y[i] = static_cast<INT>(floorf(ScreenY * SubpixelScale + 0.5f));
+			t.Z[i] = rClip.z * InvW;
+			t.InvW[i] = InvW;
+
+			// Colours are divided by w here and multiplied back per pixel, which interpolates them perspective correctly
+			t.Colour[i][0] = pColour[0] * InvW;
+			t.Colour[i][1] = pColour[1] * InvW;
+			t.Colour[i][2] = pColour[2] * InvW;
+		}
+
+		if (bVisible == TRUE)
+		{
+			// Clockwise triangles are front facing (FrontCounterClockwise = FALSE), back faces are culled
+			t.Area = static_cast<int64_t>(t.X[1] - t.X[0]) * (t.Y[2] - t.Y[0]) - static_cast<int64_t>(t.Y[1] - t.Y[0]) * (t.X[2] - t.X[0]);
+
+			bVisible = (t.Area > 0) ? TRUE : FALSE;
+		}
+
+		if (bVisible == TRUE)
+		{
+			INT MinX = t.X[0], MaxX = t.X[0];
+			INT MinY = t.Y[0], MaxY = t.Y[0];
+
+			for (UINT i = 1; i < 3; i++)
+			{
+				MinX = (t.X[i] < MinX) ? t.X[i] : MinX;
+				MaxX = (t.X[i] > MaxX) ? t.X[i] : MaxX;
+				MinY = (t.Y[i] < MinY) ? t.Y[i] : MinY;
+				MaxY = (t.Y[i] > MaxY) ? t.Y[i] : MaxY;
+			}
+
+			t.MinX = (MinX >> SubpixelBits) > 0 ? (MinX >> SubpixelBits) : 0;
+			t.MinY = (MinY >> SubpixelBits) > 0 ? (MinY >> SubpixelBits) : 0;
+			t.MaxX = (MaxX >> SubpixelBits) < static_cast<INT>(m_Width - 1) ? (MaxX >> SubpixelBits) : static_cast<INT>(m_Width - 1);
+			t.MaxY = (MaxY >> SubpixelBits) < static_cast<INT>(m_Height - 1) ? (MaxY >> SubpixelBits) : static_cast<INT>(m_Height - 1);
+
+			bVisible = ((t.MinX <= t.MaxX) && (t.MinY <= t.MaxY)) ? TRUE : FALSE;
+		}
+
+		if (bVisible == TRUE)
+		{
+			UINT TriangleIndex = static_cast<UINT>(m_Triangles.size());
+			m_Triangles.push_back(t);
+
+			// Bins are filled in submission order, which keeps the output identical regardless of the thread count
+			for (UINT ty = t.MinY / TileSize; ty <= static_cast<UINT>(t.MaxY) / TileSize; ty++)
+			{
+				for (UINT tx = t.MinX / TileSize; tx <= static_cast<UINT>(t.MaxX) / TileSize; tx++)
+				{
+					m_Bins[ty * m_TilesX + tx].push_back(TriangleIndex);
+				}
+			}
+		}
+	}
+}
+
+VOID CSoftwareRenderer::RasterizeTile(UINT TileIndex)
+{
+	CONST INT TileX = static_cast<INT>(TileIndex % m_TilesX) * TileSize;
+	CONST INT TileY = static_cast<INT>(TileIndex / m_TilesX) * TileSize;
+	CONST INT TileMaxX = ((TileX + TileSize) < static_cast<INT>(m_Width)) ? (TileX + TileSize - 1) : static_cast<INT>(m_Width - 1);
+	CONST INT TileMaxY = ((TileY + TileSize) < static_cast<INT>(m_Height)) ? (TileY + TileSize - 1) : static_cast<INT>(m_Height - 1);
+
+	for (INT y = TileY; y <= TileMaxY; y++)
+	{
+		uint32_t* pRow = m_pFrameBuffer + static_cast<SIZE_T>(y) * m_Width;
+
+		for (INT x = TileX; x <= TileMaxX; x++)
+		{
+			pRow[x] = m_ClearValue;
+		}
+	}
+
+	CONST std::vector<UINT>& rBin = m_Bins[TileIndex];
+
+	for (SIZE_T b = 0; b < rBin.size(); b++)
+	{
+		CONST Triangle& t = m_Triangles[rBin[b]];
+
+		INT MinX = (t.MinX > TileX) ? t.MinX : TileX;
+		INT MinY = (t.MinY > TileY) ? t.MinY : TileY;
+		INT MaxX = (t.MaxX < TileMaxX) ? t.MaxX : TileMaxX;
+		INT MaxY = (t.MaxY < TileMaxY) ? t.MaxY : TileMaxY;
+
+		// Edge e is opposite to vertex e, so its edge function is the (unnormalized) barycentric weight of vertex e
+		int64_t StepX[3];
+		int64_t StepY[3];
+		int64_t RowStart[3];
+
+		CONST int64_t PixelX = (static_cast<int64_t>(MinX) << SubpixelBits) + (1 << (SubpixelBits - 1));
+		CONST int64_t PixelY = (static_cast<int64_t>(MinY) << SubpixelBits) + (1 << (SubpixelBits - 1));
+
+		for (UINT e = 0; e < 3; e++)
+		{
+			CONST UINT a = (e + 1) % 3;
+			CONST UINT c = (e + 2) % 3;
+
+			// Top-left fill rule: pixels exactly on a right or bottom edge belong to the neighbouring triangle
+			BOOL bTop = ((t.Y[a] == t.Y[c]) && (t.X[c] > t.X[a])) ? TRUE : FALSE;
+			BOOL bLeft = (t.Y[c] < t.Y[a]) ? TRUE : FALSE;
+			int64_t Bias = ((bTop == TRUE) || (bLeft == TRUE)) ? 0 : -1;
+
+			StepX[e] = static_cast<int64_t>(t.Y[a] - t.Y[c]) * (1 << SubpixelBits);
+			StepY[e] = static_cast<int64_t>(t.X[c] - t.X[a]) * (1 << SubpixelBits);
+			RowStart[e] = static_cast<int64_t>(t.X[c] - t.X[a]) * (PixelY - t.Y[a]) - static_cast<int64_t>(t.Y[c] - t.Y[a]) * (PixelX - t.X[a]) + Bias;
+		}
+
+		CONST FLOAT InvArea = 1.0f / static_cast<FLOAT>(t.Area);
+
+		for (INT y = MinY; y <= MaxY; y++)
+		{
+			uint32_t* pRow = m_pFrameBuffer + static_cast<SIZE_T>(y) * m_Width;
+			int64_t E0 = RowStart[0];
+			int64_t E1 = RowStart[1];
+			int64_t E2 = RowStart[2];
+
+			for (INT x = MinX; x <= MaxX; x++)
+			{
+				if ((E0 | E1 | E2) >= 0)
+				{
+					FLOAT W0 = static_cast<FLOAT>(E0) * InvArea;
+					FLOAT W1 = static_cast<FLOAT>(E1) * InvArea;
+					FLOAT W2 = static_cast<FLOAT>(E2) * InvArea;
+
+					// Depth clipping, matching DepthClipEnable = TRUE
+					FLOAT Z = W0 * t.Z[0] + W1 * t.Z[1] + W2 * t.Z[2];
+
+					if ((Z >= 0.0f) && (Z <= 1.0f))
+					{
+						FLOAT Colour[3];
+						FLOAT W = 1.0f / (W0 * t.InvW[0] + W1 * t.InvW[1] + W2 * t.InvW[2]);
+
+						for (UINT i = 0; i < 3; i++)
+						{
+							Colour[i] = (W0 * t.Colour[0][i] + W1 * t.Colour[1][i] + W2 * t.Colour[2][i]) * W;
+						}
+
+						pRow[x] = PackColour(Colour);
+					}
+				}
+
+				E0 += StepX[0];
+				E1 += StepX[1];
+				E2 += StepX[2];
+			}
+
+			RowStart[0] += StepY[0];
+			RowStart[1] += StepY[1];
+			RowStart[2] += StepY[2];
+		}
+	}
+}
+
+VOID CSoftwareRenderer::RasterizeTiles(VOID)
+{
+	CONST UINT nTiles = m_TilesX * m_TilesY;
+
+	for (UINT TileIndex = m_NextTile.fetch_add(1); TileIndex < nTiles; TileIndex = m_NextTile.fetch_add(1))
+	{
+		RasterizeTile(TileIndex);
+	}
+}
+
+VOID CSoftwareRenderer::DispatchTiles(VOID)
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+
+		m_NextTile = 0;
+		m_nBusyWorkers = static_cast<UINT>(m_Workers.size());
+		m_Generation++;
+	}
+
+	m_WorkCondition.notify_all();
+
+	RasterizeTiles();
+
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	m_DoneCondition.wait(Lock, [this] { return m_nBusyWorkers == 0; });
+}
+
+VOID CSoftwareRenderer::WorkerMain(VOID)
+{
+	UINT64 Generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(m_Mutex);
+			m_WorkCondition.wait(Lock, [this, Generation] { return (m_bExit == TRUE) || (m_Generation != Generation); });
+
+			if (m_bExit == TRUE)
+			{
+				break;
+			}
+
+			Generation = m_Generation;
+		}
+
+		RasterizeTiles();
+
+		{
+			std::lock_guard<std::mutex> Lock(m_Mutex);
+
+			if (--m_nBusyWorkers == 0)
+			{
+				m_DoneCondition.notify_one();
+			}
+		}
+	}
+}
+
+CONST uint32_t* CSoftwareRenderer::GetFrameBuffer(ULONG& rWidth, ULONG& rHeight)
+{
+	rWidth = m_Width;
+	rHeight = m_Height;
+
+	return m_pFrameBuffer;
+}
+
+UINT64 CSoftwareRenderer::GetFrameCount(VOID)
+{
+	return m_FrameCount;
+}
+
+IRenderer::RendererType CSoftwareRenderer::GetType(VOID)
+{
+	return RendererType::SOFTWARE;
+}
+
+UINT CSoftwareRenderer::GetPassCount(VOID)
+{
+	// Everything runs on the CPU, the profiler zones cover it
+	return 0;
+}
+
+BOOL CSoftwareRenderer::GetPassTiming(UINT, PassTiming&)
+{
+	return FALSE;
+}
+
+BOOL CSoftwareRenderer::Render(VOID)
+{
+	PROFILE_FUNCTION();
+
+	BOOL Status = TRUE;
+
+	SetupTriangles();
+
+	DispatchTiles();
+
+	m_FrameCount++;
+
+	return Status;
+}
@@ -0,0 +1,94 @@
+#ifndef CSOFTWARERENDERER_HPP
+#define CSOFTWARERENDERER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CBase.hpp"
+#include "CMeshBuilder.hpp"
+#include "Math.hpp"
+
+#include "IRenderer.hpp"
+
+class CSoftwareRenderer : public IRenderer, public CBase
+{
+protected:
+	enum { TileSize = 64, SubpixelBits = 4, MaxWorkers = 16 };
+
+	static CONST FLOAT					ClearColor[];
+
+	struct Triangle
+	{
+		INT		X[3];
+		INT		Y[3];
+		FLOAT	Z[3];
+		FLOAT	InvW[3];
+		FLOAT	Colour[3][3];
+		int64_t	Area;
+		INT		MinX;
+		INT		MinY;
+		INT		MaxX;
+		INT		MaxY;
+	};
+
+	ULONG								m_Width;
+	ULONG								m_Height;
+	UINT								m_TilesX;
+	UINT								m_TilesY;
+	uint32_t*							m_pFrameBuffer;
+	uint32_t							m_ClearValue;
+
+	std::vector<Vertex>					m_Vertices;
+	std::vector<uint32_t>				m_Indices;
+	std::vector<Vec4>					m_ClipPositions;
+	std::vector<Triangle>				m_Triangles;
+	std::vector<std::vector<UINT>>		m_Bins;
+
+	std::vector<std::thread>			m_Workers;
+	std::mutex							m_Mutex;
+	std::condition_variable				m_WorkCondition;
+	std::condition_variable				m_DoneCondition;
+	std::atomic<UINT>					m_NextTile;
+	UINT64								m_Generation;
+	UINT								m_nBusyWorkers;
+	BOOL								m_bExit;
+
+	UINT64								m_FrameCount;
+
+protected:
+	CSoftwareRenderer();
+	~CSoftwareRenderer();
+
+	BOOL Initialize(ULONG Width, ULONG Height);
+	VOID Uninitialize(VOID);
+
+	BOOL CreateBuffers(VOID);
+
+	VOID SetupTriangles(VOID);
+	VOID DispatchTiles(VOID);
+	VOID RasterizeTiles(VOID);
+	VOID RasterizeTile(UINT TileIndex);
+
+	VOID WorkerMain(VOID);
+
+	static uint32_t PackColour(CONST FLOAT* pColour);
+
+public:
+	static CSoftwareRenderer* Create(ULONG Width, ULONG Height);
+	static VOID				  Destroy(CSoftwareRenderer* pRenderer);
+
+	CONST uint32_t* GetFrameBuffer(ULONG& rWidth, ULONG& rHeight);
+	UINT64			GetFrameCount(VOID);
+
+public:
+	virtual RendererType GetType(VOID);
+	virtual BOOL		 Render(VOID);
+
+	virtual UINT		 GetPassCount(VOID);
+	virtual BOOL		 GetPassTiming(UINT Pass, PassTiming& rTiming);
+};
+
+#endif // CSOFTWARERENDERER_HPP
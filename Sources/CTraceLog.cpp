@@ -0,0 +1,242 @@
+#include "CTraceLog.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "Console.hpp"
+
+namespace
+{
+	CONST uint64_t HeaderSize = 256;
+	CONST uint64_t MinRingWords = 1024;
+	CONST uint64_t MaxRingWords = 1ULL << 31;
+
+	thread_local UINT t_TraceThread = 0xFFFFFFFF;
+
+	inline uint64_t GetTicks(VOID)
+	{
+		return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+}
+
+static_assert(sizeof(CTraceLog::Header) <= HeaderSize, "Trace header does not fit its section");
+static_assert(sizeof(std::atomic<UINT64>) == sizeof(uint64_t), "Trace head must be a plain 64 bit word in the file");
+
+uint64_t CTraceLog::MakeTag(uint64_t Position, UINT Format, UINT nArguments, UINT Thread)
+{
+	// The complement keeps a zeroed slot that was reserved but never written from passing CheckTag
+	return static_cast<uint64_t>(~static_cast<uint32_t>(Position)) | (static_cast<uint64_t>(Format & 0xFFFF) << 32) | (static_cast<uint64_t>(nArguments & 0xFF) << 48) | (static_cast<uint64_t>(Thread & 0xFF) << 56);
+}
+
+BOOL CTraceLog::CheckTag(uint64_t Tag, uint64_t Position)
+{
+	return (static_cast<uint32_t>(Tag) == static_cast<uint32_t>(~static_cast<uint32_t>(Position))) ? TRUE : FALSE;
+}
+
+UINT CTraceLog::GetTagFormat(uint64_t Tag)
+{
+	return static_cast<UINT>((Tag >> 32) & 0xFFFF);
+}
+
+UINT CTraceLog::GetTagArgumentCount(uint64_t Tag)
+{
+	return static_cast<UINT>((Tag >> 48) & 0xFF);
+}
+
+UINT CTraceLog::GetTagThread(uint64_t Tag)
+{
+	return static_cast<UINT>((Tag >> 56) & 0xFF);
+}
+
+CTraceLog::CTraceLog()
+{
+	m_pHeader = NULL;
+	m_pRing = NULL;
+	m_RingMask = 0;
+	m_pHead = NULL;
+	m_bFormatsFull = FALSE;
+	m_nThreads = 0;
+}
+
+CTraceLog::~CTraceLog()
+{
+	Close();
+}
+
+BOOL CTraceLog::Open(LPCSTR pPath, SIZE_T RingBytes)
+{
+	BOOL Status = TRUE;
+	uint64_t RingWords = MinRingWords;
+
+	Close();
+
+	while ((RingWords < (static_cast<uint64_t>(RingBytes) / sizeof(uint64_t))) && (RingWords < MaxRingWords))
+	{
+		RingWords *= 2;
+	}
+
+	CONST uint64_t RingOffset = HeaderSize + FormatCapacity;
+	CONST uint64_t FileSize = RingOffset + RingWords * sizeof(uint64_t);
+
+	if (m_Mapping.Create(pPath, static_cast<SIZE_T>(FileSize)) != TRUE)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create trace file %s\n", pPath);
+	}
+
+	if (Status == TRUE)
+	{
+		uint8_t* pData = m_Mapping.GetWritableData();
+
+		m_pHeader = reinterpret_cast<Header*>(pData);
+		m_pHeader->Magic = Magic;
+		m_pHeader->Version = Version;
+		m_pHeader->FormatOffset = HeaderSize;
+		m_pHeader->FormatCapacity = FormatCapacity;
+		m_pHeader->RingOffset = RingOffset;
+		m_pHeader->RingWords = RingWords;
+		m_pHeader->ClockNumerator = std::chrono::steady_clock::period::num;
+		m_pHeader->ClockDenominator = std::chrono::steady_clock::period::den;
+		m_pHeader->StartTicks = GetTicks();
+		m_pHeader->FormatCount = 0;
+		m_pHeader->FormatBytes = 0;
+
+		m_pHead = new (&m_pHeader->Head) std::atomic<UINT64>(0);
+		m_pRing = reinterpret_cast<uint64_t*>(pData + RingOffset);
+		m_RingMask = RingWords - 1;
+
+		std::lock_guard<std::mutex> Lock(m_FormatLock);
+
+		m_bFormatsFull = FALSE;
+
+		// Call sites that registered before the file existed
+		for (UINT i = 0; i < m_Formats.size(); i++)
+		{
+			if (StoreFormat(i) != TRUE)
+			{
+				break;
+			}
+		}
+
+		Console::Write("Tracing to %s, %llu KB ring\n", pPath, static_cast<UINT64>((RingWords * sizeof(uint64_t)) / 1024));
+	}
+
+	return Status;
+}
+
+VOID CTraceLog::Close(VOID)
+{
+	if (m_pHeader != NULL)
+	{
+		m_Mapping.Flush();
+		m_Mapping.Close();
+
+		m_pHeader = NULL;
+		m_pRing = NULL;
+		m_RingMask = 0;
+		m_pHead = NULL;
+	}
+}
+
+BOOL CTraceLog::IsOpen(VOID)
+{
+	return (m_pHeader != NULL) ? TRUE : FALSE;
+}
+
+BOOL CTraceLog::StoreFormat(UINT Id)
+{
+	BOOL Status = TRUE;
+
+	CONST Format& rFormat = m_Formats[Id];
+	CONST uint64_t Length = rFormat.Text.size() + 1;
+	CONST uint64_t EntrySize = (sizeof(FormatEntry) + Length + 7) & ~7ULL;
+
+	// Formats are stored in ID order, so once one does not fit none of the later ones are written either
+	if ((m_bFormatsFull == TRUE) || ((m_pHeader->FormatBytes + EntrySize) > m_pHeader->FormatCapacity))
+	{
+		Status = FALSE;
+
+		if (m_bFormatsFull == FALSE)
+		{
+			m_bFormatsFull = TRUE;
+			CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: Trace format table is full, events from format %u on cannot be decoded\n", Id);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		uint8_t* pEntry = m_Mapping.GetWritableData() + m_pHeader->FormatOffset + m_pHeader->FormatBytes;
+
+		FormatEntry Entry = { };
+		Entry.Id = static_cast<uint16_t>(Id);
+		Entry.Level = rFormat.Level;
+		Entry.Length = static_cast<uint32_t>(Length);
+
+		memcpy(pEntry, &Entry, sizeof(FormatEntry));
+		memcpy(pEntry + sizeof(FormatEntry), rFormat.Text.c_str(), static_cast<SIZE_T>(Length));
+
+		m_pHeader->FormatBytes += EntrySize;
+		m_pHeader->FormatCount = Id + 1;
+	}
+
+	return Status;
+}
+
+UINT CTraceLog::RegisterFormat(uint8_t Level, LPCSTR pFormat)
+{
+	UINT Id = InvalidFormat;
+
+	std::lock_guard<std::mutex> Lock(m_FormatLock);
+
+	if (m_Formats.size() < InvalidFormat)
+	{
+		Id = static_cast<UINT>(m_Formats.size());
+
+		Format NewFormat = { };
+		NewFormat.Level = Level;
+		NewFormat.Text = pFormat;
+
+		m_Formats.push_back(NewFormat);
+
+		if (m_pHeader != NULL)
+		{
+			StoreFormat(Id);
+		}
+	}
+
+	return Id;
+}
+
+UINT CTraceLog::GetThread(VOID)
+{
+	if (t_TraceThread == 0xFFFFFFFF)
+	{
+		t_TraceThread = m_nThreads.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return t_TraceThread;
+}
+
+VOID CTraceLog::Write(UINT Format, UINT nArguments, CONST UINT64* pArguments)
+{
+	if ((m_pRing != NULL) && (Format != InvalidFormat))
+	{
+		nArguments = (nArguments < MaxArguments) ? nArguments : MaxArguments;
+
+		// Reserving the words is the only shared write, each record is then filled in without further synchronization
+		CONST uint64_t Position = m_pHead->fetch_add(2 + nArguments, std::memory_order_relaxed);
+
+		m_pRing[(Position + 1) & m_RingMask] = GetTicks();
+
+		for (UINT i = 0; i < nArguments; i++)
+		{
+			m_pRing[(Position + 2 + i) & m_RingMask] = pArguments[i];
+		}
+
+		// The tag goes in last, a record whose tag matches its position is complete
+		std::atomic_thread_fence(std::memory_order_release);
+
+		m_pRing[Position & m_RingMask] = MakeTag(Position, Format, nArguments, GetThread());
+	}
+}
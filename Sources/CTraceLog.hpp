@@ -0,0 +1,113 @@
+#ifndef CTRACELOG_HPP
+#define CTRACELOG_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CFileMapping.hpp"
+
+/*
+* Binary trace file, little endian, written in place through a shared file mapping:
+*
+*	Header
+*	Formats		FormatEntry records, each followed by its NUL terminated format string padded to 8 bytes
+*	Ring		RingWords 64 bit words of trace records, the oldest records are overwritten once it wraps
+*
+* A record is a tag word, a timestamp word and one word per argument. The tag holds the complement of the low 32 bits
+* of the record's absolute word position, which lets a reader tell a complete record from one that was overwritten,
+* torn or never finished. Integers are sign or zero extended to 64 bits, floating point arguments are stored as
+* doubles and pointers as their address. Tools/TraceDecoder turns a trace file back into text or JSON.
+*/
+class CTraceLog
+{
+public:
+	enum : uint32_t
+	{
+		Magic = 0x45435254, // "TRCE"
+		Version = 1,
+		FormatCapacity = 64 * 1024,
+		MaxArguments = 16,
+		InvalidFormat = 0xFFFF
+	};
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t FormatOffset;
+		uint64_t FormatCapacity;
+		uint64_t RingOffset;
+		uint64_t RingWords;
+
+		// Seconds = (Ticks - StartTicks) * ClockNumerator / ClockDenominator
+		uint64_t ClockNumerator;
+		uint64_t ClockDenominator;
+		uint64_t StartTicks;
+
+		// Updated while the trace is open
+		uint32_t FormatCount;
+		uint32_t Reserved;
+		uint64_t FormatBytes;
+		uint64_t Head;
+	};
+
+	struct FormatEntry
+	{
+		uint16_t Id;
+		uint8_t	 Level;
+		uint8_t	 Reserved;
+		uint32_t Length;
+	};
+
+	// Tag word layout
+	static uint64_t MakeTag(uint64_t Position, UINT Format, UINT nArguments, UINT Thread);
+	static BOOL		CheckTag(uint64_t Tag, uint64_t Position);
+	static UINT		GetTagFormat(uint64_t Tag);
+	static UINT		GetTagArgumentCount(uint64_t Tag);
+	static UINT		GetTagThread(uint64_t Tag);
+
+protected:
+	struct Format
+	{
+		uint8_t		Level;
+		std::string Text;
+	};
+
+	CFileMapping		  m_Mapping;
+	Header*				  m_pHeader;
+	uint64_t*			  m_pRing;
+	uint64_t			  m_RingMask;
+	std::atomic<UINT64>*  m_pHead;
+
+	// Formats live in memory too so call sites can register before the file is opened
+	std::mutex			  m_FormatLock;
+	std::vector<Format>	  m_Formats;
+	BOOL				  m_bFormatsFull;
+
+	std::atomic<UINT>	  m_nThreads;
+
+	BOOL StoreFormat(UINT Id);
+	UINT GetThread(VOID);
+
+public:
+	CTraceLog();
+	~CTraceLog();
+
+	// RingBytes is rounded up to a power of two. Open and Close must not race with Write.
+	BOOL Open(LPCSTR pPath, SIZE_T RingBytes);
+	VOID Close(VOID);
+
+	BOOL IsOpen(VOID);
+
+	// Returns InvalidFormat once every ID is taken
+	UINT RegisterFormat(uint8_t Level, LPCSTR pFormat);
+
+	// Does nothing while the trace is closed
+	VOID Write(UINT Format, UINT nArguments, CONST UINT64* pArguments);
+};
+
+#endif // CTRACELOG_HPP
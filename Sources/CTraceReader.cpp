@@ -0,0 +1,346 @@
+#include "CTraceReader.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "Console.hpp"
+
+namespace
+{
+	uint64_t GetArgument(CONST uint64_t* pArguments, UINT nArguments, UINT& rNext)
+	{
+		return (rNext < nArguments) ? pArguments[rNext++] : 0;
+	}
+
+	// Integers were widened to 64 bits when they were traced, narrow them back to the size the format asks for
+	UINT GetIntegerBits(CONST std::string& rLength)
+	{
+		UINT Bits = 32;
+
+		if (rLength == "hh")
+		{
+			Bits = 8;
+		}
+		else if (rLength == "h")
+		{
+			Bits = 16;
+		}
+		else if ((rLength == "ll") || (rLength == "j") || (rLength == "z") || (rLength == "t") || (rLength == "I") || (rLength == "I64"))
+		{
+			Bits = 64;
+		}
+
+		return Bits;
+	}
+}
+
+CTraceReader::CTraceReader()
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+	m_pRing = NULL;
+	m_Position = 0;
+	memset(&m_Statistics, 0, sizeof(m_Statistics));
+}
+
+CTraceReader::~CTraceReader()
+{
+	Close();
+}
+
+BOOL CTraceReader::Open(LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+
+	Close();
+
+	Status = m_Mapping.Open(pPath);
+
+	if (Status == TRUE)
+	{
+		CONST uint64_t Size = m_Mapping.GetSize();
+
+		// A file too small for the header keeps the zeroed one, which fails the magic check
+		if (Size >= sizeof(m_Header))
+		{
+			memcpy(&m_Header, m_Mapping.GetData(), sizeof(m_Header));
+		}
+
+		if ((m_Header.Magic != CTraceLog::Magic) || (m_Header.Version != CTraceLog::Version) ||
+			(m_Header.RingWords == 0) || ((m_Header.RingWords & (m_Header.RingWords - 1)) != 0) ||
+			(m_Header.FormatBytes > m_Header.FormatCapacity) || ((m_Header.FormatOffset + m_Header.FormatCapacity) > m_Header.RingOffset) ||
+			((m_Header.RingOffset + m_Header.RingWords * sizeof(uint64_t)) > Size) || (m_Header.ClockDenominator == 0))
+		{
+			Status = FALSE;
+		}
+
+		if (Status != TRUE)
+		{
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s is not a version %u trace file\n", pPath, CTraceLog::Version);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		Status = ReadFormats();
+	}
+
+	if (Status == TRUE)
+	{
+		m_pRing = reinterpret_cast<CONST uint64_t*>(m_Mapping.GetData() + m_Header.RingOffset);
+
+		// Everything older than one ring length has been overwritten
+		m_Position = (m_Header.Head > m_Header.RingWords) ? (m_Header.Head - m_Header.RingWords) : 0;
+	}
+	else
+	{
+		Close();
+	}
+
+	return Status;
+}
+
+VOID CTraceReader::Close(VOID)
+{
+	m_Mapping.Close();
+
+	memset(&m_Header, 0, sizeof(m_Header));
+	m_pRing = NULL;
+	m_Formats.clear();
+	m_Position = 0;
+	memset(&m_Statistics, 0, sizeof(m_Statistics));
+}
+
+BOOL CTraceReader::ReadFormats(VOID)
+{
+	BOOL Status = TRUE;
+	uint64_t Offset = 0;
+
+	CONST uint8_t* pData = m_Mapping.GetData();
+
+	while ((Status == TRUE) && (m_Formats.size() < m_Header.FormatCount))
+	{
+		CTraceLog::FormatEntry Entry = { };
+
+		if ((Offset + sizeof(Entry)) > m_Header.FormatBytes)
+		{
+			Status = FALSE;
+		}
+
+		if (Status == TRUE)
+		{
+			memcpy(&Entry, pData + m_Header.FormatOffset + Offset, sizeof(Entry));
+
+			if ((Entry.Id != m_Formats.size()) || (Entry.Length == 0) || ((Offset + sizeof(Entry) + Entry.Length) > m_Header.FormatBytes))
+			{
+				Status = FALSE;
+			}
+		}
+
+		if (Status == TRUE)
+		{
+			TraceFormat Format = { };
+			Format.Level = Entry.Level;
+			Format.pText = reinterpret_cast<LPCSTR>(pData + m_Header.FormatOffset + Offset + sizeof(Entry));
+
+			if (Format.pText[Entry.Length - 1] != 0)
+			{
+				Status = FALSE;
+			}
+			else
+			{
+				m_Formats.push_back(Format);
+				Offset += (sizeof(Entry) + Entry.Length + 7) & ~7ULL;
+			}
+		}
+	}
+
+	if (Status != TRUE)
+	{
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Trace format table is corrupt at entry %u\n", static_cast<UINT>(m_Formats.size()));
+	}
+
+	return Status;
+}
+
+BOOL CTraceReader::Read(Record& rRecord)
+{
+	BOOL bFound = FALSE;
+
+	CONST uint64_t Mask = m_Header.RingWords - 1;
+
+	while ((bFound == FALSE) && (m_pRing != NULL) && (m_Position < m_Header.Head))
+	{
+		CONST uint64_t Tag = m_pRing[m_Position & Mask];
+		CONST UINT nArguments = CTraceLog::GetTagArgumentCount(Tag);
+
+		if ((CTraceLog::CheckTag(Tag, m_Position) != TRUE) || (nArguments > CTraceLog::MaxArguments) || ((m_Position + 2 + nArguments) > m_Header.Head))
+		{
+			// Not the start of a complete record, step forward until the tags line up again
+			m_Statistics.SkippedWords++;
+			m_Position++;
+		}
+		else
+		{
+			CONST uint64_t Ticks = m_pRing[(m_Position + 1) & Mask];
+			CONST double SecondsPerTick = static_cast<double>(m_Header.ClockNumerator) / static_cast<double>(m_Header.ClockDenominator);
+
+			rRecord.Format = CTraceLog::GetTagFormat(Tag);
+			rRecord.Thread = CTraceLog::GetTagThread(Tag);
+			rRecord.Seconds = static_cast<double>(static_cast<int64_t>(Ticks - m_Header.StartTicks)) * SecondsPerTick;
+			rRecord.nArguments = nArguments;
+
+			for (UINT i = 0; i < nArguments; i++)
+			{
+				rRecord.Arguments[i] = m_pRing[(m_Position + 2 + i) & Mask];
+			}
+
+			if (rRecord.Format < m_Formats.size())
+			{
+				rRecord.Level = m_Formats[rRecord.Format].Level;
+			}
+			else
+			{
+				rRecord.Level = UnknownLevel;
+				m_Statistics.UnknownFormats++;
+			}
+
+			m_Statistics.Records++;
+			m_Position += 2 + nArguments;
+
+			bFound = TRUE;
+		}
+	}
+
+	return bFound;
+}
+
+VOID CTraceReader::GetText(CONST Record& rRecord, std::string& rText)
+{
+	if (rRecord.Format < m_Formats.size())
+	{
+		FormatRecord(m_Formats[rRecord.Format].pText, rRecord.Arguments, rRecord.nArguments, rText);
+	}
+	else
+	{
+		rText = "<unknown format " + std::to_string(rRecord.Format) + ">";
+	}
+}
+
+CONST CTraceReader::Statistics& CTraceReader::GetStatistics(VOID)
+{
+	return m_Statistics;
+}
+
+VOID CTraceReader::FormatRecord(LPCSTR pFormat, CONST uint64_t* pArguments, UINT nArguments, std::string& rText)
+{
+	CONST std::string Flags = "-+ #0";
+	CHAR Buffer[512] = { };
+	UINT Next = 0;
+
+	rText.clear();
+
+	for (LPCSTR pChar = pFormat; *pChar != 0; pChar++)
+	{
+		if (*pChar != '%')
+		{
+			rText.push_back(*pChar);
+		}
+		else if (pChar[1] == '%')
+		{
+			rText.push_back('%');
+			pChar++;
+		}
+		else
+		{
+			// Rebuild the conversion with a 64 bit length, '*' widths are read from the arguments like printf would
+			std::string Spec = "%";
+			std::string Length;
+
+			for (pChar++; (*pChar != 0) && (Flags.find(*pChar) != std::string::npos); pChar++)
+			{
+				Spec.push_back(*pChar);
+			}
+
+			for (; (*pChar == '*') || (*pChar == '.') || ((*pChar >= '0') && (*pChar <= '9')); pChar++)
+			{
+				if (*pChar == '*')
+				{
+					Spec += std::to_string(static_cast<INT>(GetArgument(pArguments, nArguments, Next)));
+				}
+				else
+				{
+					Spec.push_back(*pChar);
+				}
+			}
+
+			for (; (*pChar != 0) && (strchr("hljztLI", *pChar) != NULL); pChar++)
+			{
+				Length.push_back(*pChar);
+
+				if ((*pChar == 'I') && (((pChar[1] == '3') && (pChar[2] == '2')) || ((pChar[1] == '6') && (pChar[2] == '4'))))
+				{
+					Length.append(pChar + 1, 2);
+					pChar += 2;
+				}
+			}
+
+			CONST CHAR Conversion = *pChar;
+			CONST UINT Bits = GetIntegerBits(Length);
+			CONST uint64_t Mask = (Bits == 64) ? ~0ULL : ((1ULL << Bits) - 1);
+			INT Written = 0;
+
+			if ((Conversion == 'd') || (Conversion == 'i'))
+			{
+				uint64_t Value = GetArgument(pArguments, nArguments, Next) & Mask;
+				uint64_t Sign = 1ULL << (Bits - 1);
+				long long Signed = static_cast<long long>((Value ^ Sign) - Sign);
+
+				Written = snprintf(Buffer, sizeof(Buffer), (Spec + "lld").c_str(), Signed);
+			}
+			else if ((Conversion == 'u') || (Conversion == 'o') || (Conversion == 'x') || (Conversion == 'X'))
+			{
+				unsigned long long Value = GetArgument(pArguments, nArguments, Next) & Mask;
+
+				Written = snprintf(Buffer, sizeof(Buffer), (Spec + "ll" + Conversion).c_str(), Value);
+			}
+			else if (Conversion == 'c')
+			{
+				Written = snprintf(Buffer, sizeof(Buffer), (Spec + "c").c_str(), static_cast<INT>(GetArgument(pArguments, nArguments, Next) & 0xFF));
+			}
+			else if ((Conversion != 0) && (strchr("fFeEgGaA", Conversion) != NULL))
+			{
+				uint64_t Bits64 = GetArgument(pArguments, nArguments, Next);
+				double Value = 0.0;
+				memcpy(&Value, &Bits64, sizeof(Value));
+
+				Written = snprintf(Buffer, sizeof(Buffer), (Spec + Conversion).c_str(), Value);
+			}
+			else if (Conversion == 'p')
+			{
+				Written = snprintf(Buffer, sizeof(Buffer), "0x%016llX", static_cast<unsigned long long>(GetArgument(pArguments, nArguments, Next)));
+			}
+			else
+			{
+				// Strings are rejected when tracing, anything else is passed through untouched
+				Written = snprintf(Buffer, sizeof(Buffer), "<%%%c>", Conversion);
+				Next += (Conversion != 0) ? 1 : 0;
+			}
+
+			if (Written > 0)
+			{
+				rText.append(Buffer, (static_cast<SIZE_T>(Written) < sizeof(Buffer)) ? static_cast<SIZE_T>(Written) : (sizeof(Buffer) - 1));
+			}
+
+			if (Conversion == 0)
+			{
+				break;
+			}
+		}
+	}
+
+	// Every line gets its own line break
+	while ((rText.size() != 0) && ((rText.back() == '\n') || (rText.back() == '\r')))
+	{
+		rText.pop_back();
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef CTRACEREADER_HPP
+#define CTRACEREADER_HPP
+
+#include <string>
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CFileMapping.hpp"
+#include "CTraceLog.hpp"
+
+/*
+* Reads a trace file written by CTraceLog in place from the mapped file. Records come out in the order their space was
+* reserved, the oldest surviving record first. Words of records that were overwritten by the ring wrapping, or that a
+* crash left unfinished, are skipped and counted.
+*/
+class CTraceReader
+{
+public:
+	enum { UnknownLevel = 0xFF };
+
+	struct Record
+	{
+		UINT	 Format;
+		UINT	 Thread;
+		UINT	 Level;
+		double	 Seconds;
+		UINT	 nArguments;
+		uint64_t Arguments[CTraceLog::MaxArguments];
+	};
+
+	struct Statistics
+	{
+		UINT64 Records;
+		UINT64 SkippedWords;
+		UINT64 UnknownFormats;
+	};
+
+protected:
+	struct TraceFormat
+	{
+		uint8_t Level;
+		LPCSTR	pText;
+	};
+
+	CFileMapping			 m_Mapping;
+	CTraceLog::Header		 m_Header;
+	CONST uint64_t*			 m_pRing;
+	std::vector<TraceFormat> m_Formats;
+	uint64_t				 m_Position;
+	Statistics				 m_Statistics;
+
+	BOOL ReadFormats(VOID);
+
+public:
+	CTraceReader();
+	~CTraceReader();
+
+	BOOL Open(LPCSTR pPath);
+	VOID Close(VOID);
+
+	// FALSE once every surviving record has been read. Level is UnknownLevel when the file has no format for the record.
+	BOOL Read(Record& rRecord);
+
+	// The record's format filled in with its arguments
+	VOID GetText(CONST Record& rRecord, std::string& rText);
+
+	CONST Statistics& GetStatistics(VOID);
+
+	// printf with the arguments as they were traced, integers widened to 64 bits and floating point values as doubles.
+	// Missing arguments read as 0 and a trailing line break is dropped.
+	static VOID FormatRecord(LPCSTR pFormat, CONST uint64_t* pArguments, UINT nArguments, std::string& rText);
+};
+
+#endif // CTRACEREADER_HPP
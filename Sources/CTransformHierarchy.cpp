@@ -0,0 +1,326 @@
+#include "CTransformHierarchy.hpp"
+
+#include "Jobs.hpp"
+#include "Profiler.hpp"
+
+// rOrder[i] is the old position of the element that moves to position i
+template <typename T>
+static VOID Permute(std::vector<T>& rArray, CONST std::vector<UINT>& rOrder)
+{
+	std::vector<T> Sorted(rArray.size());
+
+	for (SIZE_T i = 0; i < rOrder.size(); i++)
+	{
+		Sorted[i] = rArray[rOrder[i]];
+	}
+
+	rArray.swap(Sorted);
+}
+
+CTransformHierarchy::CTransformHierarchy()
+{
+	m_SweepFirst = 0;
+	m_nSweepUpdated = 0;
+
+	Clear();
+}
+
+CTransformHierarchy::~CTransformHierarchy()
+{
+}
+
+VOID CTransformHierarchy::Clear(VOID)
+{
+	m_Parent.clear();
+	m_Level.clear();
+	m_ScaleX.clear();
+	m_ScaleY.clear();
+	m_ScaleZ.clear();
+	m_RotationX.clear();
+	m_RotationY.clear();
+	m_RotationZ.clear();
+	m_RotationW.clear();
+	m_TranslationX.clear();
+	m_TranslationY.clear();
+	m_TranslationZ.clear();
+	m_LocalDirty.clear();
+	m_ChangedStamp.clear();
+	m_World.clear();
+
+	m_NodeToIndex.clear();
+	m_LevelStart.clear();
+	m_LevelDirty.clear();
+	m_bSorted = TRUE;
+
+	m_UpdateStamp = 0;
+}
+
+VOID CTransformHierarchy::Reserve(UINT nNodes)
+{
+	m_Parent.reserve(nNodes);
+	m_Level.reserve(nNodes);
+	m_ScaleX.reserve(nNodes);
+	m_ScaleY.reserve(nNodes);
+	m_ScaleZ.reserve(nNodes);
+	m_RotationX.reserve(nNodes);
+	m_RotationY.reserve(nNodes);
+	m_RotationZ.reserve(nNodes);
+	m_RotationW.reserve(nNodes);
+	m_TranslationX.reserve(nNodes);
+	m_TranslationY.reserve(nNodes);
+	m_TranslationZ.reserve(nNodes);
+	m_LocalDirty.reserve(nNodes);
+	m_ChangedStamp.reserve(nNodes);
+	m_World.reserve(nNodes);
+	m_NodeToIndex.reserve(nNodes);
+}
+
+UINT CTransformHierarchy::AddNode(UINT Parent, CONST LocalTransform& rLocal)
+{
+	UINT Node = InvalidNode;
+
+	if ((Parent == InvalidNode) || (Parent < m_NodeToIndex.size()))
+	{
+		CONST UINT Index = static_cast<UINT>(m_Parent.size());
+		CONST UINT ParentIndex = (Parent != InvalidNode) ? m_NodeToIndex[Parent] : InvalidNode;
+
+		// New nodes go to the end, which keeps parents in front of their children until the next sort
+		m_Parent.push_back(ParentIndex);
+		m_Level.push_back((ParentIndex != InvalidNode) ? (m_Level[ParentIndex] + 1) : 0);
+		m_ScaleX.push_back(0.0f);
+		m_ScaleY.push_back(0.0f);
+		m_ScaleZ.push_back(0.0f);
+		m_RotationX.push_back(0.0f);
+		m_RotationY.push_back(0.0f);
+		m_RotationZ.push_back(0.0f);
+		m_RotationW.push_back(1.0f);
+		m_TranslationX.push_back(0.0f);
+		m_TranslationY.push_back(0.0f);
+		m_TranslationZ.push_back(0.0f);
+		m_LocalDirty.push_back(1);
+		m_ChangedStamp.push_back(0);
+		m_World.push_back(Math::Identity());
+
+		Node = static_cast<UINT>(m_NodeToIndex.size());
+		m_NodeToIndex.push_back(Index);
+		m_bSorted = FALSE;
+
+		SetLocal(Node, rLocal);
+	}
+
+	return Node;
+}
+
+VOID CTransformHierarchy::SetLocal(UINT Node, CONST LocalTransform& rLocal)
+{
+	if (Node < m_NodeToIndex.size())
+	{
+		CONST UINT Index = m_NodeToIndex[Node];
+
+		m_ScaleX[Index] = rLocal.Scale.x;
+		m_ScaleY[Index] = rLocal.Scale.y;
+		m_ScaleZ[Index] = rLocal.Scale.z;
+		m_RotationX[Index] = rLocal.Rotation.x;
+		m_RotationY[Index] = rLocal.Rotation.y;
+		m_RotationZ[Index] = rLocal.Rotation.z;
+		m_RotationW[Index] = rLocal.Rotation.w;
+		m_TranslationX[Index] = rLocal.Translation.x;
+		m_TranslationY[Index] = rLocal.Translation.y;
+		m_TranslationZ[Index] = rLocal.Translation.z;
+
+		m_LocalDirty[Index] = 1;
+
+		// Unsorted nodes have no level range yet, the sort marks every level dirty
+		if (m_bSorted == TRUE)
+		{
+			m_LevelDirty[m_Level[Index]] = 1;
+		}
+	}
+}
+
+VOID CTransformHierarchy::GetLocal(UINT Node, LocalTransform& rLocal)
+{
+	if (Node < m_NodeToIndex.size())
+	{
+		CONST UINT Index = m_NodeToIndex[Node];
+
+		rLocal.Scale = Vec3{ m_ScaleX[Index], m_ScaleY[Index], m_ScaleZ[Index] };
+		rLocal.Rotation = Quat{ m_RotationX[Index], m_RotationY[Index], m_RotationZ[Index], m_RotationW[Index] };
+		rLocal.Translation = Vec3{ m_TranslationX[Index], m_TranslationY[Index], m_TranslationZ[Index] };
+	}
+}
+
+VOID CTransformHierarchy::Sort(VOID)
+{
+	PROFILE_FUNCTION();
+
+	CONST UINT nNodes = static_cast<UINT>(m_Parent.size());
+	UINT nLevels = 0;
+
+	for (UINT i = 0; i < nNodes; i++)
+	{
+		nLevels = (m_Level[i] + 1 > nLevels) ? (m_Level[i] + 1) : nLevels;
+	}
+
+	// Counting sort by level, stable so siblings keep the order they were added in
+	m_LevelStart.assign(nLevels + 1, 0);
+
+	for (UINT i = 0; i < nNodes; i++)
+	{
+		m_LevelStart[m_Level[i] + 1]++;
+	}
+
+	for (UINT l = 0; l < nLevels; l++)
+	{
+		m_LevelStart[l + 1] += m_LevelStart[l];
+	}
+
+	std::vector<UINT> Order(nNodes);
+	std::vector<UINT> NewIndex(nNodes);
+	std::vector<UINT> Next(m_LevelStart.begin(), m_LevelStart.end() - 1);
+
+	for (UINT i = 0; i < nNodes; i++)
+	{
+		NewIndex[i] = Next[m_Level[i]]++;
+		Order[NewIndex[i]] = i;
+	}
+
+	Permute(m_Parent, Order);
+	Permute(m_Level, Order);
+	Permute(m_ScaleX, Order);
+	Permute(m_ScaleY, Order);
+	Permute(m_ScaleZ, Order);
+	Permute(m_RotationX, Order);
+	Permute(m_RotationY, Order);
+	Permute(m_RotationZ, Order);
+	Permute(m_RotationW, Order);
+	Permute(m_TranslationX, Order);
+	Permute(m_TranslationY, Order);
+	Permute(m_TranslationZ, Order);
+	Permute(m_LocalDirty, Order);
+	Permute(m_ChangedStamp, Order);
+	Permute(m_World, Order);
+
+	for (UINT i = 0; i < nNodes; i++)
+	{
+		m_Parent[i] = (m_Parent[i] != InvalidNode) ? NewIndex[m_Parent[i]] : InvalidNode;
+	}
+
+	for (SIZE_T n = 0; n < m_NodeToIndex.size(); n++)
+	{
+		m_NodeToIndex[n] = NewIndex[m_NodeToIndex[n]];
+	}
+
+	m_LevelDirty.assign(nLevels, 1);
+	m_bSorted = TRUE;
+}
+
+UINT CTransformHierarchy::SweepRange(UINT First, UINT Count)
+{
+	UINT nUpdated = 0;
+
+	for (UINT i = First; i < First + Count; i++)
+	{
+		CONST UINT Parent = m_Parent[i];
+		CONST BOOL bParentChanged = ((Parent != InvalidNode) && (m_ChangedStamp[Parent] == m_UpdateStamp)) ? TRUE : FALSE;
+
+		// Nothing above this node moved and neither did the node, so its world matrix is still valid
+		if ((m_LocalDirty[i] != 0) || (bParentChanged == TRUE))
+		{
+			CONST Mat4 Local = Math::Compose(
+				Vec3{ m_ScaleX[i], m_ScaleY[i], m_ScaleZ[i] },
+				Quat{ m_RotationX[i], m_RotationY[i], m_RotationZ[i], m_RotationW[i] },
+				Vec3{ m_TranslationX[i], m_TranslationY[i], m_TranslationZ[i] });
+
+			m_World[i] = (Parent != InvalidNode) ? Math::Multiply(Local, m_World[Parent]) : Local;
+			m_LocalDirty[i] = 0;
+			m_ChangedStamp[i] = m_UpdateStamp;
+			nUpdated++;
+		}
+	}
+
+	return nUpdated;
+}
+
+// Levels are swept in chunks of their own range, so First is relative to the level
+VOID CTransformHierarchy::SweepChunk(PVOID pData, UINT, UINT First, UINT Count)
+{
+	CTransformHierarchy* pHierarchy = reinterpret_cast<CTransformHierarchy*>(pData);
+
+	pHierarchy->m_nSweepUpdated.fetch_add(pHierarchy->SweepRange(pHierarchy->m_SweepFirst + First, Count));
+}
+
+UINT CTransformHierarchy::Update(VOID)
+{
+	PROFILE_FUNCTION();
+
+	UINT nUpdated = 0;
+
+	if (m_bSorted == FALSE)
+	{
+		Sort();
+	}
+
+	// Stamps from earlier updates must never match, zero is what new nodes start with
+	m_UpdateStamp = (m_UpdateStamp + 1 != 0) ? (m_UpdateStamp + 1) : 1;
+
+	if (m_UpdateStamp == 1)
+	{
+		m_ChangedStamp.assign(m_ChangedStamp.size(), 0);
+	}
+
+	UINT nPreviousLevelUpdated = 0;
+
+	for (UINT Level = 0; (Level + 1) < m_LevelStart.size(); Level++)
+	{
+		CONST UINT First = m_LevelStart[Level];
+		CONST UINT Count = m_LevelStart[Level + 1] - First;
+		UINT nLevelUpdated = 0;
+
+		// A level can only change if one of its own nodes was set or a node of the level above changed
+		if ((m_LevelDirty[Level] == 0) && (nPreviousLevelUpdated == 0))
+		{
+			continue;
+		}
+
+		if (Count < 2 * MinNodesPerChunk)
+		{
+			nLevelUpdated = SweepRange(First, Count);
+		}
+		else
+		{
+			UINT nChunks = Count / MinNodesPerChunk;
+			nChunks = (nChunks < MaxChunks) ? nChunks : static_cast<UINT>(MaxChunks);
+
+			m_SweepFirst = First;
+			m_nSweepUpdated = 0;
+
+			Jobs::ParallelFor(Count, nChunks, SweepChunk, this);
+
+			nLevelUpdated = m_nSweepUpdated.load();
+		}
+
+		m_LevelDirty[Level] = 0;
+		nPreviousLevelUpdated = nLevelUpdated;
+		nUpdated += nLevelUpdated;
+	}
+
+	return nUpdated;
+}
+
+CONST Mat4& CTransformHierarchy::GetWorld(UINT Node)
+{
+	static CONST Mat4 Identity = Math::Identity();
+
+	return (Node < m_NodeToIndex.size()) ? m_World[m_NodeToIndex[Node]] : Identity;
+}
+
+UINT CTransformHierarchy::GetNodeCount(VOID)
+{
+	return static_cast<UINT>(m_NodeToIndex.size());
+}
+
+UINT CTransformHierarchy::GetLevelCount(VOID)
+{
+	return static_cast<UINT>(m_LevelStart.size() - ((m_LevelStart.empty() == false) ? 1 : 0));
+}
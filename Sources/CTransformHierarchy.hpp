@@ -0,0 +1,84 @@
+#ifndef CTRANSFORMHIERARCHY_HPP
+#define CTRANSFORMHIERARCHY_HPP
+
+#include <atomic>
+#include <vector>
+
+#include "Defines.hpp"
+#include "Math.hpp"
+
+// Local scale, rotation and translation of every node stored as structure of arrays, with one world matrix per node.
+// Nodes are kept sorted by depth, so every level is a contiguous range that follows the level of its parents and the
+// world matrices are computed in one linear sweep. Nodes are addressed by the handle AddNode returns, which stays
+// valid when the storage is sorted again.
+class CTransformHierarchy
+{
+public:
+	enum : UINT { InvalidNode = 0xFFFFFFFF };
+	enum { MinNodesPerChunk = 2048, MaxChunks = 64 };
+
+	struct LocalTransform
+	{
+		Vec3 Scale;
+		Quat Rotation;
+		Vec3 Translation;
+	};
+
+protected:
+	std::vector<UINT>	 m_Parent;
+	std::vector<UINT>	 m_Level;
+	std::vector<FLOAT>	 m_ScaleX;
+	std::vector<FLOAT>	 m_ScaleY;
+	std::vector<FLOAT>	 m_ScaleZ;
+	std::vector<FLOAT>	 m_RotationX;
+	std::vector<FLOAT>	 m_RotationY;
+	std::vector<FLOAT>	 m_RotationZ;
+	std::vector<FLOAT>	 m_RotationW;
+	std::vector<FLOAT>	 m_TranslationX;
+	std::vector<FLOAT>	 m_TranslationY;
+	std::vector<FLOAT>	 m_TranslationZ;
+	std::vector<uint8_t> m_LocalDirty;
+	std::vector<UINT>	 m_ChangedStamp;
+	std::vector<Mat4>	 m_World;
+
+	std::vector<UINT>	 m_NodeToIndex;
+	std::vector<UINT>	 m_LevelStart;
+	std::vector<uint8_t> m_LevelDirty;
+	BOOL				 m_bSorted;
+
+	// A node's world matrix changed in the current update when its stamp equals m_UpdateStamp
+	UINT				 m_UpdateStamp;
+
+	// The level being swept, shared with the jobs that help with it
+	UINT				 m_SweepFirst;
+	std::atomic<UINT>	 m_nSweepUpdated;
+
+	VOID Sort(VOID);
+	UINT SweepRange(UINT First, UINT Count);
+
+	static VOID SweepChunk(PVOID pData, UINT Chunk, UINT First, UINT Count);
+
+public:
+	CTransformHierarchy();
+	~CTransformHierarchy();
+
+	VOID Clear(VOID);
+	VOID Reserve(UINT nNodes);
+
+	// Parent is a handle returned earlier or InvalidNode for a root, returns InvalidNode if the parent does not exist
+	UINT AddNode(UINT Parent, CONST LocalTransform& rLocal);
+
+	VOID SetLocal(UINT Node, CONST LocalTransform& rLocal);
+	VOID GetLocal(UINT Node, LocalTransform& rLocal);
+
+	// Recomputes the world matrix of every node whose local transform or any of whose ancestors changed since the last
+	// update, and returns how many were recomputed. Large levels are split over the job system.
+	UINT Update(VOID);
+
+	CONST Mat4& GetWorld(UINT Node);
+
+	UINT GetNodeCount(VOID);
+	UINT GetLevelCount(VOID);
+};
+
+#endif // CTRANSFORMHIERARCHY_HPP
@@ -0,0 +1,142 @@
+#include "CUploadRing.hpp"
+
+CUploadRing::CUploadRing()
+{
+	m_Capacity = 0;
+	m_Head = 0;
+	m_Tail = 0;
+	m_Used = 0;
+	m_Pending = 0;
+}
+
+CUploadRing::~CUploadRing()
+{
+}
+
+BOOL CUploadRing::Initialize(SIZE_T Capacity)
+{
+	BOOL Status = (Capacity != 0) ? TRUE : FALSE;
+
+	if (Status == TRUE)
+	{
+		Uninitialize();
+		m_Capacity = Capacity;
+	}
+
+	return Status;
+}
+
+VOID CUploadRing::Uninitialize(VOID)
+{
+	m_Capacity = 0;
+	m_Head = 0;
+	m_Tail = 0;
+	m_Used = 0;
+	m_Pending = 0;
+	m_Regions.clear();
+}
+
+BOOL CUploadRing::Allocate(SIZE_T nBytes, SIZE_T Alignment, SIZE_T& rOffset)
+{
+	// Alignment must be a power of two, offsets are aligned relative to the start of the buffer
+	BOOL Status = ((nBytes != 0) && (nBytes <= m_Capacity) && (Alignment != 0) && ((Alignment & (Alignment - 1)) == 0)) ? TRUE : FALSE;
+	SIZE_T Offset = 0;
+	SIZE_T Consumed = 0;
+
+	if ((Status == TRUE) && (m_Used == 0))
+	{
+		// Start over at the beginning whenever the ring drains, it keeps large allocations from wrapping
+		m_Head = 0;
+		m_Tail = 0;
+	}
+
+	if (Status == TRUE)
+	{
+		Offset = (m_Head + Alignment - 1) & ~(Alignment - 1);
+
+		if ((m_Used != 0) && (m_Head == m_Tail))
+		{
+			// Full
+			Status = FALSE;
+		}
+		else if (m_Head >= m_Tail)
+		{
+			// Free space is [Head, Capacity) followed by [0, Tail)
+			if ((Offset <= m_Capacity) && (nBytes <= (m_Capacity - Offset)))
+			{
+				Consumed = Offset + nBytes - m_Head;
+			}
+			else if (nBytes <= m_Tail)
+			{
+				// Skip the end of the buffer, the skipped bytes are released together with this allocation
+				Offset = 0;
+				Consumed = (m_Capacity - m_Head) + nBytes;
+			}
+			else
+			{
+				Status = FALSE;
+			}
+		}
+		else
+		{
+			// Free space is [Head, Tail)
+			if ((Offset <= m_Tail) && (nBytes <= (m_Tail - Offset)))
+			{
+				Consumed = Offset + nBytes - m_Head;
+			}
+			else
+			{
+				Status = FALSE;
+			}
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		m_Head = Offset + nBytes;
+		m_Head = (m_Head == m_Capacity) ? 0 : m_Head;
+		m_Used += Consumed;
+		m_Pending += Consumed;
+
+		rOffset = Offset;
+	}
+
+	return Status;
+}
+
+VOID CUploadRing::Submit(UINT64 FenceValue)
+{
+	if (m_Pending != 0)
+	{
+		Region NewRegion = { FenceValue, m_Head, m_Pending };
+		m_Regions.push_back(NewRegion);
+
+		m_Pending = 0;
+	}
+}
+
+VOID CUploadRing::Reclaim(UINT64 CompletedFenceValue)
+{
+	while ((m_Regions.size() != 0) && (m_Regions.front().FenceValue <= CompletedFenceValue))
+	{
+		m_Tail = m_Regions.front().End;
+		m_Used -= m_Regions.front().Size;
+
+		m_Regions.pop_front();
+	}
+}
+
+SIZE_T CUploadRing::GetCapacity(VOID)
+{
+	return m_Capacity;
+}
+
+SIZE_T CUploadRing::GetUsed(VOID)
+{
+	return m_Used;
+}
+
+UINT CUploadRing::GetRegionCount(VOID)
+{
+	return static_cast<UINT>(m_Regions.size());
+}
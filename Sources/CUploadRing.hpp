@@ -0,0 +1,45 @@
+#ifndef CUPLOADRING_HPP
+#define CUPLOADRING_HPP
+
+#include <deque>
+
+#include "Defines.hpp"
+
+// Offset bookkeeping for a persistently mapped upload buffer, it never touches the GPU itself.
+// Allocations bump the head, Submit tags everything allocated since the last submit with a fence value
+// and Reclaim releases tagged regions, oldest first, once that fence has completed.
+class CUploadRing
+{
+protected:
+	struct Region
+	{
+		UINT64 FenceValue;
+		SIZE_T End;
+		SIZE_T Size;
+	};
+
+	SIZE_T			   m_Capacity;
+	SIZE_T			   m_Head;
+	SIZE_T			   m_Tail;
+	SIZE_T			   m_Used;
+	SIZE_T			   m_Pending;
+	std::deque<Region> m_Regions;
+
+public:
+	CUploadRing();
+	~CUploadRing();
+
+	BOOL Initialize(SIZE_T Capacity);
+	VOID Uninitialize(VOID);
+
+	BOOL Allocate(SIZE_T nBytes, SIZE_T Alignment, SIZE_T& rOffset);
+
+	VOID Submit(UINT64 FenceValue);
+	VOID Reclaim(UINT64 CompletedFenceValue);
+
+	SIZE_T GetCapacity(VOID);
+	SIZE_T GetUsed(VOID);
+	UINT   GetRegionCount(VOID);
+};
+
+#endif // CUPLOADRING_HPP
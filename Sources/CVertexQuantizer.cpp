@@ -0,0 +1,220 @@
+#include "CVertexQuantizer.hpp"
+
+#include <cmath>
+
+#include "Console.hpp"
+
+static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must match the quantized input layout");
+
+uint16_t CVertexQuantizer::EncodeUnorm16(FLOAT Value)
+{
+	Value = (Value < 0.0f) ? 0.0f : ((Value > 1.0f) ? 1.0f : Value);
+
+	return static_cast<uint16_t>(Value * 65535.0f + 0.5f);
+}
+
+uint8_t CVertexQuantizer::EncodeUnorm8(FLOAT Value)
+{
+	Value = (Value < 0.0f) ? 0.0f : ((Value > 1.0f) ? 1.0f : Value);
+
+	return static_cast<uint8_t>(Value * 255.0f + 0.5f);
+}
+
+int16_t CVertexQuantizer::EncodeSnorm16(FLOAT Value)
+{
+	Value = (Value < -1.0f) ? -1.0f : ((Value > 1.0f) ? 1.0f : Value);
+
+	return static_cast<int16_t>(roundf(Value * 32767.0f));
+}
+
+VOID CVertexQuantizer::EncodeOctahedral(CONST FLOAT* pNormal, int16_t* pEncoded)
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower hemisphere over the diagonals
+	FLOAT Sum = fabsf(pNormal[0]) + fabsf(pNormal[1]) + fabsf(pNormal[2]);
+	FLOAT x = (Sum > 0.0f) ? (pNormal[0] / Sum) : 0.0f;
+	FLOAT y = (Sum > 0.0f) ? (pNormal[1] / Sum) : 0.0f;
+	FLOAT z = (Sum > 0.0f) ? (pNormal[2] / Sum) : 1.0f;
+
+	if (z < 0.0f)
+	{
+		FLOAT FoldedX = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		FLOAT FoldedY = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+
+		x = FoldedX;
+		y = FoldedY;
+	}
+
+	pEncoded[0] = EncodeSnorm16(x);
+	pEncoded[1] = EncodeSnorm16(y);
+}
+
+VOID CVertexQuantizer::DecodeOctahedral(CONST int16_t* pEncoded, FLOAT* pNormal)
+{
+	// Mirrors DecodeOctahedral in VertexShader.hlsl, SNORM decoding maps -32768 to -1 as well
+	FLOAT x = (pEncoded[0] < -32767) ? -1.0f : (pEncoded[0] / 32767.0f);
+	FLOAT y = (pEncoded[1] < -32767) ? -1.0f : (pEncoded[1] / 32767.0f);
+	FLOAT z = 1.0f - fabsf(x) - fabsf(y);
+	FLOAT t = (z < 0.0f) ? -z : 0.0f;
+
+	x += (x >= 0.0f) ? -t : t;
+	y += (y >= 0.0f) ? -t : t;
+
+	FLOAT Length = sqrtf(x * x + y * y + z * z);
+
+	pNormal[0] = x / Length;
+	pNormal[1] = y / Length;
+	pNormal[2] = z / Length;
+}
+
+VOID CVertexQuantizer::ComputeNormals(CONST Vertex* pVertices, UINT nVertices, CONST uint32_t* pIndices, UINT nIndices, std::vector<FLOAT>& rNormals)
+{
+	rNormals.assign(3 * static_cast<SIZE_T>(nVertices), 0.0f);
+
+	for (UINT t = 0; (t + 2) < nIndices; t += 3)
+	{
+		CONST FLOAT* p0 = pVertices[pIndices[t + 0]].Position;
+		CONST FLOAT* p1 = pVertices[pIndices[t + 1]].Position;
+		CONST FLOAT* p2 = pVertices[pIndices[t + 2]].Position;
+
+		FLOAT e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		FLOAT e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+		// Clockwise front faces, the unnormalized cross product weights each face by its area
+		FLOAT n[3] =
+		{
+			e0[1] * e1[2] - e0[2] * e1[1],
+			e0[2] * e1[0] - e0[0] * e1[2],
+			e0[0] * e1[1] - e0[1] * e1[0]
+		};
+
+		for (UINT c = 0; c < 3; c++)
+		{
+			for (UINT i = 0; i < 3; i++)
+			{
+				rNormals[3 * pIndices[t + c] + i] += n[i];
+			}
+		}
+	}
+
+	for (UINT v = 0; v < nVertices; v++)
+	{
+		FLOAT* n = &rNormals[3 * v];
+		FLOAT Length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+		if (Length > 0.0f)
+		{
+			n[0] /= Length;
+			n[1] /= Length;
+			n[2] /= Length;
+		}
+		else
+		{
+			n[0] = 0.0f;
+			n[1] = 0.0f;
+			n[2] = 1.0f;
+		}
+	}
+}
+
+BOOL CVertexQuantizer::Quantize(CONST MeshData& rMesh, std::vector<QuantizedVertex>& rVertices, Error& rError)
+{
+	BOOL Status = TRUE;
+
+	if ((rMesh.Format != VERTEX_FORMAT_FLOAT) || (rMesh.pVertices == NULL) || (rMesh.pIndices == NULL))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Only built meshes with float vertices can be quantized\n");
+	}
+
+	if (Status == TRUE)
+	{
+		CONST Vertex* pVertices = reinterpret_cast<CONST Vertex*>(rMesh.pVertices);
+
+		std::vector<uint32_t> Indices(rMesh.IndexCount);
+		std::vector<FLOAT> Normals;
+
+		for (UINT i = 0; i < rMesh.IndexCount; i++)
+		{
+			Indices[i] = (rMesh.IndexSize == sizeof(uint16_t)) ? reinterpret_cast<CONST uint16_t*>(rMesh.pIndices)[i] : reinterpret_cast<CONST uint32_t*>(rMesh.pIndices)[i];
+		}
+
+		ComputeNormals(pVertices, rMesh.VertexCount, Indices.data(), rMesh.IndexCount, Normals);
+
+		rVertices.resize(rMesh.VertexCount);
+		rError = { };
+
+		for (UINT v = 0; v < rMesh.VertexCount; v++)
+		{
+			QuantizedVertex& rQuantized = rVertices[v];
+			FLOAT PositionError = 0.0f;
+
+			for (UINT i = 0; i < 3; i++)
+			{
+				FLOAT Extent = rMesh.BoundsMax[i] - rMesh.BoundsMin[i];
+				FLOAT Normalized = (Extent > 0.0f) ? ((pVertices[v].Position[i] - rMesh.BoundsMin[i]) / Extent) : 0.0f;
+
+				rQuantized.Position[i] = EncodeUnorm16(Normalized);
+				rQuantized.Colour[i] = EncodeUnorm8(pVertices[v].Colour[i]);
+
+				FLOAT Delta = (rMesh.BoundsMin[i] + (rQuantized.Position[i] / 65535.0f) * Extent) - pVertices[v].Position[i];
+				FLOAT ColourDelta = fabsf((rQuantized.Colour[i] / 255.0f) - pVertices[v].Colour[i]);
+
+				PositionError += Delta * Delta;
+				rError.MaxColour = (ColourDelta > rError.MaxColour) ? ColourDelta : rError.MaxColour;
+			}
+
+			rQuantized.Position[3] = 0xFFFF;
+			rQuantized.Colour[3] = 0xFF;
+
+			EncodeOctahedral(&Normals[3 * v], rQuantized.Normal);
+
+			FLOAT Decoded[3] = { };
+			DecodeOctahedral(rQuantized.Normal, Decoded);
+
+			FLOAT Cosine = Decoded[0] * Normals[3 * v + 0] + Decoded[1] * Normals[3 * v + 1] + Decoded[2] * Normals[3 * v + 2];
+			Cosine = (Cosine > 1.0f) ? 1.0f : ((Cosine < -1.0f) ? -1.0f : Cosine);
+
+			FLOAT NormalError = acosf(Cosine) * (180.0f / 3.14159265f);
+
+			PositionError = sqrtf(PositionError);
+			rError.MaxPosition = (PositionError > rError.MaxPosition) ? PositionError : rError.MaxPosition;
+			rError.MaxNormalDegrees = (NormalError > rError.MaxNormalDegrees) ? NormalError : rError.MaxNormalDegrees;
+		}
+	}
+
+	return Status;
+}
+
+BOOL CVertexQuantizer::Dequantize(CONST MeshData& rMesh, std::vector<Vertex>& rVertices)
+{
+	BOOL Status = TRUE;
+
+	if ((rMesh.Format != VERTEX_FORMAT_QUANTIZED) || (rMesh.pVertices == NULL))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Mesh does not hold quantized vertices\n");
+	}
+
+	if (Status == TRUE)
+	{
+		CONST QuantizedVertex* pVertices = reinterpret_cast<CONST QuantizedVertex*>(rMesh.pVertices);
+
+		rVertices.resize(rMesh.VertexCount);
+
+		for (UINT v = 0; v < rMesh.VertexCount; v++)
+		{
+			for (UINT i = 0; i < 3; i++)
+			{
+				rVertices[v].Position[i] = rMesh.BoundsMin[i] + (pVertices[v].Position[i] / 65535.0f) * (rMesh.BoundsMax[i] - rMesh.BoundsMin[i]);
+				rVertices[v].Colour[i] = pVertices[v].Colour[i] / 255.0f;
+			}
+		}
+	}
+
+	return Status;
+}
+
+VOID CVertexQuantizer::PrintError(LPCSTR pName, CONST Error& rError)
+{
+	Console::Write("Mesh %s: quantized to %u bytes per vertex, max error %g position, %.3f degrees normal, %.4f colour\n", pName, static_cast<UINT>(sizeof(QuantizedVertex)), rError.MaxPosition, rError.MaxNormalDegrees, rError.MaxColour);
+}
@@ -0,0 +1,46 @@
+#ifndef CVERTEXQUANTIZER_HPP
+#define CVERTEXQUANTIZER_HPP
+
+#include <vector>
+
+#include "Defines.hpp"
+
+#include "CMeshBuilder.hpp"
+
+// R16G16B16A16_UNORM position within the mesh bounds, R16G16_SNORM octahedral normal, R8G8B8A8_UNORM colour
+struct QuantizedVertex
+{
+	uint16_t Position[4];
+	int16_t	 Normal[2];
+	uint8_t	 Colour[4];
+};
+
+class CVertexQuantizer
+{
+public:
+	struct Error
+	{
+		FLOAT MaxPosition;
+		FLOAT MaxNormalDegrees;
+		FLOAT MaxColour;
+	};
+
+protected:
+	static uint16_t EncodeUnorm16(FLOAT Value);
+	static uint8_t	EncodeUnorm8(FLOAT Value);
+	static int16_t	EncodeSnorm16(FLOAT Value);
+
+	static VOID		EncodeOctahedral(CONST FLOAT* pNormal, int16_t* pEncoded);
+	static VOID		DecodeOctahedral(CONST int16_t* pEncoded, FLOAT* pNormal);
+
+public:
+	// Area weighted vertex normals of an indexed triangle list
+	static VOID ComputeNormals(CONST Vertex* pVertices, UINT nVertices, CONST uint32_t* pIndices, UINT nIndices, std::vector<FLOAT>& rNormals);
+
+	static BOOL Quantize(CONST MeshData& rMesh, std::vector<QuantizedVertex>& rVertices, Error& rError);
+	static BOOL Dequantize(CONST MeshData& rMesh, std::vector<Vertex>& rVertices);
+
+	static VOID PrintError(LPCSTR pName, CONST Error& rError);
+};
+
+#endif // CVERTEXQUANTIZER_HPP
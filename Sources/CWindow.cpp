@@ -4,6 +4,7 @@
 #include <windows.h>
 
 #include "console.hpp"
+#include "Profiler.hpp"
 
 IWindow* IWindow::Create(LPCSTR ClassName, LPCSTR WindowName, ULONG Width, ULONG Height)
 {
@@ -85,7 +86,7 @@ BOOL CWindow::Initialize(LPCSTR ClassName, LPCSTR WindowName, ULONG Width, ULONG
 	if (AdjustWindowRect(&wndRect, WS_OVERLAPPEDWINDOW, FALSE) != TRUE)
 	{
 		Status = FALSE;
-		Console::Write("Error: Could not calculate window bounds\n");
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not calculate window bounds\n");
 	}
 
 	if (Status == TRUE)
@@ -95,7 +96,7 @@ BOOL CWindow::Initialize(LPCSTR ClassName, LPCSTR WindowName, ULONG Width, ULONG
 		if (m_hCID == 0)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not register class\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not register class\n");
 		}
 	}
 
@@ -106,7 +107,7 @@ BOOL CWindow::Initialize(LPCSTR ClassName, LPCSTR WindowName, ULONG Width, ULONG
 		if (m_hWnd == NULL)
 		{
 			Status = FALSE;
-			Console::Write("Error: Could not create window\n");
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not create window\n");
 		}
 	}
 
@@ -176,6 +177,8 @@ LRESULT CWindow::WindowProcedure(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 
 BOOL CWindow::GetEvent(Event& rEvent)
 {
+	PROFILE_FUNCTION();
+
 	BOOL Status = FALSE;
 	MSG msg = { 0 };
 
@@ -0,0 +1,107 @@
+#include "CWorkStealingDeque.hpp"
+
+#include "CPageAllocator.hpp"
+
+PVOID CWorkStealingDeque::operator new(SIZE_T nBytes) noexcept
+{
+	return CPageAllocator::Map(nBytes);
+}
+
+VOID CWorkStealingDeque::operator delete(PVOID pMemory, SIZE_T nBytes)
+{
+	CPageAllocator::Unmap(pMemory, nBytes);
+}
+
+CWorkStealingDeque::CWorkStealingDeque()
+{
+	m_Top = 0;
+	m_Bottom = 0;
+
+	for (UINT i = 0; i < Capacity; i++)
+	{
+		m_Items[i] = NULL;
+	}
+}
+
+CWorkStealingDeque::~CWorkStealingDeque()
+{
+}
+
+BOOL CWorkStealingDeque::Push(PVOID pItem)
+{
+	BOOL Status = TRUE;
+
+	int64_t Bottom = m_Bottom.load(std::memory_order_relaxed);
+	int64_t Top = m_Top.load(std::memory_order_acquire);
+
+	if ((Bottom - Top) >= Capacity)
+	{
+		Status = FALSE;
+	}
+	else
+	{
+		m_Items[Bottom & Mask].store(pItem, std::memory_order_relaxed);
+		m_Bottom.store(Bottom + 1, std::memory_order_release);
+	}
+
+	return Status;
+}
+
+PVOID CWorkStealingDeque::Pop(VOID)
+{
+	PVOID pItem = NULL;
+
+	int64_t Bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+
+	// Claim the bottom slot before looking at top, a thief that read the old bottom has to lose the race below
+	m_Bottom.store(Bottom, std::memory_order_seq_cst);
+
+	int64_t Top = m_Top.load(std::memory_order_seq_cst);
+
+	if (Top <= Bottom)
+	{
+		pItem = m_Items[Bottom & Mask].load(std::memory_order_relaxed);
+
+		if (Top == Bottom)
+		{
+			// Last item, a thief may be taking it at the same time
+			if (m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+			{
+				pItem = NULL;
+			}
+
+			m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+		}
+	}
+	else
+	{
+		m_Bottom.store(Bottom + 1, std::memory_order_relaxed);
+	}
+
+	return pItem;
+}
+
+PVOID CWorkStealingDeque::Steal(VOID)
+{
+	PVOID pItem = NULL;
+
+	int64_t Top = m_Top.load(std::memory_order_seq_cst);
+	int64_t Bottom = m_Bottom.load(std::memory_order_seq_cst);
+
+	if (Top < Bottom)
+	{
+		pItem = m_Items[Top & Mask].load(std::memory_order_relaxed);
+
+		if (m_Top.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+		{
+			pItem = NULL;
+		}
+	}
+
+	return pItem;
+}
+
+BOOL CWorkStealingDeque::IsEmpty(VOID)
+{
+	return (m_Top.load(std::memory_order_relaxed) >= m_Bottom.load(std::memory_order_relaxed)) ? TRUE : FALSE;
+}
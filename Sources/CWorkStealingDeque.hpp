@@ -0,0 +1,36 @@
+#ifndef CWORKSTEALINGDEQUE_HPP
+#define CWORKSTEALINGDEQUE_HPP
+
+#include <atomic>
+
+#include "Defines.hpp"
+
+// Chase-Lev deque with a fixed capacity. The owning thread pushes and pops at the bottom,
+// any other thread may steal from the top. Push fails when the deque is full.
+class CWorkStealingDeque
+{
+protected:
+	enum { Capacity = 4096, Mask = Capacity - 1 };
+
+	// Top and bottom are written by different threads, keep them on separate cache lines
+	alignas(64) std::atomic<int64_t> m_Top;
+	alignas(64) std::atomic<int64_t> m_Bottom;
+	alignas(64) std::atomic<PVOID>	 m_Items[Capacity];
+
+public:
+	// The members are over-aligned, which plain new does not honour before C++17. Deques come from whole pages
+	// instead, new returns NULL when none are left.
+	static PVOID operator new(SIZE_T nBytes) noexcept;
+	static VOID	 operator delete(PVOID pMemory, SIZE_T nBytes);
+
+	CWorkStealingDeque();
+	~CWorkStealingDeque();
+
+	BOOL  Push(PVOID pItem);
+	PVOID Pop(VOID);
+	PVOID Steal(VOID);
+
+	BOOL  IsEmpty(VOID);
+};
+
+#endif // CWORKSTEALINGDEQUE_HPP
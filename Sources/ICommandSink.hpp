@@ -0,0 +1,34 @@
+#ifndef ICOMMANDSINK_HPP
+#define ICOMMANDSINK_HPP
+
+#include "Defines.hpp"
+
+struct DrawCommand
+{
+	UINT IndexCount;
+	UINT InstanceCount;
+	UINT StartIndex;
+	INT	 BaseVertex;
+	UINT StartInstance;
+
+	// Root constants written at offset 0 before the draw, the previous draw's stay in place when this is NULL
+	CONST FLOAT* pConstants;
+	UINT		 nConstants;
+
+	// GPU address of the draw's constant buffer, 0 keeps the one bound for the previous draw
+	UINT64		 ConstantBufferAddress;
+
+	// Pipeline state of the draw in the sink's own terms, NULL keeps the previous draw's
+	PVOID		 pPipeline;
+};
+
+// One recording context, typically a command list. A sink is only ever used by one thread at a time.
+class ICommandSink
+{
+public:
+	virtual BOOL Begin(VOID) = 0;
+	virtual VOID Draw(CONST DrawCommand& rDraw) = 0;
+	virtual BOOL End(VOID) = 0;
+};
+
+#endif // ICOMMANDSINK_HPP
@@ -0,0 +1,14 @@
+#ifndef ILOGSINK_HPP
+#define ILOGSINK_HPP
+
+#include "Defines.hpp"
+
+// Destination for log output, only ever called from the console's writer thread
+class ILogSink
+{
+public:
+	virtual VOID Write(uint8_t Level, LPCSTR pText, SIZE_T Length) = 0;
+	virtual VOID Flush(VOID) = 0;
+};
+
+#endif // ILOGSINK_HPP
@@ -0,0 +1,18 @@
+#ifndef IPIPELINECOMPILER_HPP
+#define IPIPELINECOMPILER_HPP
+
+#include "Defines.hpp"
+
+// Turns the requests handed to CPipelineQueue into pipelines. Requests and pipelines are opaque to the queue, it only
+// hands them back here to be compiled or released.
+class IPipelineCompiler
+{
+public:
+	// Called on one of the queue's threads and may block for as long as the driver takes. NULL when compiling failed.
+	virtual PVOID Compile(PVOID pRequest) = 0;
+
+	virtual VOID ReleaseRequest(PVOID pRequest) = 0;
+	virtual VOID ReleasePipeline(PVOID pPipeline) = 0;
+};
+
+#endif // IPIPELINECOMPILER_HPP
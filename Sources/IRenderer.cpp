@@ -0,0 +1,69 @@
+#include "IRenderer.hpp"
+
+#if defined(_WIN32)
+#include "CRenderer.hpp"
+#endif
+
+#include "CSoftwareRenderer.hpp"
+
+#include "Console.hpp"
+
+IRenderer* IRenderer::Create(RendererType Type, HWND hWND, ULONG Width, ULONG Height)
+{
+	IRenderer* pRenderer = NULL;
+
+	switch (Type)
+	{
+#if defined(_WIN32)
+		case RendererType::D3D12:
+		{
+			pRenderer = CRenderer::Create(hWND, Width, Height);
+			break;
+		}
+#endif
+
+		case RendererType::SOFTWARE:
+		{
+			// The software renderer draws into an offscreen target and never touches the window
+			static_cast<VOID>(hWND);
+			pRenderer = CSoftwareRenderer::Create(Width, Height);
+			break;
+		}
+
+		default:
+		{
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Renderer type %u is not supported on this platform\n", static_cast<UINT>(Type));
+			break;
+		}
+	}
+
+	return pRenderer;
+}
+
+VOID IRenderer::Destroy(IRenderer* pRenderer)
+{
+	if (pRenderer != NULL)
+	{
+		switch (pRenderer->GetType())
+		{
+#if defined(_WIN32)
+			case RendererType::D3D12:
+			{
+				CRenderer::Destroy(static_cast<CRenderer*>(pRenderer));
+				break;
+			}
+#endif
+
+			case RendererType::SOFTWARE:
+			{
+				CSoftwareRenderer::Destroy(static_cast<CSoftwareRenderer*>(pRenderer));
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
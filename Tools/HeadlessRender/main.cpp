@@ -0,0 +1,147 @@
+#include "Defines.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "Console.hpp"
+#include "Hash.hpp"
+#include "Memory.hpp"
+#include "Profiler.hpp"
+
+#include "CSoftwareRenderer.hpp"
+
+/*
+* Renders frames with CSoftwareRenderer, without a window or a GPU, and checks that the picture is the one expected.
+*
+*	HeadlessRender <frames> <width> <height> <output.ppm> [expected hash]
+*
+* The last frame is written as a binary PPM and its hash is printed. The cube turns by a fixed step every frame, so the
+* same frame count always draws the same picture; when an expected hash is given a different one fails the run.
+*/
+
+static BOOL WriteImage(LPCSTR pPath, CONST uint32_t* pPixels, ULONG Width, ULONG Height)
+{
+	BOOL Status = TRUE;
+	std::ofstream File(pPath, std::ios::binary | std::ios::trunc);
+
+	if (File.is_open() == false)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open %s\n", pPath);
+	}
+
+	if (Status == TRUE)
+	{
+		File << "P6\n" << Width << " " << Height << "\n255\n";
+
+		// Pixels are packed RGBA with red in the lowest byte
+		for (ULONG i = 0; i < Width * Height; i++)
+		{
+			CONST CHAR Rgb[3] = { static_cast<CHAR>(pPixels[i] & 0xFF), static_cast<CHAR>((pPixels[i] >> 8) & 0xFF), static_cast<CHAR>((pPixels[i] >> 16) & 0xFF) };
+			File.write(Rgb, sizeof(Rgb));
+		}
+
+		File.close();
+
+		if (File.fail() == true)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to write %s\n", pPath);
+		}
+	}
+
+	return Status;
+}
+
+static BOOL Render(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	CSoftwareRenderer* pRenderer = NULL;
+	UINT nFrames = 0;
+	ULONG Width = 0;
+	ULONG Height = 0;
+
+	if ((ArgC != 5) && (ArgC != 6))
+	{
+		Status = FALSE;
+		Console::Write("Usage: HeadlessRender <frames> <width> <height> <output.ppm> [expected hash]\n");
+	}
+
+	if (Status == TRUE)
+	{
+		nFrames = static_cast<UINT>(strtoul(ArgV[1], NULL, 10));
+		Width = strtoul(ArgV[2], NULL, 10);
+		Height = strtoul(ArgV[3], NULL, 10);
+
+		pRenderer = CSoftwareRenderer::Create(Width, Height);
+
+		if (pRenderer == NULL)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to create the software renderer\n");
+		}
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < nFrames); i++)
+	{
+		Status = pRenderer->Render();
+	}
+
+	if (Status == TRUE)
+	{
+		CONST uint32_t* pPixels = pRenderer->GetFrameBuffer(Width, Height);
+		UINT64 FrameHash = Hash::OffsetBasis;
+
+		// Value by value, so the hash does not depend on the host's endianness
+		for (ULONG i = 0; i < Width * Height; i++)
+		{
+			FrameHash = Hash::Fnv1aValue(pPixels[i], FrameHash);
+		}
+
+		Console::Write("Frame %llu: %lux%lu, hash %016llx\n", pRenderer->GetFrameCount(), Width, Height, FrameHash);
+
+		Status = WriteImage(ArgV[4], pPixels, Width, Height);
+
+		if ((Status == TRUE) && (ArgC == 6) && (strtoull(ArgV[5], NULL, 16) != FrameHash))
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Expected hash %s, the software renderer is no longer deterministic or its output changed\n", ArgV[5]);
+		}
+	}
+
+	CSoftwareRenderer::Destroy(pRenderer);
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Profiler::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Render(ArgC, ArgV);
+	}
+
+	Profiler::Uninitialize();
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
@@ -0,0 +1,306 @@
+#include "Defines.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Console.hpp"
+#include "Jobs.hpp"
+#include "Memory.hpp"
+
+#include "CCommandRecorder.hpp"
+
+/*
+* Times fork-join throughput of the job system and how CCommandRecorder scales with the number of command sinks it
+* records into.
+*
+*	JobBenchmark [repetitions]
+*
+* Fork-join runs batches of jobs on a counter and waits for them, from empty jobs that measure the scheduling overhead
+* alone to jobs long enough for the workers to share them.
+*
+* The sinks are stubs that encode each draw into a word stream, roughly what a command list does on the CPU, so the
+* figures show the cost of splitting and scheduling the work rather than that of a driver. The streams are checked
+* against the original draw order before anything is timed.
+*/
+
+static CONST UINT NumForkJoins = 100;
+static CONST UINT NumDraws = 20000;
+static CONST UINT NumConstants = 16;
+
+// Words a draw and its root constants take up in the stream
+static CONST UINT DrawWords = 6 + NumConstants;
+
+class StubSink : public ICommandSink
+{
+protected:
+	std::vector<uint32_t> m_Stream;
+
+public:
+	StubSink()
+	{
+		m_Stream.reserve(static_cast<SIZE_T>(NumDraws) * DrawWords);
+	}
+
+	virtual BOOL Begin(VOID)
+	{
+		m_Stream.clear();
+		return TRUE;
+	}
+
+	virtual VOID Draw(CONST DrawCommand& rDraw)
+	{
+		m_Stream.push_back(rDraw.IndexCount);
+		m_Stream.push_back(rDraw.InstanceCount);
+		m_Stream.push_back(rDraw.StartIndex);
+		m_Stream.push_back(static_cast<uint32_t>(rDraw.BaseVertex));
+		m_Stream.push_back(rDraw.StartInstance);
+		m_Stream.push_back(static_cast<uint32_t>(rDraw.ConstantBufferAddress));
+
+		for (UINT i = 0; i < NumConstants; i++)
+		{
+			uint32_t Bits = 0;
+			memcpy(&Bits, &rDraw.pConstants[i], sizeof(Bits));
+			m_Stream.push_back(Bits);
+		}
+	}
+
+	virtual BOOL End(VOID)
+	{
+		return TRUE;
+	}
+
+	CONST std::vector<uint32_t>& GetStream(VOID)
+	{
+		return m_Stream;
+	}
+};
+
+static double GetSeconds(std::chrono::steady_clock::time_point Start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+struct SpinData
+{
+	UINT			  nIterations;
+	std::atomic<UINT> nDone;
+};
+
+static VOID SpinJob(PVOID pData)
+{
+	SpinData* pSpin = reinterpret_cast<SpinData*>(pData);
+	volatile UINT Sink = 0;
+
+	for (UINT i = 0; i < pSpin->nIterations; i++)
+	{
+		Sink = Sink + i;
+	}
+
+	pSpin->nDone.fetch_add(1);
+}
+
+static BOOL BenchmarkForkJoin(UINT Repetitions)
+{
+	BOOL Status = TRUE;
+	CONST UINT JobSizes[] = { 0, 1000, 10000 };
+	CONST UINT BatchSizes[] = { 1, 8, 64 };
+
+	Console::Write("Fork-join, %u batches per repetition, %u repetitions\n", NumForkJoins, Repetitions);
+	Console::Write("%-12s %-8s %12s %12s\n", "Iterations", "Jobs", "Per batch", "Per job");
+
+	for (UINT s = 0; (Status == TRUE) && (s < (sizeof(JobSizes) / sizeof(JobSizes[0]))); s++)
+	{
+		for (UINT b = 0; (Status == TRUE) && (b < (sizeof(BatchSizes) / sizeof(BatchSizes[0]))); b++)
+		{
+			SpinData Data;
+			Data.nIterations = JobSizes[s];
+			Data.nDone = 0;
+
+			std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+			for (UINT r = 0; r < Repetitions; r++)
+			{
+				for (UINT f = 0; f < NumForkJoins; f++)
+				{
+					Jobs::Counter Counter;
+
+					for (UINT j = 0; j < BatchSizes[b]; j++)
+					{
+						Jobs::Run(SpinJob, &Data, &Counter);
+					}
+
+					Jobs::Wait(&Counter);
+				}
+			}
+
+			CONST double Seconds = GetSeconds(Start);
+			CONST UINT64 nBatches = static_cast<UINT64>(Repetitions) * NumForkJoins;
+
+			if (Data.nDone.load() != (nBatches * BatchSizes[b]))
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %u of %llu jobs ran\n", Data.nDone.load(), nBatches * BatchSizes[b]);
+			}
+			else
+			{
+				Console::Write("%-12u %-8u %9.2f us %9.1f ns\n", JobSizes[s], BatchSizes[b], Seconds * 1e6 / nBatches, Seconds * 1e9 / (nBatches * BatchSizes[b]));
+			}
+		}
+	}
+
+	return Status;
+}
+
+// Executing the sinks in order has to replay the draws in the order they were given
+static BOOL VerifyOrder(StubSink* pSinks, UINT nSinksUsed)
+{
+	BOOL Status = TRUE;
+	UINT Expected = 0;
+
+	for (UINT s = 0; (Status == TRUE) && (s < nSinksUsed); s++)
+	{
+		CONST std::vector<uint32_t>& rStream = pSinks[s].GetStream();
+
+		for (SIZE_T w = 0; (Status == TRUE) && (w < rStream.size()); w += DrawWords)
+		{
+			Status = (rStream[w + 4] == Expected++) ? TRUE : FALSE;
+		}
+	}
+
+	if ((Status != TRUE) || (Expected != NumDraws))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: The sinks hold %u draws out of order, expected %u\n", Expected, NumDraws);
+	}
+
+	return Status;
+}
+
+static BOOL BenchmarkRecording(UINT Repetitions)
+{
+	BOOL Status = TRUE;
+
+	std::vector<FLOAT> Constants(static_cast<SIZE_T>(NumDraws) * NumConstants);
+	std::vector<DrawCommand> Draws(NumDraws);
+	std::vector<StubSink> Sinks(CCommandRecorder::MaxSinks);
+	ICommandSink* pSinks[CCommandRecorder::MaxSinks] = { };
+	CCommandRecorder Recorder;
+
+	for (UINT i = 0; i < NumDraws; i++)
+	{
+		for (UINT c = 0; c < NumConstants; c++)
+		{
+			Constants[i * NumConstants + c] = static_cast<FLOAT>(i + c);
+		}
+
+		Draws[i] = { 36, 1, 0, 0, i, &Constants[i * NumConstants], NumConstants, 0x10000ull * i, NULL };
+	}
+
+	for (UINT i = 0; i < CCommandRecorder::MaxSinks; i++)
+	{
+		pSinks[i] = &Sinks[i];
+	}
+
+	CONST UINT nThreads = Jobs::GetWorkerCount() + 1;
+	double Baseline = 0.0;
+
+	Console::Write("Recording %u draws, %u threads, %u repetitions\n", NumDraws, nThreads, Repetitions);
+	Console::Write("%-8s %12s %8s\n", "Sinks", "Time", "Speedup");
+
+	// One sink per thread is where it should stop scaling, twice that shows what the extra chunks cost
+	for (UINT nSinks = 1; (Status == TRUE) && (nSinks <= CCommandRecorder::MaxSinks) && (nSinks <= (2 * nThreads)); nSinks *= 2)
+	{
+		UINT nSinksUsed = 0;
+
+		Status = Recorder.Record(Draws.data(), NumDraws, pSinks, nSinks, nSinksUsed);
+
+		if (Status == TRUE)
+		{
+			Status = VerifyOrder(Sinks.data(), nSinksUsed);
+		}
+
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+		for (UINT r = 0; (Status == TRUE) && (r < Repetitions); r++)
+		{
+			Status = Recorder.Record(Draws.data(), NumDraws, pSinks, nSinks, nSinksUsed);
+		}
+
+		CONST double Seconds = GetSeconds(Start) / Repetitions;
+		Baseline = (nSinks == 1) ? Seconds : Baseline;
+
+		if (Status == TRUE)
+		{
+			Console::Write("%-8u %9.1f us %7.2fx\n", nSinks, Seconds * 1e6, Baseline / Seconds);
+		}
+	}
+
+	return Status;
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	UINT Repetitions = 200;
+
+	if (ArgC > 2)
+	{
+		Status = FALSE;
+	}
+	else if (ArgC == 2)
+	{
+		Repetitions = static_cast<UINT>(strtoul(ArgV[1], NULL, 10));
+		Status = (Repetitions != 0) ? TRUE : FALSE;
+	}
+
+	if (Status != TRUE)
+	{
+		Console::Write("Usage: JobBenchmark [repetitions]\n");
+	}
+
+	if (Status == TRUE)
+	{
+		Status = BenchmarkForkJoin(Repetitions);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = BenchmarkRecording(Repetitions);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Jobs::Initialize(0) != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Jobs::Uninitialize();
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
@@ -0,0 +1,189 @@
+#include "Defines.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+/*
+* Measures how long a logging call keeps its caller, in nanoseconds per call.
+*
+*	LogBenchmark [messages]
+*
+* Every call is timed on its own and the mean, median, 99th percentile and worst case are reported, with the cost of
+* reading the clock twice shown alongside. Messages are written in bursts that fit the queue and the writer thread
+* drains it between bursts, so the figures are for formatting and queueing rather than for a full queue. Standard
+* output only shows errors while this runs, the messages still reach the other sinks.
+*/
+
+static CONST UINT BurstSize = 512;
+
+enum Case : UINT
+{
+	CASE_SHORT = 0,
+	CASE_FORMATTED = 1,
+	CASE_DEBUG = 2,
+	CASE_ERROR = 3
+};
+
+static UINT64 GetNanoseconds(std::chrono::steady_clock::time_point Start, std::chrono::steady_clock::time_point End)
+{
+	return static_cast<UINT64>(std::chrono::duration_cast<std::chrono::nanoseconds>(End - Start).count());
+}
+
+static BOOL Log(Case eCase, UINT i)
+{
+	BOOL Status = TRUE;
+
+	switch (eCase)
+	{
+		case CASE_SHORT:
+			Status = Console::Write("Frame %u\n", i);
+			break;
+		case CASE_FORMATTED:
+			Status = Console::Write("Frame %u: %.3f ms CPU, %.3f ms GPU, %u draws, %llu bytes uploaded, %s\n", i, 0.001 * i, 0.002 * i, i % 1000, 4096ull * i, "ok");
+			break;
+		case CASE_DEBUG:
+			// Compiled out unless CONSOLE_MIN_LEVEL lets debug messages through
+			Status = CONSOLE_LOG(Console::LEVEL_DEBUG, "Frame %u\n", i);
+			break;
+		case CASE_ERROR:
+			Status = CONSOLE_LOG(Console::LEVEL_WARNING, "Warning: Frame %u took %.3f ms\n", i, 0.001 * i);
+			break;
+	}
+
+	return Status;
+}
+
+// Returns the calls that could not be queued
+static UINT Measure(Case eCase, UINT nMessages, std::vector<UINT64>& rLatencies)
+{
+	UINT nDropped = 0;
+
+	rLatencies.resize(nMessages);
+
+	for (UINT i = 0; i < nMessages; i++)
+	{
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		CONST BOOL bQueued = Log(eCase, i);
+		std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now();
+
+		rLatencies[i] = GetNanoseconds(Start, End);
+		nDropped += (bQueued == TRUE) ? 0 : 1;
+
+		if (((i + 1) % BurstSize) == 0)
+		{
+			Console::Flush();
+		}
+	}
+
+	Console::Flush();
+
+	return nDropped;
+}
+
+static VOID Report(LPCSTR pName, std::vector<UINT64>& rLatencies, UINT nDropped)
+{
+	UINT64 Total = 0;
+
+	for (UINT64 Latency : rLatencies)
+	{
+		Total += Latency;
+	}
+
+	std::sort(rLatencies.begin(), rLatencies.end());
+
+	CONST SIZE_T Count = rLatencies.size();
+
+	Console::Write("%-22s %8.1f %8llu %8llu %8llu %8u\n", pName, static_cast<double>(Total) / Count, rLatencies[Count / 2], rLatencies[(Count * 99) / 100], rLatencies[Count - 1], nDropped);
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	UINT nMessages = 100000;
+
+	if (ArgC > 2)
+	{
+		Status = FALSE;
+	}
+	else if (ArgC == 2)
+	{
+		nMessages = static_cast<UINT>(strtoul(ArgV[1], NULL, 10));
+		Status = (nMessages != 0) ? TRUE : FALSE;
+	}
+
+	if (Status != TRUE)
+	{
+		Console::Write("Usage: LogBenchmark [messages]\n");
+	}
+
+	if (Status == TRUE)
+	{
+		CONST Case Cases[] = { CASE_SHORT, CASE_FORMATTED, CASE_DEBUG, CASE_ERROR };
+		CONST LPCSTR Names[] = { "Write, short", "Write, formatted", "CONSOLE_LOG debug", "CONSOLE_LOG warning" };
+
+		std::vector<UINT64> Latencies[sizeof(Cases) / sizeof(Cases[0])];
+		std::vector<UINT64> ClockLatencies(nMessages);
+		UINT nDropped[sizeof(Cases) / sizeof(Cases[0])] = { };
+
+		for (UINT i = 0; i < nMessages; i++)
+		{
+			std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+			std::chrono::steady_clock::time_point End = std::chrono::steady_clock::now();
+
+			ClockLatencies[i] = GetNanoseconds(Start, End);
+		}
+
+		Console::Flush();
+		Console::SetMinLevel(Console::LEVEL_ERROR);
+
+		for (UINT c = 0; c < (sizeof(Cases) / sizeof(Cases[0])); c++)
+		{
+			nDropped[c] = Measure(Cases[c], nMessages, Latencies[c]);
+		}
+
+		Console::SetMinLevel(Console::LEVEL_INFO);
+
+		Console::Write("%u messages per case, minimum level %u, %u hardware threads\n", nMessages, static_cast<UINT>(CONSOLE_MIN_LEVEL), std::thread::hardware_concurrency());
+		Console::Write("%-22s %8s %8s %8s %8s %8s\n", "Call (ns)", "Mean", "Median", "99%", "Max", "Dropped");
+
+		Report("Clock alone", ClockLatencies, 0);
+
+		for (UINT c = 0; c < (sizeof(Cases) / sizeof(Cases[0])); c++)
+		{
+			Report(Names[c], Latencies[c], nDropped[c]);
+		}
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
@@ -0,0 +1,377 @@
+#include "Defines.hpp"
+#include "Math.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "Console.hpp"
+#include "Jobs.hpp"
+#include "Memory.hpp"
+
+#include "CInstanceBuilder.hpp"
+#include "CTransformHierarchy.hpp"
+
+/*
+* Times the SIMD kernels in Math.hpp against their scalar references, then the world matrix sweep of a
+* CTransformHierarchy with 100k nodes and the culling and compaction of 100k instances by a CInstanceBuilder.
+*
+*	MathBenchmark [repetitions]
+*
+* The instruction set is fixed when this is compiled, so build it once per target (e.g. -msse2, -mavx, -mavx2 -mfma or
+* MATH_SCALAR) to compare them. Both paths are checked against each other before anything is timed.
+*/
+
+// Interleaved like the renderer's vertex buffers, positions are read with a stride
+struct BenchmarkVertex
+{
+	FLOAT Position[3];
+	FLOAT Colour[3];
+};
+
+static CONST UINT NumMatrices = 1024;
+static CONST UINT NumPoints = 4096;
+static CONST UINT NumHierarchyNodes = 100000;
+static CONST UINT NumInstanceColumns = 400;
+static CONST UINT NumInstanceRows = 250;
+
+static FLOAT Random(VOID)
+{
+	return static_cast<FLOAT>(rand()) / static_cast<FLOAT>(RAND_MAX) * 2.0f - 1.0f;
+}
+
+static BOOL IsClose(FLOAT a, FLOAT b)
+{
+	return fabsf(a - b) <= 1e-4f * (1.0f + fabsf(a) + fabsf(b));
+}
+
+static double GetSeconds(std::chrono::steady_clock::time_point Start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+static VOID PrintResult(LPCSTR pName, double ScalarSeconds, double SimdSeconds, UINT64 Operations)
+{
+	CONST double ScalarNs = ScalarSeconds * 1e9 / static_cast<double>(Operations);
+	CONST double SimdNs = SimdSeconds * 1e9 / static_cast<double>(Operations);
+
+	Console::Write("%-18s %9.2f ns %9.2f ns %7.2fx\n", pName, ScalarNs, SimdNs, ScalarNs / SimdNs);
+}
+
+static BOOL Verify(CONST std::vector<Mat4>& rMatrices, CONST std::vector<BenchmarkVertex>& rVertices)
+{
+	BOOL Status = TRUE;
+
+	for (UINT i = 0; (Status == TRUE) && ((i + 1) < NumMatrices); i++)
+	{
+		Mat4 Simd = Math::Multiply(rMatrices[i], rMatrices[i + 1]);
+		Mat4 Reference = Math::Scalar::Multiply(rMatrices[i], rMatrices[i + 1]);
+
+		for (UINT e = 0; e < 16; e++)
+		{
+			if (IsClose(Simd.m[e / 4][e % 4], Reference.m[e / 4][e % 4]) == FALSE)
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Matrix product %u differs from the scalar reference\n", i);
+				break;
+			}
+		}
+	}
+
+	std::vector<Vec4> Simd(NumPoints);
+	std::vector<Vec4> Reference(NumPoints);
+
+	if (Status == TRUE)
+	{
+		Math::TransformPoints(rMatrices[0], rVertices[0].Position, sizeof(BenchmarkVertex), Simd.data(), NumPoints);
+		Math::Scalar::TransformPoints(rMatrices[0], rVertices[0].Position, sizeof(BenchmarkVertex), Reference.data(), NumPoints);
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < NumPoints); i++)
+	{
+		if ((IsClose(Simd[i].x, Reference[i].x) == FALSE) || (IsClose(Simd[i].y, Reference[i].y) == FALSE) ||
+			(IsClose(Simd[i].z, Reference[i].z) == FALSE) || (IsClose(Simd[i].w, Reference[i].w) == FALSE))
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Transformed point %u differs from the scalar reference\n", i);
+		}
+	}
+
+	return Status;
+}
+
+static CTransformHierarchy::LocalTransform RandomTransform(VOID)
+{
+	CTransformHierarchy::LocalTransform Local = { };
+
+	Local.Scale = Vec3{ 1.0f + 0.1f * Random(), 1.0f + 0.1f * Random(), 1.0f + 0.1f * Random() };
+	Local.Rotation = Math::AxisAngle(Math::Normalize(Vec3{ Random(), Random(), Random() + 2.0f }), Random());
+	Local.Translation = Vec3{ Random(), Random(), Random() };
+
+	return Local;
+}
+
+// Every node hangs below a random earlier node, which gives a wide hierarchy about a dozen levels deep
+static VOID BenchmarkHierarchy(UINT Repetitions)
+{
+	CTransformHierarchy Hierarchy;
+	std::vector<UINT> Nodes(NumHierarchyNodes);
+
+	Hierarchy.Reserve(NumHierarchyNodes);
+
+	for (UINT i = 0; i < NumHierarchyNodes; i++)
+	{
+		UINT Parent = (i < 64) ? CTransformHierarchy::InvalidNode : Nodes[static_cast<UINT>(rand()) % i];
+		Nodes[i] = Hierarchy.AddNode(Parent, RandomTransform());
+	}
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	UINT nUpdated = Hierarchy.Update();
+	double Seconds = GetSeconds(Start);
+
+	Console::Write("Hierarchy: %u nodes in %u levels, first update (sort and sweep) %.3f ms\n", Hierarchy.GetNodeCount(), Hierarchy.GetLevelCount(), Seconds * 1e3);
+
+	// Changes are made up front so only the sweeps are timed
+	CONST UINT DirtyCounts[] = { NumHierarchyNodes, NumHierarchyNodes / 100, 1, 0 };
+	CONST LPCSTR DirtyNames[] = { "all nodes set", "1% of nodes set", "one node set", "nothing set" };
+	std::vector<CTransformHierarchy::LocalTransform> Locals(NumHierarchyNodes);
+
+	for (UINT i = 0; i < NumHierarchyNodes; i++)
+	{
+		Hierarchy.GetLocal(Nodes[i], Locals[i]);
+	}
+
+	for (UINT d = 0; d < (sizeof(DirtyCounts) / sizeof(DirtyCounts[0])); d++)
+	{
+		UINT Sweeps = (DirtyCounts[d] == NumHierarchyNodes) ? ((Repetitions + 9) / 10) : Repetitions;
+		UINT64 nTotalUpdated = 0;
+
+		Seconds = 0.0;
+
+		for (UINT r = 0; r < Sweeps; r++)
+		{
+			for (UINT i = 0; i < DirtyCounts[d]; i++)
+			{
+				UINT n = (DirtyCounts[d] == NumHierarchyNodes) ? i : static_cast<UINT>(rand() % NumHierarchyNodes);
+				Hierarchy.SetLocal(Nodes[n], Locals[n]);
+			}
+
+			Start = std::chrono::steady_clock::now();
+			nUpdated = Hierarchy.Update();
+			Seconds += GetSeconds(Start);
+
+			nTotalUpdated += nUpdated;
+		}
+
+		Console::Write("  %-16s %9.1f us per update, %7.1f ns per recomputed node, %llu nodes recomputed per update\n", DirtyNames[d],
+			Seconds * 1e6 / Sweeps, (nTotalUpdated != 0) ? (Seconds * 1e9 / static_cast<double>(nTotalUpdated)) : 0.0, nTotalUpdated / Sweeps);
+	}
+}
+
+// The renderer's field of cubes seen from its camera while the field turns, so the visible share changes every build
+static VOID BenchmarkInstances(UINT Repetitions)
+{
+	CTransformHierarchy Hierarchy;
+	CInstanceBuilder Builder;
+	CONST UINT nInstances = NumInstanceColumns * NumInstanceRows;
+
+	CTransformHierarchy::LocalTransform Field = { Vec3{ 1.0f, 1.0f, 1.0f }, Quat{ 0.0f, 0.0f, 0.0f, 1.0f }, Vec3{ 0.0f, -1.5f, 0.0f } };
+
+	Hierarchy.Reserve(nInstances + 1);
+	Builder.Reserve(nInstances);
+
+	UINT FieldNode = Hierarchy.AddNode(CTransformHierarchy::InvalidNode, Field);
+
+	for (UINT i = 0; i < nInstances; i++)
+	{
+		CONST FLOAT x = (static_cast<FLOAT>(i % NumInstanceColumns) - 0.5f * NumInstanceColumns) * 0.3f;
+		CONST FLOAT z = (static_cast<FLOAT>(i / NumInstanceColumns) - 0.5f * NumInstanceRows) * 0.3f;
+		CONST CTransformHierarchy::LocalTransform Cube = { Vec3{ 0.1f, 0.1f, 0.1f }, Quat{ 0.0f, 0.0f, 0.0f, 1.0f }, Vec3{ x, 0.0f, z } };
+
+		Builder.Add(Hierarchy.AddNode(FieldNode, Cube), 0.87f, Vec4{ 1.0f, 1.0f, 1.0f, 0.5f });
+	}
+
+	CONST Mat4 View = Math::LookAtRH(Vec3{ 0.0f, 0.0f, 3.0f }, Vec3{ 0.0f, 0.0f, 0.0f }, Vec3{ 0.0f, 1.0f, 0.0f });
+	CONST Mat4 ViewProjection = Math::Multiply(View, Math::PerspectiveFovRH(Math::Pi / 4.0f, 16.0f / 9.0f, 0.1f, 100.0f));
+
+	std::vector<InstanceData> Output(nInstances);
+	UINT64 nTotalVisible = 0;
+	double Seconds = 0.0;
+
+	for (UINT r = 0; r < Repetitions; r++)
+	{
+		Field.Rotation = Math::AxisAngle(Vec3{ 0.0f, 1.0f, 0.0f }, static_cast<FLOAT>(r) * 0.05f);
+		Hierarchy.SetLocal(FieldNode, Field);
+		Hierarchy.Update();
+
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		nTotalVisible += Builder.Build(Hierarchy, ViewProjection, Output.data());
+		Seconds += GetSeconds(Start);
+	}
+
+	Console::Write("Instances: %u culled and compacted in %.1f us per build, %llu visible on average\n", nInstances, Seconds * 1e6 / Repetitions, nTotalVisible / Repetitions);
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	UINT Repetitions = 200;
+
+	if (ArgC > 2)
+	{
+		Status = FALSE;
+	}
+	else if (ArgC == 2)
+	{
+		Repetitions = static_cast<UINT>(strtoul(ArgV[1], NULL, 10));
+		Status = (Repetitions != 0) ? TRUE : FALSE;
+	}
+
+	if (Status != TRUE)
+	{
+		Console::Write("Usage: MathBenchmark [repetitions]\n");
+	}
+
+	std::vector<Mat4> Matrices(NumMatrices);
+	std::vector<Mat4> Products(NumMatrices);
+	std::vector<BenchmarkVertex> Vertices(NumPoints);
+	std::vector<Vec4> Points(NumPoints);
+
+	if (Status == TRUE)
+	{
+		srand(1);
+
+		for (UINT i = 0; i < NumMatrices; i++)
+		{
+			for (UINT e = 0; e < 16; e++)
+			{
+				Matrices[i].m[e / 4][e % 4] = Random();
+			}
+		}
+
+		for (UINT i = 0; i < NumPoints; i++)
+		{
+			for (UINT e = 0; e < 3; e++)
+			{
+				Vertices[i].Position[e] = Random();
+				Vertices[i].Colour[e] = Random();
+			}
+		}
+
+		Status = Verify(Matrices, Vertices);
+	}
+
+	if (Status == TRUE)
+	{
+		// The checksum keeps the compiler from discarding work whose results are never read
+		FLOAT Checksum = 0.0f;
+		double Scalar = 0.0;
+		double Simd = 0.0;
+
+		Console::Write("Instruction set: %s, %u repetitions\n", Math::GetInstructionSet(), Repetitions);
+		Console::Write("%-18s %12s %12s %8s\n", "Kernel", "Scalar", Math::GetInstructionSet(), "Speedup");
+
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+		for (UINT r = 0; r < Repetitions; r++)
+		{
+			for (UINT i = 0; (i + 1) < NumMatrices; i++)
+			{
+				Products[i] = Math::Scalar::Multiply(Matrices[i], Matrices[i + 1]);
+			}
+
+			Checksum += Products[r % (NumMatrices - 1)].m[r % 4][0];
+		}
+
+		Scalar = GetSeconds(Start);
+		Start = std::chrono::steady_clock::now();
+
+		for (UINT r = 0; r < Repetitions; r++)
+		{
+			for (UINT i = 0; (i + 1) < NumMatrices; i++)
+			{
+				Products[i] = Math::Multiply(Matrices[i], Matrices[i + 1]);
+			}
+
+			Checksum += Products[r % (NumMatrices - 1)].m[r % 4][0];
+		}
+
+		Simd = GetSeconds(Start);
+		PrintResult("Mat4 multiply", Scalar, Simd, static_cast<UINT64>(Repetitions) * (NumMatrices - 1));
+
+		Start = std::chrono::steady_clock::now();
+
+		for (UINT r = 0; r < Repetitions; r++)
+		{
+			Math::Scalar::TransformPoints(Matrices[r % NumMatrices], Vertices[0].Position, sizeof(BenchmarkVertex), Points.data(), NumPoints);
+			Checksum += Points[r % NumPoints].x;
+		}
+
+		Scalar = GetSeconds(Start);
+		Start = std::chrono::steady_clock::now();
+
+		for (UINT r = 0; r < Repetitions; r++)
+		{
+			Math::TransformPoints(Matrices[r % NumMatrices], Vertices[0].Position, sizeof(BenchmarkVertex), Points.data(), NumPoints);
+			Checksum += Points[r % NumPoints].x;
+		}
+
+		Simd = GetSeconds(Start);
+		PrintResult("Point transform", Scalar, Simd, static_cast<UINT64>(Repetitions) * NumPoints);
+
+		// Inverse has no separate SIMD path, it is timed to keep an eye on its cost
+		UINT nSingular = 0;
+		Start = std::chrono::steady_clock::now();
+
+		for (UINT r = 0; r < Repetitions; r++)
+		{
+			for (UINT i = 0; i < NumMatrices; i++)
+			{
+				nSingular += (Math::Inverse(Matrices[i], Products[i]) == TRUE) ? 0 : 1;
+			}
+
+			Checksum += Products[r % NumMatrices].m[0][r % 4];
+		}
+
+		Simd = GetSeconds(Start);
+		Console::Write("%-18s %9.2f ns\n", "Mat4 inverse", Simd * 1e9 / (static_cast<double>(Repetitions) * NumMatrices));
+
+		Console::Write("Checksum: %f, %u singular matrices\n", Checksum, nSingular);
+
+		BenchmarkHierarchy(Repetitions);
+		BenchmarkInstances(Repetitions);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Jobs::Initialize(0) != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Jobs::Uninitialize();
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
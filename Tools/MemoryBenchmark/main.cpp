@@ -0,0 +1,393 @@
+#include "Defines.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+#include "CHeapAllocator.hpp"
+
+/*
+* Times Memory::Allocate and Memory::Free against the system's malloc and free, then replays a trace of resource
+* allocations against a CHeapAllocator.
+*
+*	MemoryBenchmark [repetitions]
+*
+* Three patterns are timed: a block freed as soon as it is allocated, a batch of live blocks freed in a shuffled order
+* and the same batches on every hardware thread at once. Sizes are drawn from the small size classes with a fixed seed,
+* so each allocator sees the same sequence. The size class hit rates are reported at the end.
+*
+* The heap trace mixes buffer and texture sized placements with frees and resizes, the way streaming fills a heap, and
+* reports the time per operation and how fragmented the heap is left.
+*/
+
+static CONST UINT NumBlocks = 4096;
+static CONST SIZE_T MaxBlockSize = 1024;
+static CONST UINT NumTraceOperations = 100000;
+static CONST UINT64 HeapCapacity = 256ull * 1024 * 1024;
+
+enum TraceOperation : uint8_t
+{
+	TRACE_ALLOCATE = 0,
+	TRACE_FREE = 1,
+	TRACE_REALLOCATE = 2
+};
+
+struct TraceEntry
+{
+	TraceOperation Operation;
+	UINT64		   Size;
+	UINT64		   Alignment;
+	uint32_t	   Pick;
+};
+
+struct Workload
+{
+	std::vector<SIZE_T> Sizes;
+	std::vector<UINT>	FreeOrder;
+};
+
+// Called through volatile pointers, compilers are allowed to remove a malloc that is freed straight away
+static PVOID (*volatile g_pMalloc)(SIZE_T) = malloc;
+static VOID (*volatile g_pFree)(PVOID) = free;
+
+struct SystemAllocator
+{
+	static PVOID Allocate(SIZE_T nBytes)
+	{
+		return g_pMalloc(nBytes);
+	}
+
+	static VOID Free(PVOID pMemory)
+	{
+		g_pFree(pMemory);
+	}
+};
+
+struct SizeClassAllocator
+{
+	static PVOID Allocate(SIZE_T nBytes)
+	{
+		return Memory::Allocate(nBytes, FALSE);
+	}
+
+	static VOID Free(PVOID pMemory)
+	{
+		Memory::Free(pMemory);
+	}
+};
+
+static double GetSeconds(std::chrono::steady_clock::time_point Start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+// Small blocks are far more common than large ones, as they are in the renderer
+static Workload CreateWorkload(UINT Seed)
+{
+	Workload Result;
+	uint32_t State = Seed * 2654435761u + 1;
+
+	Result.Sizes.resize(NumBlocks);
+	Result.FreeOrder.resize(NumBlocks);
+
+	for (UINT i = 0; i < NumBlocks; i++)
+	{
+		State = State * 1664525u + 1013904223u;
+
+		CONST SIZE_T Limit = ((State >> 28) < 12) ? 128 : MaxBlockSize;
+		Result.Sizes[i] = 1 + ((State >> 8) % Limit);
+		Result.FreeOrder[i] = i;
+	}
+
+	for (UINT i = NumBlocks - 1; i > 0; i--)
+	{
+		State = State * 1664525u + 1013904223u;
+		std::swap(Result.FreeOrder[i], Result.FreeOrder[(State >> 8) % (i + 1)]);
+	}
+
+	return Result;
+}
+
+template <typename Allocator>
+static UINT64 RunPairs(CONST Workload& rWorkload, UINT Repetitions)
+{
+	UINT64 Checksum = 0;
+
+	for (UINT r = 0; r < Repetitions; r++)
+	{
+		for (UINT i = 0; i < NumBlocks; i++)
+		{
+			uint8_t* pBlock = reinterpret_cast<uint8_t*>(Allocator::Allocate(rWorkload.Sizes[i]));
+
+			// Touched, or the pair could be dropped
+			pBlock[0] = static_cast<uint8_t>(i);
+			Checksum += pBlock[0];
+
+			Allocator::Free(pBlock);
+		}
+	}
+
+	return Checksum;
+}
+
+template <typename Allocator>
+static UINT64 RunBatches(CONST Workload& rWorkload, UINT Repetitions)
+{
+	UINT64 Checksum = 0;
+	std::vector<uint8_t*> Blocks(NumBlocks);
+
+	for (UINT r = 0; r < Repetitions; r++)
+	{
+		for (UINT i = 0; i < NumBlocks; i++)
+		{
+			Blocks[i] = reinterpret_cast<uint8_t*>(Allocator::Allocate(rWorkload.Sizes[i]));
+			Blocks[i][0] = static_cast<uint8_t>(i);
+		}
+
+		for (UINT i = 0; i < NumBlocks; i++)
+		{
+			Checksum += Blocks[rWorkload.FreeOrder[i]][0];
+			Allocator::Free(Blocks[rWorkload.FreeOrder[i]]);
+		}
+	}
+
+	return Checksum;
+}
+
+template <typename Allocator>
+static double TimeThreads(CONST std::vector<Workload>& rWorkloads, UINT Repetitions, UINT64& rChecksum)
+{
+	std::vector<UINT64> Checksums(rWorkloads.size(), 0);
+	std::vector<std::thread> Threads;
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	for (SIZE_T t = 0; t < rWorkloads.size(); t++)
+	{
+		Threads.emplace_back([&rWorkloads, &Checksums, Repetitions, t]()
+		{
+			Checksums[t] = RunBatches<Allocator>(rWorkloads[t], Repetitions);
+		});
+	}
+
+	for (std::thread& rThread : Threads)
+	{
+		rThread.join();
+	}
+
+	CONST double Seconds = GetSeconds(Start);
+
+	for (UINT64 Checksum : Checksums)
+	{
+		rChecksum += Checksum;
+	}
+
+	return Seconds;
+}
+
+// Sizes are spread evenly over powers of two from 256 bytes to 4 MB, most placements use the 64 KB resource alignment
+static VOID CreateTrace(std::vector<TraceEntry>& rTrace)
+{
+	uint32_t State = 7;
+
+	rTrace.resize(NumTraceOperations);
+
+	for (UINT i = 0; i < NumTraceOperations; i++)
+	{
+		State = State * 1664525u + 1013904223u;
+		CONST uint32_t Kind = (State >> 8) % 20;
+
+		State = State * 1664525u + 1013904223u;
+		CONST UINT64 Base = 256ull << ((State >> 8) % 15);
+
+		State = State * 1664525u + 1013904223u;
+		rTrace[i].Operation = (Kind < 9) ? TRACE_ALLOCATE : ((Kind < 18) ? TRACE_FREE : TRACE_REALLOCATE);
+		rTrace[i].Size = Base + ((State >> 8) % Base);
+		rTrace[i].Alignment = (((State >> 4) % 16) == 0) ? (4ull * 1024 * 1024) : (64ull * 1024);
+		rTrace[i].Pick = State;
+	}
+}
+
+static VOID BenchmarkHeapTrace(UINT Repetitions)
+{
+	std::vector<TraceEntry> Trace;
+	std::vector<CHeapAllocator::Allocation> Live;
+	CHeapAllocator Heap;
+	CHeapAllocator::Statistics Stats = { };
+	UINT64 nFailed = 0;
+	double Seconds = 0.0;
+
+	CreateTrace(Trace);
+	Live.reserve(NumTraceOperations);
+
+	for (UINT r = 0; r < Repetitions; r++)
+	{
+		Heap.Initialize(HeapCapacity);
+		Live.clear();
+
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+		for (CONST TraceEntry& rEntry : Trace)
+		{
+			CHeapAllocator::Allocation NewAllocation = { };
+
+			if ((rEntry.Operation == TRACE_ALLOCATE) || Live.empty())
+			{
+				if (Heap.Allocate(rEntry.Size, rEntry.Alignment, NewAllocation) == TRUE)
+				{
+					Live.push_back(NewAllocation);
+				}
+				else
+				{
+					nFailed++;
+				}
+			}
+			else
+			{
+				CONST SIZE_T Index = rEntry.Pick % Live.size();
+
+				if (rEntry.Operation == TRACE_FREE)
+				{
+					Heap.Free(Live[Index].Handle);
+
+					Live[Index] = Live.back();
+					Live.pop_back();
+				}
+				else if (Heap.Reallocate(Live[Index], rEntry.Size, rEntry.Alignment, NewAllocation) == TRUE)
+				{
+					// The contents would be copied here when the allocation moved
+					if (NewAllocation.Handle != Live[Index].Handle)
+					{
+						Heap.Free(Live[Index].Handle);
+					}
+
+					Live[Index] = NewAllocation;
+				}
+				else
+				{
+					nFailed++;
+				}
+			}
+		}
+
+		Seconds += GetSeconds(Start);
+	}
+
+	Heap.GetStatistics(Stats);
+
+	Console::Write("Heap trace: %u operations in %.1f ns each, %llu failed, %u live allocations left %.1f%% fragmented\n", NumTraceOperations, Seconds * 1e9 / (static_cast<double>(Repetitions) * NumTraceOperations), nFailed / Repetitions, Stats.Allocations, Stats.Fragmentation * 100.0f);
+}
+
+static VOID PrintResult(LPCSTR pName, double SystemSeconds, double SizeClassSeconds, UINT64 Operations)
+{
+	CONST double SystemNs = SystemSeconds * 1e9 / static_cast<double>(Operations);
+	CONST double SizeClassNs = SizeClassSeconds * 1e9 / static_cast<double>(Operations);
+
+	Console::Write("%-22s %9.2f ns %9.2f ns %7.2fx\n", pName, SystemNs, SizeClassNs, SystemNs / SizeClassNs);
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	UINT Repetitions = 200;
+
+	if (ArgC > 2)
+	{
+		Status = FALSE;
+	}
+	else if (ArgC == 2)
+	{
+		Repetitions = static_cast<UINT>(strtoul(ArgV[1], NULL, 10));
+		Status = (Repetitions != 0) ? TRUE : FALSE;
+	}
+
+	if (Status != TRUE)
+	{
+		Console::Write("Usage: MemoryBenchmark [repetitions]\n");
+	}
+
+	if (Status == TRUE)
+	{
+		CONST UINT nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		std::vector<Workload> Workloads;
+		UINT64 Checksum = 0;
+		double System = 0.0;
+		double SizeClass = 0.0;
+
+		for (UINT t = 0; t < nThreads; t++)
+		{
+			Workloads.push_back(CreateWorkload(t));
+		}
+
+		Console::Write("%u blocks of up to %llu bytes, %u repetitions, %u threads\n", NumBlocks, static_cast<UINT64>(MaxBlockSize), Repetitions, nThreads);
+		Console::Write("%-22s %12s %12s %8s\n", "Pattern", "malloc", "Memory", "Speedup");
+
+		// Both are warmed up first, so neither pays for mapping its first pages inside the timing
+		Checksum += RunBatches<SystemAllocator>(Workloads[0], 1);
+		Checksum += RunBatches<SizeClassAllocator>(Workloads[0], 1);
+
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		Checksum += RunPairs<SystemAllocator>(Workloads[0], Repetitions);
+		System = GetSeconds(Start);
+
+		Start = std::chrono::steady_clock::now();
+		Checksum += RunPairs<SizeClassAllocator>(Workloads[0], Repetitions);
+		SizeClass = GetSeconds(Start);
+
+		PrintResult("Allocate and free", System, SizeClass, static_cast<UINT64>(Repetitions) * NumBlocks);
+
+		Start = std::chrono::steady_clock::now();
+		Checksum += RunBatches<SystemAllocator>(Workloads[0], Repetitions);
+		System = GetSeconds(Start);
+
+		Start = std::chrono::steady_clock::now();
+		Checksum += RunBatches<SizeClassAllocator>(Workloads[0], Repetitions);
+		SizeClass = GetSeconds(Start);
+
+		PrintResult("Batch, shuffled free", System, SizeClass, static_cast<UINT64>(Repetitions) * NumBlocks);
+
+		// Wall time per thread's operation, an allocator that scales perfectly keeps the single threaded figure
+		System = TimeThreads<SystemAllocator>(Workloads, Repetitions, Checksum);
+		SizeClass = TimeThreads<SizeClassAllocator>(Workloads, Repetitions, Checksum);
+
+		PrintResult("Batch, every thread", System, SizeClass, static_cast<UINT64>(Repetitions) * NumBlocks);
+
+		Console::Write("Checksum: %llu\n", Checksum);
+
+		Memory::ReportStatistics();
+
+		BenchmarkHeapTrace(Repetitions);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
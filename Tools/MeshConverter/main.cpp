@@ -0,0 +1,306 @@
+#include "Defines.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+#include "CMeshBuilder.hpp"
+#include "CMeshFile.hpp"
+#include "CMeshOptimizer.hpp"
+#include "CVertexQuantizer.hpp"
+
+/*
+* Converts a Wavefront OBJ file into the binary mesh container read by CMeshFile.
+*
+*	MeshConverter [-keep-winding] [-no-optimize] [-quantize] [-max-acmr <value>] <input.obj> <output.mesh>
+*
+* Supports "v x y z [r g b]" vertices and "f" polygons in any of the v, v/vt, v//vn or v/vt/vn forms,
+* including negative (relative) indices. Polygons are fanned into triangles. OBJ faces are counter-clockwise,
+* so the winding is flipped to the clockwise front faces used by the renderers unless -keep-winding is given.
+* -quantize stores 16 byte QuantizedVertex data instead of 24 byte float vertices and reports the error it introduces.
+* -max-acmr fails the conversion, without writing the output, when the triangle order that would be written transforms
+* more vertices per triangle than the given value in a cache of CMeshOptimizer::DefaultCacheSize entries.
+*/
+
+static BOOL ParseIndex(CONST std::string& rToken, UINT nPositions, UINT& rIndex)
+{
+	BOOL Status = TRUE;
+	CHAR* pEnd = NULL;
+
+	long Value = strtol(rToken.c_str(), &pEnd, 10);
+
+	if ((pEnd == rToken.c_str()) || (Value == 0))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Value = (Value < 0) ? (static_cast<long>(nPositions) + Value) : (Value - 1);
+
+		if ((Value < 0) || (Value >= static_cast<long>(nPositions)))
+		{
+			Status = FALSE;
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		rIndex = static_cast<UINT>(Value);
+	}
+
+	return Status;
+}
+
+static BOOL LoadObj(LPCSTR pPath, BOOL bFlipWinding, CMeshBuilder& rBuilder)
+{
+	BOOL Status = TRUE;
+
+	std::ifstream File(pPath);
+	std::vector<Vertex> Positions;
+	std::vector<UINT> Polygon;
+	std::string Line;
+	UINT LineNumber = 0;
+
+	if (File.is_open() == false)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open %s\n", pPath);
+	}
+
+	while ((Status == TRUE) && std::getline(File, Line))
+	{
+		std::istringstream Stream(Line);
+		std::string Keyword;
+
+		LineNumber++;
+		Stream >> Keyword;
+
+		if (Keyword == "v")
+		{
+			Vertex v = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+
+			if (!(Stream >> v.Position[0] >> v.Position[1] >> v.Position[2]))
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s(%u): Expected three coordinates\n", pPath, LineNumber);
+			}
+
+			// Optional vertex colour extension
+			FLOAT Colour[3] = { };
+
+			if ((Status == TRUE) && (Stream >> Colour[0] >> Colour[1] >> Colour[2]))
+			{
+				memcpy(v.Colour, Colour, sizeof(Colour));
+			}
+
+			Positions.push_back(v);
+		}
+		else if (Keyword == "f")
+		{
+			std::string Token;
+			Polygon.clear();
+
+			while ((Status == TRUE) && (Stream >> Token))
+			{
+				UINT Index = 0;
+
+				if (ParseIndex(Token, static_cast<UINT>(Positions.size()), Index) == TRUE)
+				{
+					Polygon.push_back(Index);
+				}
+				else
+				{
+					Status = FALSE;
+					CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s(%u): Invalid face index %s\n", pPath, LineNumber, Token.c_str());
+				}
+			}
+
+			if ((Status == TRUE) && (Polygon.size() < 3))
+			{
+				Status = FALSE;
+				CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s(%u): Faces need at least three vertices\n", pPath, LineNumber);
+			}
+
+			for (SIZE_T i = 2; (Status == TRUE) && (i < Polygon.size()); i++)
+			{
+				CONST Vertex& rV0 = Positions[Polygon[0]];
+				CONST Vertex& rV1 = Positions[Polygon[i - 1]];
+				CONST Vertex& rV2 = Positions[Polygon[i]];
+
+				if (bFlipWinding == TRUE)
+				{
+					rBuilder.AddTriangle(rV0, rV2, rV1);
+				}
+				else
+				{
+					rBuilder.AddTriangle(rV0, rV1, rV2);
+				}
+			}
+		}
+	}
+
+	return Status;
+}
+
+static BOOL CheckAcmr(LPCSTR pName, CONST MeshData& rMesh, FLOAT MaxAcmr)
+{
+	BOOL Status = TRUE;
+	std::vector<uint32_t> Indices(rMesh.IndexCount);
+	CMeshOptimizer::CacheStatistics Stats = { };
+
+	for (UINT i = 0; i < rMesh.IndexCount; i++)
+	{
+		Indices[i] = (rMesh.IndexSize == sizeof(uint16_t)) ? reinterpret_cast<CONST uint16_t*>(rMesh.pIndices)[i] : reinterpret_cast<CONST uint32_t*>(rMesh.pIndices)[i];
+	}
+
+	CMeshOptimizer::SimulateCache(Indices.data(), rMesh.IndexCount, rMesh.VertexCount, CMeshOptimizer::DefaultCacheSize, Stats);
+
+	if (Stats.Acmr > MaxAcmr)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Mesh %s has an ACMR of %.3f, above the limit of %.3f\n", pName, Stats.Acmr, MaxAcmr);
+	}
+
+	return Status;
+}
+
+static BOOL Convert(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	BOOL bFlipWinding = TRUE;
+	BOOL bOptimize = TRUE;
+	BOOL bQuantize = FALSE;
+	FLOAT MaxAcmr = 0.0f;
+	LPCSTR pInput = NULL;
+	LPCSTR pOutput = NULL;
+
+	for (INT i = 1; i < ArgC; i++)
+	{
+		if (strcmp(ArgV[i], "-keep-winding") == 0)
+		{
+			bFlipWinding = FALSE;
+		}
+		else if (strcmp(ArgV[i], "-no-optimize") == 0)
+		{
+			bOptimize = FALSE;
+		}
+		else if (strcmp(ArgV[i], "-quantize") == 0)
+		{
+			bQuantize = TRUE;
+		}
+		else if ((strcmp(ArgV[i], "-max-acmr") == 0) && ((i + 1) < ArgC))
+		{
+			MaxAcmr = strtof(ArgV[++i], NULL);
+			Status = (MaxAcmr > 0.0f) ? Status : FALSE;
+		}
+		else if (pInput == NULL)
+		{
+			pInput = ArgV[i];
+		}
+		else if (pOutput == NULL)
+		{
+			pOutput = ArgV[i];
+		}
+		else
+		{
+			Status = FALSE;
+		}
+	}
+
+	if ((Status != TRUE) || (pOutput == NULL))
+	{
+		Status = FALSE;
+		Console::Write("Usage: MeshConverter [-keep-winding] [-no-optimize] [-quantize] [-max-acmr <value>] <input.obj> <output.mesh>\n");
+	}
+
+	CMeshBuilder Builder;
+
+	if (Status == TRUE)
+	{
+		Status = LoadObj(pInput, bFlipWinding, Builder);
+	}
+
+	if ((Status == TRUE) && (bOptimize == TRUE))
+	{
+		Status = Builder.Optimize(CMeshOptimizer::DefaultCacheSize);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Builder.Build();
+	}
+
+	MeshData Mesh = { };
+	std::vector<QuantizedVertex> QuantizedVertices;
+
+	if (Status == TRUE)
+	{
+		Builder.PrintStatistics(pInput);
+		Builder.GetMeshData(Mesh);
+	}
+
+	if ((Status == TRUE) && (MaxAcmr > 0.0f))
+	{
+		Status = CheckAcmr(pInput, Mesh, MaxAcmr);
+	}
+
+	if ((Status == TRUE) && (bQuantize == TRUE))
+	{
+		CVertexQuantizer::Error QuantizationError = { };
+
+		Status = CVertexQuantizer::Quantize(Mesh, QuantizedVertices, QuantizationError);
+
+		if (Status == TRUE)
+		{
+			CVertexQuantizer::PrintError(pInput, QuantizationError);
+
+			Mesh.pVertices = QuantizedVertices.data();
+			Mesh.VertexStride = sizeof(QuantizedVertex);
+			Mesh.Format = VERTEX_FORMAT_QUANTIZED;
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		Status = CMeshFile::Write(pOutput, Mesh);
+	}
+
+	if (Status == TRUE)
+	{
+		Console::Write("Wrote %s\n", pOutput);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Convert(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
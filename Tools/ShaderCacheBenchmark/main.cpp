@@ -0,0 +1,232 @@
+#include "Defines.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+#include "CShaderCache.hpp"
+
+/*
+* Times the shader cache without a D3D device: key hashing, a cold start that fills and writes the cache, and a warm
+* start that maps it and reads every blob back.
+*
+*	ShaderCacheBenchmark <cache file> [shader source ...]
+*
+* The cache file is deleted and rebuilt. The blobs are random bytes sized like DXBC, the compile a cold start also pays
+* for on top of the numbers printed here is not included. Sources that are given are hashed with their includes.
+*/
+
+static CONST UINT NumBlobs = 256;
+static CONST UINT MinBlobSize = 2 * 1024;
+static CONST UINT MaxBlobSize = 32 * 1024;
+static CONST UINT HashBufferSize = 16 * 1024 * 1024;
+
+static double GetMilliseconds(std::chrono::steady_clock::time_point Start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+}
+
+static UINT64 GetBlobKey(UINT Index)
+{
+	// The same fields a renderer would add, with the index standing in for the source
+	CShaderKey Key;
+	Key.AddValue(Index);
+	Key.AddString("main");
+	Key.AddString((Index % 2) ? "ps_5_0" : "vs_5_0");
+	Key.AddValue(0);
+
+	return Key.GetKey();
+}
+
+static BOOL BenchmarkHashing(INT nSources, CHAR* pSources[])
+{
+	BOOL Status = TRUE;
+	std::vector<uint8_t> Buffer(HashBufferSize);
+
+	for (SIZE_T i = 0; i < Buffer.size(); i++)
+	{
+		Buffer[i] = static_cast<uint8_t>(rand());
+	}
+
+	CShaderKey Key;
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	Key.Add(Buffer.data(), Buffer.size());
+
+	double Milliseconds = GetMilliseconds(Start);
+	Console::Write("Hash: %.0f MB/s over %u MB (key %016llx)\n", (HashBufferSize / (1024.0 * 1024.0)) / (Milliseconds * 1e-3), HashBufferSize / (1024 * 1024), Key.GetKey());
+
+	for (INT i = 0; (Status == TRUE) && (i < nSources); i++)
+	{
+		CShaderKey SourceKey;
+		Start = std::chrono::steady_clock::now();
+
+		Status = SourceKey.AddFile(pSources[i]);
+		Milliseconds = GetMilliseconds(Start);
+
+		if (Status == TRUE)
+		{
+			Console::Write("Hash: %s with its includes in %.3f ms (key %016llx)\n", pSources[i], Milliseconds, SourceKey.GetKey());
+		}
+	}
+
+	return Status;
+}
+
+static BOOL BenchmarkCache(LPCSTR pPath)
+{
+	BOOL Status = TRUE;
+	std::vector<std::vector<uint8_t>> Blobs(NumBlobs);
+	UINT64 nBytes = 0;
+
+	for (UINT i = 0; i < NumBlobs; i++)
+	{
+		Blobs[i].resize(MinBlobSize + static_cast<UINT>(rand()) % (MaxBlobSize - MinBlobSize));
+
+		for (SIZE_T b = 0; b < Blobs[i].size(); b++)
+		{
+			Blobs[i][b] = static_cast<uint8_t>(rand());
+		}
+
+		nBytes += Blobs[i].size();
+	}
+
+	remove(pPath);
+
+	// Cold: every lookup misses and every blob is stored, then the file is written
+	CShaderCache Cache;
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	Status = Cache.Open(pPath);
+
+	for (UINT i = 0; (Status == TRUE) && (i < NumBlobs); i++)
+	{
+		CONST VOID* pData = NULL;
+		SIZE_T Size = 0;
+
+		if (Cache.Find(GetBlobKey(i), &pData, &Size) == TRUE)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Blob %u was found in an empty cache\n", i);
+		}
+		else
+		{
+			Status = Cache.Store(GetBlobKey(i), Blobs[i].data(), Blobs[i].size(), &pData);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Cache.Save();
+	}
+
+	if (Status == TRUE)
+	{
+		Console::Write("Cold: %u blobs, %.1f KB, looked up, stored and written in %.3f ms\n", NumBlobs, nBytes / 1024.0, GetMilliseconds(Start));
+	}
+
+	// Warm: every lookup hits, each blob is summed so the mapped pages are really loaded. Checked once the clock stops.
+	std::vector<CONST VOID*> Found(NumBlobs, NULL);
+	std::vector<SIZE_T> FoundSizes(NumBlobs, 0);
+	UINT64 Checksum = 0;
+	double LookupMilliseconds = 0.0;
+	double Milliseconds = 0.0;
+
+	if (Status == TRUE)
+	{
+		Start = std::chrono::steady_clock::now();
+		Status = Cache.Open(pPath);
+
+		for (UINT i = 0; (Status == TRUE) && (i < NumBlobs); i++)
+		{
+			std::chrono::steady_clock::time_point LookupStart = std::chrono::steady_clock::now();
+			Status = Cache.Find(GetBlobKey(i), &Found[i], &FoundSizes[i]);
+			LookupMilliseconds += GetMilliseconds(LookupStart);
+
+			for (SIZE_T b = 0; (Status == TRUE) && (b < FoundSizes[i]); b++)
+			{
+				Checksum += reinterpret_cast<CONST uint8_t*>(Found[i])[b];
+			}
+		}
+
+		Milliseconds = GetMilliseconds(Start);
+	}
+
+	if ((Status == TRUE) && (Cache.GetEntryCount() != NumBlobs))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Cache holds %u blobs, expected %u\n", Cache.GetEntryCount(), NumBlobs);
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < NumBlobs); i++)
+	{
+		if ((Found[i] == NULL) || (FoundSizes[i] != Blobs[i].size()) || (memcmp(Found[i], Blobs[i].data(), FoundSizes[i]) != 0))
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Blob %u did not survive the round trip\n", i);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		Console::Write("Warm: %u blobs mapped, found and read in %.3f ms, %.0f ns per lookup (checksum %llu)\n", NumBlobs, Milliseconds, LookupMilliseconds * 1e6 / NumBlobs, Checksum);
+	}
+
+	Cache.Close();
+
+	return Status;
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (ArgC < 2)
+	{
+		Status = FALSE;
+		Console::Write("Usage: ShaderCacheBenchmark <cache file> [shader source ...]\n");
+	}
+
+	if (Status == TRUE)
+	{
+		srand(1);
+		Status = BenchmarkHashing(ArgC - 2, ArgV + 2);
+	}
+
+	if (Status == TRUE)
+	{
+		Status = BenchmarkCache(ArgV[1]);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
@@ -0,0 +1,167 @@
+#include "Defines.hpp"
+
+#include <windows.h>
+
+#include <d3dcompiler.h>
+
+#include <string>
+#include <vector>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+#include "CPermutationRegistry.hpp"
+#include "CSceneShaders.hpp"
+#include "CShaderRegistry.hpp"
+
+/*
+* Compiles every reachable variant of the scene's shaders ahead of time and writes them out as the table
+* CShaderRegistry embeds.
+*
+*	ShaderCompiler <Shaders directory> <EmbeddedShaders.inl>
+*
+* The variants come from CSceneShaders, the same declaration CRenderer checks its permutation against. They are
+* compiled with the flags of a release build at runtime.
+*/
+
+struct CompileContext
+{
+	std::string						  Directory;
+	std::vector<std::string>		  Names;
+	std::vector<std::vector<uint8_t>> Bytecode;
+};
+
+static BOOL CompileVariant(PVOID pContext, CONST CPermutationRegistry::Shader& rShader, CONST CPermutationRegistry::Variant& rVariant, SIZE_T& rBytecodeSize)
+{
+	BOOL Status = TRUE;
+	CompileContext* pCompileContext = reinterpret_cast<CompileContext*>(pContext);
+	ID3DBlob* pShader = NULL;
+	ID3DBlob* pError = NULL;
+
+	D3D_SHADER_MACRO Defines[NumShaderFeatures + 1] = { };
+	rVariant.Permutation.GetDefines(rShader.Features, Defines);
+
+	CONST std::string Name = CShaderRegistry::GetName(rShader.pFileName, rShader.pEntrypoint, rShader.pTarget, Defines);
+	CONST std::string Path = pCompileContext->Directory + rShader.pFileName;
+	WCHAR WidePath[MAX_PATH] = { };
+
+	if (MultiByteToWideChar(CP_UTF8, 0, Path.c_str(), -1, WidePath, MAX_PATH) == 0)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Shader path %s is too long\n", Path.c_str());
+	}
+
+	// The same flags CRenderer::CompileShader uses in a release build
+	if ((Status == TRUE) && (D3DCompileFromFile(WidePath, Defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, rShader.pEntrypoint, rShader.pTarget, 0, 0, &pShader, &pError) != S_OK))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not compile %s\n", Name.c_str());
+
+		if (pError != NULL)
+		{
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error Info: %s\n", pError->GetBufferPointer());
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		CONST uint8_t* pBytes = reinterpret_cast<CONST uint8_t*>(pShader->GetBufferPointer());
+
+		pCompileContext->Names.push_back(Name);
+		pCompileContext->Bytecode.emplace_back(pBytes, pBytes + pShader->GetBufferSize());
+
+		rBytecodeSize = pShader->GetBufferSize();
+		Console::Write("%s: %llu bytes\n", Name.c_str(), static_cast<UINT64>(rBytecodeSize));
+	}
+
+	if (pShader != NULL)
+	{
+		pShader->Release();
+		pShader = NULL;
+	}
+
+	if (pError != NULL)
+	{
+		pError->Release();
+		pError = NULL;
+	}
+
+	return Status;
+}
+
+static BOOL Compile(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	CPermutationRegistry Registry;
+	CompileContext Context;
+	std::vector<CShaderRegistry::Blob> Blobs;
+
+	if (ArgC != 3)
+	{
+		Status = FALSE;
+		Console::Write("Usage: ShaderCompiler <Shaders directory> <EmbeddedShaders.inl>\n");
+	}
+
+	if ((Status == TRUE) && (CSceneShaders::Declare(Registry) != TRUE))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Failed to declare the scene's shaders\n");
+	}
+
+	if (Status == TRUE)
+	{
+		Context.Directory = ArgV[1];
+
+		if ((Context.Directory.empty() == false) && (Context.Directory.back() != '/') && (Context.Directory.back() != '\\'))
+		{
+			Context.Directory += "/";
+		}
+
+		Status = Registry.Compile(CompileVariant, &Context);
+	}
+
+	// Names and bytecode are complete, their storage no longer moves
+	for (SIZE_T i = 0; (Status == TRUE) && (i < Context.Names.size()); i++)
+	{
+		Blobs.push_back({ Context.Names[i].c_str(), Context.Bytecode[i].data(), Context.Bytecode[i].size() });
+	}
+
+	if (Status == TRUE)
+	{
+		Status = CShaderRegistry::Write(ArgV[2], Blobs.data(), static_cast<UINT>(Blobs.size()));
+	}
+
+	if (Status == TRUE)
+	{
+		CONST CPermutationRegistry::Report& rReport = Registry.GetReport();
+
+		Console::Write("Embedded %u reachable variants of %u shaders (%u possible), %llu bytes of bytecode\n", rReport.nCompiled, rReport.nShaders, rReport.nPossible, rReport.BytecodeSize);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Compile(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
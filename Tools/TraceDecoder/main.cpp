@@ -0,0 +1,197 @@
+#include "Defines.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+#include "CTraceReader.hpp"
+
+/*
+* Turns a binary trace written by Console::OpenTrace back into text or JSON.
+*
+*	TraceDecoder [-json] <input.trace> <output>
+*
+* Records are written out in the order their space was reserved, the oldest surviving record first. Records that were
+* overwritten by the ring wrapping, or that a crash left unfinished, are skipped and counted.
+*/
+
+static LPCSTR GetLevelName(UINT Level)
+{
+	static LPCSTR LevelNames[] = { "debug", "info", "warning", "error" };
+
+	return (Level < (sizeof(LevelNames) / sizeof(LevelNames[0]))) ? LevelNames[Level] : "unknown";
+}
+
+static VOID EscapeJson(CONST std::string& rText, std::string& rEscaped)
+{
+	CHAR Buffer[8] = { };
+
+	rEscaped.clear();
+
+	for (SIZE_T i = 0; i < rText.size(); i++)
+	{
+		CONST uint8_t Char = static_cast<uint8_t>(rText[i]);
+
+		if ((Char == '"') || (Char == '\\'))
+		{
+			rEscaped.push_back('\\');
+			rEscaped.push_back(static_cast<CHAR>(Char));
+		}
+		else if (Char < 0x20)
+		{
+			snprintf(Buffer, sizeof(Buffer), "\\u%04x", Char);
+			rEscaped.append(Buffer);
+		}
+		else
+		{
+			rEscaped.push_back(static_cast<CHAR>(Char));
+		}
+	}
+}
+
+static BOOL Decode(CTraceReader& rTrace, BOOL bJson, std::ofstream& rOutput)
+{
+	BOOL Status = TRUE;
+
+	CTraceReader::Record Record = { };
+	std::string Text;
+	std::string Escaped;
+	std::string Line;
+	CHAR Prefix[128] = { };
+
+	if (bJson == TRUE)
+	{
+		rOutput << "[\n";
+	}
+
+	for (BOOL bFirst = TRUE; rTrace.Read(Record) == TRUE; bFirst = FALSE)
+	{
+		rTrace.GetText(Record, Text);
+
+		if (bJson == TRUE)
+		{
+			EscapeJson(Text, Escaped);
+			snprintf(Prefix, sizeof(Prefix), "%s  { \"time\": %.9f, \"thread\": %u, \"level\": \"%s\", \"format\": %u, \"message\": \"",
+					 (bFirst == FALSE) ? ",\n" : "", Record.Seconds, Record.Thread, GetLevelName(Record.Level), Record.Format);
+
+			Line = Prefix + Escaped + "\" }";
+		}
+		else
+		{
+			snprintf(Prefix, sizeof(Prefix), "%14.9f T%-3u %-7s ", Record.Seconds, Record.Thread, GetLevelName(Record.Level));
+
+			Line = Prefix + Text + "\n";
+		}
+
+		rOutput << Line;
+	}
+
+	if (bJson == TRUE)
+	{
+		rOutput << "\n]\n";
+	}
+
+	if (rOutput.good() == false)
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not write the decoded trace\n");
+	}
+
+	return Status;
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	BOOL bJson = FALSE;
+	LPCSTR pInput = NULL;
+	LPCSTR pOutput = NULL;
+
+	for (INT i = 1; i < ArgC; i++)
+	{
+		if (strcmp(ArgV[i], "-json") == 0)
+		{
+			bJson = TRUE;
+		}
+		else if (pInput == NULL)
+		{
+			pInput = ArgV[i];
+		}
+		else if (pOutput == NULL)
+		{
+			pOutput = ArgV[i];
+		}
+		else
+		{
+			Status = FALSE;
+		}
+	}
+
+	if ((Status != TRUE) || (pOutput == NULL))
+	{
+		Status = FALSE;
+		Console::Write("Usage: TraceDecoder [-json] <input.trace> <output>\n");
+	}
+
+	CTraceReader Trace;
+	std::ofstream Output;
+
+	if (Status == TRUE)
+	{
+		Status = Trace.Open(pInput);
+	}
+
+	if (Status == TRUE)
+	{
+		Output.open(pOutput, std::ios::out | std::ios::trunc);
+
+		if (Output.is_open() == false)
+		{
+			Status = FALSE;
+			CONSOLE_LOG(Console::LEVEL_ERROR, "Error: Could not open %s\n", pOutput);
+		}
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Decode(Trace, bJson, Output);
+	}
+
+	if (Status == TRUE)
+	{
+		CONST CTraceReader::Statistics& rStatistics = Trace.GetStatistics();
+
+		Console::Write("Decoded %llu records into %s, skipped %llu words, %llu records had no format\n", rStatistics.Records, pOutput, rStatistics.SkippedWords, rStatistics.UnknownFormats);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}
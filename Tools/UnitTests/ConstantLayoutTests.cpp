@@ -0,0 +1,143 @@
+#include "UnitTests.hpp"
+
+#include <cstring>
+
+#include "CConstantLayout.hpp"
+
+static BOOL TestVectorPacking(VOID)
+{
+	BOOL Status = TRUE;
+	CConstantLayout Layout;
+
+	TEST_CHECK((Layout.GetMemberCount() == 0) && (Layout.GetSize() == 0));
+
+	CONST UINT A = Layout.Add(CConstantLayout::CONSTANT_FLOAT);
+	CONST UINT B = Layout.Add(CConstantLayout::CONSTANT_FLOAT3);
+	CONST UINT C = Layout.Add(CConstantLayout::CONSTANT_FLOAT2);
+	CONST UINT D = Layout.Add(CConstantLayout::CONSTANT_FLOAT3);
+	CONST UINT E = Layout.Add(CConstantLayout::CONSTANT_UINT);
+
+	// The first float3 exactly fills the rest of register 0
+	TEST_CHECK((Layout.GetOffset(A) == 0) && (Layout.GetOffset(B) == 4));
+	TEST_CHECK(Layout.GetOffset(C) == 16);
+
+	// Bytes 24 to 36 would straddle a 16 byte boundary, so the second float3 moves to the next register
+	TEST_CHECK(Layout.GetOffset(D) == 32);
+
+	// A scalar packs into the tail of the float3's register
+	TEST_CHECK(Layout.GetOffset(E) == 44);
+	TEST_CHECK((Layout.GetMemberCount() == 5) && (Layout.GetSize() == 48));
+
+	return Status;
+}
+
+static BOOL TestArraysAndMatrices(VOID)
+{
+	BOOL Status = TRUE;
+	CConstantLayout Layout;
+	CConstantLayout::Member Member = { };
+
+	CONST UINT Scale = Layout.Add(CConstantLayout::CONSTANT_FLOAT);
+	CONST UINT Weights = Layout.Add(CConstantLayout::CONSTANT_FLOAT, 2);
+	CONST UINT Bias = Layout.Add(CConstantLayout::CONSTANT_FLOAT);
+	CONST UINT World = Layout.Add(CConstantLayout::CONSTANT_FLOAT4X4);
+	CONST UINT Normal = Layout.Add(CConstantLayout::CONSTANT_FLOAT3X3);
+	CONST UINT Time = Layout.Add(CConstantLayout::CONSTANT_FLOAT);
+	CONST UINT Offset = Layout.Add(CConstantLayout::CONSTANT_FLOAT2);
+	CONST UINT Bones = Layout.Add(CConstantLayout::CONSTANT_FLOAT4X3, 2);
+
+	// An array starts a new register even when its first element would fit behind Scale, each element takes a whole
+	// register but the last one only holds what it needs
+	TEST_CHECK((Layout.GetOffset(Scale) == 0) && (Layout.GetOffset(Weights) == 16));
+	TEST_CHECK((Layout.GetMember(Weights, Member) == TRUE) && (Member.nElements == 2) && (Member.Size == 20));
+
+	// The rest of the array's last register is still free
+	TEST_CHECK(Layout.GetOffset(Bias) == 36);
+
+	// Matrices start a new register, every row but the last takes a whole one
+	TEST_CHECK((Layout.GetOffset(World) == 48) && (Layout.GetMember(World, Member) == TRUE) && (Member.Size == 64));
+	TEST_CHECK((Layout.GetOffset(Normal) == 112) && (Layout.GetMember(Normal, Member) == TRUE) && (Member.Size == 44));
+
+	// A scalar fits behind the float3x3's last row, a float2 after it would straddle
+	TEST_CHECK((Layout.GetOffset(Time) == 156) && (Layout.GetOffset(Offset) == 160));
+
+	TEST_CHECK((Layout.GetOffset(Bones) == 176) && (Layout.GetMember(Bones, Member) == TRUE) && (Member.Size == 124));
+	TEST_CHECK((Layout.GetMemberCount() == 8) && (Layout.GetSize() == 304));
+
+	return Status;
+}
+
+static BOOL TestWrite(VOID)
+{
+	BOOL Status = TRUE;
+	CConstantLayout Layout;
+	uint8_t Buffer[96];
+
+	CONST FLOAT Normal[9] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f };
+	CONST FLOAT Weights[2] = { 10.0f, 11.0f };
+	CONST FLOAT Time = 12.0f;
+
+	CONST UINT NormalIndex = Layout.Add(CConstantLayout::CONSTANT_FLOAT3X3);
+	CONST UINT TimeIndex = Layout.Add(CConstantLayout::CONSTANT_FLOAT);
+	CONST UINT WeightsIndex = Layout.Add(CConstantLayout::CONSTANT_FLOAT, 2);
+
+	TEST_CHECK(Layout.GetSize() == 80);
+
+	memset(Buffer, 0xCD, sizeof(Buffer));
+
+	Layout.Write(Buffer, NormalIndex, Normal);
+	Layout.Write(Buffer, TimeIndex, &Time);
+	Layout.Write(Buffer, WeightsIndex, Weights);
+
+	// Out of range members are ignored
+	Layout.Write(Buffer, Layout.GetMemberCount(), Weights);
+
+	// Tightly packed rows are spread one register apart and the padding between them is left alone
+	for (UINT Row = 0; Row < 3; Row++)
+	{
+		TEST_CHECK(memcmp(&Buffer[Row * 16], &Normal[Row * 3], 3 * sizeof(FLOAT)) == 0);
+	}
+
+	TEST_CHECK((Buffer[12] == 0xCD) && (Buffer[28] == 0xCD));
+	TEST_CHECK(memcmp(&Buffer[44], &Time, sizeof(FLOAT)) == 0);
+
+	TEST_CHECK(memcmp(&Buffer[48], &Weights[0], sizeof(FLOAT)) == 0);
+	TEST_CHECK(memcmp(&Buffer[64], &Weights[1], sizeof(FLOAT)) == 0);
+	TEST_CHECK((Buffer[52] == 0xCD) && (Buffer[68] == 0xCD) && (Buffer[80] == 0xCD));
+
+	return Status;
+}
+
+static BOOL TestEdgeCases(VOID)
+{
+	BOOL Status = TRUE;
+	CConstantLayout Layout;
+	CConstantLayout::Member Member = { };
+
+	// An array of no elements is a single value
+	CONST UINT Index = Layout.Add(CConstantLayout::CONSTANT_FLOAT4, 0);
+
+	TEST_CHECK((Layout.GetMember(Index, Member) == TRUE) && (Member.nElements == 1) && (Member.Size == 16));
+	TEST_CHECK((Layout.GetMember(Index + 1, Member) == FALSE) && (Layout.GetOffset(Index + 1) == 0));
+
+	Layout.Clear();
+	TEST_CHECK((Layout.GetMemberCount() == 0) && (Layout.GetSize() == 0));
+
+	// Clear starts from offset 0 again
+	Layout.Add(CConstantLayout::CONSTANT_INT);
+	TEST_CHECK((Layout.GetOffset(0) == 0) && (Layout.GetSize() == 16));
+
+	return Status;
+}
+
+BOOL TestConstantLayout(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestVectorPacking() == TRUE) ? Status : FALSE;
+	Status = (TestArraysAndMatrices() == TRUE) ? Status : FALSE;
+	Status = (TestWrite() == TRUE) ? Status : FALSE;
+	Status = (TestEdgeCases() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,112 @@
+#include "UnitTests.hpp"
+
+#include "CFrameScheduler.hpp"
+
+static BOOL TestSlotRotation(VOID)
+{
+	BOOL Status = TRUE;
+	CFrameScheduler Scheduler;
+
+	TEST_CHECK(Scheduler.Initialize(0) == FALSE);
+	TEST_CHECK(Scheduler.Initialize(CFrameScheduler::MaxFramesInFlight + 1) == FALSE);
+
+	for (UINT nFrames = 1; nFrames <= CFrameScheduler::MaxFramesInFlight; nFrames++)
+	{
+		TEST_CHECK((Scheduler.Initialize(nFrames) == TRUE) && (Scheduler.GetFrameCount() == nFrames));
+		TEST_CHECK((Scheduler.GetFrameNumber() == 0) && (Scheduler.GetLatestFence() == 0));
+
+		// Slots are used round robin from 0, frame numbers count from 1
+		for (UINT Frame = 0; Frame < (3 * nFrames); Frame++)
+		{
+			TEST_CHECK(Scheduler.BeginFrame() == (Frame % nFrames));
+			TEST_CHECK((Scheduler.GetSlot() == (Frame % nFrames)) && (Scheduler.GetFrameNumber() == (Frame + 1)));
+
+			Scheduler.EndFrame(Frame + 1);
+		}
+	}
+
+	// Uninitialized, BeginFrame stays where it is
+	Scheduler.Uninitialize();
+	TEST_CHECK((Scheduler.BeginFrame() == 0) && (Scheduler.GetFrameNumber() == 0));
+
+	return Status;
+}
+
+static BOOL TestFenceWaits(VOID)
+{
+	BOOL Status = TRUE;
+	CFrameScheduler Scheduler;
+
+	TEST_CHECK(Scheduler.Initialize(3) == TRUE);
+
+	// Nothing has been submitted to a slot the first time round
+	for (UINT64 Fence = 1; Fence <= 3; Fence++)
+	{
+		Scheduler.BeginFrame();
+		TEST_CHECK((Scheduler.MustWait(0) == FALSE) && (Scheduler.GetWaitFence() == 0));
+		Scheduler.EndFrame(Fence);
+	}
+
+	TEST_CHECK(Scheduler.GetLatestFence() == 3);
+
+	// Slot 0 again, its last frame signalled fence 1
+	TEST_CHECK(Scheduler.BeginFrame() == 0);
+	TEST_CHECK(Scheduler.GetWaitFence() == 1);
+	TEST_CHECK((Scheduler.MustWait(0) == TRUE) && (Scheduler.MustWait(1) == FALSE) && (Scheduler.MustWait(3) == FALSE));
+	Scheduler.EndFrame(4);
+
+	TEST_CHECK((Scheduler.BeginFrame() == 1) && (Scheduler.GetWaitFence() == 2));
+	TEST_CHECK((Scheduler.MustWait(1) == TRUE) && (Scheduler.MustWait(2) == FALSE));
+
+	// A lower fence value never moves the latest one back
+	Scheduler.EndFrame(1);
+	TEST_CHECK(Scheduler.GetLatestFence() == 4);
+
+	return Status;
+}
+
+// The loop CRenderer runs, with a GPU that completes a frame only when the CPU has to wait for it
+static BOOL TestFramesInFlight(VOID)
+{
+	BOOL Status = TRUE;
+	CFrameScheduler Scheduler;
+
+	for (UINT nFrames = 1; nFrames <= CFrameScheduler::MaxFramesInFlight; nFrames++)
+	{
+		UINT64 Completed = 0;
+		UINT nWaits = 0;
+
+		TEST_CHECK(Scheduler.Initialize(nFrames) == TRUE);
+
+		for (UINT64 Fence = 1; (Status == TRUE) && (Fence <= 100); Fence++)
+		{
+			Scheduler.BeginFrame();
+
+			if (Scheduler.MustWait(Completed) == TRUE)
+			{
+				Completed = Scheduler.GetWaitFence();
+				nWaits++;
+			}
+
+			// No more than nFrames frames are ever queued on the GPU
+			TEST_CHECK((Fence - Completed) <= nFrames);
+
+			Scheduler.EndFrame(Fence);
+		}
+
+		TEST_CHECK(nWaits == (100 - nFrames));
+	}
+
+	return Status;
+}
+
+BOOL TestFrameScheduler(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestSlotRotation() == TRUE) ? Status : FALSE;
+	Status = (TestFenceWaits() == TRUE) ? Status : FALSE;
+	Status = (TestFramesInFlight() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,153 @@
+#include "UnitTests.hpp"
+
+#include "CGpuTimer.hpp"
+
+static CONST LPCSTR PassNames[] = { "Shadow", "Main", "Post" };
+
+static BOOL TestQueryLayout(VOID)
+{
+	BOOL Status = TRUE;
+	CGpuTimer Timer;
+
+	TEST_CHECK(Timer.Initialize(0, PassNames, 1000) == FALSE);
+	TEST_CHECK(Timer.Initialize(CGpuTimer::MaxPasses + 1, PassNames, 1000) == FALSE);
+	TEST_CHECK(Timer.Initialize(3, PassNames, 0) == FALSE);
+
+	TEST_CHECK(Timer.Initialize(3, PassNames, 1000) == TRUE);
+	TEST_CHECK((Timer.GetPassCount() == 3) && (Timer.GetQueryCount() == 6));
+
+	// A slot's queries are consecutive, begin before end, and follow on from the previous slot's
+	for (UINT Slot = 0; Slot < CFrameScheduler::MaxFramesInFlight; Slot++)
+	{
+		for (UINT Pass = 0; Pass < 3; Pass++)
+		{
+			TEST_CHECK(Timer.GetBeginQuery(Slot, Pass) == (Slot * 6 + 2 * Pass));
+			TEST_CHECK(Timer.GetEndQuery(Slot, Pass) == (Timer.GetBeginQuery(Slot, Pass) + 1));
+		}
+	}
+
+	return Status;
+}
+
+static BOOL TestPendingSlots(VOID)
+{
+	BOOL Status = TRUE;
+	CGpuTimer Timer;
+	IRenderer::PassTiming Timing = { };
+
+	CONST UINT64 Timestamps[] = { 100, 102, 200, 205, 300, 301 };
+
+	TEST_CHECK(Timer.Initialize(3, PassNames, 1000) == TRUE);
+
+	// Resolving a slot that was never submitted must not record anything
+	Timer.Resolve(0, Timestamps);
+	TEST_CHECK((Timer.GetPassTiming(0, Timing) == TRUE) && (Timing.Samples == 0));
+
+	Timer.Submit(1);
+	TEST_CHECK((Timer.IsPending(0) == FALSE) && (Timer.IsPending(1) == TRUE));
+
+	Timer.Resolve(1, Timestamps);
+	TEST_CHECK(Timer.IsPending(1) == FALSE);
+
+	// One tick is a millisecond at 1000 ticks per second
+	TEST_CHECK((Timer.GetPassTiming(0, Timing) == TRUE) && (Timing.Samples == 1) && (Timing.AvgMs == 2.0f));
+	TEST_CHECK((Timer.GetPassTiming(1, Timing) == TRUE) && (Timing.Samples == 1) && (Timing.AvgMs == 5.0f));
+	TEST_CHECK((Timer.GetPassTiming(2, Timing) == TRUE) && (Timing.Samples == 1) && (Timing.AvgMs == 1.0f));
+	TEST_CHECK(Timer.GetPassTiming(3, Timing) == FALSE);
+
+	// A second resolve of the same slot is ignored until it is submitted again
+	Timer.Resolve(1, Timestamps);
+	TEST_CHECK((Timer.GetPassTiming(0, Timing) == TRUE) && (Timing.Samples == 1));
+
+	// Slots past the frames in flight are never pending
+	Timer.Submit(CFrameScheduler::MaxFramesInFlight);
+	TEST_CHECK(Timer.IsPending(CFrameScheduler::MaxFramesInFlight) == FALSE);
+
+	// Uninitialize forgets pending slots
+	Timer.Submit(2);
+	Timer.Uninitialize();
+	TEST_CHECK((Timer.IsPending(2) == FALSE) && (Timer.GetPassCount() == 0));
+
+	return Status;
+}
+
+static BOOL TestSkippedPasses(VOID)
+{
+	BOOL Status = TRUE;
+	CGpuTimer Timer;
+	IRenderer::PassTiming Timing = { };
+
+	// The first pass was not recorded, the second straddles a clock reset, only the third has a duration
+	CONST UINT64 Timestamps[] = { 0, 50, 900, 10, 40, 40 };
+
+	TEST_CHECK(Timer.Initialize(3, PassNames, 1000) == TRUE);
+
+	Timer.Submit(0);
+	Timer.Resolve(0, Timestamps);
+
+	TEST_CHECK((Timer.GetPassTiming(0, Timing) == TRUE) && (Timing.Samples == 0) && (Timing.AvgMs == 0.0f));
+	TEST_CHECK((Timer.GetPassTiming(1, Timing) == TRUE) && (Timing.Samples == 0));
+	TEST_CHECK((Timer.GetPassTiming(2, Timing) == TRUE) && (Timing.Samples == 1) && (Timing.MaxMs == 0.0f));
+
+	return Status;
+}
+
+static BOOL TestRollingWindow(VOID)
+{
+	BOOL Status = TRUE;
+	CGpuTimer Timer;
+	IRenderer::PassTiming Timing = { };
+
+	CONST UINT nFrames = CGpuTimer::WindowSize + 10;
+	CONST UINT nSlots = 3;
+
+	TEST_CHECK(Timer.Initialize(1, PassNames, 1000) == TRUE);
+
+	// Frame i takes i + 1 ticks and is resolved once its slot comes round again, as the renderer does
+	for (UINT Frame = 0; Frame < (nFrames + nSlots); Frame++)
+	{
+		CONST UINT Slot = Frame % nSlots;
+
+		if (Frame >= nSlots)
+		{
+			CONST UINT64 Begin = 1000 * static_cast<UINT64>(Frame - nSlots + 1);
+			CONST UINT64 Timestamps[] = { Begin, Begin + (Frame - nSlots + 1) };
+
+			TEST_CHECK(Timer.IsPending(Slot) == TRUE);
+			Timer.Resolve(Slot, Timestamps);
+		}
+
+		if (Frame < nFrames)
+		{
+			Timer.Submit(Slot);
+		}
+	}
+
+	// Only the most recent WindowSize frames count, 11 to 130 ms
+	TEST_CHECK((Timer.GetPassTiming(0, Timing) == TRUE) && (Timing.Samples == CGpuTimer::WindowSize));
+	TEST_CHECK((Timing.MinMs == 11.0f) && (Timing.MaxMs == 130.0f) && (Timing.AvgMs == 70.5f));
+
+	// At a real GPU frequency a tick is not an exact number of milliseconds
+	CONST UINT64 Timestamps[] = { 1000000, 1000000 + 24000 };
+
+	TEST_CHECK(Timer.Initialize(1, PassNames, 24000000) == TRUE);
+
+	Timer.Submit(0);
+	Timer.Resolve(0, Timestamps);
+
+	TEST_CHECK((Timer.GetPassTiming(0, Timing) == TRUE) && (Timing.AvgMs > 0.9999f) && (Timing.AvgMs < 1.0001f));
+
+	return Status;
+}
+
+BOOL TestGpuTimer(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestQueryLayout() == TRUE) ? Status : FALSE;
+	Status = (TestPendingSlots() == TRUE) ? Status : FALSE;
+	Status = (TestSkippedPasses() == TRUE) ? Status : FALSE;
+	Status = (TestRollingWindow() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,78 @@
+#include "UnitTests.hpp"
+
+#include "CHeapAllocator.hpp"
+
+static BOOL TestStaleHandles(VOID)
+{
+	BOOL Status = TRUE;
+	CHeapAllocator Heap;
+	CHeapAllocator::Allocation First = { };
+	CHeapAllocator::Allocation Second = { };
+	CHeapAllocator::Allocation Resized = { };
+	CHeapAllocator::Statistics Stats = { };
+
+	TEST_CHECK(Heap.Initialize(64 * 1024) == TRUE);
+	TEST_CHECK(Heap.Allocate(4096, 256, First) == TRUE);
+	TEST_CHECK(Heap.Allocate(4096, 256, Second) == TRUE);
+
+	// Second absorbs the free space after it and goes on a free list
+	Heap.Free(Second.Handle);
+	TEST_CHECK(Heap.Reallocate(Second, 8192, 256, Resized) == FALSE);
+
+	// First absorbs Second, whose node is released: neither free nor sized
+	Heap.Free(First.Handle);
+	TEST_CHECK(Heap.Reallocate(First, 8192, 256, Resized) == FALSE);
+	TEST_CHECK(Heap.Reallocate(Second, 8192, 256, Resized) == FALSE);
+
+	// Freeing again changes nothing
+	Heap.Free(First.Handle);
+	Heap.Free(Second.Handle);
+	Heap.GetStatistics(Stats);
+	TEST_CHECK((Stats.Allocations == 0) && (Stats.AllocatedBytes == 0) && (Stats.FreeBlocks == 1));
+
+	return Status;
+}
+
+static BOOL TestReallocate(VOID)
+{
+	BOOL Status = TRUE;
+	CHeapAllocator Heap;
+	CHeapAllocator::Allocation First = { };
+	CHeapAllocator::Allocation Second = { };
+	CHeapAllocator::Allocation Resized = { };
+	CHeapAllocator::Statistics Stats = { };
+
+	TEST_CHECK(Heap.Initialize(64 * 1024) == TRUE);
+	TEST_CHECK((Heap.Allocate(1000, 256, First) == TRUE) && (First.Offset == 0) && (First.Size == 1024));
+
+	// Grows into the free space that follows and keeps its handle
+	TEST_CHECK(Heap.Reallocate(First, 8192, 256, Resized) == TRUE);
+	TEST_CHECK((Resized.Handle == First.Handle) && (Resized.Offset == 0) && (Resized.Size == 8192));
+	First = Resized;
+
+	// Blocked by the next allocation, the old one stays live until the caller frees it
+	TEST_CHECK(Heap.Allocate(4096, 4096, Second) == TRUE);
+	TEST_CHECK(Heap.Reallocate(First, 16384, 256, Resized) == TRUE);
+	TEST_CHECK((Resized.Handle != First.Handle) && (Resized.Size == 16384));
+
+	Heap.GetStatistics(Stats);
+	TEST_CHECK((Stats.Allocations == 3) && (Stats.AllocatedBytes == 8192 + 4096 + 16384));
+
+	Heap.Free(First.Handle);
+	Heap.Free(Second.Handle);
+	Heap.Free(Resized.Handle);
+	Heap.GetStatistics(Stats);
+	TEST_CHECK((Stats.Allocations == 0) && (Stats.FreeBlocks == 1) && (Stats.LargestFreeBlock == 64 * 1024));
+
+	return Status;
+}
+
+BOOL TestHeapAllocator(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestStaleHandles() == TRUE) ? Status : FALSE;
+	Status = (TestReallocate() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,297 @@
+#include "UnitTests.hpp"
+
+#include <atomic>
+
+#include "Jobs.hpp"
+
+struct ForkJoinData
+{
+	std::atomic<UINT> nDone;
+	std::atomic<UINT> nOutOfOrder;
+	UINT			  nExpected;
+	Jobs::Counter*	  pDependency;
+};
+
+static VOID CountJob(PVOID pData)
+{
+	reinterpret_cast<ForkJoinData*>(pData)->nDone.fetch_add(1);
+}
+
+// Runs after the jobs of pDependency, all of them have to be done by then
+static VOID ContinuationJob(PVOID pData)
+{
+	ForkJoinData* pForkJoin = reinterpret_cast<ForkJoinData*>(pData);
+
+	if ((pForkJoin->nDone.load() != pForkJoin->nExpected) || (pForkJoin->pDependency->GetPending() != 0))
+	{
+		pForkJoin->nOutOfOrder.fetch_add(1);
+	}
+}
+
+// Forks and joins jobs of its own from inside a job, on a counter that lives on the worker's stack
+static VOID NestedJob(PVOID pData)
+{
+	ForkJoinData Inner;
+	Jobs::Counter Counter;
+
+	Inner.nDone = 0;
+	Inner.nOutOfOrder = 0;
+
+	for (UINT i = 0; i < 4; i++)
+	{
+		Jobs::Run(CountJob, &Inner, &Counter);
+	}
+
+	Jobs::Wait(&Counter);
+
+	reinterpret_cast<ForkJoinData*>(pData)->nDone.fetch_add(Inner.nDone.load());
+}
+
+// The counter is on the stack and gone as soon as Wait returns, a Release still using it writes to a dead frame
+static BOOL ForkJoinOnce(UINT nJobs)
+{
+	BOOL Status = TRUE;
+	ForkJoinData Data;
+	Jobs::Counter Counter;
+
+	Data.nDone = 0;
+	Data.nOutOfOrder = 0;
+
+	for (UINT i = 0; i < nJobs; i++)
+	{
+		Jobs::Run(CountJob, &Data, &Counter);
+	}
+
+	Jobs::Wait(&Counter);
+
+	TEST_CHECK((Data.nDone.load() == nJobs) && (Counter.GetPending() == 0));
+
+	return Status;
+}
+
+static BOOL TestStackCounters(VOID)
+{
+	BOOL Status = TRUE;
+
+	for (UINT i = 0; (Status == TRUE) && (i < 20000); i++)
+	{
+		Status = ForkJoinOnce(1 + (i % 8));
+	}
+
+	return Status;
+}
+
+// Each batch starts while the Release that finished the last one may still be closing the list
+static BOOL TestReusedCounter(VOID)
+{
+	BOOL Status = TRUE;
+	ForkJoinData Data;
+	Jobs::Counter Counter;
+
+	Data.nDone = 0;
+	Data.nOutOfOrder = 0;
+
+	for (UINT i = 0; (Status == TRUE) && (i < 20000); i++)
+	{
+		Jobs::Run(CountJob, &Data, &Counter);
+
+		if ((i % 3) == 0)
+		{
+			Jobs::Wait(&Counter);
+			TEST_CHECK((Data.nDone.load() == (i + 1)) && (Counter.GetPending() == 0));
+		}
+	}
+
+	Jobs::Wait(&Counter);
+	TEST_CHECK(Data.nDone.load() == 20000);
+
+	return Status;
+}
+
+static BOOL TestContinuations(VOID)
+{
+	BOOL Status = TRUE;
+
+	for (UINT i = 0; (Status == TRUE) && (i < 5000); i++)
+	{
+		ForkJoinData Data;
+		Jobs::Counter Forked;
+		Jobs::Counter Joined;
+
+		Data.nDone = 0;
+		Data.nOutOfOrder = 0;
+		Data.nExpected = 1 + (i % 6);
+		Data.pDependency = &Forked;
+
+		for (UINT j = 0; j < Data.nExpected; j++)
+		{
+			Jobs::Run(CountJob, &Data, &Forked);
+		}
+
+		Jobs::RunAfter(&Forked, Jobs::ANY_THREAD, ContinuationJob, &Data, &Joined);
+
+		// Joined alone covers both, the continuation cannot run before Forked is released
+		Jobs::Wait(&Joined);
+
+		TEST_CHECK(Data.nOutOfOrder.load() == 0);
+		TEST_CHECK(Data.nDone.load() == Data.nExpected);
+
+		Jobs::Wait(&Forked);
+	}
+
+	return Status;
+}
+
+struct ParallelForCoverage
+{
+	UINT			  nItems;
+	UINT			  nChunks;
+	std::atomic<UINT> Visits[1000];
+	std::atomic<UINT> ChunkRuns[64];
+	std::atomic<UINT> nMismatched;
+};
+
+static VOID CoverRange(PVOID pData, UINT Chunk, UINT First, UINT Count)
+{
+	ParallelForCoverage* pCoverage = reinterpret_cast<ParallelForCoverage*>(pData);
+	UINT ExpectedFirst = 0;
+	UINT ExpectedCount = 0;
+
+	Jobs::GetChunk(pCoverage->nItems, pCoverage->nChunks, Chunk, ExpectedFirst, ExpectedCount);
+
+	if ((Chunk >= pCoverage->nChunks) || (First != ExpectedFirst) || (Count != ExpectedCount) || ((First + Count) > pCoverage->nItems))
+	{
+		pCoverage->nMismatched.fetch_add(1);
+	}
+	else
+	{
+		for (UINT i = First; i < First + Count; i++)
+		{
+			pCoverage->Visits[i].fetch_add(1);
+		}
+
+		pCoverage->ChunkRuns[Chunk].fetch_add(1);
+	}
+}
+
+static BOOL ParallelForOnce(UINT nItems, UINT nChunks)
+{
+	BOOL Status = TRUE;
+	ParallelForCoverage Coverage;
+
+	// No chunks is one chunk
+	Coverage.nItems = nItems;
+	Coverage.nChunks = (nChunks != 0) ? nChunks : 1;
+	Coverage.nMismatched = 0;
+
+	for (UINT i = 0; i < 1000; i++)
+	{
+		Coverage.Visits[i] = 0;
+	}
+
+	for (UINT i = 0; i < 64; i++)
+	{
+		Coverage.ChunkRuns[i] = 0;
+	}
+
+	Jobs::ParallelFor(nItems, nChunks, CoverRange, &Coverage);
+
+	TEST_CHECK(Coverage.nMismatched.load() == 0);
+
+	for (UINT i = 0; i < nItems; i++)
+	{
+		TEST_CHECK(Coverage.Visits[i].load() == 1);
+	}
+
+	// Empty chunks still run, so a chunk can always stand for a fixed resource such as a command sink
+	for (UINT i = 0; i < Coverage.nChunks; i++)
+	{
+		TEST_CHECK(Coverage.ChunkRuns[i].load() == 1);
+	}
+
+	return Status;
+}
+
+static BOOL TestParallelFor(VOID)
+{
+	BOOL Status = TRUE;
+	CONST UINT ChunkCounts[] = { 0, 1, 3, 7, 64 };
+
+	for (UINT c = 0; (Status == TRUE) && (c < (sizeof(ChunkCounts) / sizeof(ChunkCounts[0]))); c++)
+	{
+		for (UINT r = 0; (Status == TRUE) && (r < 200); r++)
+		{
+			Status = ParallelForOnce(1000, ChunkCounts[c]);
+		}
+	}
+
+	TEST_CHECK(ParallelForOnce(0, 8) == TRUE);
+	TEST_CHECK(ParallelForOnce(5, 64) == TRUE);
+
+	// Sizes differ by one item at most and the chunks follow each other
+	UINT Next = 0;
+
+	for (UINT Chunk = 0; Chunk < 7; Chunk++)
+	{
+		UINT First = 0;
+		UINT Count = 0;
+
+		Jobs::GetChunk(1000, 7, Chunk, First, Count);
+		TEST_CHECK((First == Next) && ((Count == 142) || (Count == 143)));
+
+		Next = First + Count;
+	}
+
+	TEST_CHECK(Next == 1000);
+
+	return Status;
+}
+
+static BOOL TestNestedForkJoin(VOID)
+{
+	BOOL Status = TRUE;
+
+	for (UINT i = 0; (Status == TRUE) && (i < 2000); i++)
+	{
+		ForkJoinData Data;
+		Jobs::Counter Counter;
+
+		Data.nDone = 0;
+		Data.nOutOfOrder = 0;
+
+		for (UINT j = 0; j < 4; j++)
+		{
+			Jobs::Run(NestedJob, &Data, &Counter);
+		}
+
+		Jobs::Wait(&Counter);
+
+		TEST_CHECK(Data.nDone.load() == 16);
+	}
+
+	return Status;
+}
+
+BOOL TestJobSystem(VOID)
+{
+	BOOL Status = TRUE;
+
+	// More workers than most CI machines have cores, so releases get preempted at every step
+	if (Jobs::Initialize(4) != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = (TestStackCounters() == TRUE) ? Status : FALSE;
+		Status = (TestReusedCounter() == TRUE) ? Status : FALSE;
+		Status = (TestContinuations() == TRUE) ? Status : FALSE;
+		Status = (TestNestedForkJoin() == TRUE) ? Status : FALSE;
+		Status = (TestParallelFor() == TRUE) ? Status : FALSE;
+	}
+
+	Jobs::Uninitialize();
+
+	return Status;
+}
@@ -0,0 +1,393 @@
+#include "UnitTests.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CPipelineCacheFile.hpp"
+#include "CPipelineKey.hpp"
+
+// Stand-in for D3D12_GRAPHICS_PIPELINE_STATE_DESC with the same field names, so keys can be built without d3d12.h
+struct TestBytecode
+{
+	CONST VOID* pShaderBytecode;
+	SIZE_T		BytecodeLength;
+};
+
+struct TestSODeclaration
+{
+	UINT	Stream;
+	LPCSTR	SemanticName;
+	UINT	SemanticIndex;
+	uint8_t StartComponent;
+	uint8_t ComponentCount;
+	uint8_t OutputSlot;
+};
+
+struct TestStreamOutput
+{
+	CONST TestSODeclaration* pSODeclaration;
+	UINT					 NumEntries;
+	CONST UINT*				 pBufferStrides;
+	UINT					 NumStrides;
+	UINT					 RasterizedStream;
+};
+
+struct TestRenderTargetBlend
+{
+	BOOL	BlendEnable;
+	BOOL	LogicOpEnable;
+	UINT	SrcBlend;
+	UINT	DestBlend;
+	UINT	BlendOp;
+	UINT	SrcBlendAlpha;
+	UINT	DestBlendAlpha;
+	UINT	BlendOpAlpha;
+	UINT	LogicOp;
+	uint8_t RenderTargetWriteMask;
+};
+
+struct TestBlend
+{
+	BOOL				  AlphaToCoverageEnable;
+	BOOL				  IndependentBlendEnable;
+	TestRenderTargetBlend RenderTarget[8];
+};
+
+struct TestRasterizer
+{
+	UINT  FillMode;
+	UINT  CullMode;
+	BOOL  FrontCounterClockwise;
+	INT	  DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL  DepthClipEnable;
+	BOOL  MultisampleEnable;
+	BOOL  AntialiasedLineEnable;
+	UINT  ForcedSampleCount;
+	UINT  ConservativeRaster;
+};
+
+struct TestStencilOp
+{
+	UINT StencilFailOp;
+	UINT StencilDepthFailOp;
+	UINT StencilPassOp;
+	UINT StencilFunc;
+};
+
+struct TestDepthStencil
+{
+	BOOL		  DepthEnable;
+	UINT		  DepthWriteMask;
+	UINT		  DepthFunc;
+	BOOL		  StencilEnable;
+	uint8_t		  StencilReadMask;
+	uint8_t		  StencilWriteMask;
+	TestStencilOp FrontFace;
+	TestStencilOp BackFace;
+};
+
+struct TestInputElement
+{
+	LPCSTR SemanticName;
+	UINT   SemanticIndex;
+	UINT   Format;
+	UINT   InputSlot;
+	UINT   AlignedByteOffset;
+	UINT   InputSlotClass;
+	UINT   InstanceDataStepRate;
+};
+
+struct TestInputLayout
+{
+	CONST TestInputElement* pInputElementDescs;
+	UINT					NumElements;
+};
+
+struct TestSampleDesc
+{
+	UINT Count;
+	UINT Quality;
+};
+
+struct TestCachedPSO
+{
+	CONST VOID* pCachedBlob;
+	SIZE_T		CachedBlobSizeInBytes;
+};
+
+struct TestGraphicsDesc
+{
+	PVOID			 pRootSignature;
+	TestBytecode	 VS;
+	TestBytecode	 PS;
+	TestBytecode	 DS;
+	TestBytecode	 HS;
+	TestBytecode	 GS;
+	TestStreamOutput StreamOutput;
+	TestBlend		 BlendState;
+	UINT			 SampleMask;
+	TestRasterizer	 RasterizerState;
+	TestDepthStencil DepthStencilState;
+	TestInputLayout	 InputLayout;
+	UINT			 IBStripCutValue;
+	UINT			 PrimitiveTopologyType;
+	UINT			 NumRenderTargets;
+	UINT			 RTVFormats[8];
+	UINT			 DSVFormat;
+	TestSampleDesc	 SampleDesc;
+	UINT			 NodeMask;
+	TestCachedPSO	 CachedPSO;
+	UINT			 Flags;
+};
+
+static CONST CHAR CachePath[] = "PipelineCacheTests.bin";
+
+static UINT64 GetKey(CONST TestGraphicsDesc& rDesc, UINT64 RootSignatureKey)
+{
+	CPipelineKey Key;
+
+	Key.AddValue(RootSignatureKey);
+	Key.AddGraphicsDesc(rDesc);
+
+	return Key.GetKey();
+}
+
+static BOOL TestPipelineKey(VOID)
+{
+	BOOL Status = TRUE;
+
+	uint8_t VS[64] = { 'D', 'X', 'B', 'C' };
+	uint8_t PS[40] = { };
+
+	for (UINT i = 4; i < sizeof(VS); i++)
+	{
+		VS[i] = static_cast<uint8_t>(i);
+	}
+
+	for (UINT i = 0; i < sizeof(PS); i++)
+	{
+		PS[i] = static_cast<uint8_t>(3 * i);
+	}
+
+	CONST TestInputElement Elements[] =
+	{
+		{ "POSITION", 0, 6, 0, 0, 0, 0 },
+		{ "COLOR", 0, 6, 0, 12, 0, 0 }
+	};
+
+	TestGraphicsDesc Desc = { };
+	Desc.VS = { VS, sizeof(VS) };
+	Desc.PS = { PS, sizeof(PS) };
+	Desc.SampleMask = 0xFFFFFFFF;
+	Desc.InputLayout = { Elements, 2 };
+	Desc.NumRenderTargets = 1;
+	Desc.RTVFormats[0] = 28;
+	Desc.SampleDesc = { 1, 0 };
+
+	CONST UINT64 Base = GetKey(Desc, 7);
+
+	TEST_CHECK(GetKey(Desc, 7) == Base);
+	TEST_CHECK(GetKey(Desc, 8) != Base);
+
+	// Neither the live root signature nor the cached blob are part of the pipeline
+	TestGraphicsDesc Other = Desc;
+	Other.pRootSignature = &Other;
+	Other.CachedPSO = { VS, 3 };
+	TEST_CHECK(GetKey(Other, 7) == Base);
+
+	// Render target formats past NumRenderTargets are ignored by the runtime
+	Other = Desc;
+	Other.RTVFormats[3] = 5;
+	TEST_CHECK(GetKey(Other, 7) == Base);
+
+	// Pointers are followed, where the bytecode and the semantic names live does not matter
+	std::vector<uint8_t> CopiedVS(VS, VS + sizeof(VS));
+	CONST std::string Color = "COLOR";
+	TestInputElement CopiedElements[] = { Elements[0], Elements[1] };
+
+	CopiedElements[1].SemanticName = Color.c_str();
+	Other = Desc;
+	Other.VS = { CopiedVS.data(), CopiedVS.size() };
+	Other.InputLayout = { CopiedElements, 2 };
+	TEST_CHECK(GetKey(Other, 7) == Base);
+
+	// DXBC is keyed by the checksum in its header, anything else by every byte
+	CopiedVS[40] ^= 1;
+	TEST_CHECK(GetKey(Other, 7) == Base);
+
+	CopiedVS[10] ^= 1;
+	TEST_CHECK(GetKey(Other, 7) != Base);
+
+	std::vector<uint8_t> CopiedPS(PS, PS + sizeof(PS));
+	CopiedPS[30] ^= 1;
+	Other = Desc;
+	Other.PS = { CopiedPS.data(), CopiedPS.size() };
+	TEST_CHECK(GetKey(Other, 7) != Base);
+
+	// Every state that changes the pipeline changes the key, and no two of these collide
+	std::vector<UINT64> Keys(1, Base);
+
+	Other = Desc;
+	Other.BlendState.RenderTarget[5].BlendEnable = TRUE;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.RasterizerState.CullMode = 3;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.RasterizerState.SlopeScaledDepthBias = 1.0f;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.DepthStencilState.BackFace.StencilFunc = 2;
+	Keys.push_back(GetKey(Other, 7));
+
+	CopiedElements[1] = Elements[1];
+	CopiedElements[1].AlignedByteOffset = 16;
+	Other = Desc;
+	Other.InputLayout = { CopiedElements, 2 };
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.InputLayout.NumElements = 1;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.RTVFormats[0] = 29;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.DSVFormat = 40;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.SampleDesc.Count = 4;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.PrimitiveTopologyType = 2;
+	Keys.push_back(GetKey(Other, 7));
+
+	Other = Desc;
+	Other.Flags = 1;
+	Keys.push_back(GetKey(Other, 7));
+
+	for (SIZE_T i = 0; i < Keys.size(); i++)
+	{
+		for (SIZE_T j = i + 1; j < Keys.size(); j++)
+		{
+			TEST_CHECK(Keys[i] != Keys[j]);
+		}
+	}
+
+	return Status;
+}
+
+static BOOL TestCacheFile(VOID)
+{
+	BOOL Status = TRUE;
+	CPipelineCacheFile File;
+
+	CONST CPipelineCacheFile::AdapterIdentity Adapter = { 0x10DE, 0x2204, 0x1, 0xA1, 0x001F000E000A1234ull };
+	CPipelineCacheFile::AdapterIdentity OtherAdapter = Adapter;
+
+	std::vector<uint8_t> Blob(5000);
+
+	for (SIZE_T i = 0; i < Blob.size(); i++)
+	{
+		Blob[i] = static_cast<uint8_t>(7 * i);
+	}
+
+	std::remove(CachePath);
+
+	// The first run has no file
+	TEST_CHECK((File.Open(CachePath, Adapter) == FALSE) && (File.GetBlob() == NULL) && (File.GetBlobSize() == 0));
+
+	// The blob is read in place from the mapping, on its alignment boundary
+	TEST_CHECK(CPipelineCacheFile::Write(CachePath, Adapter, Blob.data(), Blob.size()) == TRUE);
+	TEST_CHECK((File.Open(CachePath, Adapter) == TRUE) && (File.GetBlobSize() == Blob.size()));
+	TEST_CHECK((File.GetBlob() != NULL) && (memcmp(File.GetBlob(), Blob.data(), Blob.size()) == 0));
+	TEST_CHECK((reinterpret_cast<uintptr_t>(File.GetBlob()) % CPipelineCacheFile::BlobAlignment) == 0);
+
+	File.Close();
+	TEST_CHECK((File.GetBlob() == NULL) && (File.GetBlobSize() == 0));
+
+	// A blob only means something to the adapter and driver that wrote it
+	OtherAdapter.DriverVersion++;
+	TEST_CHECK(File.Open(CachePath, OtherAdapter) == FALSE);
+
+	OtherAdapter = Adapter;
+	OtherAdapter.DeviceId++;
+	TEST_CHECK(File.Open(CachePath, OtherAdapter) == FALSE);
+
+	OtherAdapter = Adapter;
+	OtherAdapter.Revision++;
+	TEST_CHECK(File.Open(CachePath, OtherAdapter) == FALSE);
+
+	// Writing again replaces the file
+	TEST_CHECK(CPipelineCacheFile::Write(CachePath, Adapter, Blob.data(), 100) == TRUE);
+	TEST_CHECK((File.Open(CachePath, Adapter) == TRUE) && (File.GetBlobSize() == 100));
+
+	File.Close();
+
+	TEST_CHECK(CPipelineCacheFile::Write(CachePath, Adapter, NULL, 0) == TRUE);
+	TEST_CHECK((File.Open(CachePath, Adapter) == TRUE) && (File.GetBlobSize() == 0));
+
+	File.Close();
+
+	TEST_CHECK(CPipelineCacheFile::Write(CachePath, Adapter, NULL, 16) == FALSE);
+
+	// A blob cut short and a file that is not a cache are both refused
+	TEST_CHECK(CPipelineCacheFile::Write(CachePath, Adapter, Blob.data(), Blob.size()) == TRUE);
+
+	std::vector<CHAR> Contents;
+	FILE* pFile = fopen(CachePath, "rb");
+
+	if (pFile != NULL)
+	{
+		Contents.resize(sizeof(CPipelineCacheFile::Header) + CPipelineCacheFile::BlobAlignment + Blob.size());
+		Contents.resize(fread(Contents.data(), 1, Contents.size(), pFile));
+		fclose(pFile);
+	}
+
+	TEST_CHECK(Contents.size() > 10);
+
+	pFile = fopen(CachePath, "wb");
+
+	if (pFile != NULL)
+	{
+		fwrite(Contents.data(), 1, Contents.size() - 10, pFile);
+		fclose(pFile);
+	}
+
+	TEST_CHECK(File.Open(CachePath, Adapter) == FALSE);
+
+	pFile = fopen(CachePath, "wb");
+
+	if (pFile != NULL)
+	{
+		fwrite("PSOL", 1, 4, pFile);
+		fclose(pFile);
+	}
+
+	TEST_CHECK(File.Open(CachePath, Adapter) == FALSE);
+
+	std::remove(CachePath);
+
+	return Status;
+}
+
+BOOL TestPipelineCache(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestPipelineKey() == TRUE) ? Status : FALSE;
+	Status = (TestCacheFile() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,249 @@
+#include "UnitTests.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CPipelineQueue.hpp"
+
+struct TestRequest
+{
+	UINT64 Key;
+	BOOL   bFail;
+};
+
+// Pipelines are copies of their key. Compile holds every thread while the gate is closed, so a test can fill the queue
+// behind a pipeline that is being compiled.
+class TestCompiler : public IPipelineCompiler
+{
+protected:
+	std::mutex			m_Lock;
+	std::vector<UINT64> m_Order;
+
+public:
+	std::atomic<BOOL> m_bGateClosed;
+	std::atomic<INT>  m_nRequests;
+	std::atomic<INT>  m_nPipelines;
+
+	TestCompiler()
+	{
+		m_bGateClosed = FALSE;
+		m_nRequests = 0;
+		m_nPipelines = 0;
+	}
+
+	virtual PVOID Compile(PVOID pRequest)
+	{
+		TestRequest* pTestRequest = reinterpret_cast<TestRequest*>(pRequest);
+		UINT64* pPipeline = NULL;
+
+		while (m_bGateClosed.load() == TRUE)
+		{
+			std::this_thread::yield();
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(m_Lock);
+			m_Order.push_back(pTestRequest->Key);
+		}
+
+		if (pTestRequest->bFail == FALSE)
+		{
+			pPipeline = new UINT64(pTestRequest->Key);
+			m_nPipelines++;
+		}
+
+		return pPipeline;
+	}
+
+	virtual VOID ReleaseRequest(PVOID pRequest)
+	{
+		m_nRequests--;
+		delete reinterpret_cast<TestRequest*>(pRequest);
+	}
+
+	virtual VOID ReleasePipeline(PVOID pPipeline)
+	{
+		m_nPipelines--;
+		delete reinterpret_cast<UINT64*>(pPipeline);
+	}
+
+	PVOID CreateRequest(UINT64 Key, BOOL bFail)
+	{
+		m_nRequests++;
+		return new TestRequest{ Key, bFail };
+	}
+
+	std::vector<UINT64> GetOrder(VOID)
+	{
+		std::lock_guard<std::mutex> Lock(m_Lock);
+		return m_Order;
+	}
+};
+
+static UINT64 GetPipelineKey(PVOID pPipeline)
+{
+	return (pPipeline != NULL) ? *reinterpret_cast<UINT64*>(pPipeline) : 0;
+}
+
+static BOOL TestPriorities(VOID)
+{
+	BOOL Status = TRUE;
+	TestCompiler Compiler;
+	CPipelineQueue Queue;
+	CPipelineQueue::Report Report = { };
+
+	TEST_CHECK(Queue.Initialize(&Compiler, 1) == TRUE);
+
+	// The only thread picks up 100 and stays inside Compile until the gate opens
+	Compiler.m_bGateClosed = TRUE;
+	TEST_CHECK(Queue.Request(100, CPipelineQueue::PRIORITY_LOW, Compiler.CreateRequest(100, FALSE)) == TRUE);
+
+	while (Queue.GetStatus(100) != CPipelineQueue::PIPELINE_COMPILING)
+	{
+		std::this_thread::yield();
+	}
+
+	TEST_CHECK(Queue.Request(1, CPipelineQueue::PRIORITY_LOW, Compiler.CreateRequest(1, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(2, CPipelineQueue::PRIORITY_NORMAL, Compiler.CreateRequest(2, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(3, CPipelineQueue::PRIORITY_LOW, Compiler.CreateRequest(3, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(4, CPipelineQueue::PRIORITY_HIGH, Compiler.CreateRequest(4, TRUE)) == TRUE);
+
+	// Asking again raises a pending pipeline but never lowers it, the second request is released either way
+	TEST_CHECK(Queue.Request(3, CPipelineQueue::PRIORITY_HIGH, Compiler.CreateRequest(3, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(2, CPipelineQueue::PRIORITY_LOW, Compiler.CreateRequest(2, FALSE)) == TRUE);
+	TEST_CHECK(Compiler.m_nRequests.load() == 5);
+
+	TEST_CHECK(Queue.GetStatus(100) == CPipelineQueue::PIPELINE_COMPILING);
+	TEST_CHECK(Queue.GetStatus(1) == CPipelineQueue::PIPELINE_PENDING);
+	TEST_CHECK(Queue.GetStatus(9) == CPipelineQueue::PIPELINE_UNKNOWN);
+
+	Queue.GetReport(Report);
+	TEST_CHECK((Report.nPending == 4) && (Report.nCompiling == 1) && (Report.nReady == 0));
+
+	Queue.BeginFrame();
+	TEST_CHECK(Queue.Acquire(1) == NULL);
+
+	Compiler.m_bGateClosed = FALSE;
+	Queue.WaitIdle();
+
+	// Highest priority first, then in the order they were asked for, a raised pipeline counts from when it was raised
+	CONST std::vector<UINT64> Expected = { 100, 4, 3, 2, 1 };
+	TEST_CHECK(Compiler.GetOrder() == Expected);
+
+	TEST_CHECK(Queue.GetStatus(1) == CPipelineQueue::PIPELINE_READY);
+	TEST_CHECK(Queue.GetStatus(4) == CPipelineQueue::PIPELINE_FAILED);
+
+	Queue.GetReport(Report);
+	TEST_CHECK((Report.nPending == 0) && (Report.nCompiling == 0) && (Report.nReady == 4) && (Report.nFailed == 1));
+	TEST_CHECK(Compiler.m_nRequests.load() == 0);
+
+	Queue.Uninitialize();
+	TEST_CHECK(Compiler.m_nPipelines.load() == 0);
+
+	return Status;
+}
+
+static BOOL TestAcquire(VOID)
+{
+	BOOL Status = TRUE;
+	TestCompiler Compiler;
+	CPipelineQueue Queue;
+	CPipelineQueue::Report Report = { };
+
+	TEST_CHECK(Queue.Initialize(&Compiler, 2) == TRUE);
+
+	TEST_CHECK(Queue.Request(1, CPipelineQueue::PRIORITY_NORMAL, Compiler.CreateRequest(1, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(2, CPipelineQueue::PRIORITY_NORMAL, Compiler.CreateRequest(2, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(3, CPipelineQueue::PRIORITY_NORMAL, Compiler.CreateRequest(3, TRUE)) == TRUE);
+
+	Queue.WaitIdle();
+	Queue.BeginFrame();
+
+	// Ready, fallen back, skipped without and with a fallback that is not ready
+	TEST_CHECK(GetPipelineKey(Queue.Acquire(1)) == 1);
+	TEST_CHECK(GetPipelineKey(Queue.Acquire(3, 2)) == 2);
+	TEST_CHECK(Queue.Acquire(3) == NULL);
+	TEST_CHECK(Queue.Acquire(3, 77) == NULL);
+	TEST_CHECK(Queue.Acquire(77) == NULL);
+
+	Queue.GetReport(Report);
+	TEST_CHECK((Report.nDrawsReady == 1) && (Report.nDrawsFallback == 1) && (Report.nDrawsSkipped == 3));
+
+	// Draw counts are per frame, pipeline counts are not
+	Queue.BeginFrame();
+	Queue.GetReport(Report);
+	TEST_CHECK((Report.nDrawsReady == 0) && (Report.nDrawsFallback == 0) && (Report.nDrawsSkipped == 0));
+	TEST_CHECK((Report.nReady == 2) && (Report.nFailed == 1));
+
+	// A ready or failed pipeline is never compiled again, the new request is released
+	TEST_CHECK(Queue.Request(1, CPipelineQueue::PRIORITY_HIGH, Compiler.CreateRequest(1, FALSE)) == TRUE);
+	TEST_CHECK(Queue.Request(3, CPipelineQueue::PRIORITY_HIGH, Compiler.CreateRequest(3, FALSE)) == TRUE);
+	TEST_CHECK((Compiler.m_nRequests.load() == 0) && (Compiler.GetOrder().size() == 3));
+	TEST_CHECK(Queue.GetStatus(3) == CPipelineQueue::PIPELINE_FAILED);
+
+	Queue.Uninitialize();
+	TEST_CHECK(Compiler.m_nPipelines.load() == 0);
+
+	return Status;
+}
+
+static BOOL TestShutdown(VOID)
+{
+	BOOL Status = TRUE;
+	TestCompiler Compiler;
+	CPipelineQueue Queue;
+	CPipelineQueue::Report Report = { };
+	PVOID pRequest = NULL;
+
+	// Not initialized, the request stays with the caller
+	TEST_CHECK(Queue.Initialize(&Compiler, 0) == FALSE);
+	TEST_CHECK(Queue.Initialize(&Compiler, CPipelineQueue::MaxThreads + 1) == FALSE);
+
+	pRequest = Compiler.CreateRequest(1, FALSE);
+	TEST_CHECK(Queue.Request(1, CPipelineQueue::PRIORITY_LOW, pRequest) == FALSE);
+	Compiler.ReleaseRequest(pRequest);
+
+	// Returns straight away without threads
+	Queue.WaitIdle();
+
+	TEST_CHECK(Queue.Initialize(&Compiler, 3) == TRUE);
+
+	for (UINT64 Key = 0; Key < 500; Key++)
+	{
+		Queue.Request(Key, static_cast<CPipelineQueue::Priority>(Key % 3), Compiler.CreateRequest(Key, ((Key % 10) == 0) ? TRUE : FALSE));
+	}
+
+	Queue.WaitIdle();
+	Queue.GetReport(Report);
+	TEST_CHECK((Report.nReady == 450) && (Report.nFailed == 50) && (Compiler.GetOrder().size() == 500));
+
+	// Uninitialize with work still queued and draws being made, every request and pipeline is released
+	for (UINT64 Key = 500; Key < 1000; Key++)
+	{
+		Queue.Request(Key, CPipelineQueue::PRIORITY_NORMAL, Compiler.CreateRequest(Key, FALSE));
+	}
+
+	for (UINT64 Key = 0; Key < 1000; Key += 7)
+	{
+		Queue.Acquire(Key, 1);
+	}
+
+	Queue.Uninitialize();
+	TEST_CHECK((Compiler.m_nRequests.load() == 0) && (Compiler.m_nPipelines.load() == 0));
+	TEST_CHECK(Queue.GetStatus(1) == CPipelineQueue::PIPELINE_UNKNOWN);
+
+	return Status;
+}
+
+BOOL TestPipelineQueue(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestPriorities() == TRUE) ? Status : FALSE;
+	Status = (TestAcquire() == TRUE) ? Status : FALSE;
+	Status = (TestShutdown() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,190 @@
+#include "UnitTests.hpp"
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CPermutationRegistry.hpp"
+#include "CSceneShaders.hpp"
+#include "CShaderPermutation.hpp"
+#include "CShaderRegistry.hpp"
+
+// Stand-in for D3D_SHADER_MACRO
+struct TestMacro
+{
+	LPCSTR Name;
+	LPCSTR Definition;
+};
+
+static_assert(CShaderPermutation::Make<>().GetBits() == 0, "An empty permutation has no bits");
+static_assert(CShaderPermutation::Make<SHADER_FEATURE_LIT, SHADER_FEATURE_INSTANCED>().GetBits() == 5, "One bit per feature");
+static_assert(CShaderPermutation::Make<SHADER_FEATURE_LIT>().With(SHADER_FEATURE_LIT, FALSE).GetBits() == 0, "With clears a feature");
+static_assert(CShaderPermutation(7).Mask(CShaderPermutation(2)).GetBits() == 2, "Mask keeps the shader's features");
+
+struct CompileLog
+{
+	std::vector<std::string> Names;
+	UINT					 nFailAfter;
+};
+
+// Records the name each variant would be embedded under, bytecode sizes are 100 plus the key
+static BOOL CompileVariant(PVOID pContext, CONST CPermutationRegistry::Shader& rShader, CONST CPermutationRegistry::Variant& rVariant, SIZE_T& rBytecodeSize)
+{
+	CompileLog* pLog = reinterpret_cast<CompileLog*>(pContext);
+	TestMacro Defines[NumShaderFeatures + 1];
+
+	rVariant.Permutation.GetDefines(rShader.Features, Defines);
+	pLog->Names.push_back(CShaderRegistry::GetName(rShader.pFileName, rShader.pEntrypoint, rShader.pTarget, Defines));
+	rBytecodeSize = 100 + rVariant.Permutation.GetBits();
+
+	return (pLog->Names.size() <= pLog->nFailAfter) ? TRUE : FALSE;
+}
+
+static BOOL TestKeyEncoding(VOID)
+{
+	BOOL Status = TRUE;
+	TestMacro Defines[NumShaderFeatures + 1];
+
+	CONST CShaderPermutation Key = CShaderPermutation::Make<SHADER_FEATURE_INSTANCED>().With(SHADER_FEATURE_QUANTIZED, TRUE);
+
+	TEST_CHECK(Key.GetBits() == ((1u << SHADER_FEATURE_INSTANCED) | (1u << SHADER_FEATURE_QUANTIZED)));
+	TEST_CHECK((Key.Has(SHADER_FEATURE_INSTANCED) == TRUE) && (Key.Has(SHADER_FEATURE_LIT) == FALSE));
+	TEST_CHECK((Key == CShaderPermutation(3)) && (Key != CShaderPermutation(7)));
+	TEST_CHECK(CShaderPermutation::GetCombinationCount() == 8);
+
+	// Every feature of the shader is defined as 1 or 0 in feature order, and the list ends at a NULL name
+	TEST_CHECK(Key.GetDefines(CShaderPermutation(7), Defines) == 3);
+	TEST_CHECK((strcmp(Defines[0].Name, "INSTANCED") == 0) && (strcmp(Defines[0].Definition, "1") == 0));
+	TEST_CHECK((strcmp(Defines[1].Name, "QUANTIZED_VERTICES") == 0) && (strcmp(Defines[1].Definition, "1") == 0));
+	TEST_CHECK((strcmp(Defines[2].Name, "LIT") == 0) && (strcmp(Defines[2].Definition, "0") == 0));
+	TEST_CHECK((Defines[3].Name == NULL) && (Defines[3].Definition == NULL));
+
+	// Features the shader does not read are left undefined
+	TEST_CHECK(Key.GetDefines(CShaderPermutation::Make<SHADER_FEATURE_LIT>(), Defines) == 1);
+	TEST_CHECK((strcmp(Defines[0].Name, "LIT") == 0) && (strcmp(Defines[0].Definition, "0") == 0) && (Defines[1].Name == NULL));
+
+	TEST_CHECK((Key.GetDefines(CShaderPermutation(), Defines) == 0) && (Defines[0].Name == NULL));
+	TEST_CHECK(CShaderPermutation::GetDefineName(NumShaderFeatures) == NULL);
+
+	// Each key of a shader gets its own embedded name
+	std::set<std::string> Names;
+
+	for (UINT Bits = 0; Bits < CShaderPermutation::GetCombinationCount(); Bits++)
+	{
+		CShaderPermutation(Bits).GetDefines(CShaderPermutation(7), Defines);
+		Names.insert(CShaderRegistry::GetName("VertexShader.hlsl", "main", "vs_5_0", Defines));
+	}
+
+	TEST_CHECK(Names.size() == CShaderPermutation::GetCombinationCount());
+
+	return Status;
+}
+
+static BOOL TestSceneReachability(VOID)
+{
+	BOOL Status = TRUE;
+	CPermutationRegistry Registry;
+	CompileLog Log;
+
+	CONST CShaderPermutation Key = CShaderPermutation::Make<SHADER_FEATURE_INSTANCED, SHADER_FEATURE_QUANTIZED>();
+
+	TEST_CHECK(CSceneShaders::Declare(Registry) == TRUE);
+	TEST_CHECK(Registry.GetShaderCount() == CSceneShaders::NumSceneShaders);
+	TEST_CHECK(Registry.GetShader(CSceneShaders::NumSceneShaders) == NULL);
+
+	// The renderer always instances and never lights, quantization is chosen at runtime
+	TEST_CHECK(Registry.IsReachable(CShaderPermutation::Make<SHADER_FEATURE_INSTANCED>()) == TRUE);
+	TEST_CHECK(Registry.IsReachable(Key) == TRUE);
+	TEST_CHECK(Registry.IsReachable(CShaderPermutation()) == FALSE);
+	TEST_CHECK(Registry.IsReachable(Key.With(SHADER_FEATURE_LIT, TRUE)) == FALSE);
+	TEST_CHECK(Registry.IsReachable(CShaderPermutation(1u << NumShaderFeatures)) == FALSE);
+
+	// Two vertex shader variants, and the pixel shader only reads LIT so it has one
+	Log.nFailAfter = 0xFFFFFFFF;
+	TEST_CHECK(Registry.Compile(CompileVariant, &Log) == TRUE);
+
+	CONST CPermutationRegistry::Report& rReport = Registry.GetReport();
+
+	TEST_CHECK((rReport.nShaders == 2) && (rReport.nPossible == 10) && (rReport.nReachable == 3) && (rReport.nCompiled == 3));
+	TEST_CHECK(rReport.BytecodeSize == (101 + 103 + 100));
+
+	CONST std::vector<std::string> Expected =
+	{
+		CShaderRegistry::GetName("VertexShader.hlsl", "main", "vs_5_0") + "|INSTANCED=1|QUANTIZED_VERTICES=0|LIT=0",
+		CShaderRegistry::GetName("VertexShader.hlsl", "main", "vs_5_0") + "|INSTANCED=1|QUANTIZED_VERTICES=1|LIT=0",
+		CShaderRegistry::GetName("PixelShader.hlsl", "main", "ps_5_0") + "|LIT=0"
+	};
+
+	TEST_CHECK(Log.Names == Expected);
+
+	TEST_CHECK(Registry.AddShader("VertexShader.hlsl", "main", "vs_5_0", CShaderPermutation()) == CPermutationRegistry::InvalidShader);
+
+	return Status;
+}
+
+static BOOL TestRules(VOID)
+{
+	BOOL Status = TRUE;
+	std::vector<CPermutationRegistry::Variant> Variants;
+
+	CPermutationRegistry Registry;
+
+	TEST_CHECK(Registry.AddShader("a.hlsl", "main", "vs_5_0", CShaderPermutation(7)) == 0);
+	TEST_CHECK(Registry.AddShader("b.hlsl", "main", "ps_5_0", CShaderPermutation::Make<SHADER_FEATURE_LIT>()) == 1);
+
+	// Without Fix rules every combination but LIT without QUANTIZED is reachable. Shader b only sees LIT, which is
+	// reachable both ways.
+	Registry.Require(SHADER_FEATURE_LIT, SHADER_FEATURE_QUANTIZED);
+	Registry.GetVariants(Variants);
+
+	TEST_CHECK(Variants.size() == 8);
+
+	for (SIZE_T i = 0; i < Variants.size(); i++)
+	{
+		CONST CShaderPermutation Permutation = Variants[i].Permutation;
+
+		TEST_CHECK((Variants[i].ShaderIndex != 0) || (Permutation.Has(SHADER_FEATURE_LIT) == FALSE) || (Permutation.Has(SHADER_FEATURE_QUANTIZED) == TRUE));
+
+		// Ordered by shader, then by key
+		if (i != 0)
+		{
+			TEST_CHECK((Variants[i - 1].ShaderIndex < Variants[i].ShaderIndex) ||
+					   ((Variants[i - 1].ShaderIndex == Variants[i].ShaderIndex) && (Variants[i - 1].Permutation.GetBits() < Permutation.GetBits())));
+		}
+	}
+
+	TEST_CHECK((Variants[6].ShaderIndex == 1) && (Variants[6].Permutation.GetBits() == 0));
+	TEST_CHECK((Variants[7].ShaderIndex == 1) && (Variants[7].Permutation == CShaderPermutation::Make<SHADER_FEATURE_LIT>()));
+
+	// Compile stops at the first failure
+	CompileLog Log;
+	Log.nFailAfter = 1;
+
+	TEST_CHECK(Registry.Compile(CompileVariant, &Log) == FALSE);
+	TEST_CHECK((Log.Names.size() == 2) && (Registry.GetReport().nCompiled == 1));
+
+	// Rules that contradict each other leave nothing to compile
+	CPermutationRegistry Contradiction;
+
+	Contradiction.AddShader("a.hlsl", "main", "vs_5_0", CShaderPermutation(7));
+	Contradiction.Fix(SHADER_FEATURE_LIT, TRUE);
+	Contradiction.Fix(SHADER_FEATURE_QUANTIZED, FALSE);
+	Contradiction.Require(SHADER_FEATURE_LIT, SHADER_FEATURE_QUANTIZED);
+	Contradiction.GetVariants(Variants);
+
+	TEST_CHECK(Variants.empty() == true);
+
+	return Status;
+}
+
+BOOL TestShaderPermutation(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestKeyEncoding() == TRUE) ? Status : FALSE;
+	Status = (TestSceneReachability() == TRUE) ? Status : FALSE;
+	Status = (TestRules() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
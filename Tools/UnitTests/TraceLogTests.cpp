@@ -0,0 +1,145 @@
+#include "UnitTests.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "CTraceLog.hpp"
+#include "CTraceReader.hpp"
+
+static CONST CHAR TracePath[] = "TraceLogTests.trace";
+
+// Arguments widened the way Console::Trace widens them
+static uint64_t TraceInteger(int64_t Value)
+{
+	return static_cast<uint64_t>(Value);
+}
+
+static uint64_t TraceDouble(double Value)
+{
+	uint64_t Bits = 0;
+	memcpy(&Bits, &Value, sizeof(Bits));
+
+	return Bits;
+}
+
+static BOOL TestWrapAround(VOID)
+{
+	BOOL Status = TRUE;
+	CTraceLog Log;
+	CTraceReader Reader;
+	CTraceReader::Record Record = { };
+	std::string Text;
+
+	std::remove(TracePath);
+
+	// Registered before the file exists, written to it when it is opened
+	CONST UINT Value = Log.RegisterFormat(1, "Value %d\n");
+
+	// Rounded up to the smallest ring, 1024 words
+	TEST_CHECK(Log.Open(TracePath, 0) == TRUE);
+
+	CONST UINT Pair = Log.RegisterFormat(2, "Pair %u %u");
+
+	TEST_CHECK((Value == 0) && (Pair == 1));
+
+	// Three words a record, the ring wraps almost three times
+	for (INT i = 0; i < 1000; i++)
+	{
+		CONST UINT64 Argument = TraceInteger(i - 500);
+		Log.Write(Value, 1, &Argument);
+	}
+
+	CONST UINT64 Arguments[] = { 7, 4000000000ULL };
+	Log.Write(Pair, 2, Arguments);
+
+	// Reaches the file but was never registered
+	Log.Write(7, 0, NULL);
+
+	Log.Close();
+
+	TEST_CHECK(Reader.Open(TracePath) == TRUE);
+
+	// 3006 words were written, so the ring starts at word 1982. That is the argument of record 660, the first whole
+	// record left is 661.
+	for (INT i = 661; i < 1000; i++)
+	{
+		TEST_CHECK(Reader.Read(Record) == TRUE);
+		TEST_CHECK((Record.Format == Value) && (Record.Level == 1) && (Record.nArguments == 1));
+
+		Reader.GetText(Record, Text);
+		TEST_CHECK(Text == ("Value " + std::to_string(i - 500)));
+	}
+
+	TEST_CHECK((Reader.Read(Record) == TRUE) && (Record.Format == Pair) && (Record.Level == 2));
+	Reader.GetText(Record, Text);
+	TEST_CHECK(Text == "Pair 7 4000000000");
+
+	TEST_CHECK((Reader.Read(Record) == TRUE) && (Record.Format == 7) && (Record.Level == CTraceReader::UnknownLevel));
+	Reader.GetText(Record, Text);
+	TEST_CHECK(Text == "<unknown format 7>");
+
+	TEST_CHECK(Reader.Read(Record) == FALSE);
+
+	CONST CTraceReader::Statistics& rStatistics = Reader.GetStatistics();
+
+	TEST_CHECK((rStatistics.Records == 341) && (rStatistics.SkippedWords == 1) && (rStatistics.UnknownFormats == 1));
+
+	Reader.Close();
+
+	// Anything but a trace is refused
+	FILE* pFile = fopen(TracePath, "wb");
+
+	if (pFile != NULL)
+	{
+		fputs("Not a trace", pFile);
+		fclose(pFile);
+	}
+
+	TEST_CHECK(Reader.Open(TracePath) == FALSE);
+	TEST_CHECK(Reader.Read(Record) == FALSE);
+
+	std::remove(TracePath);
+
+	return Status;
+}
+
+static BOOL TestFormatting(VOID)
+{
+	BOOL Status = TRUE;
+	std::string Text;
+
+	// Integers are narrowed back to the size the format asks for
+	CONST uint64_t Integers[] = { TraceInteger(-42), 0xFFFFFFD6ULL, TraceInteger(-1), 4000000000ULL, 1ULL << 40, 0x1FF, 0xBEEF };
+
+	CTraceReader::FormatRecord("%d %i %u %u %llu %hhu %08X", Integers, 7, Text);
+	TEST_CHECK(Text == "-42 -42 4294967295 4000000000 1099511627776 255 0000BEEF");
+
+	// FLOAT arguments were traced as doubles
+	CONST uint64_t Floats[] = { TraceDouble(3.14159), TraceDouble(-0.5), TraceDouble(1e10) };
+
+	CTraceReader::FormatRecord("%.2f %+.1f %g", Floats, 3, Text);
+	TEST_CHECK(Text == "3.14 -0.5 1e+10");
+
+	// '*' takes its width or precision from the next argument
+	CONST uint64_t Widths[] = { 6, 42, 3, 7, 3, TraceDouble(2.5) };
+
+	CTraceReader::FormatRecord("[%*d] [%-*d] %.*f%%", Widths, 6, Text);
+	TEST_CHECK(Text == "[    42] [7  ] 2.500%");
+
+	// Missing arguments read as 0 and the trailing line break is dropped
+	CTraceReader::FormatRecord("%d %d\n", Integers, 0, Text);
+	TEST_CHECK(Text == "0 0");
+
+	return Status;
+}
+
+BOOL TestTraceLog(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestWrapAround() == TRUE) ? Status : FALSE;
+	Status = (TestFormatting() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,297 @@
+#include "UnitTests.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "Jobs.hpp"
+#include "Math.hpp"
+
+#include "CTransformHierarchy.hpp"
+
+// The same nodes kept as a plain parent list, world matrices are recomputed from scratch by walking up to the root
+struct ReferenceNode
+{
+	UINT								 Parent;
+	CTransformHierarchy::LocalTransform Local;
+};
+
+class Reference
+{
+protected:
+	std::vector<ReferenceNode> m_Nodes;
+
+public:
+	UINT AddNode(CTransformHierarchy& rHierarchy, UINT Parent, CONST CTransformHierarchy::LocalTransform& rLocal)
+	{
+		m_Nodes.push_back(ReferenceNode{ Parent, rLocal });
+
+		return rHierarchy.AddNode(Parent, rLocal);
+	}
+
+	VOID SetLocal(CTransformHierarchy& rHierarchy, UINT Node, CONST CTransformHierarchy::LocalTransform& rLocal)
+	{
+		m_Nodes[Node].Local = rLocal;
+		rHierarchy.SetLocal(Node, rLocal);
+	}
+
+	UINT GetParent(UINT Node)
+	{
+		return m_Nodes[Node].Parent;
+	}
+
+	UINT GetNodeCount(VOID)
+	{
+		return static_cast<UINT>(m_Nodes.size());
+	}
+
+	Mat4 GetWorld(UINT Node)
+	{
+		CONST CTransformHierarchy::LocalTransform& rLocal = m_Nodes[Node].Local;
+		Mat4 World = Math::Compose(rLocal.Scale, rLocal.Rotation, rLocal.Translation);
+
+		for (UINT Parent = m_Nodes[Node].Parent; Parent != CTransformHierarchy::InvalidNode; Parent = m_Nodes[Parent].Parent)
+		{
+			CONST CTransformHierarchy::LocalTransform& rParent = m_Nodes[Parent].Local;
+			World = Math::Multiply(World, Math::Compose(rParent.Scale, rParent.Rotation, rParent.Translation));
+		}
+
+		return World;
+	}
+
+	// Nodes that have Node on their way to the root, including Node itself
+	UINT GetSubtreeSize(UINT Node)
+	{
+		UINT Size = 0;
+
+		for (UINT n = 0; n < m_Nodes.size(); n++)
+		{
+			UINT Ancestor = n;
+
+			while ((Ancestor != Node) && (Ancestor != CTransformHierarchy::InvalidNode))
+			{
+				Ancestor = m_Nodes[Ancestor].Parent;
+			}
+
+			Size += (Ancestor == Node) ? 1 : 0;
+		}
+
+		return Size;
+	}
+
+	// The products are associated differently, so only nearly equal
+	BOOL Matches(CTransformHierarchy& rHierarchy)
+	{
+		BOOL bMatches = (rHierarchy.GetNodeCount() == m_Nodes.size()) ? TRUE : FALSE;
+
+		for (UINT n = 0; (bMatches == TRUE) && (n < m_Nodes.size()); n++)
+		{
+			CONST Mat4 Expected = GetWorld(n);
+			CONST Mat4& rWorld = rHierarchy.GetWorld(n);
+
+			for (UINT r = 0; r < 4; r++)
+			{
+				for (UINT c = 0; c < 4; c++)
+				{
+					CONST FLOAT Tolerance = 1e-4f * ((fabsf(Expected.m[r][c]) > 1.0f) ? fabsf(Expected.m[r][c]) : 1.0f);
+
+					bMatches = (fabsf(rWorld.m[r][c] - Expected.m[r][c]) <= Tolerance) ? bMatches : FALSE;
+				}
+			}
+		}
+
+		return bMatches;
+	}
+};
+
+static FLOAT RandomFloat(uint32_t& rState, FLOAT Min, FLOAT Max)
+{
+	return Min + (Max - Min) * (static_cast<FLOAT>(UnitTests::Random(rState) % 10000) / 10000.0f);
+}
+
+static CTransformHierarchy::LocalTransform RandomLocal(uint32_t& rState)
+{
+	CTransformHierarchy::LocalTransform Local = { };
+
+	Local.Scale = Vec3{ RandomFloat(rState, 0.5f, 1.5f), RandomFloat(rState, 0.5f, 1.5f), RandomFloat(rState, 0.5f, 1.5f) };
+	Local.Rotation = Math::Normalize(Quat{ RandomFloat(rState, -1.0f, 1.0f), RandomFloat(rState, -1.0f, 1.0f), RandomFloat(rState, -1.0f, 1.0f), RandomFloat(rState, -1.0f, 1.0f) });
+	Local.Translation = Vec3{ RandomFloat(rState, -2.0f, 2.0f), RandomFloat(rState, -2.0f, 2.0f), RandomFloat(rState, -2.0f, 2.0f) };
+
+	return Local;
+}
+
+static BOOL TestOutOfOrder(VOID)
+{
+	BOOL Status = TRUE;
+	CTransformHierarchy Hierarchy;
+	Reference Nodes;
+	uint32_t State = 1;
+
+	TEST_CHECK((Hierarchy.Update() == 0) && (Hierarchy.GetLevelCount() == 0));
+
+	// Parents are picked at random from the nodes so far, so depths are interleaved in the order nodes are added
+	for (UINT n = 0; n < 300; n++)
+	{
+		CONST UINT Parent = ((n == 0) || ((UnitTests::Random(State) % 10) == 0)) ? static_cast<UINT>(CTransformHierarchy::InvalidNode) : (UnitTests::Random(State) % n);
+
+		TEST_CHECK(Nodes.AddNode(Hierarchy, Parent, RandomLocal(State)) == n);
+	}
+
+	TEST_CHECK(Hierarchy.AddNode(Nodes.GetNodeCount(), RandomLocal(State)) == CTransformHierarchy::InvalidNode);
+
+	TEST_CHECK(Hierarchy.Update() == 300);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+	TEST_CHECK(Hierarchy.GetLevelCount() > 2);
+
+	// Nothing changed
+	TEST_CHECK(Hierarchy.Update() == 0);
+
+	// Nodes added after an update sort the storage again, only they are recomputed and the old handles still work
+	for (UINT n = 300; n < 400; n++)
+	{
+		CONST UINT Parent = ((UnitTests::Random(State) % 10) == 0) ? static_cast<UINT>(CTransformHierarchy::InvalidNode) : (UnitTests::Random(State) % n);
+
+		TEST_CHECK(Nodes.AddNode(Hierarchy, Parent, RandomLocal(State)) == n);
+	}
+
+	TEST_CHECK(Hierarchy.Update() == 100);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	return Status;
+}
+
+static BOOL TestChanges(VOID)
+{
+	BOOL Status = TRUE;
+	CTransformHierarchy Hierarchy;
+	CTransformHierarchy::LocalTransform Local = { };
+	Reference Nodes;
+	uint32_t State = 2;
+	UINT Chain[8] = { };
+
+	// A chain eight levels deep with three leaves on every link, and a second tree beside it
+	for (UINT i = 0; i < 8; i++)
+	{
+		Chain[i] = Nodes.AddNode(Hierarchy, (i != 0) ? Chain[i - 1] : static_cast<UINT>(CTransformHierarchy::InvalidNode), RandomLocal(State));
+
+		for (UINT Leaf = 0; Leaf < 3; Leaf++)
+		{
+			Nodes.AddNode(Hierarchy, Chain[i], RandomLocal(State));
+		}
+	}
+
+	CONST UINT Other = Nodes.AddNode(Hierarchy, CTransformHierarchy::InvalidNode, RandomLocal(State));
+
+	for (UINT i = 0; i < 5; i++)
+	{
+		Nodes.AddNode(Hierarchy, Other, RandomLocal(State));
+	}
+
+	TEST_CHECK(Hierarchy.Update() == Nodes.GetNodeCount());
+	TEST_CHECK((Hierarchy.GetLevelCount() == 9) && (Nodes.Matches(Hierarchy) == TRUE));
+
+	// A deep node takes only its own subtree with it, setting it twice counts once
+	Nodes.SetLocal(Hierarchy, Chain[6], RandomLocal(State));
+	Nodes.SetLocal(Hierarchy, Chain[6], RandomLocal(State));
+
+	TEST_CHECK(Nodes.GetSubtreeSize(Chain[6]) == 8);
+	TEST_CHECK(Hierarchy.Update() == 8);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	// A leaf is only itself
+	Nodes.SetLocal(Hierarchy, Chain[3] + 2, RandomLocal(State));
+
+	TEST_CHECK(Nodes.GetParent(Chain[3] + 2) == Chain[3]);
+	TEST_CHECK(Hierarchy.Update() == 1);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	// A root moves its whole tree and leaves the other one alone
+	Nodes.SetLocal(Hierarchy, Chain[0], RandomLocal(State));
+
+	TEST_CHECK(Hierarchy.Update() == 32);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	// Both roots and a node below one of them
+	Nodes.SetLocal(Hierarchy, Other, RandomLocal(State));
+	Nodes.SetLocal(Hierarchy, Chain[0], RandomLocal(State));
+	Nodes.SetLocal(Hierarchy, Chain[4], RandomLocal(State));
+
+	TEST_CHECK(Hierarchy.Update() == 38);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	// Locals are stored as they were set
+	CONST CTransformHierarchy::LocalTransform Expected = RandomLocal(State);
+
+	Nodes.SetLocal(Hierarchy, Other, Expected);
+	Hierarchy.GetLocal(Other, Local);
+
+	TEST_CHECK((Local.Scale.y == Expected.Scale.y) && (Local.Rotation.w == Expected.Rotation.w) && (Local.Translation.z == Expected.Translation.z));
+
+	return Status;
+}
+
+static BOOL TestLargeLevel(VOID)
+{
+	BOOL Status = TRUE;
+	CTransformHierarchy Hierarchy;
+	Reference Nodes;
+	uint32_t State = 3;
+
+	// Level 1 is past 2 * MinNodesPerChunk, so it is swept by ParallelFor. Every seventh node of it has a child.
+	CONST UINT nLevelNodes = 2 * CTransformHierarchy::MinNodesPerChunk + 100;
+	CONST UINT Roots[2] = { Nodes.AddNode(Hierarchy, CTransformHierarchy::InvalidNode, RandomLocal(State)), Nodes.AddNode(Hierarchy, CTransformHierarchy::InvalidNode, RandomLocal(State)) };
+
+	for (UINT i = 0; i < nLevelNodes; i++)
+	{
+		Nodes.AddNode(Hierarchy, Roots[UnitTests::Random(State) % 2], RandomLocal(State));
+	}
+
+	for (UINT i = 0; i < nLevelNodes; i += 7)
+	{
+		Nodes.AddNode(Hierarchy, 2 + i, RandomLocal(State));
+	}
+
+	TEST_CHECK(Hierarchy.Update() == Nodes.GetNodeCount());
+	TEST_CHECK((Hierarchy.GetLevelCount() == 3) && (Nodes.Matches(Hierarchy) == TRUE));
+
+	// One root and everything below it
+	Nodes.SetLocal(Hierarchy, Roots[1], RandomLocal(State));
+
+	TEST_CHECK(Hierarchy.Update() == Nodes.GetSubtreeSize(Roots[1]));
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	// Scattered nodes of the large level, each with its child if it has one
+	UINT nExpected = 0;
+
+	for (UINT i = 0; i < nLevelNodes; i += 50)
+	{
+		Nodes.SetLocal(Hierarchy, 2 + i, RandomLocal(State));
+		nExpected += ((i % 7) == 0) ? 2 : 1;
+	}
+
+	TEST_CHECK(Hierarchy.Update() == nExpected);
+	TEST_CHECK(Nodes.Matches(Hierarchy) == TRUE);
+
+	return Status;
+}
+
+BOOL TestTransformHierarchy(VOID)
+{
+	BOOL Status = TRUE;
+
+	// Large levels are split over the workers
+	if (Jobs::Initialize(4) != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = (TestOutOfOrder() == TRUE) ? Status : FALSE;
+		Status = (TestChanges() == TRUE) ? Status : FALSE;
+		Status = (TestLargeLevel() == TRUE) ? Status : FALSE;
+	}
+
+	Jobs::Uninitialize();
+
+	return Status;
+}
@@ -0,0 +1,31 @@
+#ifndef UNITTESTS_HPP
+#define UNITTESTS_HPP
+
+#include "Defines.hpp"
+
+// Reports a failed condition with its location and clears the calling test's Status, the test carries on so every
+// failure in it is reported
+#define TEST_CHECK(Condition) (Status = (UnitTests::Check(((Condition) ? TRUE : FALSE), #Condition, __FILE__, __LINE__) == TRUE) ? Status : FALSE)
+
+class UnitTests
+{
+public:
+	static BOOL Check(BOOL bCondition, LPCSTR pExpression, LPCSTR pFile, UINT Line);
+
+	// Same sequence on every platform, so a failing fuzz run can be replayed
+	static uint32_t Random(uint32_t& rState);
+};
+
+BOOL TestConstantLayout(VOID);
+BOOL TestFrameScheduler(VOID);
+BOOL TestGpuTimer(VOID);
+BOOL TestHeapAllocator(VOID);
+BOOL TestJobSystem(VOID);
+BOOL TestPipelineCache(VOID);
+BOOL TestPipelineQueue(VOID);
+BOOL TestShaderPermutation(VOID);
+BOOL TestTraceLog(VOID);
+BOOL TestTransformHierarchy(VOID);
+BOOL TestUploadRing(VOID);
+
+#endif // UNITTESTS_HPP
@@ -0,0 +1,204 @@
+#include "UnitTests.hpp"
+
+#include <vector>
+
+#include "CUploadRing.hpp"
+
+struct LiveAllocation
+{
+	SIZE_T Offset;
+	SIZE_T Size;
+	UINT64 FenceValue;
+};
+
+static BOOL TestWrapAround(VOID)
+{
+	BOOL Status = TRUE;
+	CUploadRing Ring;
+	SIZE_T Offset = 0;
+
+	TEST_CHECK(Ring.Initialize(256) == TRUE);
+
+	TEST_CHECK((Ring.Allocate(100, 4, Offset) == TRUE) && (Offset == 0));
+	Ring.Submit(1);
+	TEST_CHECK((Ring.Allocate(100, 4, Offset) == TRUE) && (Offset == 100));
+	Ring.Submit(2);
+
+	// 56 bytes are left at the end, too few for 80, so the allocation wraps into the space the first fence freed
+	Ring.Reclaim(1);
+	TEST_CHECK((Ring.Allocate(80, 4, Offset) == TRUE) && (Offset == 0));
+	TEST_CHECK(Ring.GetUsed() == 100 + 56 + 80);
+	Ring.Submit(3);
+
+	// The skipped tail is released together with the allocation that wrapped
+	Ring.Reclaim(2);
+	TEST_CHECK(Ring.GetUsed() == 56 + 80);
+	TEST_CHECK((Ring.Allocate(20, 4, Offset) == TRUE) && (Offset == 80));
+	Ring.Submit(4);
+
+	Ring.Reclaim(4);
+	TEST_CHECK((Ring.GetUsed() == 0) && (Ring.GetRegionCount() == 0));
+
+	return Status;
+}
+
+static BOOL TestFullRing(VOID)
+{
+	BOOL Status = TRUE;
+	CUploadRing Ring;
+	SIZE_T Offset = 0;
+
+	TEST_CHECK(Ring.Initialize(256) == TRUE);
+
+	TEST_CHECK((Ring.Allocate(128, 1, Offset) == TRUE) && (Offset == 0));
+	TEST_CHECK((Ring.Allocate(128, 1, Offset) == TRUE) && (Offset == 128));
+	TEST_CHECK(Ring.GetUsed() == 256);
+
+	// Head met the tail, nothing fits until a fence completes
+	TEST_CHECK(Ring.Allocate(1, 1, Offset) == FALSE);
+	Ring.Submit(1);
+	Ring.Reclaim(0);
+	TEST_CHECK(Ring.Allocate(1, 1, Offset) == FALSE);
+
+	Ring.Reclaim(1);
+	TEST_CHECK((Ring.Allocate(256, 1, Offset) == TRUE) && (Offset == 0));
+
+	return Status;
+}
+
+static BOOL TestFenceGatedReuse(VOID)
+{
+	BOOL Status = TRUE;
+	CUploadRing Ring;
+	SIZE_T Offset = 0;
+
+	TEST_CHECK(Ring.Initialize(256) == TRUE);
+
+	TEST_CHECK(Ring.Allocate(96, 16, Offset) == TRUE);
+	Ring.Submit(5);
+	TEST_CHECK(Ring.Allocate(96, 16, Offset) == TRUE);
+	Ring.Submit(6);
+	TEST_CHECK(Ring.GetRegionCount() == 2);
+
+	// Regions go back oldest first and only once their own fence has completed
+	Ring.Reclaim(4);
+	TEST_CHECK((Ring.GetRegionCount() == 2) && (Ring.Allocate(96, 16, Offset) == FALSE));
+
+	Ring.Reclaim(5);
+	TEST_CHECK((Ring.GetRegionCount() == 1) && (Ring.Allocate(96, 16, Offset) == TRUE) && (Offset == 0));
+	Ring.Submit(7);
+
+	// Nothing allocated since the last submit, so there is no region to tag
+	Ring.Submit(8);
+	TEST_CHECK(Ring.GetRegionCount() == 2);
+
+	Ring.Reclaim(7);
+	TEST_CHECK(Ring.GetUsed() == 0);
+
+	return Status;
+}
+
+static BOOL TestInvalidAllocations(VOID)
+{
+	BOOL Status = TRUE;
+	CUploadRing Ring;
+	SIZE_T Offset = 0;
+
+	TEST_CHECK(Ring.Allocate(16, 16, Offset) == FALSE);
+	TEST_CHECK(Ring.Initialize(0) == FALSE);
+	TEST_CHECK(Ring.Initialize(1024) == TRUE);
+
+	TEST_CHECK(Ring.Allocate(0, 16, Offset) == FALSE);
+	TEST_CHECK(Ring.Allocate(16, 0, Offset) == FALSE);
+	TEST_CHECK(Ring.Allocate(16, 24, Offset) == FALSE);
+	TEST_CHECK(Ring.Allocate(1025, 16, Offset) == FALSE);
+
+	TEST_CHECK((Ring.Allocate(1, 1, Offset) == TRUE) && (Offset == 0));
+	TEST_CHECK((Ring.Allocate(1, 256, Offset) == TRUE) && (Offset == 256));
+	TEST_CHECK(Ring.GetUsed() == 257);
+
+	return Status;
+}
+
+// Random sizes, alignments and fence latencies against a list of the allocations whose fence has not completed
+static BOOL TestRandomAllocations(VOID)
+{
+	BOOL Status = TRUE;
+	CUploadRing Ring;
+	std::vector<LiveAllocation> Live;
+	uint32_t State = 1;
+	UINT64 Fence = 0;
+	UINT64 Completed = 0;
+	UINT nFailures = 0;
+
+	CONST SIZE_T Capacity = 4096;
+	TEST_CHECK(Ring.Initialize(Capacity) == TRUE);
+
+	for (UINT i = 0; (Status == TRUE) && (i < 100000); i++)
+	{
+		CONST SIZE_T Size = 1 + UnitTests::Random(State) % 700;
+		CONST SIZE_T Alignment = static_cast<SIZE_T>(1) << (UnitTests::Random(State) % 9);
+		SIZE_T Offset = 0;
+
+		if (Ring.Allocate(Size, Alignment, Offset) == TRUE)
+		{
+			TEST_CHECK(((Offset % Alignment) == 0) && ((Offset + Size) <= Capacity));
+
+			for (SIZE_T a = 0; (Status == TRUE) && (a < Live.size()); a++)
+			{
+				TEST_CHECK(((Offset + Size) <= Live[a].Offset) || (Offset >= (Live[a].Offset + Live[a].Size)));
+			}
+
+			Live.push_back({ Offset, Size, Fence + 1 });
+		}
+		else
+		{
+			nFailures++;
+		}
+
+		// A frame ends every few allocations and the GPU trails by up to three of them
+		if ((UnitTests::Random(State) % 4) == 0)
+		{
+			Ring.Submit(++Fence);
+		}
+
+		if ((Completed + 3 < Fence) || ((UnitTests::Random(State) % 3) == 0))
+		{
+			Completed = (Completed < Fence) ? (Completed + 1) : Completed;
+			Ring.Reclaim(Completed);
+
+			for (SIZE_T a = Live.size(); a > 0; a--)
+			{
+				if (Live[a - 1].FenceValue <= Completed)
+				{
+					Live.erase(Live.begin() + (a - 1));
+				}
+			}
+		}
+
+		TEST_CHECK(Ring.GetUsed() <= Capacity);
+	}
+
+	Ring.Submit(++Fence);
+	Ring.Reclaim(Fence);
+
+	TEST_CHECK((Ring.GetUsed() == 0) && (Ring.GetRegionCount() == 0));
+
+	// Some allocations have to fail for a full ring to have been exercised at all
+	TEST_CHECK(nFailures != 0);
+
+	return Status;
+}
+
+BOOL TestUploadRing(VOID)
+{
+	BOOL Status = TRUE;
+
+	Status = (TestWrapAround() == TRUE) ? Status : FALSE;
+	Status = (TestFullRing() == TRUE) ? Status : FALSE;
+	Status = (TestFenceGatedReuse() == TRUE) ? Status : FALSE;
+	Status = (TestInvalidAllocations() == TRUE) ? Status : FALSE;
+	Status = (TestRandomAllocations() == TRUE) ? Status : FALSE;
+
+	return Status;
+}
@@ -0,0 +1,118 @@
+#include "Defines.hpp"
+
+#include <cstring>
+
+#include "Console.hpp"
+#include "Memory.hpp"
+
+#include "UnitTests.hpp"
+
+/*
+* Runs the tests of the parts of the engine that work without a GPU.
+*
+*	UnitTests [suite]
+*
+* Every suite runs when none is named. Each failed check is printed with its location and any failure fails the run.
+*/
+
+struct Suite
+{
+	LPCSTR pName;
+	BOOL (*pRun)(VOID);
+};
+
+static CONST Suite Suites[] =
+{
+	{ "ConstantLayout", TestConstantLayout },
+	{ "FrameScheduler", TestFrameScheduler },
+	{ "GpuTimer", TestGpuTimer },
+	{ "HeapAllocator", TestHeapAllocator },
+	{ "JobSystem", TestJobSystem },
+	{ "PipelineCache", TestPipelineCache },
+	{ "PipelineQueue", TestPipelineQueue },
+	{ "ShaderPermutation", TestShaderPermutation },
+	{ "TraceLog", TestTraceLog },
+	{ "TransformHierarchy", TestTransformHierarchy },
+	{ "UploadRing", TestUploadRing }
+};
+
+BOOL UnitTests::Check(BOOL bCondition, LPCSTR pExpression, LPCSTR pFile, UINT Line)
+{
+	if (bCondition != TRUE)
+	{
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %s(%u): %s\n", pFile, Line, pExpression);
+	}
+
+	return bCondition;
+}
+
+uint32_t UnitTests::Random(uint32_t& rState)
+{
+	rState = rState * 1664525u + 1013904223u;
+	return rState >> 8;
+}
+
+static BOOL Run(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+	UINT nRun = 0;
+	UINT nFailed = 0;
+
+	if (ArgC > 2)
+	{
+		Status = FALSE;
+		Console::Write("Usage: UnitTests [suite]\n");
+	}
+
+	for (UINT i = 0; (Status == TRUE) && (i < (sizeof(Suites) / sizeof(Suites[0]))); i++)
+	{
+		if ((ArgC == 1) || (strcmp(ArgV[1], Suites[i].pName) == 0))
+		{
+			CONST BOOL bPassed = Suites[i].pRun();
+
+			Console::Write("%s: %s\n", Suites[i].pName, (bPassed == TRUE) ? "Passed" : "Failed");
+
+			nRun++;
+			nFailed += (bPassed == TRUE) ? 0 : 1;
+		}
+	}
+
+	if ((Status == TRUE) && (nRun == 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: There is no suite called %s\n", ArgV[1]);
+	}
+
+	if ((Status == TRUE) && (nFailed != 0))
+	{
+		Status = FALSE;
+		CONSOLE_LOG(Console::LEVEL_ERROR, "Error: %u of %u suites failed\n", nFailed, nRun);
+	}
+
+	return Status;
+}
+
+INT main(INT ArgC, CHAR* ArgV[])
+{
+	BOOL Status = TRUE;
+
+	if (Memory::Initialize() != TRUE)
+	{
+		Status = FALSE;
+	}
+
+	if ((Status == TRUE) && (Console::Initialize() != TRUE))
+	{
+		Status = FALSE;
+	}
+
+	if (Status == TRUE)
+	{
+		Status = Run(ArgC, ArgV);
+	}
+
+	Console::Uninitialize();
+	Memory::Uninitialize();
+
+	return Status == TRUE ? 0 : -1;
+}